@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <cstring>
 #include <functional>
 #include <iostream>
@@ -6,6 +7,7 @@
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 #include "blazingdb/transport/common/macros.hpp"
 #include "blazingdb/transport/io/fd_reader_writer.h"
 
@@ -14,56 +16,146 @@
 namespace blazingdb {
 namespace network {
 
+/**
+ * Receives the messages of every peer on a single ROUTER socket and hands them to a set of worker threads, so the
+ * messages of different peers, and the ones in flight on the same connection, are read concurrently.
+ *
+ * A message is a multipart zmq message: the routing identity of the peer (added by the ROUTER), the request id
+ * chosen by the peer and then the frames the handler reads. When the handler returns, the worker acknowledges the
+ * request id with "END" ("ERR" if the handler threw), which gives the peer back the credit the message used.
+ */
 class TCPServerSocket {
 public:
-  TCPServerSocket(int tcp_port) : context(1) {
+  TCPServerSocket(int tcp_port)
+      : context(1), workers_endpoint{"inproc://transport-workers-" + std::to_string(tcp_port)} {
     try {
-      socket = zmq::socket_t(context, ZMQ_REP);
+      frontend = zmq::socket_t(context, ZMQ_ROUTER);
       auto connection = "tcp://*:" + std::to_string(tcp_port);
       std::cout << "listening: " << connection << std::endl;
-      int linger = -1;
-      socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
-      socket.bind(connection);
+      // the acknowledgments still queued when the server closes are not worth waiting for
+      int linger = 0;
+      frontend.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+      frontend.bind(connection);
 
+      backend = zmq::socket_t(context, ZMQ_DEALER);
+      backend.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+      // the backend hands each message to the next worker with room for it, a small queue per worker keeps a big
+      // message from holding up the ones queued behind it
+      int worker_queue_size = 1;
+      backend.setsockopt(ZMQ_SNDHWM, &worker_queue_size, sizeof(worker_queue_size));
+      backend.bind(workers_endpoint);
     } catch (std::exception &e) {
       std::cerr << e.what() << std::endl;
     }
   }
 
-  void run(std::function<void(void *)> handler) {
-    while (context) {
-      if (socket.connected()) {
-        handler((void *)&socket);
+  /**
+   * Serves messages until close() is called.
+   *
+   * @param handler      reads the frames of one message (after the request id) from the socket it receives.
+   * @param num_workers  how many messages are read at the same time.
+   */
+  void run(std::function<void(void *)> handler, int num_workers) {
+    std::vector<std::thread> workers;
+    for (int worker = 0; worker < std::max(num_workers, 1); worker++) {
+      workers.emplace_back([this, &handler]() { run_worker(handler); });
+    }
+    try {
+      zmq::proxy(static_cast<void *>(frontend), static_cast<void *>(backend), nullptr);
+    } catch (zmq::error_t &e) {
+      // ETERM, the server was closed
+    }
+    frontend.close();
+    backend.close();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void close() { zmq_ctx_shutdown(static_cast<void *>(context)); }
+
+private:
+  void run_worker(const std::function<void(void *)> &handler) {
+    zmq::socket_t socket;
+    try {
+      socket = zmq::socket_t(context, ZMQ_DEALER);
+      int linger = 0;
+      int worker_queue_size = 1;
+      socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+      socket.setsockopt(ZMQ_RCVHWM, &worker_queue_size, sizeof(worker_queue_size));
+      socket.connect(workers_endpoint);
+    } catch (zmq::error_t &e) {
+      // the server was closed before the worker started
+      return;
+    }
+    while (true) {
+      zmq::message_t identity;
+      zmq::message_t request_id;
+      try {
+        if (!socket.recv(identity) || !identity.more() || !socket.recv(request_id)) {
+          continue;
+        }
+      } catch (zmq::error_t &e) {
+        break;
+      }
+
+      const char *status = "END";
+      try {
+        if (request_id.more()) {
+          handler((void *)&socket);
+        }
+      } catch (std::exception &e) {
+        std::cerr << "[ERROR] " << e.what() << std::endl;
+        status = "ERR";
+      }
 
-        //        uint64_t more_part;
-        //        size_t more_size = sizeof(more_part);
-        //
-        //        socket.getsockopt(ZMQ_RCVMORE, &more_part, &more_size);
+      try {
+        // whatever the handler did not read belongs to this message
+        int more = 0;
+        size_t more_size = sizeof(more);
+        socket.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+        while (more) {
+          zmq::message_t part;
+          socket.recv(part);
+          more = part.more();
+        }
 
-      } else {
+        socket.send(identity, ZMQ_SNDMORE);
+        socket.send(request_id, ZMQ_SNDMORE);
+        zmq::message_t reply(status, 3);
+        socket.send(reply, 0);
+      } catch (zmq::error_t &e) {
         break;
       }
     }
-  }
-  void close() {
     socket.close();
-    context.close();
   }
 
-private:
   zmq::context_t context;
-  zmq::socket_t socket;
-  std::function<void(int)> handler;
+  zmq::socket_t frontend;
+  zmq::socket_t backend;
+  std::string workers_endpoint;
 };
 
+/**
+ * The DEALER end of a connection to a TCPServerSocket. It does not wait for a reply between messages, the caller
+ * prefixes every message with its request id and reads the acknowledgments when it needs them.
+ */
 class TCPClientSocket {
 public:
   TCPClientSocket(const std::string &tcp_host, int tcp_port) : context(1) {
     try {
-      socket = zmq::socket_t(context, ZMQ_REQ);
+      socket = zmq::socket_t(context, ZMQ_DEALER);
       auto connection = "tcp://" + tcp_host + ":" + std::to_string(tcp_port);
       int linger = -1;
       socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+#ifdef ZMQ_HEARTBEAT_IVL
+      // client sockets are kept open between messages, the heartbeats let zmq notice a dead peer and reconnect
+      int heartbeat_interval = 10000;
+      int heartbeat_timeout = 30000;
+      socket.setsockopt(ZMQ_HEARTBEAT_IVL, &heartbeat_interval, sizeof(heartbeat_interval));
+      socket.setsockopt(ZMQ_HEARTBEAT_TIMEOUT, &heartbeat_timeout, sizeof(heartbeat_timeout));
+#endif
       socket.connect(connection);
     } catch (std::exception &e) {
       std::cerr << e.what() << std::endl;
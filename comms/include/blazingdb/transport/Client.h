@@ -11,14 +11,28 @@
 namespace blazingdb {
 namespace transport {
 
+/**
+ * A connection to a peer. Several threads can use the same client at once and several messages can be in flight on
+ * it: Send returns once the message was handed to the connection, without waiting for the peer to process it.
+ */
 class Client {
 public:
   class SendError;
 
   virtual Status Send(GPUMessage& message) = 0;
 
+  /**
+   * Sends the last event of a message token once the peer processed the messages sent before through this client,
+   * and waits until the peer processed it.
+   */
   virtual bool notifyLastMessageEvent(const Message::MetaData &message_metadata) = 0;
 
+  /**
+   * Waits until the peer processed every message sent before through this client. Returns false if the peer failed
+   * to process any message since the previous call.
+   */
+  virtual bool Flush() = 0;
+
   virtual void Close() = 0;
 
   virtual void SetDevice(int) = 0;
@@ -32,7 +46,12 @@ public:
 
   virtual void SetDevice(int) = 0;
 
-  static std::shared_ptr<Client> Make(const std::string& ip, int16_t port);
+  /**
+   * @param max_messages_in_flight  how many messages can be sent before the peer acknowledges them. Sending waits
+   * for a credit once they are all used.
+   */
+  static std::shared_ptr<Client> Make(const std::string& ip, int16_t port,
+                                      std::size_t max_messages_in_flight = 16);
 };
 
 }  // namespace transport
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <set>
 #include <map>
@@ -27,20 +29,38 @@ public:
   MessageQueue& operator=(const MessageQueue&) = delete;
 
 public:
+  /**
+   * Waits for a message with the given token and removes it from the queue.
+   * Messages with the same token are returned in the order they arrived.
+   *
+   * @param messageToken  the token of the message.
+   * @return              the message, or nullptr if it was a sentinel message.
+   */
   std::shared_ptr<ReceivedMessage> getMessage(const std::string& messageToken);
 
+  /**
+   * Stores a message and wakes up one of the receivers waiting for its token, if any.
+   *
+   * @param message  the message to store.
+   */
   void putMessage(std::shared_ptr<ReceivedMessage>& message);
 
-  
 private:
-  std::shared_ptr<ReceivedMessage> getMessageQueue(const std::string& messageToken);
-
-  void putMessageQueue(std::shared_ptr<ReceivedMessage>& message);
+  /**
+   * The messages that arrived for one message token, and the receivers waiting for them.
+   * Only the receivers of a token wait on its condition variable, so a put never wakes up
+   * receivers that are waiting for other tokens.
+   */
+  struct TokenQueue {
+    std::deque<std::shared_ptr<ReceivedMessage>> messages;
+    std::condition_variable condition_variable;
+    std::size_t num_waiters{0};
+  };
 
 private:
   std::mutex mutex_;
-  std::vector<std::shared_ptr<ReceivedMessage>> message_queue_;
-  std::condition_variable condition_variable_;
+  // a TokenQueue is removed once it has no messages and nobody is waiting on it
+  std::unordered_map<std::string, TokenQueue> message_queues_;
 };
 
 }  // namespace transport
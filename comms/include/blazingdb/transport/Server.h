@@ -164,11 +164,12 @@ public:
   /**
    * Static function that creates a TCP server.
    *
+   * @param num_workers  how many threads read the incoming messages.
    * @return  unique pointer of the TCP server.
    */
-  static std::unique_ptr<Server> TCP(unsigned short port);
+  static std::unique_ptr<Server> TCP(unsigned short port, int num_workers = 4);
 
-  static std::unique_ptr<Server> BatchProcessing(unsigned short port);
+  static std::unique_ptr<Server> BatchProcessing(unsigned short port, int num_workers = 4);
 };
 
 }  // namespace transport
@@ -1,5 +1,6 @@
 #pragma once
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <stack>
 #include <vector>
@@ -19,12 +20,20 @@ struct PinnedBuffer {
 
 class PinnedBufferProvider {
 public:
+  /**
+   * Receives the begin and end time, in microseconds since the epoch of std::chrono::high_resolution_clock,
+   * of a getBuffer call that had to wait for the pool or grow it.
+   */
+  using WaitObserver = std::function<void(int64_t, int64_t)>;
+
   PinnedBufferProvider(std::size_t sizeBuffers, std::size_t numBuffers);
 
   ~PinnedBufferProvider();
 
   PinnedBuffer *getBuffer();
 
+  void setWaitObserver(WaitObserver observer);
+
   void freeBuffer(PinnedBuffer *buffer);
 
   std::size_t sizeBuffers();
@@ -50,6 +59,8 @@ private:
   int allocation_counter;
     
   std::vector<char *> allocations;
+
+  WaitObserver waitObserver;
 };
 
 // Memory Pool
@@ -57,6 +68,19 @@ PinnedBufferProvider &getPinnedBufferProvider();
 
 void setPinnedBufferProvider(std::size_t sizeBuffers, std::size_t numBuffers);
 
+/**
+ * Receives one chunk of a buffer and returns how many bytes it took.
+ */
+using ChunkWriter = std::function<std::size_t(const char *, std::size_t)>;
+
+/**
+ * Copies the buffers to host memory in chunks of the pinned buffer size and hands every chunk to write, in order.
+ */
+void writeBuffersFromGPU(std::vector<ColumnTransport> &column_transport,
+                         std::vector<std::size_t> bufferSizes,
+                         std::vector<const char *> buffers, ChunkWriter write,
+                         int gpuNum);
+
 void writeBuffersFromGPUTCP(std::vector<ColumnTransport> &column_transport,
                             std::vector<std::size_t> bufferSizes,
                             std::vector<const char *> buffers, void *fileDescriptor,
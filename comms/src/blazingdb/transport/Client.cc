@@ -1,7 +1,19 @@
 #include "blazingdb/transport/Client.h"
 #include <cuda_runtime_api.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <map>
+#include <mutex>
+#include <stdexcept>
 #include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
 #include "blazingdb/network/TCPSocket.h"
 #include "blazingdb/transport/ColumnTransport.h"
 #include "blazingdb/transport/Status.h"
@@ -30,59 +42,108 @@ private:
   const std::string message_;
 };
 
-template <typename MetadataType>
-void write_metadata(void* file_descriptor, const MetadataType& metadata) {
-  blazingdb::transport::io::writeToSocket(file_descriptor, (char*)&metadata,
-                                          sizeof(MetadataType));
-}
+namespace {
+
+/**
+ * The frames of a message. They are built before the connection is locked, so several threads can copy their
+ * tables out of the GPU at the same time.
+ */
+class OutgoingMessage {
+public:
+  std::size_t add(const char* data, std::size_t size) {
+    zmq::message_t frame(size);
+    if (size > 0) {
+      memcpy(frame.data(), data, size);
+    }
+    frames_.push_back(std::move(frame));
+    return size;
+  }
+
+  template <typename MetadataType>
+  void addMetadata(const MetadataType& metadata) {
+    add((const char*)&metadata, sizeof(MetadataType));
+  }
+
+  std::vector<zmq::message_t>& frames() { return frames_; }
 
+private:
+  std::vector<zmq::message_t> frames_;
+};
+
+}  // namespace
+
+/**
+ * Every message is sent as one multipart zmq message prefixed with a request id, and the server acknowledges each
+ * request id once the message was stored (see TCPServerSocket). A message uses one of max_messages_in_flight
+ * credits from the moment it is queued until its acknowledgment arrives, which bounds the memory the peer needs for
+ * this connection.
+ *
+ * The zmq socket can not be used by two threads at once, so only the io thread of the connection uses it: it sends
+ * the queued messages and reads the acknowledgments. The threads that send only take the mutex to queue a message or
+ * to wait on the condition variable, so they are never held back by another thread waiting for acknowledgments.
+ */
 class ConcreteClientTCP : public ClientTCP {
 public:
-  ConcreteClientTCP(const std::string& ip, int16_t port)
-      : client_socket{ip, port} {}
-  void Close() override { client_socket.close(); }
+  ConcreteClientTCP(const std::string& ip, int16_t port, std::size_t max_messages_in_flight)
+      : client_socket{ip, port},
+        maxMessagesInFlight{std::max<std::size_t>(max_messages_in_flight, 1)} {
+    if (pipe(wakeUpFds) != 0) {
+      throw std::runtime_error("transport::Client: could not create the wake up pipe of the io thread");
+    }
+    fcntl(wakeUpFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeUpFds[1], F_SETFL, O_NONBLOCK);
+    ioThread = std::thread([this] { ioLoop(); });
+  }
+
+  ~ConcreteClientTCP() {
+    stopIoThread();
+    ::close(wakeUpFds[0]);
+    ::close(wakeUpFds[1]);
+  }
+
+  void Close() override {
+    stopIoThread();
+    client_socket.close();
+  }
 
   void SetDevice(int gpuId) override { this->gpuId = gpuId; }
-  
+
   bool notifyLastMessageEvent(const Message::MetaData &message_metadata) override {
-    void* fd = client_socket.fd();
-    zmq::socket_t* socket_ptr = (zmq::socket_t*)fd;
-    blazingdb::transport::io::writeToSocket(fd, "LAST", 4);
-
-    write_metadata(fd, message_metadata);
-
-    blazingdb::transport::io::writeToSocket(fd, "OK", 2, false);
-
-    int data_past_topic{0};
-    auto data_past_topic_size{sizeof(data_past_topic)};
-    socket_ptr->getsockopt(ZMQ_RCVMORE, &data_past_topic,
-                           &data_past_topic_size);
-    // receive the ok
-    zmq::message_t local_message;
-    auto success = socket_ptr->recv(local_message);
-    if (success.value() == false || local_message.size() == 0) {
-      std::cerr << "Client:   throw zmq::error_t()" << std::endl;
-      throw zmq::error_t();
-    }
+    OutgoingMessage outgoing;
+    outgoing.add("LAST", 4);
+    outgoing.addMetadata(message_metadata);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // the peer reads messages concurrently, so the last event is held back until the messages before it were stored
+    uint64_t barrier = nextRequestId;
+    waitUntil(lock, [this, barrier] { return acknowledgedBefore(barrier) && hasCreditUnsafe(); });
+    uint64_t requestId = enqueueUnsafe(std::move(outgoing));
+    waitUntil(lock, [this, requestId] { return acknowledgedBefore(requestId + 1); });
+    return failedRequests.erase(requestId) == 0;
+  }
 
-    std::string end_message(static_cast<char*>(local_message.data()),
-                            local_message.size());
-    assert(end_message == "END");
-    return true;
+  bool Flush() override {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t barrier = nextRequestId;
+    waitUntil(lock, [this, barrier] { return acknowledgedBefore(barrier); });
+    auto firstNotFlushed = failedRequests.lower_bound(barrier);
+    bool processed = failedRequests.begin() == firstNotFlushed;
+    failedRequests.erase(failedRequests.begin(), firstNotFlushed);
+    return processed;
   }
 
   Status Send(GPUMessage& message) override {
-    void* fd = client_socket.fd();
     auto &node = message.getSenderNode();
     auto message_metadata = message.metadata();
 
+    OutgoingMessage outgoing;
     // Initialize the topic message to be sent.
-    blazingdb::transport::io::writeToSocket(fd, "GPUS", 4);
+    outgoing.add("GPUS", 4);
 
     // send message metadata
-    write_metadata(fd, message_metadata);
+    outgoing.addMetadata(message_metadata);
     // send address metadata
-    write_metadata(fd, node.address().metadata_);
+    outgoing.addMetadata(node.address().metadata_);
 
     // send message content (gpu buffers)
     std::vector<std::size_t> buffer_sizes;
@@ -91,45 +152,188 @@ public:
     std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
     std::tie(buffer_sizes, buffers, column_offsets, temp_scope_holder) = message.GetRawColumns();
 
-    write_metadata(fd, (int32_t)column_offsets.size());
-    blazingdb::transport::io::writeToSocket(
-        fd, (char*)column_offsets.data(),
-        sizeof(ColumnTransport) * column_offsets.size());
-
-    write_metadata(fd, (int32_t)buffer_sizes.size());
-    blazingdb::transport::io::writeToSocket(fd, (char*)buffer_sizes.data(),
-                                            sizeof(std::size_t) * buffer_sizes.size());
-
-    blazingdb::transport::io::writeBuffersFromGPUTCP(column_offsets, buffer_sizes, buffers, fd, gpuId);
-    blazingdb::transport::io::writeToSocket(fd, "OK", 2, false);
-
-    zmq::socket_t* socket_ptr = (zmq::socket_t*)fd;
-
-    int data_past_topic{0};
-    auto data_past_topic_size{sizeof(data_past_topic)};
-    socket_ptr->getsockopt(ZMQ_RCVMORE, &data_past_topic,
-                           &data_past_topic_size);
-    // receive the ok
-    zmq::message_t local_message;
-    auto success = socket_ptr->recv(local_message);
-    if (success.value() == false || local_message.size() == 0) {
-      std::cerr << "Client:   throw zmq::error_t()" << std::endl;
-      throw zmq::error_t();
-    }
+    outgoing.addMetadata((int32_t)column_offsets.size());
+    outgoing.add((char*)column_offsets.data(), sizeof(ColumnTransport) * column_offsets.size());
+
+    outgoing.addMetadata((int32_t)buffer_sizes.size());
+    outgoing.add((char*)buffer_sizes.data(), sizeof(std::size_t) * buffer_sizes.size());
 
-    std::string end_message(static_cast<char*>(local_message.data()),
-                            local_message.size());
-    assert(end_message == "END");
+    blazingdb::transport::io::writeBuffersFromGPU(
+        column_offsets, buffer_sizes, buffers,
+        [&outgoing](const char* data, std::size_t size) { return outgoing.add(data, size); }, gpuId);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    waitUntil(lock, [this] { return hasCreditUnsafe(); });
+    enqueueUnsafe(std::move(outgoing));
     return Status{true};
   }
 
+private:
+  /**
+   * Whether every request queued before requestId was acknowledged.
+   */
+  bool acknowledgedBefore(uint64_t requestId) {
+    return (queued.empty() || queued.front().first >= requestId) && (inFlight.empty() || *inFlight.begin() >= requestId);
+  }
+
+  bool hasCreditUnsafe() {
+    return queued.size() + inFlight.size() < maxMessagesInFlight;
+  }
+
+  uint64_t enqueueUnsafe(OutgoingMessage&& outgoing) {
+    uint64_t requestId = nextRequestId++;
+    queued.emplace_back(requestId, std::move(outgoing));
+    wakeUpIoThread();
+    return requestId;
+  }
+
+  /**
+   * Waits on the condition variable until done() holds. Throws if the io thread failed or the connection was
+   * closed before that.
+   */
+  template <typename Predicate>
+  void waitUntil(std::unique_lock<std::mutex>& lock, Predicate done) {
+    condition.wait(lock, [this, &done] { return ioError || stopping || done(); });
+    if (done()) {
+      return;
+    }
+    if (ioError) {
+      std::rethrow_exception(ioError);
+    }
+    throw std::runtime_error("transport::Client: the connection was closed");
+  }
+
+  void wakeUpIoThread() {
+    char byte = 0;
+    // a full pipe already wakes the io thread up
+    ssize_t written = ::write(wakeUpFds[1], &byte, 1);
+    (void)written;
+  }
+
+  void stopIoThread() {
+    std::lock_guard<std::mutex> stopLock(stopMutex);
+    if (!ioThread.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      condition.notify_all();
+    }
+    wakeUpIoThread();
+    ioThread.join();
+  }
+
+  /**
+   * Sends the queued messages while there are credits, and reads the acknowledgments as they arrive. When the
+   * connection is closed the messages still queued are sent before the loop ends.
+   */
+  void ioLoop() {
+    zmq::socket_t* socket_ptr = (zmq::socket_t*)client_socket.fd();
+    try {
+      while (true) {
+        std::vector<std::pair<uint64_t, OutgoingMessage>> requests;
+        bool stop;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stop = stopping;
+          while (!queued.empty() && (stopping || inFlight.size() < maxMessagesInFlight)) {
+            inFlight.insert(queued.front().first);
+            requests.push_back(std::move(queued.front()));
+            queued.pop_front();
+          }
+        }
+        for (auto& request : requests) {
+          sendRequest(*socket_ptr, request.first, request.second);
+        }
+        if (stop) {
+          return;
+        }
+
+        zmq::pollitem_t items[] = {{static_cast<void*>(*socket_ptr), 0, ZMQ_POLLIN, 0},
+                                   {nullptr, wakeUpFds[0], ZMQ_POLLIN, 0}};
+        try {
+          zmq::poll(items, 2, -1);
+        } catch (const zmq::error_t& e) {
+          if (e.num() == EINTR) {
+            continue;
+          }
+          throw;
+        }
+        if (items[1].revents & ZMQ_POLLIN) {
+          char bytes[64];
+          while (::read(wakeUpFds[0], bytes, sizeof(bytes)) > 0) {
+          }
+        }
+        if (items[0].revents & ZMQ_POLLIN) {
+          receiveAcks(*socket_ptr);
+        }
+      }
+    } catch (...) {
+      std::cerr << "Client:   io thread failed" << std::endl;
+      std::lock_guard<std::mutex> lock(mutex);
+      ioError = std::current_exception();
+      condition.notify_all();
+    }
+  }
+
+  void sendRequest(zmq::socket_t& socket, uint64_t requestId, OutgoingMessage& outgoing) {
+    auto& frames = outgoing.frames();
+    zmq::message_t requestIdFrame(sizeof(requestId));
+    memcpy(requestIdFrame.data(), &requestId, sizeof(requestId));
+    socket.send(requestIdFrame, frames.empty() ? 0 : ZMQ_SNDMORE);
+    for (std::size_t frameIndex = 0; frameIndex < frames.size(); frameIndex++) {
+      socket.send(frames[frameIndex], frameIndex + 1 < frames.size() ? ZMQ_SNDMORE : 0);
+    }
+  }
+
+  void receiveAcks(zmq::socket_t& socket) {
+    std::vector<std::pair<uint64_t, bool>> acks;
+    zmq::message_t requestIdFrame;
+    while (socket.recv(requestIdFrame, zmq::recv_flags::dontwait)) {
+      zmq::message_t status;
+      if (!requestIdFrame.more() || requestIdFrame.size() != sizeof(uint64_t) || !socket.recv(status)) {
+        std::cerr << "Client:   throw zmq::error_t()" << std::endl;
+        throw zmq::error_t();
+      }
+      uint64_t requestId;
+      memcpy(&requestId, requestIdFrame.data(), sizeof(requestId));
+      acks.emplace_back(requestId, status.size() == 3 && memcmp(status.data(), "END", 3) == 0);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& ack : acks) {
+      inFlight.erase(ack.first);
+      if (!ack.second) {
+        failedRequests.insert(ack.first);
+      }
+    }
+    condition.notify_all();
+  }
+
 protected:
   blazingdb::network::TCPClientSocket client_socket;
   int gpuId{0};
+
+private:
+  std::mutex mutex;  /**< guards the requests, never held while using the socket */
+  std::condition_variable condition;  /**< notified when acknowledgments arrive and when the io thread stops */
+  const std::size_t maxMessagesInFlight;
+  uint64_t nextRequestId{0};
+  std::deque<std::pair<uint64_t, OutgoingMessage>> queued;  /**< waiting for the io thread to send them */
+  std::set<uint64_t> inFlight;  /**< sent and not acknowledged yet */
+  std::set<uint64_t> failedRequests;  /**< acknowledged as failed and not reported yet */
+  bool stopping{false};
+  std::exception_ptr ioError;  /**< why the io thread stopped, if it failed */
+
+  std::mutex stopMutex;  /**< serializes Close and the destructor */
+  int wakeUpFds[2];  /**< a pipe the io thread polls with the socket, written to when a message is queued */
+  std::thread ioThread;  /**< the only thread that uses the socket */
 };
 
-std::shared_ptr<Client> ClientTCP::Make(const std::string& ip, int16_t port) {
-  return std::shared_ptr<Client>(new ConcreteClientTCP(ip, port));
+std::shared_ptr<Client> ClientTCP::Make(const std::string& ip, int16_t port,
+                                        std::size_t max_messages_in_flight) {
+  return std::shared_ptr<Client>(new ConcreteClientTCP(ip, port, max_messages_in_flight));
 }
 
 }  // namespace transport
@@ -1,5 +1,4 @@
 #include "blazingdb/transport/MessageQueue.h"
-#include <algorithm>
 #include <iostream>
 #include "../engine/src/CodeTimer.h"
 using namespace std::chrono_literals;
@@ -18,13 +17,12 @@ MessageQueue::MessageQueue()
 std::shared_ptr<ReceivedMessage> MessageQueue::getMessage(
     const std::string &messageToken) {
   std::unique_lock<std::mutex> lock(mutex_);
+  TokenQueue &token_queue = message_queues_[messageToken];
+  token_queue.num_waiters++;
 
   CodeTimer blazing_timer;
-  while(!condition_variable_.wait_for(lock, 60000ms, [&, this] {
-      bool got_the_message = std::any_of(this->message_queue_.cbegin(),
-                        this->message_queue_.cend(), [&](const auto &e) {
-                          return e->getMessageTokenValue() == messageToken;
-                        });
+  while(!token_queue.condition_variable.wait_for(lock, 60000ms, [&] {
+      bool got_the_message = !token_queue.messages.empty();
       if (!got_the_message && blazing_timer.elapsed_time() > 59000){
         auto logger = spdlog::get("batch_logger");
         logger->warn("|||{info}|{duration}|messageToken|{messageToken}||",
@@ -34,26 +32,14 @@ std::shared_ptr<ReceivedMessage> MessageQueue::getMessage(
       }
       return got_the_message;
     })){}
-  return getMessageQueue(messageToken);
-}
 
-void MessageQueue::putMessage(std::shared_ptr<ReceivedMessage> &message) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  putMessageQueue(message);
+  token_queue.num_waiters--;
+  std::shared_ptr<ReceivedMessage> message = std::move(token_queue.messages.front());
+  token_queue.messages.pop_front();
+  if (token_queue.messages.empty() && token_queue.num_waiters == 0) {
+    message_queues_.erase(messageToken);
+  }
   lock.unlock();
-  condition_variable_.notify_all(); // Note: Very important to notify all threads
-}
-
-std::shared_ptr<ReceivedMessage> MessageQueue::getMessageQueue(
-    const std::string &messageToken) {
-  auto it = std::find_if(message_queue_.begin(), message_queue_.end(),
-                           [&messageToken](const auto &e) {
-                             return e->getMessageTokenValue() == messageToken;
-                           });
-  assert(it != message_queue_.end());
-
-  std::shared_ptr<ReceivedMessage> message = *it;
-  message_queue_.erase(it, it + 1);
 
   if (message->is_sentinel()) {
     return nullptr;
@@ -62,8 +48,15 @@ std::shared_ptr<ReceivedMessage> MessageQueue::getMessageQueue(
   return message;
 }
 
-void MessageQueue::putMessageQueue(std::shared_ptr<ReceivedMessage> &message) {
-  message_queue_.push_back(message);
+void MessageQueue::putMessage(std::shared_ptr<ReceivedMessage> &message) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  TokenQueue &token_queue = message_queues_[message->getMessageTokenValue()];
+  token_queue.messages.push_back(message);
+  // every message is consumed by a single receiver, so there is no need to wake up the others.
+  // We notify while holding the lock because the receiver erases the TokenQueue once it is done with it
+  if (token_queue.num_waiters > 0) {
+    token_queue.condition_variable.notify_one();
+  }
 }
 
 }  // namespace transport
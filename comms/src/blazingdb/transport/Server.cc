@@ -97,10 +97,11 @@ namespace {
 	"LAST" this represent a last event used to indicate that there is 
 	not going to be more message with the same message_token
 	"" 
+	Messages are read by num_workers threads at the same time, see TCPServerSocket.
 */ 
 class ServerTCP : public Server {
 public:
-	ServerTCP(unsigned short port) : server_socket{port} {}
+	ServerTCP(unsigned short port, int num_workers) : server_socket{port}, num_workers{num_workers} {}
 
 	void SetDevice(int gpuId) override { this->gpuId = gpuId; }
 
@@ -124,30 +125,18 @@ protected:
 
 	BlazingThread thread;
 
+	int num_workers;
+
 	int gpuId{0};
 };
 Message::MetaData collect_last_event(void * socket, Server * server) {
-	zmq::socket_t * socket_ptr = (zmq::socket_t *) socket;
-	Message::MetaData message_metadata = read_metadata<Message::MetaData>(socket);
-
-	zmq::message_t local_message;
-	auto success = socket_ptr->recv(local_message);
-	if(success.value() == false || local_message.size() == 0) {
-		throw zmq::error_t();
-	}
-	std::string ok_message(static_cast<char *>(local_message.data()), local_message.size());
-
-	assert(ok_message == "OK");
-	blazingdb::transport::io::writeToSocket(socket, "END", 3, false);
-
-	return message_metadata;
+	return read_metadata<Message::MetaData>(socket);
 }
 
 template <typename buffer_container_type = std::vector<rmm::device_buffer>>
 std::tuple<Message::MetaData, Address::MetaData, std::vector<ColumnTransport>, buffer_container_type>
 collect_gpu_message(
 	void * socket, int gpuId, void (*read_tpc_message)(std::vector<std::size_t>, void *, int, buffer_container_type &)) {
-	zmq::socket_t * socket_ptr = (zmq::socket_t *) socket;
 	// begin of message
 	Message::MetaData message_metadata = read_metadata<Message::MetaData>(socket);
 	Address::MetaData address_metadata = read_metadata<Address::MetaData>(socket);
@@ -164,24 +153,7 @@ collect_gpu_message(
 
 	buffer_container_type raw_columns;
 	read_tpc_message(buffer_sizes, socket, gpuId, raw_columns);
-
-	int data_past_topic{0};
-	auto data_past_topic_size{sizeof(data_past_topic)};
-	socket_ptr->getsockopt(ZMQ_RCVMORE, &data_past_topic, &data_past_topic_size);
-	if(data_past_topic == 0 || data_past_topic_size == 0) {
-		throw std::runtime_error("ZQMServer: No data inside message.");
-	}
-	// receive the ok
-	zmq::message_t local_message;
-	auto success = socket_ptr->recv(local_message);
-	if(success.value() == false || local_message.size() == 0) {
-		throw std::runtime_error("ZQMServer: success.value() == false");
-	}
-
-	std::string ok_message(static_cast<char *>(local_message.data()), local_message.size());
-	assert(ok_message == "OK");
-	blazingdb::transport::io::writeToSocket(socket, "END", 3, false);
-	// end of message
+	// end of message, the socket acknowledges it once it was stored
 	return std::make_tuple(message_metadata, address_metadata, column_offsets, raw_columns);
 }
 
@@ -217,10 +189,10 @@ void ServerTCP::Run() {
 				}
 			} catch(const std::runtime_error & exception) {
 				std::cerr << "[ERROR] " << exception.what() << std::endl;
-				// TODO: write failure
-				throw exception;
+				// the socket acknowledges the message as failed
+				throw;
 			}
-		});
+		}, num_workers);
 	});
 	std::this_thread::yield();
 }
@@ -238,7 +210,7 @@ void ServerTCP::Run() {
 */ 
 class ServerForBatchProcessing : public ServerTCP {
 public:
-	ServerForBatchProcessing(unsigned short port) : ServerTCP(port) {}
+	ServerForBatchProcessing(unsigned short port, int num_workers) : ServerTCP(port, num_workers) {}
 
 	void Run() override {
 		thread = BlazingThread([this]() {
@@ -282,10 +254,10 @@ public:
 					}
 				} catch(const std::runtime_error & exception) {
 					std::cerr << "[ERROR] " << exception.what() << std::endl;
-					// TODO: write failure
-					throw exception;
+					// the socket acknowledges the message as failed
+					throw;
 				}
-			});
+			}, num_workers);
 		});
 		std::this_thread::yield();
 	} 
@@ -293,10 +265,12 @@ public:
 
 }  // namespace
 
-std::unique_ptr<Server> Server::TCP(unsigned short port) { return std::unique_ptr<Server>(new ServerTCP(port)); }
+std::unique_ptr<Server> Server::TCP(unsigned short port, int num_workers) {
+	return std::unique_ptr<Server>(new ServerTCP(port, num_workers));
+}
 
-std::unique_ptr<Server> Server::BatchProcessing(unsigned short port) {
-	return std::unique_ptr<Server>(new ServerForBatchProcessing(port));
+std::unique_ptr<Server> Server::BatchProcessing(unsigned short port, int num_workers) {
+	return std::unique_ptr<Server>(new ServerForBatchProcessing(port, num_workers));
 }
 
 }  // namespace transport
@@ -3,6 +3,7 @@
 #include <cuda_runtime_api.h>
 #include "blazingdb/transport/io/fd_reader_writer.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
@@ -10,15 +11,13 @@
 #include <thread>
 #include <vector>
 
+#include <algorithm>
 #include <cassert>
-#include <queue>
+#include <stdexcept>
 #include "blazingdb/transport/ColumnTransport.h"
 #include "blazingdb/concurrency/BlazingThread.h"
 #include <rmm/device_buffer.hpp>
 
-#include "../engine/src/CodeTimer.h"
-using namespace std::chrono_literals;
-
 #include <spdlog/spdlog.h>
 using namespace fmt::literals;
 
@@ -52,20 +51,39 @@ PinnedBufferProvider::~PinnedBufferProvider(){
 // TODO: consider adding some kind of priority
 // based on when the request was made
 PinnedBuffer *PinnedBufferProvider::getBuffer() {
-  std::unique_lock<std::mutex> lock(inUseMutex);
+  using Clock = std::chrono::high_resolution_clock;
+  auto begin = Clock::now();
+  std::unique_lock<std::mutex> lock(inUseMutex, std::try_to_lock);
+  bool waited = !lock.owns_lock();
+  if (waited) {
+    lock.lock();
+  }
   if (this->buffers.empty()) {
     //if (this->buffer_counter >= 100){
     //    cv.wait(lock, [this] { return !this->buffers.empty(); });        
     //}else{
         this->grow();
+        waited = true;
     //}
     
   }
   PinnedBuffer *temp = this->buffers.top();
   this->buffers.pop();
+  WaitObserver observer = waited ? this->waitObserver : nullptr;
+  lock.unlock();
+
+  if (observer) {
+    observer(std::chrono::duration_cast<std::chrono::microseconds>(begin.time_since_epoch()).count(),
+             std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count());
+  }
   return temp;
 }
 
+void PinnedBufferProvider::setWaitObserver(WaitObserver observer) {
+  std::lock_guard<std::mutex> lock(inUseMutex);
+  this->waitObserver = observer;
+}
+
 
 // Will create a new allocation and grow the buffer pool with this->numBuffers/2 new buffers
 // Its not threadsafe and the lock needs to be applied before calling it
@@ -125,154 +143,127 @@ void setPinnedBufferProvider(std::size_t sizeBuffers, std::size_t numBuffers) {
 
 PinnedBufferProvider &getPinnedBufferProvider() { return *global_instance; }
 
-void writeBuffersFromGPUTCP(std::vector<ColumnTransport> &column_transport,
-                            std::vector<std::size_t> bufferSizes,
-                            std::vector<const char *> buffers, void *fileDescriptor,
-                            int gpuNum) {
+namespace {
+
+// Number of pinned chunks a single send can have being copied or waiting to be written.
+// It bounds the pinned memory used by one send no matter how many columns the table has.
+constexpr std::size_t MAX_CHUNKS_IN_FLIGHT = 4;
+
+struct chunk_in_flight {
+  PinnedBuffer *pinned{nullptr};
+  cudaEvent_t copied{};
+};
+
+}  // namespace
+
+void writeBuffersFromGPU(std::vector<ColumnTransport> &column_transport,
+                         std::vector<std::size_t> bufferSizes,
+                         std::vector<const char *> buffers, ChunkWriter write,
+                         int gpuNum) {
   if (bufferSizes.size() == 0) {
     return;
   }
-  struct queue_item {
-    std::size_t bufferIndex{};
-    std::size_t chunkIndex{};
-    PinnedBuffer *chunk{nullptr};
-    std::size_t chunk_size{};
-
-    bool operator<(const queue_item &item) const {
-      if (bufferIndex == item.bufferIndex) {
-        return chunkIndex > item.chunkIndex;
-      } else {
-        return bufferIndex > item.bufferIndex;
-      }
-    }
+  cudaSetDevice(gpuNum);
 
-    bool operator==(const queue_item &item) const {
-      return ((bufferIndex == item.bufferIndex) &&
-              (chunkIndex == item.chunkIndex));
-    }
+  // Every chunk is sent as its own message, and the receiver reads them back with the same chunk size.
+  // Empty buffers are still sent as one empty chunk.
+  struct chunk {
+    const char *data;
+    std::size_t size;
   };
-  std::priority_queue<queue_item> writePairs;
-  std::condition_variable cv;
-  std::mutex writeMutex;
-  std::vector<char *> tempReadAllocations(bufferSizes.size());
-  std::vector<BlazingThread> copyThreads(bufferSizes.size());
-  std::size_t amountWrittenTotalTotal = 0;
-
-  std::vector<queue_item> writeOrder;
-  for (size_t bufferIndex = 0; bufferIndex < bufferSizes.size();
-       bufferIndex++) {
-    std::size_t amountWrittenTotal = 0;
-    size_t chunkIndex = 0;
+  std::size_t chunkSize = getPinnedBufferProvider().sizeBuffers();
+  std::vector<chunk> writeOrder;
+  for (size_t bufferIndex = 0; bufferIndex < bufferSizes.size(); bufferIndex++) {
+    std::size_t position = 0;
     do {
-      writeOrder.push_back(
-          {.bufferIndex = bufferIndex, .chunkIndex = chunkIndex});
-      amountWrittenTotal += getPinnedBufferProvider().sizeBuffers();
-      chunkIndex++;
-    } while (amountWrittenTotal < bufferSizes[bufferIndex]);
+      std::size_t amountToWrite = std::min(chunkSize, bufferSizes[bufferIndex] - position);
+      writeOrder.push_back({buffers[bufferIndex] + position, amountToWrite});
+      position += amountToWrite;
+    } while (position < bufferSizes[bufferIndex]);
   }
 
-  // buffer is from gpu or is from cpu
-  for (size_t bufferIndex = 0; bufferIndex < bufferSizes.size();
-       bufferIndex++) {
-    copyThreads[bufferIndex] = BlazingThread(
-        [bufferIndex, &cv, &amountWrittenTotalTotal, &writeMutex, &buffers,
-         &writePairs, &writeOrder, &bufferSizes, &tempReadAllocations,
-         fileDescriptor, gpuNum]() {
-          cudaSetDevice(gpuNum);
-          std::size_t amountWrittenTotal = 0;
-          size_t chunkIndex = 0;
-          do {
-            PinnedBuffer *buffer = getPinnedBufferProvider().getBuffer();
-            std::size_t amountToWrite;
-            if ((bufferSizes[bufferIndex] - amountWrittenTotal) > buffer->size)
-              amountToWrite = buffer->size;
-            else
-              amountToWrite = bufferSizes[bufferIndex] - amountWrittenTotal;
-
-            cudaSetDevice(gpuNum);
-            cudaMemcpyAsync(buffer->data,
-                            buffers[bufferIndex] + amountWrittenTotal,
-                            amountToWrite, cudaMemcpyDeviceToHost, nullptr);
-            cudaStreamSynchronize(nullptr);
-            {
-              std::unique_lock<std::mutex> lock(writeMutex);
-              writePairs.push(queue_item{.bufferIndex = bufferIndex,
-                                         .chunkIndex = chunkIndex,
-                                         .chunk = buffer,
-                                         .chunk_size = amountToWrite});
-              chunkIndex++;
-              amountWrittenTotal += amountToWrite;
-              cv.notify_one();
-            }
-          } while (amountWrittenTotal < bufferSizes[bufferIndex]);
-          {
-            std::lock_guard<std::mutex> lock(writeMutex);
-            amountWrittenTotalTotal += amountWrittenTotal;
-          }
-        });
+  // The copies run in order on their own stream while this thread writes the chunks that are already
+  // in host memory, so the copy of chunk N+1 overlaps the socket write of chunk N.
+  cudaStream_t stream;
+  cudaError_t err = cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+  if (err != cudaSuccess) {
+    throw std::runtime_error("writeBuffersFromGPU: could not create the copy stream: " +
+                             std::string(cudaGetErrorString(err)));
+  }
+  std::vector<chunk_in_flight> inFlight(std::min(MAX_CHUNKS_IN_FLIGHT, writeOrder.size()));
+  for (std::size_t slotIndex = 0; slotIndex < inFlight.size(); slotIndex++) {
+    err = cudaEventCreateWithFlags(&inFlight[slotIndex].copied, cudaEventDisableTiming);
+    if (err != cudaSuccess) {
+      for (std::size_t created = 0; created < slotIndex; created++) {
+        cudaEventDestroy(inFlight[created].copied);
+      }
+      cudaStreamDestroy(stream);
+      throw std::runtime_error("writeBuffersFromGPU: could not create the copy event: " +
+                               std::string(cudaGetErrorString(err)));
+    }
   }
 
-  BlazingThread writeThread =
-      BlazingThread([fileDescriptor, &writePairs, &bufferSizes, writeOrder,
-                   &writeMutex, &cv] {
-        PinnedBuffer *buffer = nullptr;
-        std::size_t amountToWrite;
-        queue_item item;
-        std::size_t writeIndex = 0;
-        bool started = false;
-        do {
-          {
-            CodeTimer blazing_timer;
-            std::unique_lock<std::mutex> lock(writeMutex);
-            while(!cv.wait_for(lock, 60000ms, [&writePairs, &writeOrder, writeIndex, &blazing_timer] {
-                bool wrote = !writePairs.empty() &&
-                      writeOrder[writeIndex] == writePairs.top();
-                
-                if (!wrote && blazing_timer.elapsed_time() > 59000){
-                  auto logger = spdlog::get("batch_logger");
-                  logger->warn("|||{info}|{duration}||||",
-                              "info"_a="writeBuffersFromGPUTCP timed out",
-                              "duration"_a=blazing_timer.elapsed_time());
-                }
-                return wrote;
-              })){}
-
-            item = writePairs.top();
-            amountToWrite = item.chunk_size;
-            buffer = item.chunk;
-            started = false;
-            writePairs.pop();
-          }
-
-          if (buffer != nullptr) {
-            std::lock_guard<std::mutex> lock(writeMutex);
-            std::size_t amountWritten = blazingdb::transport::io::writeToSocket(
-                fileDescriptor, (char *)buffer->data, amountToWrite);
-            writeIndex++;
-            if (amountWritten != amountToWrite) {
-              getPinnedBufferProvider().freeBuffer(buffer);
-              throw std::exception();
-            }
-            getPinnedBufferProvider().freeBuffer(buffer);
-          }
-        } while (writeIndex < writeOrder.size());
-      });
+  auto startCopy = [&](std::size_t chunkIndex) {
+    chunk_in_flight &slot = inFlight[chunkIndex % inFlight.size()];
+    slot.pinned = getPinnedBufferProvider().getBuffer();
+    // buffer is from gpu or is from cpu
+    cudaMemcpyAsync(slot.pinned->data, writeOrder[chunkIndex].data,
+                    writeOrder[chunkIndex].size, cudaMemcpyDefault, stream);
+    cudaEventRecord(slot.copied, stream);
+  };
 
-  for (std::size_t threadIndex = 0; threadIndex < copyThreads.size();
-       threadIndex++) {
-    copyThreads[threadIndex].join();
-  }
-  {
-    std::unique_lock<std::mutex> lock(writeMutex);
-    writePairs.push({.bufferIndex = INT_MAX,
-                     .chunkIndex = INT_MAX,
-                     .chunk = nullptr,
-                     .chunk_size = amountWrittenTotalTotal});
-    cv.notify_one();
+  auto releaseAll = [&]() {
+    cudaStreamSynchronize(stream);
+    for (auto &slot : inFlight) {
+      if (slot.pinned != nullptr) {
+        getPinnedBufferProvider().freeBuffer(slot.pinned);
+        slot.pinned = nullptr;
+      }
+      cudaEventDestroy(slot.copied);
+    }
+    cudaStreamDestroy(stream);
+  };
+
+  try {
+    for (std::size_t chunkIndex = 0; chunkIndex < inFlight.size(); chunkIndex++) {
+      startCopy(chunkIndex);
+    }
+    for (std::size_t chunkIndex = 0; chunkIndex < writeOrder.size(); chunkIndex++) {
+      chunk_in_flight &slot = inFlight[chunkIndex % inFlight.size()];
+      err = cudaEventSynchronize(slot.copied);
+      if (err != cudaSuccess) {
+        throw std::runtime_error("writeBuffersFromGPU: copy to pinned memory failed: " +
+                                 std::string(cudaGetErrorString(err)));
+      }
+
+      std::size_t amountToWrite = writeOrder[chunkIndex].size;
+      std::size_t amountWritten = write((char *)slot.pinned->data, amountToWrite);
+      getPinnedBufferProvider().freeBuffer(slot.pinned);
+      slot.pinned = nullptr;
+      if (amountWritten != amountToWrite) {
+        throw std::runtime_error("writeBuffersFromGPU: could not write the whole chunk");
+      }
+
+      if (chunkIndex + inFlight.size() < writeOrder.size()) {
+        startCopy(chunkIndex + inFlight.size());
+      }
+    }
+  } catch (...) {
+    releaseAll();
+    throw;
   }
-  writeThread.join();
-  PinnedBuffer *buffer = getPinnedBufferProvider().getBuffer();
-  getPinnedBufferProvider().freeBuffer(buffer);
+  releaseAll();
+}
+
+void writeBuffersFromGPUTCP(std::vector<ColumnTransport> &column_transport,
+                            std::vector<std::size_t> bufferSizes,
+                            std::vector<const char *> buffers, void *fileDescriptor,
+                            int gpuNum) {
+  writeBuffersFromGPU(column_transport, bufferSizes, buffers,
+                      [fileDescriptor](const char *data, std::size_t size) {
+                        return blazingdb::transport::io::writeToSocket(fileDescriptor, data, size);
+                      },
+                      gpuNum);
 }
 
 void readBuffersIntoGPUTCP(std::vector<std::size_t> bufferSizes,
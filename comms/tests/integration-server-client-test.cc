@@ -5,6 +5,7 @@
 #include <chrono>
 #include <memory>
 #include <thread>
+#include <vector>
 #include <rmm/device_buffer.hpp>
 
 namespace blazingdb {
@@ -56,9 +57,64 @@ public:
         message_metadata.contextToken, node, message_metadata.total_row_size);
   }
 
+  static std::shared_ptr<ReceivedMessage> MakeFromHost(
+      const Message::MetaData &message_metadata,
+      const Address::MetaData &address_metadata,
+      const std::vector<ColumnTransport> &columns_offsets,
+      std::vector<std::basic_string<char>> &&raw_buffers) {
+    Node node(
+        Address::TCP(address_metadata.ip, address_metadata.comunication_port,
+                     address_metadata.protocol_port));
+    return std::make_shared<ReceivedDeviceMessage>(
+        message_metadata.contextToken, node, message_metadata.total_row_size);
+  }
+
   DefineClassName(ComponentMessage);
 };
 
+// Several threads share a client with a few messages in flight, and the
+// server reads them with several workers. The last event must still be
+// stored after every message sent before it.
+TEST(ServerClientTCP, MessagesInFlightAreStoredBeforeTheLastEvent) {
+  constexpr unsigned short port = 8001;
+  constexpr int num_threads = 4;
+  constexpr int messages_per_thread = 50;
+
+  std::unique_ptr<Server> server = Server::BatchProcessing(port, 4);
+  auto endpoint = ComponentMessage::MessageID();
+  server->registerEndPoint(endpoint);
+  server->registerContext(context_token);
+  server->registerHostDeserializerForEndPoint(ComponentMessage::MakeFromHost, endpoint);
+  server->Run();
+
+  Node node(Address::TCP("localhost", port, 9999));
+  auto client = blazingdb::transport::ClientTCP::Make("localhost", port, 4);
+  std::vector<std::thread> senders;
+  for (int thread = 0; thread < num_threads; thread++) {
+    senders.emplace_back([&client, &node]() {
+      ComponentMessage message{context_token, node, 0};
+      for (int i = 0; i < messages_per_thread; i++) {
+        EXPECT_TRUE(client->Send(message).IsOk());
+      }
+    });
+  }
+  for (auto &sender : senders) {
+    sender.join();
+  }
+  ComponentMessage message{context_token, node, 0};
+  EXPECT_TRUE(client->notifyLastMessageEvent(message.metadata()));
+
+  for (int i = 0; i < num_threads * messages_per_thread; i++) {
+    EXPECT_NE(server->getMessage(context_token, endpoint), nullptr);
+  }
+  // the sentinel of the last event
+  EXPECT_EQ(server->getMessage(context_token, endpoint), nullptr);
+  EXPECT_TRUE(client->Flush());
+
+  client->Close();
+  server->Close();
+}
+
 void ExecMaster(){
  // Create server
   std::unique_ptr<Server> server = Server::BatchProcessing(8000);
@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+#include <blazingdb/transport/io/fd_reader_writer.h>
+#include <blazingdb/transport/io/reader_writer.h>
+#include <cuda_runtime_api.h>
+
+#include <rmm/device_buffer.hpp>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+
+// Loopback throughput of the GPU buffer transport: a table of num_columns
+// device buffers is sent with writeBuffersFromGPUTCP over a zmq tcp socket
+// on 127.0.0.1 and read back into device memory by a receiver thread.
+// Wide tables with small columns stress the per buffer overhead of the
+// sender, a few big columns stress the copy/write overlap.
+
+namespace {
+
+constexpr std::size_t PINNED_BUFFER_SIZE = 1048576;
+constexpr std::size_t PINNED_NUM_BUFFERS = 100;
+
+std::string receive_string(zmq::socket_t &socket) {
+  zmq::message_t message;
+  socket.recv(message);
+  return std::string(static_cast<char *>(message.data()), message.size());
+}
+
+void run_receiver(zmq::socket_t &socket, const std::vector<std::size_t> &buffer_sizes) {
+  while (true) {
+    std::string topic = receive_string(socket);
+    if (topic == "STOP") {
+      blazingdb::transport::io::writeToSocket(&socket, "END", 3, false);
+      break;
+    }
+    std::vector<rmm::device_buffer> received;
+    blazingdb::transport::io::readBuffersIntoGPUTCP(buffer_sizes, &socket, 0, received);
+    receive_string(socket);  // OK
+    blazingdb::transport::io::writeToSocket(&socket, "END", 3, false);
+  }
+}
+
+}  // namespace
+
+static void BM_LoopbackSend(benchmark::State &state) {
+  std::size_t num_columns = state.range(0);
+  std::size_t column_bytes = state.range(1);
+
+  cudaSetDevice(0);
+  // replacing the provider would free the buffers of the new one, so it is set once for all the runs
+  static std::once_flag pinned_buffers_initialized;
+  std::call_once(pinned_buffers_initialized, [] {
+    blazingdb::transport::io::setPinnedBufferProvider(PINNED_BUFFER_SIZE, PINNED_NUM_BUFFERS);
+  });
+
+  std::vector<rmm::device_buffer> columns;
+  std::vector<std::size_t> buffer_sizes;
+  std::vector<const char *> buffers;
+  for (std::size_t index = 0; index < num_columns; index++) {
+    columns.emplace_back(column_bytes);
+    cudaMemset(columns.back().data(), (int)index, column_bytes);
+  }
+  for (auto &column : columns) {
+    buffer_sizes.push_back(column.size());
+    buffers.push_back((const char *)column.data());
+  }
+  std::vector<blazingdb::transport::ColumnTransport> column_transport(num_columns);
+
+  zmq::context_t context(1);
+  zmq::socket_t receiver_socket(context, ZMQ_REP);
+  zmq::socket_t sender_socket(context, ZMQ_REQ);
+  receiver_socket.bind("tcp://127.0.0.1:*");
+  char endpoint[256];
+  size_t endpoint_size = sizeof(endpoint);
+  receiver_socket.getsockopt(ZMQ_LAST_ENDPOINT, endpoint, &endpoint_size);
+  sender_socket.connect(endpoint);
+
+  std::thread receiver([&receiver_socket, &buffer_sizes] {
+    cudaSetDevice(0);
+    run_receiver(receiver_socket, buffer_sizes);
+  });
+
+  for (auto _ : state) {
+    blazingdb::transport::io::writeToSocket(&sender_socket, "GPUS", 4);
+    blazingdb::transport::io::writeBuffersFromGPUTCP(column_transport, buffer_sizes, buffers, &sender_socket, 0);
+    blazingdb::transport::io::writeToSocket(&sender_socket, "OK", 2, false);
+    receive_string(sender_socket);  // END
+  }
+
+  blazingdb::transport::io::writeToSocket(&sender_socket, "STOP", 4, false);
+  receive_string(sender_socket);
+  receiver.join();
+
+  state.SetBytesProcessed(state.iterations() * num_columns * column_bytes);
+  state.counters["columns"] = num_columns;
+}
+BENCHMARK(BM_LoopbackSend)
+    ->Args({1, 256 << 20})
+    ->Args({16, 16 << 20})
+    ->Args({128, 2 << 20})
+    ->Args({512, 512 << 10})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
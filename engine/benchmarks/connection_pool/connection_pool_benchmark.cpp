@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <blazingdb/transport/Client.h>
+#include <blazingdb/transport/Server.h>
+
+#include "communication/network/ConnectionPool.h"
+
+using namespace ral::communication::network;
+
+// Small message throughput to a transport server on loopback, opening a
+// connection per message (what Client::send used to do) against reusing the
+// connections of a ConnectionPool. The messages carry no columns, so the
+// numbers only measure the transport. Run it with several threads to see the
+// effect of the per peer connection limit and of the messages in flight.
+
+namespace {
+
+const std::string PEER_IP = "127.0.0.1";
+const int16_t PEER_PORT = 22555;
+const std::string MESSAGE_TOKEN = "benchmark-message";
+const uint32_t CONTEXT_TOKEN = 0;
+
+class EmptyMessage : public blazingdb::transport::GPUMessage {
+public:
+	EmptyMessage(const blazingdb::transport::Node & node) : GPUMessage(MESSAGE_TOKEN, CONTEXT_TOKEN, node) {}
+
+	raw_buffer GetRawColumns() override {
+		return raw_buffer{};
+	}
+};
+
+std::shared_ptr<blazingdb::transport::ReceivedMessage> make_received_message(
+	const blazingdb::transport::Message::MetaData & message_metadata,
+	const blazingdb::transport::Address::MetaData & address_metadata,
+	const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets,
+	const std::vector<rmm::device_buffer> & raw_buffers) {
+	blazingdb::transport::Node node;
+	return std::make_shared<blazingdb::transport::ReceivedMessage>(message_metadata.messageToken, message_metadata.contextToken, node);
+}
+
+// the peer lives until the process exits
+void start_peer() {
+	static blazingdb::transport::Server * peer = [] {
+		auto server = blazingdb::transport::Server::TCP(PEER_PORT, std::thread::hardware_concurrency());
+		server->registerEndPoint(MESSAGE_TOKEN);
+		server->registerDeviceDeserializerForEndPoint(make_received_message, MESSAGE_TOKEN);
+		server->registerContext(CONTEXT_TOKEN);
+		server->Run();
+		return server.release();
+	}();
+}
+
+blazingdb::transport::Message::MetaData make_metadata() {
+	blazingdb::transport::Message::MetaData metadata;
+	MESSAGE_TOKEN.copy(metadata.messageToken, MESSAGE_TOKEN.size());
+	metadata.contextToken = CONTEXT_TOKEN;
+	return metadata;
+}
+
+}  // namespace
+
+static void BM_NewConnectionPerMessage(benchmark::State & state) {
+	start_peer();
+	auto metadata = make_metadata();
+	for(auto _ : state) {
+		auto client = blazingdb::transport::ClientTCP::Make(PEER_IP, PEER_PORT);
+		benchmark::DoNotOptimize(client->notifyLastMessageEvent(metadata));
+		client->Close();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NewConnectionPerMessage)->ThreadRange(1, 16)->UseRealTime();
+
+static std::unique_ptr<ConnectionPool> shared_pool;
+
+static void BM_PooledConnection(benchmark::State & state) {
+	start_peer();
+	if(state.thread_index == 0) {
+		shared_pool = std::make_unique<ConnectionPool>(state.range(0));
+	}
+	auto metadata = make_metadata();
+	for(auto _ : state) {
+		auto connection = shared_pool->acquire(PEER_IP, PEER_PORT);
+		benchmark::DoNotOptimize(connection->notifyLastMessageEvent(metadata));
+		connection.release();
+	}
+	state.SetItemsProcessed(state.iterations());
+	if(state.thread_index == 0) {
+		shared_pool.reset();
+	}
+}
+BENCHMARK(BM_PooledConnection)->Arg(1)->Arg(8)->ThreadRange(1, 16)->UseRealTime();
+
+// Messages that do not wait for the peer, up to range(1) of them in flight on each connection.
+static void BM_PooledSend(benchmark::State & state) {
+	start_peer();
+	if(state.thread_index == 0) {
+		shared_pool = std::make_unique<ConnectionPool>(state.range(0), 60000, state.range(1));
+	}
+	blazingdb::transport::Node node;
+	EmptyMessage message(node);
+	for(auto _ : state) {
+		auto connection = shared_pool->acquire(PEER_IP, PEER_PORT);
+		benchmark::DoNotOptimize(connection->Send(message));
+		connection.release();
+	}
+	state.SetItemsProcessed(state.iterations());
+	if(state.thread_index == 0) {
+		// all the threads are done sending, the flush waits for their messages too
+		shared_pool->flush(PEER_IP, PEER_PORT);
+		shared_pool.reset();
+	}
+}
+BENCHMARK(BM_PooledSend)->Args({1, 1})->Args({1, 16})->Args({8, 16})->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Interpreter/interpreter_host.h"
+
+using namespace interops;
+
+namespace {
+
+/**
+ * Two columns $0 INT32 and $1 FLOAT64, with nulls in $0 if with_nulls, and the plan of
+ * [+(*($0, 3), $1)], [>(+(*($0, 3), $1), 10)], [SIN($1)].
+ */
+struct host_interpreter_input {
+	std::vector<int32_t> a;
+	std::vector<double> b;
+	std::vector<cudf::bitmask_type> a_mask;
+	std::vector<double> out_sum;
+	std::unique_ptr<bool[]> out_greater;
+	std::vector<double> out_sin;
+	std::vector<std::vector<cudf::bitmask_type>> out_masks;
+
+	std::vector<host_column> table;
+	std::vector<mutable_host_column> out_table;
+
+	host_interpreter_input(cudf::size_type num_rows, bool with_nulls)
+		: a(num_rows), b(num_rows), a_mask((num_rows + 31) / 32, ~cudf::bitmask_type{0}), out_sum(num_rows),
+			out_greater(new bool[num_rows]), out_sin(num_rows), out_masks(3, std::vector<cudf::bitmask_type>((num_rows + 31) / 32)) {
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<int32_t> ints(-1000, 1000);
+		std::uniform_real_distribution<double> doubles(-1000, 1000);
+		for (cudf::size_type i = 0; i < num_rows; i++) {
+			a[i] = ints(generator);
+			b[i] = doubles(generator);
+			if (with_nulls && i % 10 == 0) {
+				a_mask[i / 32] &= ~(cudf::bitmask_type{1} << (i % 32));
+			}
+		}
+
+		table.resize(2);
+		table[0].type = cudf::data_type{cudf::type_id::INT32};
+		table[0].size = num_rows;
+		table[0].data = a.data();
+		table[0].null_mask = with_nulls ? a_mask.data() : nullptr;
+		table[1].type = cudf::data_type{cudf::type_id::FLOAT64};
+		table[1].size = num_rows;
+		table[1].data = b.data();
+
+		out_table.resize(3);
+		out_table[0] = mutable_host_column{cudf::data_type{cudf::type_id::FLOAT64}, num_rows, out_sum.data(), out_masks[0].data()};
+		out_table[1] = mutable_host_column{cudf::data_type{cudf::type_id::BOOL8}, num_rows, out_greater.get(), out_masks[1].data()};
+		out_table[2] = mutable_host_column{cudf::data_type{cudf::type_id::FLOAT64}, num_rows, out_sin.data(), out_masks[2].data()};
+	}
+};
+
+void run_host_interpreter(benchmark::State & state, int num_threads) {
+	const cudf::size_type num_rows = state.range(0);
+	host_interpreter_input input(num_rows, state.range(1) != 0);
+
+	host_scalar three;
+	three.type = cudf::data_type{cudf::type_id::INT32};
+	three.valid = true;
+	three.int_value = 3;
+	host_scalar ten = three;
+	ten.int_value = 10;
+
+	// registers: 0 = $0, 1 = $1, 2 = $0 * 3 + $1, 3 = $0 * 3 then > 10, 4 = SIN($1)
+	std::vector<column_index_type> left_inputs = {0, 3, 2, 1};
+	std::vector<column_index_type> right_inputs = {SCALAR_INDEX, 1, SCALAR_INDEX, UNARY_INDEX};
+	std::vector<column_index_type> outputs = {3, 2, 3, 4};
+	std::vector<column_index_type> final_output_positions = {2, 3, 4};
+	std::vector<operator_type> operators = {operator_type::BLZ_MUL, operator_type::BLZ_ADD, operator_type::BLZ_GREATER, operator_type::BLZ_SIN};
+	std::vector<host_scalar> left_scalars(4);
+	std::vector<host_scalar> right_scalars = {three, host_scalar{}, ten, host_scalar{}};
+	std::vector<column_index_type> final_output_ops = {1, 2, 3};
+
+	for (auto _ : state) {
+		perform_host_interpreter_operation(input.out_table, input.table, left_inputs, right_inputs, outputs,
+			final_output_positions, operators, left_scalars, right_scalars, final_output_ops, num_threads);
+		benchmark::DoNotOptimize(input.out_sum.data());
+	}
+	state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+void HostInterpreterSingleThread(benchmark::State & state) {
+	run_host_interpreter(state, 1);
+}
+
+void HostInterpreterAllThreads(benchmark::State & state) {
+	run_host_interpreter(state, 0);
+}
+
+void CustomArguments(benchmark::internal::Benchmark * b) {
+	for (int64_t rows = 1 << 10; rows <= 1 << 24; rows <<= 7) {
+		b->Args({rows, 0});
+		b->Args({rows, 1});
+	}
+}
+
+} // namespace
+
+BENCHMARK(HostInterpreterSingleThread)->Apply(CustomArguments)->Unit(benchmark::kMicrosecond);
+BENCHMARK(HostInterpreterAllThreads)->Apply(CustomArguments)->Unit(benchmark::kMicrosecond)->UseRealTime();
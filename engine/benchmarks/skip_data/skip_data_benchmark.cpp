@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <arrow/io/file.h>
+#include <parquet/api/writer.h>
+#include <parquet/exception.h>
+
+#include "io/data_parser/ParquetParser.h"
+#include "io/data_parser/metadata/parquet_metadata_cache.h"
+#include "skip_data/SkipDataProcessor.h"
+
+namespace {
+
+constexpr int NUM_ROW_GROUPS = 64;
+constexpr int ROWS_PER_ROW_GROUP = 8192;
+
+uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/**
+ * The key of a row, like a customer id or a uuid. Sorted keys grow with the row, the others are spread over all the row
+ * groups so their min and max do not prune anything.
+ */
+std::string make_id(int64_t row, bool sorted) {
+	char id[32];
+	std::snprintf(id, sizeof(id), "id-%016llx", static_cast<unsigned long long>(sorted ? row : mix(row)));
+	return id;
+}
+
+/**
+ * Writes a local file with a string key and an integer column, in NUM_ROW_GROUPS dictionary encoded row groups.
+ */
+std::string write_file(bool sorted) {
+	std::string path = std::string("/tmp/skip_data_benchmark_") + (sorted ? "sorted" : "random") + ".parquet";
+
+	parquet::schema::NodeVector fields;
+	fields.push_back(parquet::schema::PrimitiveNode::Make(
+		"id", parquet::Repetition::REQUIRED, parquet::Type::BYTE_ARRAY, parquet::ConvertedType::UTF8));
+	fields.push_back(parquet::schema::PrimitiveNode::Make(
+		"amount", parquet::Repetition::REQUIRED, parquet::Type::INT64, parquet::ConvertedType::NONE));
+	auto schema = std::static_pointer_cast<parquet::schema::GroupNode>(
+		parquet::schema::GroupNode::Make("schema", parquet::Repetition::REQUIRED, fields));
+
+	std::shared_ptr<arrow::io::FileOutputStream> out_file;
+	PARQUET_ASSIGN_OR_THROW(out_file, arrow::io::FileOutputStream::Open(path));
+	parquet::WriterProperties::Builder builder;
+	builder.enable_dictionary();
+	std::shared_ptr<parquet::ParquetFileWriter> file_writer = parquet::ParquetFileWriter::Open(out_file, schema, builder.build());
+
+	for (int row_group = 0; row_group < NUM_ROW_GROUPS; row_group++) {
+		parquet::RowGroupWriter * row_group_writer = file_writer->AppendRowGroup();
+		auto id_writer = static_cast<parquet::ByteArrayWriter *>(row_group_writer->NextColumn());
+		for (int i = 0; i < ROWS_PER_ROW_GROUP; i++) {
+			std::string id = make_id(int64_t{row_group} * ROWS_PER_ROW_GROUP + i, sorted);
+			parquet::ByteArray value(id.size(), reinterpret_cast<const uint8_t *>(id.data()));
+			id_writer->WriteBatch(1, nullptr, nullptr, &value);
+		}
+		auto amount_writer = static_cast<parquet::Int64Writer *>(row_group_writer->NextColumn());
+		for (int i = 0; i < ROWS_PER_ROW_GROUP; i++) {
+			int64_t amount = mix(i) % 1000;
+			amount_writer->WriteBatch(1, nullptr, nullptr, &amount);
+		}
+	}
+	file_writer->Close();
+	PARQUET_THROW_NOT_OK(out_file->Close());
+	return path;
+}
+
+/**
+ * Reads the metadata of a generated file and runs skip data for a point lookup of one of its keys, counting the row
+ * groups that are kept. Arguments: whether the keys are sorted, and the PARQUET_VALUE_FILTER_MAX_BYTES setting.
+ */
+void BM_SkipDataPointLookup(benchmark::State & state) {
+	bool sorted = state.range(0) != 0;
+	std::string path = write_file(sorted);
+	// no cache, so every iteration reads the metadata
+	ral::io::parquet_metadata_cache::getInstance().initialize(0, "", state.range(1));
+
+	std::shared_ptr<arrow::io::ReadableFile> file;
+	PARQUET_ASSIGN_OR_THROW(file, arrow::io::ReadableFile::Open(path));
+	ral::io::data_handle handle;
+	handle.fileHandle = file;
+	handle.uri = Uri{path};
+
+	std::string id = make_id(37 * ROWS_PER_ROW_GROUP + 100, sorted);
+	std::string table_scan = "BindableTableScan(table=[[main, t]], filters=[[=($0, '" + id + "')]], projects=[[0, 1]], aliases=[[id, amount]])";
+
+	ral::io::parquet_parser parser;
+	cudf::size_type kept_row_groups = NUM_ROW_GROUPS;
+	for (auto _ : state) {
+		std::unique_ptr<ral::frame::BlazingTable> metadata = parser.get_metadata({handle}, 0);
+		auto result = ral::skip_data::process_skipdata_for_table(metadata->toBlazingTableView(), {"id", "amount"}, table_scan);
+		kept_row_groups = result.second ? NUM_ROW_GROUPS : result.first->num_rows();
+	}
+
+	state.counters["row_groups"] = NUM_ROW_GROUPS;
+	state.counters["kept_row_groups"] = kept_row_groups;
+	ral::io::parquet_metadata_cache::getInstance().initialize(10000, "");
+	std::remove(path.c_str());
+}
+
+} // namespace
+
+BENCHMARK(BM_SkipDataPointLookup)
+	->Args({0, 0})
+	->Args({0, 16384})
+	->Args({1, 0})
+	->Args({1, 16384})
+	->Unit(benchmark::kMillisecond);
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "execution_graph/logic_controllers/CacheMachine.h"  // WaitingQueue
+#include "execution_graph/logic_controllers/LogicPrimitives.h"  // BlazingTable
+#include "execution_graph/logic_controllers/BlazingColumn.h"  // BlazingColumn
+
+using namespace ral;
+
+// Contention microbenchmarks for WaitingQueue. Run them with several threads,
+// e.g. --benchmark_filter=WaitingQueue to see how put/pop scale with the
+// number of producers and consumers.
+
+static std::unique_ptr<cache::message> createCacheMsg(std::string msgId) {
+	std::vector<std::unique_ptr<frame::BlazingColumn>> blazingColumns;
+	std::vector<std::string> colNames = {};
+	auto blazingTable = std::make_unique<frame::BlazingTable>(std::move(blazingColumns), colNames);
+	auto content = std::make_unique<cache::GPUCacheData>(std::move(blazingTable));
+	return std::make_unique<cache::message>(std::move(content), msgId);
+}
+
+static std::unique_ptr<cache::WaitingQueue> shared_queue;
+
+// Half of the threads put messages and the other half pop them, like TableScan
+// workers feeding a kernel.
+static void BM_WaitingQueuePutPop(benchmark::State & state) {
+	if(state.thread_index == 0) {
+		shared_queue = std::make_unique<cache::WaitingQueue>();
+	}
+	bool producer = state.thread_index % 2 == 0 || state.threads == 1;
+	for(auto _ : state) {
+		if(producer) {
+			shared_queue->put(createCacheMsg(""));
+		}
+		if(!producer || state.threads == 1) {
+			auto msg = shared_queue->pop_or_wait();
+			benchmark::DoNotOptimize(msg);
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+	if(state.thread_index == 0) {
+		// every thread runs the same number of iterations, this only makes sure no consumer is left waiting
+		shared_queue->finish();
+	}
+}
+BENCHMARK(BM_WaitingQueuePutPop)->ThreadRange(1, 32)->UseRealTime();
+
+// Every thread puts messages with its own ids and takes them back by id while
+// the queue holds the messages of all the other threads, like the network
+// receive path.
+static void BM_WaitingQueueGetById(benchmark::State & state) {
+	if(state.thread_index == 0) {
+		shared_queue = std::make_unique<cache::WaitingQueue>();
+		for(int i = 0; i < state.range(0); i++) {
+			shared_queue->put(createCacheMsg("background_" + std::to_string(i)));
+		}
+	}
+	std::string prefix = std::to_string(state.thread_index) + "_";
+	size_t message_index = 0;
+	for(auto _ : state) {
+		std::string message_id = prefix + std::to_string(message_index++);
+		shared_queue->put(createCacheMsg(message_id));
+		auto msg = shared_queue->get_or_wait(message_id);
+		benchmark::DoNotOptimize(msg);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WaitingQueueGetById)->Arg(0)->Arg(1000)->ThreadRange(1, 32)->UseRealTime();
+
+// Producers put while another thread keeps asking for the number of bytes queued,
+// like ConcatenatingCacheMachine and the flow control do.
+static void BM_WaitingQueueNumBytes(benchmark::State & state) {
+	if(state.thread_index == 0) {
+		shared_queue = std::make_unique<cache::WaitingQueue>();
+	}
+	for(auto _ : state) {
+		if(state.thread_index == 0) {
+			benchmark::DoNotOptimize(shared_queue->get_num_bytes());
+		} else {
+			shared_queue->put(createCacheMsg(""));
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WaitingQueueNumBytes)->ThreadRange(2, 32)->UseRealTime();
@@ -146,6 +146,14 @@ cdef extern from * namespace "blazing":
         """
         cdef T blaz_move[T](T) nogil
 
+cdef extern from "../src/utilities/Metrics.h" namespace "ral::utilities" nogil:
+        cdef struct MetricsSample:
+            string scope
+            int32_t query_id
+            int64_t id
+            string name
+            map[string, int64_t] values
+
 cdef extern from "../include/engine/engine.h" nogil:
 
         unique_ptr[ResultSet] performPartition(int masterIndex, vector[NodeMetaDataTCP] tcpMetadata, int ctxToken, BlazingTableView blazingTableView, vector[string] columnNames) except +raiseRunQueryError
@@ -162,6 +170,8 @@ cdef extern from "../include/engine/engine.h" nogil:
             vector[vector[int]] table_columns
         TableScanInfo getTableScanInfo(string logicalPlan)
 
+        vector[MetricsSample] getMetricsSnapshot()
+
 cdef extern from "../include/engine/initialize.h" nogil:
     cdef void initialize(int ralId, int gpuId, string network_iface_name, string ralHost, int ralCommunicationPort, bool singleNode, map[string,string] config_options,
                             string allocation_mode, size_t initial_pool_size, size_t maximum_pool_size, bool enable_logging) except +raiseInitializeError
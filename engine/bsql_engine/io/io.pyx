@@ -115,6 +115,11 @@ cdef cio.TableScanInfo getTableScanInfoPython(string logicalPlan) nogil:
         temp = cio.getTableScanInfo(logicalPlan)
     return temp
 
+cdef vector[cio.MetricsSample] getMetricsSnapshotPython() nogil:
+    with nogil:
+        temp = cio.getMetricsSnapshot()
+    return temp
+
 cdef void initializePython(int ralId, int gpuId, string network_iface_name, string ralHost, int ralCommunicationPort, bool singleNode, map[string,string] config_options, 
                             string allocation_mode, size_t initial_pool_size, size_t maximum_pool_size, bool enable_logging) nogil except *:
     with nogil:
@@ -465,6 +470,20 @@ cpdef getTableScanInfoCaller(logicalPlan):
     table_scans = [step.decode('utf-8') for step in temp.relational_algebra_steps]
     return table_names, table_scans
 
+cpdef getMetricsSnapshotCaller():
+    cdef vector[cio.MetricsSample] samples = getMetricsSnapshotPython()
+    metrics = []
+    for index in range(samples.size()):
+        values = samples[index].values
+        metrics.append({
+            'scope': samples[index].scope.decode('utf-8'),
+            'query_id': samples[index].query_id,
+            'id': samples[index].id,
+            'name': samples[index].name.decode('utf-8'),
+            'values': {key.decode('utf-8'): value for key, value in values.items()}
+        })
+    return metrics
+
 
 cpdef np_to_cudf_types_int(dtype):
     return <underlying_type_t_type_id> ( np_to_cudf_types[dtype])
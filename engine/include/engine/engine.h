@@ -6,6 +6,7 @@
 
 #include <execution_graph/logic_controllers/LogicPrimitives.h>
 #include "../../src/error.hpp"
+#include "../../src/utilities/Metrics.h"
 
 struct SkipDataResultSet {
 	std::vector<int> files;
@@ -53,6 +54,9 @@ std::unique_ptr<ResultSet> performPartition(
 	const ral::frame::BlazingTableView & table,
 	std::vector<std::string> column_names);
 
+// Returns the current values of the metrics of every kernel, cache and message type of the most recent queries
+std::vector<ral::utilities::MetricsSample> getMetricsSnapshot();
+
 extern "C" {
 std::pair<std::unique_ptr<PartitionedResultSet>, error_code_t> runQuery_C(int32_t masterIndex,
 	std::vector<NodeMetaDataTCP> tcpMetadata,
@@ -82,4 +86,6 @@ std::pair<std::unique_ptr<ResultSet>, error_code_t> performPartition_C(
 	int32_t ctxToken,
 	const ral::frame::BlazingTableView & table,
 	std::vector<std::string> column_names);
+
+std::pair<std::vector<ral::utilities::MetricsSample>, error_code_t> getMetricsSnapshot_C();
 } // extern "C"
@@ -112,10 +112,15 @@ std::vector<std::unique_ptr<ral::frame::BlazingTable>> execute_plan(std::vector<
 			if (it != config_options.end()){
 				max_kernel_run_threads = std::stoi(config_options["MAX_KERNEL_RUN_THREADS"]);
 			}
+			size_t executor_num_threads = 0; //default, kernels are not run as tasks
+			it = config_options.find("TASK_EXECUTOR_NUM_THREADS");
+			if (it != config_options.end()){
+				executor_num_threads = std::stoi(config_options["TASK_EXECUTOR_NUM_THREADS"]);
+			}
 
 			ral::MemoryMonitor mem_monitor(&tree, config_options);
 			mem_monitor.start();
-			query_graph->execute(max_kernel_run_threads);
+			query_graph->execute(max_kernel_run_threads, executor_num_threads);
 			mem_monitor.finalize();
 			output_frame = output.release();
 		}
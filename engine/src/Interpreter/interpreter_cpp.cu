@@ -4,11 +4,14 @@
 #include <cudf/table/table_view.hpp>
 #include <cudf/table/table_device_view.cuh>
 #include <stack>
+#include <numeric>
+#include <limits>
 #include <map>
 #include <regex>
 #include <random>
 
 #include "interpreter_ops.cuh"
+#include "register_allocation.h"
 #include "CalciteExpressionParsing.h"
 #include "error.hpp"
 #include <curand_kernel.h>
@@ -275,7 +278,7 @@ struct expr_to_plan_visitor : public ral::parser::node_visitor
 {
 public:
 	expr_to_plan_visitor(const std::map<column_index_type, column_index_type> & expr_idx_to_col_idx_map,
-											cudf::size_type start_processing_position,
+											cudf::size_type num_input_columns,
 											std::vector<column_index_type> & left_inputs,
 											std::vector<column_index_type> & right_inputs,
 											std::vector<column_index_type> & outputs,
@@ -283,48 +286,62 @@ public:
 											std::vector<std::unique_ptr<cudf::scalar>> & left_scalars,
 											std::vector<std::unique_ptr<cudf::scalar>> & right_scalars)
 		: expr_idx_to_col_idx_map{expr_idx_to_col_idx_map},
-			start_processing_position{start_processing_position},
+			num_input_columns{num_input_columns},
 			left_inputs{left_inputs},
 			right_inputs{right_inputs},
 			outputs{outputs},
 			operators{operators},
 			left_scalars{left_scalars},
-			right_scalars{right_scalars},
-			processing_space_free_(512, true)
+			right_scalars{right_scalars}
 	{
-		std::fill_n(processing_space_free_.begin(), start_processing_position, false);
 	}
 
 	void visit(const ral::parser::operad_node& node) override {
 		column_index_type position;
+		std::string key;
 		if (is_literal(node.value)) {
 			position = SCALAR_INDEX;
+			auto literal_node = static_cast<const ral::parser::literal_node*>(&node);
+			key = "L" + std::to_string(static_cast<int32_t>(literal_node->type().id())) + ":" + node.value;
 		} else {
 			position = expr_idx_to_col_idx_map.at(static_cast<const ral::parser::variable_node&>(node).index());
+			key = "V" + std::to_string(position);
 		}
 
 		node_to_processing_position_.insert({&node, position});
+		node_to_key_.insert({&node, key});
+		last_position_ = position;
 	}
 
 	void visit(const ral::parser::operator_node& node) override {
 		operator_type operation = map_to_operator_type(node.value);
+
+		// every value is computed once, so the subexpressions repeated within or across expressions are reused.
+		// Nullary operators (i.e. RAND) give a different value every time.
+		std::string key;
+		if(!is_nullary_operator(operation)) {
+			key = std::to_string(static_cast<int32_t>(operation)) + "(";
+			for (auto&& child : node.children) {
+				key += node_to_key_.at(child.get()) + ",";
+			}
+			key += ")";
+
+			auto it = computed_values_.find(key);
+			if (it != computed_values_.end()) {
+				node_to_processing_position_.insert({&node, it->second});
+				node_to_key_.insert({&node, "R" + std::to_string(it->second)});
+				last_position_ = it->second;
+				return;
+			}
+		}
+
 		operators.push_back(operation);
 		if(is_binary_operator(operation)) {
 			const ral::parser::node * left_operand = node.children[0].get();
 			column_index_type left_position = node_to_processing_position_.at(left_operand);
-			if(left_operand->type != ral::parser::node_type::LITERAL) {
-				if(left_position >= start_processing_position) {
-					processing_space_free_[left_position] = true;
-				}
-			}
 
 			const ral::parser::node * right_operand = node.children[1].get();
 			column_index_type right_position = node_to_processing_position_.at(right_operand);
-			if(right_operand->type != ral::parser::node_type::LITERAL) {
-				if(right_position >= start_processing_position) {
-					processing_space_free_[right_position] = true;
-				}
-			}
 
 			if(left_operand->type == ral::parser::node_type::LITERAL && right_operand->type == ral::parser::node_type::LITERAL) {
 				RAL_FAIL("Operations between literals is not supported");
@@ -361,9 +378,6 @@ public:
 			RAL_EXPECTS(left_operand->type != ral::parser::node_type::LITERAL, "Unary operations on literals is not supported");
 
 			column_index_type left_position = node_to_processing_position_.at(left_operand);
-			if(left_position >= start_processing_position) {
-				processing_space_free_[left_position] = true;
-			}
 
 			left_inputs.push_back(left_position);
 			right_inputs.push_back(UNARY_INDEX);
@@ -377,29 +391,31 @@ public:
 			right_scalars.emplace_back(nullptr);
 		}
 
-		column_index_type position = get_first_open_position(start_processing_position);
+		// one virtual register per value, the registers are assigned once the whole plan is made
+		RAL_EXPECTS(num_input_columns + outputs.size() < std::numeric_limits<column_index_type>::max(), "Interops plan has too many operations");
+		column_index_type position = static_cast<column_index_type>(num_input_columns + outputs.size());
 		node_to_processing_position_.insert({&node, position});
+		node_to_key_.insert({&node, "R" + std::to_string(position)});
+		if(!key.empty()) {
+			computed_values_.insert({key, position});
+		}
 		outputs.push_back(position);
+		last_position_ = position;
 	}
 
-private:
-	column_index_type get_first_open_position(cudf::size_type start_position) {
-		assert(processing_space_free_.size() <= std::numeric_limits<column_index_type>().max());
-
-		for(size_t i = start_position; i < processing_space_free_.size(); i++) {
-			if(processing_space_free_[i]) {
-				processing_space_free_[i] = false;
-				return static_cast<column_index_type>(i);
-			}
-		}
-		return -1;
-	}
+	/**
+	 * The position of the value of the last node visited, which is the root of the last expression.
+	 */
+	column_index_type last_position() const { return last_position_; }
 
-	std::vector<bool> processing_space_free_;  // A place to store whether or not a processing space is occupied at any point in time
+private:
 	std::map<const ral::parser::node*, column_index_type> node_to_processing_position_;
+	std::map<const ral::parser::node*, std::string> node_to_key_;
+	std::map<std::string, column_index_type> computed_values_;  // The virtual register of every value computed so far
+	column_index_type last_position_ = -1;
 
 	const std::map<column_index_type, column_index_type> & expr_idx_to_col_idx_map;
-	cudf::size_type start_processing_position;
+	cudf::size_type num_input_columns;
 
 	std::vector<column_index_type> & left_inputs;
 	std::vector<column_index_type> & right_inputs;
@@ -410,31 +426,36 @@ private:
 };
 
 /**
- * Creates a physical plan for the expression that can be added to the total plan
+ * Creates the physical plan of all the expressions evaluated together
  */
-void add_expression_to_interpreter_plan(const ral::parser::parse_tree & expr_tree,
+void add_expressions_to_interpreter_plan(const std::vector<ral::parser::parse_tree> & expr_trees,
 	const std::map<column_index_type, column_index_type> & expr_idx_to_col_idx_map,
-	cudf::size_type start_processing_position,
-	cudf::size_type final_output_position,
+	cudf::size_type num_input_columns,
 	std::vector<column_index_type> & left_inputs,
 	std::vector<column_index_type> & right_inputs,
 	std::vector<column_index_type> & outputs,
+	std::vector<column_index_type> & final_output_positions,
+	std::vector<column_index_type> & final_output_ops,
 	std::vector<operator_type> & operators,
 	std::vector<std::unique_ptr<cudf::scalar>> & left_scalars,
 	std::vector<std::unique_ptr<cudf::scalar>> & right_scalars) {
 
 	expr_to_plan_visitor visitor{expr_idx_to_col_idx_map,
-															start_processing_position,
+															num_input_columns,
 															left_inputs,
 															right_inputs,
 															outputs,
 															operators,
 															left_scalars,
 															right_scalars};
-	expr_tree.visit(visitor);
 
-	// Update final output position
-	outputs.back() = final_output_position;
+	std::vector<column_index_type> final_outputs;
+	for (auto&& expr_tree : expr_trees) {
+		expr_tree.visit(visitor);
+		final_outputs.push_back(visitor.last_position());
+	}
+
+	allocate_registers(num_input_columns, left_inputs, right_inputs, outputs, final_outputs, final_output_positions, final_output_ops);
 }
 
 void perform_interpreter_operation(cudf::mutable_table_view & out_table,
@@ -446,7 +467,8 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	const std::vector<operator_type> & operators,
 	const std::vector<std::unique_ptr<cudf::scalar>> & left_scalars,
 	const std::vector<std::unique_ptr<cudf::scalar>> & right_scalars,
-	cudf::size_type operation_num_rows) {
+	cudf::size_type operation_num_rows,
+	const std::vector<column_index_type> & final_output_ops) {
 	using namespace detail;
 	cudaStream_t stream = 0;
 
@@ -463,9 +485,23 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	auto max_right_it = std::max_element(right_inputs.begin(), right_inputs.end());
 	auto max_out_it = std::max_element(outputs.begin(), outputs.end());
 
-	RAL_EXPECTS(std::max(std::max(*max_left_it, *max_right_it), *max_out_it) < 64, "Interops does not support plans with an input or output index greater than 63");
-
-	column_index_type max_output = *max_out_it;
+	RAL_EXPECTS(std::max(std::max(*max_left_it, *max_right_it), *max_out_it) < 64 && table.num_columns() <= 64, "Interops does not support plans with an input or output index greater than 63");
+
+	// the input columns are loaded in the first registers, which the plan may not use all of
+	column_index_type max_output = std::max(*max_out_it, static_cast<column_index_type>(table.num_columns() - 1));
+
+	// the output columns are written in the order they are computed, each one after its operation
+	std::vector<column_index_type> output_write_order(final_output_positions.size());
+	std::iota(output_write_order.begin(), output_write_order.end(), 0);
+	std::vector<column_index_type> output_write_ops(final_output_positions.size(), static_cast<column_index_type>(operators.size() - 1));
+	if (!final_output_ops.empty()) {
+		std::stable_sort(output_write_order.begin(), output_write_order.end(), [&final_output_ops](column_index_type a, column_index_type b) {
+			return final_output_ops[a] < final_output_ops[b];
+		});
+		for (size_t i = 0; i < output_write_order.size(); i++) {
+			output_write_ops[i] = final_output_ops[output_write_order[i]];
+		}
+	}
 
 	size_t shared_memory_per_thread = (max_output + 1) * sizeof(int64_t);
 
@@ -555,6 +591,8 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	rmm::device_vector<column_index_type> right_device_inputs(right_inputs);
 	rmm::device_vector<column_index_type> device_outputs(outputs);
 	rmm::device_vector<column_index_type> final_device_output_positions(final_output_positions);
+	rmm::device_vector<column_index_type> device_output_write_order(output_write_order);
+	rmm::device_vector<column_index_type> device_output_write_ops(output_write_ops);
 	rmm::device_vector<operator_type> device_operators(operators);
 
 
@@ -566,6 +604,8 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 												right_device_inputs.data().get(),
 												device_outputs.data().get(),
 												final_device_output_positions.data().get(),
+												device_output_write_order.data().get(),
+												device_output_write_ops.data().get(),
 												left_device_input_types.data().get(),
 												right_device_input_types.data().get(),
 												device_operators.data().get(),
@@ -13,30 +13,34 @@
 #include <map>
 #include <memory>
 #include "parser/expression_tree.hpp"
+#include "register_allocation.h"
 
 namespace interops {
 
-typedef int16_t column_index_type;
-
-enum column_index : column_index_type {
-	UNARY_INDEX = -1,
-	SCALAR_INDEX = -2,
-	SCALAR_NULL_INDEX = -3,
-	NULLARY_INDEX = -4
-
-};
-
-void add_expression_to_interpreter_plan(const ral::parser::parse_tree & expr_tree,
+/**
+ * Creates the plan of a list of expressions that are evaluated together. A subexpression that appears more than once,
+ * in one expression or in several, is computed once, and the registers are assigned with allocate_registers, so the
+ * plan only holds the values that are still needed at every point.
+ *
+ * @param final_output_positions Set to the register of every expression.
+ * @param final_output_ops Set to the operation after which every expression is written to its output column.
+ */
+void add_expressions_to_interpreter_plan(const std::vector<ral::parser::parse_tree> & expr_trees,
 	const std::map<column_index_type, column_index_type> & expr_idx_to_col_idx_map,
-	cudf::size_type start_processing_position,
-	cudf::size_type final_output_position,
+	cudf::size_type num_input_columns,
 	std::vector<column_index_type> & left_inputs,
 	std::vector<column_index_type> & right_inputs,
 	std::vector<column_index_type> & outputs,
+	std::vector<column_index_type> & final_output_positions,
+	std::vector<column_index_type> & final_output_ops,
 	std::vector<operator_type> & operators,
 	std::vector<std::unique_ptr<cudf::scalar>> & left_scalars,
 	std::vector<std::unique_ptr<cudf::scalar>> & right_scalars);
 
+/**
+ * @param final_output_ops The operation after which every output column is written, so its register can be reused by
+ * the next operations. If empty, all are written after the last operation.
+ */
 void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	const cudf::table_view & table,
 	const std::vector<column_index_type> & left_inputs,
@@ -46,6 +50,7 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	const std::vector<operator_type> & operators,
 	const std::vector<std::unique_ptr<cudf::scalar>> & left_scalars,
 	const std::vector<std::unique_ptr<cudf::scalar>> & right_scalars,
-	cudf::size_type operation_num_rows = 0);
+	cudf::size_type operation_num_rows = 0,
+	const std::vector<column_index_type> & final_output_ops = {});
 
 } // namespace interops
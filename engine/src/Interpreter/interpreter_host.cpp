@@ -0,0 +1,820 @@
+#include "interpreter_host.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace interops {
+namespace {
+
+template <typename T>
+struct type_tag {
+	using type = T;
+};
+
+/**
+ * Calls fn with the type_tag of the storage type of a fixed width column.
+ */
+template <typename Fn>
+void dispatch_storage_type(cudf::type_id type, Fn && fn) {
+	switch (type) {
+	case cudf::type_id::BOOL8: fn(type_tag<bool>{}); break;
+	case cudf::type_id::INT8: fn(type_tag<int8_t>{}); break;
+	case cudf::type_id::INT16: fn(type_tag<int16_t>{}); break;
+	case cudf::type_id::INT32: fn(type_tag<int32_t>{}); break;
+	case cudf::type_id::INT64: fn(type_tag<int64_t>{}); break;
+	case cudf::type_id::UINT8: fn(type_tag<uint8_t>{}); break;
+	case cudf::type_id::UINT16: fn(type_tag<uint16_t>{}); break;
+	case cudf::type_id::UINT32: fn(type_tag<uint32_t>{}); break;
+	case cudf::type_id::UINT64: fn(type_tag<uint64_t>{}); break;
+	case cudf::type_id::FLOAT32: fn(type_tag<float>{}); break;
+	case cudf::type_id::FLOAT64: fn(type_tag<double>{}); break;
+	case cudf::type_id::TIMESTAMP_DAYS: fn(type_tag<int32_t>{}); break;
+	case cudf::type_id::TIMESTAMP_SECONDS:
+	case cudf::type_id::TIMESTAMP_MILLISECONDS:
+	case cudf::type_id::TIMESTAMP_MICROSECONDS:
+	case cudf::type_id::TIMESTAMP_NANOSECONDS: fn(type_tag<int64_t>{}); break;
+	default: throw std::runtime_error("Host interpreter does not support columns of type " + std::to_string(static_cast<int32_t>(type)));
+	}
+}
+
+bool is_float_type(cudf::type_id type) {
+	return type == cudf::type_id::FLOAT32 || type == cudf::type_id::FLOAT64;
+}
+
+bool is_timestamp_type(cudf::type_id type) {
+	return type == cudf::type_id::TIMESTAMP_DAYS || type == cudf::type_id::TIMESTAMP_SECONDS ||
+		type == cudf::type_id::TIMESTAMP_MILLISECONDS || type == cudf::type_id::TIMESTAMP_MICROSECONDS ||
+		type == cudf::type_id::TIMESTAMP_NANOSECONDS;
+}
+
+bool is_string_type(cudf::type_id type) {
+	return type == cudf::type_id::STRING;
+}
+
+int64_t ticks_per_day(cudf::type_id type) {
+	switch (type) {
+	case cudf::type_id::TIMESTAMP_SECONDS: return 86400ll;
+	case cudf::type_id::TIMESTAMP_MILLISECONDS: return 86400000ll;
+	case cudf::type_id::TIMESTAMP_MICROSECONDS: return 86400000000ll;
+	case cudf::type_id::TIMESTAMP_NANOSECONDS: return 86400000000000ll;
+	default: return 1;
+	}
+}
+
+int64_t nanoseconds_per_tick(cudf::type_id type) {
+	return type == cudf::type_id::TIMESTAMP_DAYS ? 86400000000000ll : 86400000000000ll / ticks_per_day(type);
+}
+
+int64_t floor_div(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+/**
+ * The year, month and day of a number of days since the epoch, in the proleptic gregorian calendar.
+ */
+void civil_from_days(int64_t days, int64_t & year, int64_t & month, int64_t & day) {
+	days += 719468;
+	const int64_t era = floor_div(days, 146097);
+	const int64_t day_of_era = days - era * 146097;
+	const int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+	const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	const int64_t mp = (5 * day_of_year + 2) / 153;
+	day = day_of_year - (153 * mp + 2) / 5 + 1;
+	month = mp < 10 ? mp + 3 : mp - 9;
+	year = year_of_era + era * 400 + (month <= 2);
+}
+
+const int64_t INT_MAGIC_NUMBER = std::numeric_limits<int64_t>::max() - 13ll;
+const double FLOAT_MAGIC_NUMBER = 1.7976931348623123e+308;
+
+template <typename T>
+T magic_number() {
+	return INT_MAGIC_NUMBER;
+}
+
+template <>
+double magic_number<double>() {
+	return FLOAT_MAGIC_NUMBER;
+}
+
+// the rows divided by zero are null, and with integers they would trap
+int64_t divide(int64_t a, int64_t b) {
+	return b == 0 ? 0 : (b == -1 ? static_cast<int64_t>(0ull - static_cast<uint64_t>(a)) : a / b);
+}
+
+double divide(double a, double b) {
+	return a / b;
+}
+
+/**
+ * An operation of the plan, with the types of its inputs and output.
+ */
+struct host_operation {
+	operator_type oper;
+	column_index_type left;
+	column_index_type right;
+	column_index_type output;
+	cudf::type_id left_type;
+	cudf::type_id right_type;
+	cudf::type_id output_type;
+	const host_scalar * left_scalar;
+	const host_scalar * right_scalar;
+};
+
+/**
+ * The values of a register for the rows of a chunk. A register holds doubles if its type is a floating point and
+ * int64 otherwise, as on the GPU.
+ */
+struct host_register {
+	std::vector<int64_t> ints;
+	std::vector<double> floats;
+	std::vector<uint8_t> valids;
+	bool is_float = false;
+	bool all_valid = true;
+};
+
+/**
+ * A binary input, either a register or a scalar repeated for the whole chunk.
+ */
+struct host_operand {
+	const int64_t * ints = nullptr;
+	const double * floats = nullptr;
+	const uint8_t * valids = nullptr;
+	bool all_valid = true;
+	const host_column * strings = nullptr;
+	const host_scalar * string_scalar = nullptr;
+};
+
+class host_interpreter {
+public:
+	host_interpreter(std::vector<mutable_host_column> & out_table,
+		const std::vector<host_column> & table,
+		std::vector<host_operation> operations,
+		const std::vector<column_index_type> & final_output_positions,
+		std::vector<column_index_type> output_write_order,
+		std::vector<column_index_type> output_write_ops,
+		column_index_type num_registers)
+		: out_table{out_table},
+			table{table},
+			operations{std::move(operations)},
+			final_output_positions{final_output_positions},
+			output_write_order{std::move(output_write_order)},
+			output_write_ops{std::move(output_write_ops)},
+			num_registers{num_registers} {}
+
+	/**
+	 * The state of one thread, reused for all the chunks it processes.
+	 */
+	struct workspace {
+		std::vector<host_register> registers;
+		std::vector<std::vector<int64_t>> left_scalar_ints, right_scalar_ints;
+		std::vector<std::vector<double>> left_scalar_floats, right_scalar_floats;
+		std::vector<uint8_t> all_valids;
+		std::vector<uint8_t> all_nulls;
+		std::vector<int64_t> zero_ints;
+		std::vector<double> zero_floats;
+		std::vector<int64_t> left_ns, right_ns;
+		host_register scratch;
+		std::mt19937_64 generator;
+	};
+
+	void init_workspace(workspace & ws, uint64_t seed) const {
+		ws.registers.resize(num_registers + 1);
+		for (auto & reg : ws.registers) {
+			reg.ints.resize(HOST_INTERPRETER_CHUNK_SIZE);
+			reg.floats.resize(HOST_INTERPRETER_CHUNK_SIZE);
+			reg.valids.resize(HOST_INTERPRETER_CHUNK_SIZE);
+		}
+		ws.scratch = std::move(ws.registers.back());
+		ws.registers.pop_back();
+		ws.all_valids.assign(HOST_INTERPRETER_CHUNK_SIZE, 1);
+		ws.all_nulls.assign(HOST_INTERPRETER_CHUNK_SIZE, 0);
+		ws.zero_ints.assign(HOST_INTERPRETER_CHUNK_SIZE, 0);
+		ws.zero_floats.assign(HOST_INTERPRETER_CHUNK_SIZE, 0);
+		ws.left_ns.resize(HOST_INTERPRETER_CHUNK_SIZE);
+		ws.right_ns.resize(HOST_INTERPRETER_CHUNK_SIZE);
+
+		// the scalars are repeated once, so every operation is a loop over arrays
+		ws.left_scalar_ints.resize(operations.size());
+		ws.right_scalar_ints.resize(operations.size());
+		ws.left_scalar_floats.resize(operations.size());
+		ws.right_scalar_floats.resize(operations.size());
+		for (size_t i = 0; i < operations.size(); i++) {
+			const host_operation & op = operations[i];
+			if (op.left == SCALAR_INDEX && !is_string_type(op.left_type)) {
+				ws.left_scalar_ints[i].assign(HOST_INTERPRETER_CHUNK_SIZE, op.left_scalar->int_value);
+				ws.left_scalar_floats[i].assign(HOST_INTERPRETER_CHUNK_SIZE, op.left_scalar->float_value);
+			}
+			if (op.right == SCALAR_INDEX && !is_string_type(op.right_type)) {
+				ws.right_scalar_ints[i].assign(HOST_INTERPRETER_CHUNK_SIZE, op.right_scalar->int_value);
+				ws.right_scalar_floats[i].assign(HOST_INTERPRETER_CHUNK_SIZE, op.right_scalar->float_value);
+			}
+		}
+		ws.generator.seed(seed);
+	}
+
+	void process_chunk(workspace & ws, cudf::size_type begin, cudf::size_type num_rows) const {
+		for (size_t column_index = 0; column_index < table.size(); column_index++) {
+			if (!is_string_type(table[column_index].type.id())) {
+				load_column(table[column_index], begin, num_rows, ws.registers[column_index]);
+			}
+		}
+
+		size_t next_output = 0;
+		for (size_t op_index = 0; op_index < operations.size(); op_index++) {
+			process_operation(ws, op_index, begin, num_rows);
+
+			for (; next_output < output_write_order.size() && output_write_ops[next_output] == static_cast<column_index_type>(op_index); next_output++) {
+				column_index_type column_index = output_write_order[next_output];
+				write_column(out_table[column_index], begin, num_rows, ws.registers[final_output_positions[column_index]]);
+			}
+		}
+	}
+
+private:
+	static void load_column(const host_column & column, cudf::size_type begin, cudf::size_type num_rows, host_register & reg) {
+		reg.is_float = is_float_type(column.type.id());
+		dispatch_storage_type(column.type.id(), [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			const T * data = static_cast<const T *>(column.data) + begin;
+			if (reg.is_float) {
+				double * out = reg.floats.data();
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					out[i] = static_cast<double>(data[i]);
+				}
+			} else {
+				int64_t * out = reg.ints.data();
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					out[i] = static_cast<int64_t>(data[i]);
+				}
+			}
+		});
+		load_valids(column.null_mask, begin, num_rows, reg);
+	}
+
+	static void load_valids(const cudf::bitmask_type * null_mask, cudf::size_type begin, cudf::size_type num_rows, host_register & reg) {
+		reg.all_valid = true;
+		if (null_mask == nullptr) {
+			return;
+		}
+
+		// the chunks start at a multiple of the word size
+		const cudf::bitmask_type * words = null_mask + begin / 32;
+		cudf::size_type num_words = (num_rows + 31) / 32;
+		for (cudf::size_type w = 0; w < num_words; w++) {
+			cudf::size_type bits = std::min(32, num_rows - w * 32);
+			cudf::bitmask_type expected = bits == 32 ? ~cudf::bitmask_type{0} : ((cudf::bitmask_type{1} << bits) - 1);
+			if ((words[w] & expected) != expected) {
+				reg.all_valid = false;
+				break;
+			}
+		}
+		if (reg.all_valid) {
+			return;
+		}
+
+		uint8_t * valids = reg.valids.data();
+		for (cudf::size_type i = 0; i < num_rows; i++) {
+			valids[i] = (words[i / 32] >> (i % 32)) & 1u;
+		}
+	}
+
+	static void write_column(mutable_host_column & column, cudf::size_type begin, cudf::size_type num_rows, const host_register & reg) {
+		dispatch_storage_type(column.type.id(), [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			T * data = static_cast<T *>(column.data) + begin;
+			if (reg.is_float) {
+				const double * in = reg.floats.data();
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					data[i] = static_cast<T>(in[i]);
+				}
+			} else {
+				const int64_t * in = reg.ints.data();
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					data[i] = static_cast<T>(in[i]);
+				}
+			}
+		});
+
+		if (column.null_mask == nullptr) {
+			return;
+		}
+		cudf::bitmask_type * words = column.null_mask + begin / 32;
+		cudf::size_type num_words = (num_rows + 31) / 32;
+		for (cudf::size_type w = 0; w < num_words; w++) {
+			cudf::size_type bits = std::min(32, num_rows - w * 32);
+			cudf::bitmask_type word = 0;
+			if (reg.all_valid) {
+				word = bits == 32 ? ~cudf::bitmask_type{0} : ((cudf::bitmask_type{1} << bits) - 1);
+			} else {
+				const uint8_t * valids = reg.valids.data() + w * 32;
+				for (cudf::size_type b = 0; b < bits; b++) {
+					word |= static_cast<cudf::bitmask_type>(valids[b]) << b;
+				}
+			}
+			words[w] = word;
+		}
+	}
+
+	host_operand get_operand(workspace & ws, size_t op_index, column_index_type position, cudf::type_id type, bool left,
+		cudf::size_type begin, cudf::size_type num_rows) const {
+		host_operand operand;
+		if (position >= 0) {
+			if (is_string_type(type)) {
+				// string values always come from the table input, intermediate string result not supported
+				operand.strings = &table[position];
+				operand.valids = ws.all_valids.data();
+				if (table[position].null_mask != nullptr) {
+					host_register & reg = ws.registers[position];
+					load_valids(table[position].null_mask, begin, num_rows, reg);
+					operand.all_valid = reg.all_valid;
+					operand.valids = reg.all_valid ? ws.all_valids.data() : reg.valids.data();
+				}
+				return operand;
+			}
+			const host_register & reg = ws.registers[position];
+			operand.ints = reg.ints.data();
+			operand.floats = reg.floats.data();
+			operand.all_valid = reg.all_valid;
+			operand.valids = reg.all_valid ? ws.all_valids.data() : reg.valids.data();
+		} else if (position == SCALAR_INDEX) {
+			if (is_string_type(type)) {
+				operand.string_scalar = left ? operations[op_index].left_scalar : operations[op_index].right_scalar;
+			} else {
+				operand.ints = left ? ws.left_scalar_ints[op_index].data() : ws.right_scalar_ints[op_index].data();
+				operand.floats = left ? ws.left_scalar_floats[op_index].data() : ws.right_scalar_floats[op_index].data();
+			}
+			operand.valids = ws.all_valids.data();
+		} else {
+			operand.all_valid = false;
+			operand.valids = ws.all_nulls.data();
+			operand.ints = ws.zero_ints.data();
+			operand.floats = ws.zero_floats.data();
+		}
+		return operand;
+	}
+
+	template <typename F>
+	static void store_values(host_register & out, cudf::size_type num_rows, F f) {
+		if (out.is_float) {
+			double * o = out.floats.data();
+			for (cudf::size_type i = 0; i < num_rows; i++) {
+				o[i] = static_cast<double>(f(i));
+			}
+		} else {
+			int64_t * o = out.ints.data();
+			for (cudf::size_type i = 0; i < num_rows; i++) {
+				o[i] = static_cast<int64_t>(f(i));
+			}
+		}
+	}
+
+	static void and_valids(host_register & out, const host_operand & left, const host_operand & right, cudf::size_type num_rows) {
+		out.all_valid = left.all_valid && right.all_valid;
+		if (out.all_valid) {
+			return;
+		}
+		uint8_t * o = out.valids.data();
+		const uint8_t * l = left.valids;
+		const uint8_t * r = right.valids;
+		for (cudf::size_type i = 0; i < num_rows; i++) {
+			o[i] = l[i] & r[i];
+		}
+	}
+
+	static int compare_strings(const host_operand & operand, cudf::size_type row, const host_operand & other, cudf::size_type other_row) {
+		const char * a;
+		int32_t a_size;
+		if (operand.strings) {
+			a = static_cast<const char *>(operand.strings->data) + operand.strings->offsets[row];
+			a_size = operand.strings->offsets[row + 1] - operand.strings->offsets[row];
+		} else {
+			a = operand.string_scalar->str.data();
+			a_size = operand.string_scalar->str.size();
+		}
+		const char * b;
+		int32_t b_size;
+		if (other.strings) {
+			b = static_cast<const char *>(other.strings->data) + other.strings->offsets[other_row];
+			b_size = other.strings->offsets[other_row + 1] - other.strings->offsets[other_row];
+		} else {
+			b = other.string_scalar->str.data();
+			b_size = other.string_scalar->str.size();
+		}
+		int result = std::memcmp(a, b, std::min(a_size, b_size));
+		return result != 0 ? result : (a_size < b_size ? -1 : (a_size > b_size ? 1 : 0));
+	}
+
+	template <typename L, typename R>
+	void process_binary(const host_operation & op, const L * l, const R * r, host_register & out, cudf::size_type num_rows) const {
+		using C = typename std::conditional<std::is_same<L, double>::value || std::is_same<R, double>::value, double, int64_t>::type;
+
+		switch (op.oper) {
+		case operator_type::BLZ_ADD: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<C>(l[i]) + static_cast<C>(r[i]); }); break;
+		case operator_type::BLZ_SUB: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<C>(l[i]) - static_cast<C>(r[i]); }); break;
+		case operator_type::BLZ_MUL: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<C>(l[i]) * static_cast<C>(r[i]); }); break;
+		case operator_type::BLZ_DIV: store_values(out, num_rows, [=](cudf::size_type i) { return divide(static_cast<C>(l[i]), static_cast<C>(r[i])); }); break;
+		case operator_type::BLZ_MOD:
+			if (!is_float_type(op.left_type) && !is_float_type(op.right_type)) {
+				store_values(out, num_rows, [=](cudf::size_type i) {
+					// as in divide
+					int64_t divisor = static_cast<int64_t>(r[i]);
+					return (divisor == 0 || divisor == -1) ? int64_t{0} : static_cast<int64_t>(l[i]) % divisor;
+				});
+			} else {
+				store_values(out, num_rows, [=](cudf::size_type i) { return std::fmod(static_cast<double>(l[i]), static_cast<double>(r[i])); });
+			}
+			break;
+		case operator_type::BLZ_POW: store_values(out, num_rows, [=](cudf::size_type i) { return std::pow(static_cast<double>(l[i]), static_cast<double>(r[i])); }); break;
+		case operator_type::BLZ_ROUND:
+			store_values(out, num_rows, [=](cudf::size_type i) {
+				double factor = std::pow(10, static_cast<double>(r[i]));
+				return std::round(static_cast<double>(l[i]) * factor) / factor;
+			});
+			break;
+		case operator_type::BLZ_LOGICAL_AND: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] && r[i]); }); break;
+		case operator_type::BLZ_BITWISE_AND: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i]) & static_cast<int64_t>(r[i]); }); break;
+		case operator_type::BLZ_BITWISE_OR: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i]) | static_cast<int64_t>(r[i]); }); break;
+		case operator_type::BLZ_BITWISE_XOR: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i]) ^ static_cast<int64_t>(r[i]); }); break;
+		case operator_type::BLZ_EQUAL: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] == r[i]); }); break;
+		case operator_type::BLZ_NOT_EQUAL: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] != r[i]); }); break;
+		case operator_type::BLZ_LESS: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] < r[i]); }); break;
+		case operator_type::BLZ_GREATER: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] > r[i]); }); break;
+		case operator_type::BLZ_LESS_EQUAL: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] <= r[i]); }); break;
+		case operator_type::BLZ_GREATER_EQUAL: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i] >= r[i]); }); break;
+		default: throw std::runtime_error("Host interpreter does not support operator " + std::to_string(static_cast<int>(op.oper)));
+		}
+	}
+
+	template <typename L, typename R>
+	void process_binary_operation(const host_operation & op, const host_operand & left, const host_operand & right,
+		const L * l, const R * r, host_register & out, cudf::size_type num_rows) const {
+		if (op.oper == operator_type::BLZ_MAGIC_IF_NOT) {
+			// the rows where the condition does not hold tell first_non_magic to use its second value
+			const uint8_t * lv = left.valids;
+			const uint8_t * rv = right.valids;
+			if (out.is_float) {
+				store_values(out, num_rows, [=](cudf::size_type i) { return (lv[i] && l[i]) ? static_cast<double>(r[i]) : FLOAT_MAGIC_NUMBER; });
+			} else {
+				store_values(out, num_rows, [=](cudf::size_type i) { return (lv[i] && l[i]) ? static_cast<int64_t>(r[i]) : INT_MAGIC_NUMBER; });
+			}
+			uint8_t * o = out.valids.data();
+			for (cudf::size_type i = 0; i < num_rows; i++) {
+				o[i] = (lv[i] && l[i]) ? rv[i] : 1;
+			}
+			out.all_valid = false;
+		} else if (op.oper == operator_type::BLZ_FIRST_NON_MAGIC) {
+			const uint8_t * lv = left.valids;
+			const uint8_t * rv = right.valids;
+			const L magic = magic_number<L>();
+			if (out.is_float) {
+				store_values(out, num_rows, [=](cudf::size_type i) { return l[i] == magic ? static_cast<double>(r[i]) : static_cast<double>(l[i]); });
+			} else {
+				store_values(out, num_rows, [=](cudf::size_type i) { return l[i] == magic ? static_cast<int64_t>(r[i]) : static_cast<int64_t>(l[i]); });
+			}
+			uint8_t * o = out.valids.data();
+			for (cudf::size_type i = 0; i < num_rows; i++) {
+				o[i] = l[i] == magic ? rv[i] : lv[i];
+			}
+			out.all_valid = false;
+		} else if (op.oper == operator_type::BLZ_LOGICAL_OR) {
+			// a true on one side makes the result true even if the other side is null
+			const uint8_t * lv = left.valids;
+			const uint8_t * rv = right.valids;
+			store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>((lv[i] && l[i]) || (rv[i] && r[i])); });
+			out.all_valid = left.all_valid && right.all_valid;
+			if (!out.all_valid) {
+				uint8_t * o = out.valids.data();
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					o[i] = (lv[i] && rv[i]) || (lv[i] && l[i]) || (rv[i] && r[i]);
+				}
+			}
+		} else {
+			process_binary(op, l, r, out, num_rows);
+			and_valids(out, left, right, num_rows);
+			if (op.oper == operator_type::BLZ_DIV || (op.oper == operator_type::BLZ_MOD && !is_float_type(op.left_type) && !is_float_type(op.right_type))) {
+				// if div by zero = null
+				bool any_zero = false;
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					any_zero |= r[i] == 0;
+				}
+				if (any_zero) {
+					if (out.all_valid) {
+						std::fill_n(out.valids.begin(), num_rows, 1);
+						out.all_valid = false;
+					}
+					uint8_t * o = out.valids.data();
+					for (cudf::size_type i = 0; i < num_rows; i++) {
+						o[i] = o[i] && r[i] != 0;
+					}
+				}
+			}
+		}
+	}
+
+	void process_string_comparison(const host_operation & op, const host_operand & left, const host_operand & right,
+		host_register & out, cudf::size_type begin, cudf::size_type num_rows) const {
+		auto compare = [&](cudf::size_type i) { return compare_strings(left, begin + i, right, begin + i); };
+		switch (op.oper) {
+		case operator_type::BLZ_EQUAL: store_values(out, num_rows, [&](cudf::size_type i) { return static_cast<int64_t>(compare(i) == 0); }); break;
+		case operator_type::BLZ_NOT_EQUAL: store_values(out, num_rows, [&](cudf::size_type i) { return static_cast<int64_t>(compare(i) != 0); }); break;
+		case operator_type::BLZ_LESS: store_values(out, num_rows, [&](cudf::size_type i) { return static_cast<int64_t>(compare(i) < 0); }); break;
+		case operator_type::BLZ_GREATER: store_values(out, num_rows, [&](cudf::size_type i) { return static_cast<int64_t>(compare(i) > 0); }); break;
+		case operator_type::BLZ_LESS_EQUAL: store_values(out, num_rows, [&](cudf::size_type i) { return static_cast<int64_t>(compare(i) <= 0); }); break;
+		case operator_type::BLZ_GREATER_EQUAL: store_values(out, num_rows, [&](cudf::size_type i) { return static_cast<int64_t>(compare(i) >= 0); }); break;
+		default: throw std::runtime_error("Host interpreter does not support operator " + std::to_string(static_cast<int>(op.oper)) + " on strings");
+		}
+		and_valids(out, left, right, num_rows);
+	}
+
+	void process_unary_operation(const host_operation & op, const host_operand & left, host_register & out,
+		cudf::size_type begin, cudf::size_type num_rows) const {
+		if (op.oper == operator_type::BLZ_IS_NULL || op.oper == operator_type::BLZ_IS_NOT_NULL) {
+			const uint8_t * lv = left.valids;
+			const bool is_null = op.oper == operator_type::BLZ_IS_NULL;
+			store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(is_null ? !lv[i] : lv[i]); });
+			out.all_valid = true;
+			return;
+		}
+
+		if (op.oper == operator_type::BLZ_CHAR_LENGTH) {
+			const host_column & strings = *left.strings;
+			const unsigned char * chars = static_cast<const unsigned char *>(strings.data);
+			store_values(out, num_rows, [&](cudf::size_type i) {
+				int64_t length = 0;
+				for (int32_t c = strings.offsets[begin + i]; c < strings.offsets[begin + i + 1]; c++) {
+					length += (chars[c] & 0xC0) != 0x80;
+				}
+				return length;
+			});
+		} else if (is_float_type(op.left_type)) {
+			process_unary(op, left.floats, out, num_rows);
+		} else {
+			process_unary(op, left.ints, out, num_rows);
+		}
+
+		out.all_valid = left.all_valid;
+		if (!out.all_valid) {
+			std::copy_n(left.valids, num_rows, out.valids.begin());
+		}
+	}
+
+	template <typename L>
+	void process_unary(const host_operation & op, const L * l, host_register & out, cudf::size_type num_rows) const {
+		const cudf::type_id type = op.left_type;
+		switch (op.oper) {
+		case operator_type::BLZ_NOT: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(!l[i]); }); break;
+		case operator_type::BLZ_ABS: store_values(out, num_rows, [=](cudf::size_type i) { return l[i] < 0 ? -l[i] : l[i]; }); break;
+		case operator_type::BLZ_FLOOR: store_values(out, num_rows, [=](cudf::size_type i) { return std::floor(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_CEIL: store_values(out, num_rows, [=](cudf::size_type i) { return std::ceil(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_SIN: store_values(out, num_rows, [=](cudf::size_type i) { return std::sin(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_COS: store_values(out, num_rows, [=](cudf::size_type i) { return std::cos(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_ASIN: store_values(out, num_rows, [=](cudf::size_type i) { return std::asin(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_ACOS: store_values(out, num_rows, [=](cudf::size_type i) { return std::acos(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_TAN: store_values(out, num_rows, [=](cudf::size_type i) { return std::tan(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_COTAN: store_values(out, num_rows, [=](cudf::size_type i) { return 1.0 / std::tan(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_ATAN: store_values(out, num_rows, [=](cudf::size_type i) { return std::atan(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_LN: store_values(out, num_rows, [=](cudf::size_type i) { return std::log(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_LOG: store_values(out, num_rows, [=](cudf::size_type i) { return std::log10(static_cast<double>(l[i])); }); break;
+		case operator_type::BLZ_CAST_TINYINT:
+		case operator_type::BLZ_CAST_SMALLINT:
+		case operator_type::BLZ_CAST_INTEGER:
+		case operator_type::BLZ_CAST_BIGINT: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i]); }); break;
+		case operator_type::BLZ_CAST_FLOAT:
+		case operator_type::BLZ_CAST_DOUBLE: store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<double>(l[i]); }); break;
+		case operator_type::BLZ_CAST_DATE: {
+			const int64_t per_day = is_timestamp_type(type) ? ticks_per_day(type) : 1;
+			store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i]) / per_day; });
+			break;
+		}
+		case operator_type::BLZ_CAST_TIMESTAMP: {
+			const int64_t to_ns = is_timestamp_type(type) ? nanoseconds_per_tick(type) : 1;
+			store_values(out, num_rows, [=](cudf::size_type i) { return static_cast<int64_t>(l[i]) * to_ns; });
+			break;
+		}
+		case operator_type::BLZ_YEAR:
+		case operator_type::BLZ_MONTH:
+		case operator_type::BLZ_DAY: {
+			const int64_t per_day = ticks_per_day(type);
+			const operator_type oper = op.oper;
+			store_values(out, num_rows, [=](cudf::size_type i) {
+				int64_t year, month, day;
+				civil_from_days(floor_div(static_cast<int64_t>(l[i]), per_day), year, month, day);
+				return oper == operator_type::BLZ_YEAR ? year : (oper == operator_type::BLZ_MONTH ? month : day);
+			});
+			break;
+		}
+		case operator_type::BLZ_HOUR:
+		case operator_type::BLZ_MINUTE:
+		case operator_type::BLZ_SECOND: {
+			const int64_t per_day = ticks_per_day(type);
+			const int64_t per_second = per_day / 86400 > 0 ? per_day / 86400 : 1;
+			const operator_type oper = op.oper;
+			store_values(out, num_rows, [=](cudf::size_type i) {
+				int64_t value = static_cast<int64_t>(l[i]);
+				int64_t seconds = (per_day == 1) ? 0 : (value - floor_div(value, per_day) * per_day) / per_second;
+				return oper == operator_type::BLZ_HOUR ? seconds / 3600 : (oper == operator_type::BLZ_MINUTE ? (seconds / 60) % 60 : seconds % 60);
+			});
+			break;
+		}
+		default: throw std::runtime_error("Host interpreter does not support operator " + std::to_string(static_cast<int>(op.oper)));
+		}
+	}
+
+	void process_operation(workspace & ws, size_t op_index, cudf::size_type begin, cudf::size_type num_rows) const {
+		const host_operation & op = operations[op_index];
+
+		if (op.right == NULLARY_INDEX) {
+			host_register & out = ws.registers[op.output];
+			out.is_float = is_float_type(op.output_type);
+			if (op.oper == operator_type::BLZ_RAND) {
+				std::uniform_real_distribution<double> distribution(0.0, 1.0);
+				store_values(out, num_rows, [&](cudf::size_type) { return distribution(ws.generator); });
+			}
+			out.all_valid = true;
+			return;
+		}
+
+		// the output register can be one of the inputs, some operations go over their inputs more than once so the result
+		// is computed aside and swapped in
+		host_register & out = ws.scratch;
+		out.is_float = is_float_type(op.output_type);
+
+		if (op.right == UNARY_INDEX) {
+			host_operand left = get_operand(ws, op_index, op.left, op.left_type, true, begin, num_rows);
+			process_unary_operation(op, left, out, begin, num_rows);
+		} else {
+			host_operand left = get_operand(ws, op_index, op.left, op.left_type, true, begin, num_rows);
+			host_operand right = get_operand(ws, op_index, op.right, op.right_type, false, begin, num_rows);
+			const bool left_float = is_float_type(op.left_type);
+			const bool right_float = is_float_type(op.right_type);
+
+			if (is_string_type(op.left_type) && is_string_type(op.right_type)) {
+				process_string_comparison(op, left, right, out, begin, num_rows);
+			} else if (is_timestamp_type(op.left_type) && is_timestamp_type(op.right_type) && op.left_type != op.right_type) {
+				// compared in nanoseconds
+				const int64_t left_factor = nanoseconds_per_tick(op.left_type);
+				const int64_t right_factor = nanoseconds_per_tick(op.right_type);
+				int64_t * left_ns = ws.left_ns.data();
+				int64_t * right_ns = ws.right_ns.data();
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					left_ns[i] = left.ints[i] * left_factor;
+				}
+				for (cudf::size_type i = 0; i < num_rows; i++) {
+					right_ns[i] = right.ints[i] * right_factor;
+				}
+				process_binary_operation(op, left, right, ws.left_ns.data(), ws.right_ns.data(), out, num_rows);
+			} else if (left_float && right_float) {
+				process_binary_operation(op, left, right, left.floats, right.floats, out, num_rows);
+			} else if (left_float) {
+				process_binary_operation(op, left, right, left.floats, right.ints, out, num_rows);
+			} else if (right_float) {
+				process_binary_operation(op, left, right, left.ints, right.floats, out, num_rows);
+			} else {
+				process_binary_operation(op, left, right, left.ints, right.ints, out, num_rows);
+			}
+		}
+
+		std::swap(ws.registers[op.output], ws.scratch);
+	}
+
+	std::vector<mutable_host_column> & out_table;
+	const std::vector<host_column> & table;
+	const std::vector<host_operation> operations;
+	const std::vector<column_index_type> & final_output_positions;
+	const std::vector<column_index_type> output_write_order;
+	const std::vector<column_index_type> output_write_ops;
+	const column_index_type num_registers;
+};
+
+} // namespace
+
+void perform_host_interpreter_operation(std::vector<mutable_host_column> & out_table,
+	const std::vector<host_column> & table,
+	const std::vector<column_index_type> & left_inputs,
+	const std::vector<column_index_type> & right_inputs,
+	const std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_output_positions,
+	const std::vector<operator_type> & operators,
+	const std::vector<host_scalar> & left_scalars,
+	const std::vector<host_scalar> & right_scalars,
+	const std::vector<column_index_type> & final_output_ops,
+	int num_threads) {
+	if (final_output_positions.empty() || operators.empty()) {
+		return;
+	}
+
+	cudf::size_type num_rows = out_table.empty() ? 0 : out_table[0].size;
+	column_index_type num_registers = static_cast<column_index_type>(table.size());
+	for (size_t i = 0; i < operators.size(); i++) {
+		num_registers = std::max<column_index_type>(num_registers, std::max(std::max(left_inputs[i], right_inputs[i]), outputs[i]) + 1);
+	}
+
+	// the types of the registers are followed through the plan, as they change when a register is reused
+	std::vector<host_operation> operations(operators.size());
+	std::map<column_index_type, cudf::type_id> register_types;
+	for (size_t i = 0; i < table.size(); i++) {
+		register_types[i] = table[i].type.id();
+	}
+	for (size_t i = 0; i < operators.size(); i++) {
+		host_operation & op = operations[i];
+		op.oper = operators[i];
+		op.left = left_inputs[i];
+		op.right = right_inputs[i];
+		op.output = outputs[i];
+		op.left_scalar = left_inputs[i] == SCALAR_INDEX ? &left_scalars[i] : nullptr;
+		op.right_scalar = right_inputs[i] == SCALAR_INDEX ? &right_scalars[i] : nullptr;
+
+		auto input_type = [&](column_index_type position, const host_scalar * scalar) {
+			if (position >= 0) {
+				return register_types.at(position);
+			} else if (position == SCALAR_INDEX) {
+				return scalar->type.id();
+			}
+			return cudf::type_id::EMPTY;
+		};
+		op.left_type = input_type(op.left, op.left_scalar);
+		op.right_type = input_type(op.right, op.right_scalar);
+
+		if (op.right == UNARY_INDEX) {
+			op.output_type = get_output_type(op.oper, op.left_type);
+		} else if (op.right == NULLARY_INDEX) {
+			op.output_type = get_output_type(op.oper);
+		} else {
+			op.output_type = get_output_type(op.oper, op.left_type, op.right_type);
+		}
+		register_types[op.output] = op.output_type;
+	}
+
+	// the output columns are written in the order they are computed, each one after its operation
+	std::vector<column_index_type> output_write_order(final_output_positions.size());
+	std::iota(output_write_order.begin(), output_write_order.end(), 0);
+	std::vector<column_index_type> output_write_ops(final_output_positions.size(), static_cast<column_index_type>(operators.size() - 1));
+	if (!final_output_ops.empty()) {
+		std::stable_sort(output_write_order.begin(), output_write_order.end(), [&final_output_ops](column_index_type a, column_index_type b) {
+			return final_output_ops[a] < final_output_ops[b];
+		});
+		for (size_t i = 0; i < output_write_order.size(); i++) {
+			output_write_ops[i] = final_output_ops[output_write_order[i]];
+		}
+	}
+
+	host_interpreter interpreter(out_table, table, std::move(operations), final_output_positions, std::move(output_write_order),
+		std::move(output_write_ops), num_registers);
+
+	const cudf::size_type num_chunks = (num_rows + HOST_INTERPRETER_CHUNK_SIZE - 1) / HOST_INTERPRETER_CHUNK_SIZE;
+	if (num_threads <= 0) {
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	num_threads = std::min<cudf::size_type>(num_threads, num_chunks);
+
+	std::random_device rd;
+	std::atomic<cudf::size_type> next_chunk{0};
+	auto process_chunks = [&](uint64_t seed) {
+		host_interpreter::workspace ws;
+		interpreter.init_workspace(ws, seed);
+		for (cudf::size_type chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+			cudf::size_type begin = chunk * HOST_INTERPRETER_CHUNK_SIZE;
+			interpreter.process_chunk(ws, begin, std::min(HOST_INTERPRETER_CHUNK_SIZE, num_rows - begin));
+		}
+	};
+
+	if (num_threads <= 1) {
+		process_chunks(rd());
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	std::vector<std::exception_ptr> errors(num_threads);
+	for (int t = 0; t < num_threads; t++) {
+		uint64_t seed = rd();
+		threads.emplace_back([&, t, seed]() {
+			try {
+				process_chunks(seed);
+			} catch (...) {
+				errors[t] = std::current_exception();
+				next_chunk = num_chunks;
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+	for (auto & error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+} // namespace interops
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cudf/types.hpp>
+
+#include "parser/expression_utils.hpp"
+#include "register_allocation.h"
+
+namespace interops {
+
+/**
+ * A column in host memory, laid out like a cudf column: the values one after the other, or for strings int32 offsets
+ * (size + 1 of them) into the chars in data. The null mask uses the cudf layout and is nullptr if there are no nulls.
+ */
+struct host_column {
+	cudf::data_type type;
+	cudf::size_type size = 0;
+	const void * data = nullptr;
+	const cudf::bitmask_type * null_mask = nullptr;
+	const int32_t * offsets = nullptr;
+};
+
+/**
+ * An output column of the host interpreter, which only writes fixed width types. Its null mask is not written if it is
+ * nullptr.
+ */
+struct mutable_host_column {
+	cudf::data_type type;
+	cudf::size_type size = 0;
+	void * data = nullptr;
+	cudf::bitmask_type * null_mask = nullptr;
+};
+
+/**
+ * The value of a literal of the plan. Integers and timestamps go in int_value, floating points in float_value and
+ * strings in str.
+ */
+struct host_scalar {
+	cudf::data_type type;
+	bool valid = false;
+	int64_t int_value = 0;
+	double float_value = 0;
+	std::string str;
+};
+
+/**
+ * The number of rows every operation of the plan is applied to at once.
+ */
+constexpr cudf::size_type HOST_INTERPRETER_CHUNK_SIZE = 2048;
+
+/**
+ * Runs an interpreter plan on the CPU, with the same plans perform_interpreter_operation runs on the GPU, so small
+ * tables and machines without a GPU do not need one.
+ *
+ * The rows are processed in chunks of HOST_INTERPRETER_CHUNK_SIZE, applying every operation to the whole chunk with a
+ * loop the compiler can vectorize, and the validity is skipped for the chunks where the inputs have no nulls. The
+ * chunks are split among num_threads threads, 0 uses one per core. As on the GPU, strings can only be read from the
+ * input columns, and the plan has no limit on the number of registers.
+ *
+ * @param left_scalars The scalar of every operation whose left input is SCALAR_INDEX.
+ * @param final_output_ops The operation after which every output column is written, all are written after the last one
+ * if empty.
+ */
+void perform_host_interpreter_operation(std::vector<mutable_host_column> & out_table,
+	const std::vector<host_column> & table,
+	const std::vector<column_index_type> & left_inputs,
+	const std::vector<column_index_type> & right_inputs,
+	const std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_output_positions,
+	const std::vector<operator_type> & operators,
+	const std::vector<host_scalar> & left_scalars,
+	const std::vector<host_scalar> & right_scalars,
+	const std::vector<column_index_type> & final_output_ops = {},
+	int num_threads = 0);
+
+} // namespace interops
@@ -155,6 +155,8 @@ public:
 		const column_index_type * right_input_positions,
 		const column_index_type * output_positions,
 		const column_index_type * final_output_positions,
+		const column_index_type * output_write_order,
+		const column_index_type * output_write_ops,
 		const cudf::type_id * input_types_left,
 		const cudf::type_id * input_types_right,
 		const operator_type * operations,
@@ -169,6 +171,8 @@ public:
 			right_input_positions{right_input_positions},
 			output_positions{output_positions},
 			final_output_positions{final_output_positions},
+			output_write_order{output_write_order},
+			output_write_ops{output_write_ops},
 			input_types_left{input_types_left},
 			input_types_right{input_types_right},
 			operations{operations},
@@ -200,14 +204,16 @@ public:
 				read_data(column_index, total_buffer, row_index + row);
 			}
 
+			cudf::size_type next_output = 0;
 			for(int16_t op_index = 0; op_index < num_operations; op_index++) {
 				process_operator(op_index, total_buffer, row_index + row, cur_row_valids,state );
-			}
 
-			// copy data and row valids into buffer
-			for(cudf::size_type column_index = 0; column_index < out_table.num_columns(); column_index++) {
-				write_data(column_index, final_output_positions[column_index], total_buffer, row_index + row);
-				setColumnValid(valids_out_buffer[column_index],	row, getColumnValid(cur_row_valids, this->final_output_positions[column_index]));
+				// copy data and row valids into buffer as soon as they are computed, as the plan can reuse their registers
+				for(; next_output < out_table.num_columns() && output_write_ops[next_output] == op_index; next_output++) {
+					cudf::size_type column_index = output_write_order[next_output];
+					write_data(column_index, final_output_positions[column_index], total_buffer, row_index + row);
+					setColumnValid(valids_out_buffer[column_index],	row, getColumnValid(cur_row_valids, this->final_output_positions[column_index]));
+				}
 			}
 		}
 
@@ -817,6 +823,8 @@ private:
 	const column_index_type * right_input_positions;
 	const column_index_type * output_positions;
 	const column_index_type * final_output_positions;  // should be same size as output_data, e.g. num_outputs
+	const column_index_type * output_write_order;  // the output columns sorted by the operation that computes them
+	const column_index_type * output_write_ops;  // the operation after which every column of output_write_order is written
 
 	const cudf::type_id * input_types_left;
 	const cudf::type_id * input_types_right;
@@ -0,0 +1,104 @@
+#include "register_allocation.h"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+namespace interops {
+
+column_index_type allocate_registers(column_index_type num_input_columns,
+	std::vector<column_index_type> & left_inputs,
+	std::vector<column_index_type> & right_inputs,
+	std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_outputs,
+	std::vector<column_index_type> & final_output_positions,
+	std::vector<column_index_type> & final_output_ops) {
+	const int num_operations = outputs.size();
+
+	int num_values = num_input_columns;
+	for (int op = 0; op < num_operations; op++) {
+		num_values = std::max(num_values, outputs[op] + 1);
+	}
+
+	// the uses are counted in steps, an operation k reads its inputs at step 2k and the output columns computed by it
+	// are written at step 2k + 1, after its own output register is set
+	std::vector<int> definition(num_values, -1);
+	std::vector<int> last_use(num_values, -1);
+	for (int op = 0; op < num_operations; op++) {
+		if (outputs[op] < num_input_columns || definition[outputs[op]] >= 0) {
+			throw std::runtime_error("Interpreter plan has a register written more than once");
+		}
+		definition[outputs[op]] = op;
+		if (left_inputs[op] >= 0) {
+			last_use[left_inputs[op]] = 2 * op;
+		}
+		if (right_inputs[op] >= 0) {
+			last_use[right_inputs[op]] = 2 * op;
+		}
+	}
+
+	final_output_positions.resize(final_outputs.size());
+	final_output_ops.resize(final_outputs.size());
+	for (std::size_t i = 0; i < final_outputs.size(); i++) {
+		column_index_type value = final_outputs[i];
+		int write_op = std::max(definition[value], 0);
+		final_output_ops[i] = write_op;
+		last_use[value] = std::max(last_use[value], 2 * write_op + 1);
+	}
+
+	std::vector<column_index_type> physical(num_values, -1);
+	std::set<column_index_type> free_registers;
+	column_index_type num_registers = num_input_columns;
+	for (column_index_type value = 0; value < num_input_columns; value++) {
+		physical[value] = value;
+		if (last_use[value] < 0) {
+			free_registers.insert(value);
+		}
+	}
+
+	for (int op = 0; op < num_operations; op++) {
+		column_index_type left = left_inputs[op];
+		column_index_type right = right_inputs[op];
+		if (left >= 0) {
+			left_inputs[op] = physical[left];
+		}
+		if (right >= 0) {
+			right_inputs[op] = physical[right];
+		}
+		// an operation reads its inputs before writing its output, so it can write over them
+		if (left >= 0 && last_use[left] == 2 * op) {
+			free_registers.insert(physical[left]);
+		}
+		if (right >= 0 && last_use[right] == 2 * op) {
+			free_registers.insert(physical[right]);
+		}
+
+		column_index_type value = outputs[op];
+		column_index_type reg;
+		if (free_registers.empty()) {
+			reg = num_registers++;
+		} else {
+			reg = *free_registers.begin();
+			free_registers.erase(free_registers.begin());
+		}
+		physical[value] = reg;
+		outputs[op] = reg;
+		if (last_use[value] <= 2 * op + 1) {
+			free_registers.insert(reg);
+		}
+		for (column_index_type input = 0; input < num_input_columns; input++) {
+			// input columns that are also output columns
+			if (last_use[input] == 2 * op + 1) {
+				free_registers.insert(input);
+			}
+		}
+	}
+
+	for (std::size_t i = 0; i < final_outputs.size(); i++) {
+		final_output_positions[i] = physical[final_outputs[i]];
+	}
+
+	return num_registers;
+}
+
+} // namespace interops
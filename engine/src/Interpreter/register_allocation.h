@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace interops {
+
+typedef int16_t column_index_type;
+
+enum column_index : column_index_type {
+	UNARY_INDEX = -1,
+	SCALAR_INDEX = -2,
+	SCALAR_NULL_INDEX = -3,
+	NULLARY_INDEX = -4
+
+};
+
+/**
+ * @brief Assigns the registers of an interpreter plan made with one register per value.
+ *
+ * The plan comes with virtual registers: 0 to num_input_columns - 1 hold the input columns and every operation writes a
+ * register that no other operation writes. Negative inputs (scalars, unary and nullary operations) are not registers
+ * and are left as they are.
+ *
+ * The register of a value is freed after the last operation that reads it, and every output column is written right
+ * after the operation that computes it (see perform_interpreter_operation), so the plan needs as many registers as values
+ * alive at the same time instead of one per value. The lowest free register is always taken, as the interpreter
+ * allocates its shared memory up to the highest one.
+ *
+ * @param final_outputs The virtual register of every output column.
+ * @param final_output_positions Set to the register of every output column.
+ * @param final_output_ops Set to the operation after which every output column is written.
+ * @return The number of registers the plan uses, counting the input columns.
+ */
+column_index_type allocate_registers(column_index_type num_input_columns,
+	std::vector<column_index_type> & left_inputs,
+	std::vector<column_index_type> & right_inputs,
+	std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_outputs,
+	std::vector<column_index_type> & final_output_positions,
+	std::vector<column_index_type> & final_output_ops);
+
+} // namespace interops
@@ -0,0 +1,160 @@
+#include "BlazingHostBufferPool.h"
+
+#include <cstdlib>
+#include <new>
+
+blazing_host_buffer::blazing_host_buffer(std::size_t size) : num_bytes{size} {
+	ptr = blazing_host_buffer_pool::getInstance().allocate(size, capacity_bytes);
+}
+
+blazing_host_buffer::blazing_host_buffer(std::basic_string<char> && data)
+	: num_bytes{data.size()}, capacity_bytes{data.size()}, adopted{true}, adopted_data{std::move(data)} {
+	ptr = num_bytes == 0 ? nullptr : &adopted_data[0];
+	blazing_host_buffer_pool::getInstance().add_external_bytes(capacity_bytes);
+}
+
+blazing_host_buffer::~blazing_host_buffer() {
+	release();
+}
+
+blazing_host_buffer::blazing_host_buffer(blazing_host_buffer && other) noexcept {
+	take(other);
+}
+
+blazing_host_buffer & blazing_host_buffer::operator=(blazing_host_buffer && other) noexcept {
+	if (this != &other) {
+		release();
+		take(other);
+	}
+	return *this;
+}
+
+void blazing_host_buffer::take(blazing_host_buffer & other) {
+	num_bytes = other.num_bytes;
+	capacity_bytes = other.capacity_bytes;
+	adopted = other.adopted;
+	if (adopted) {
+		adopted_data = std::move(other.adopted_data);
+		// a short string lives inside the object, so its address changes with the move
+		ptr = num_bytes == 0 ? nullptr : &adopted_data[0];
+	} else {
+		ptr = other.ptr;
+	}
+	other.ptr = nullptr;
+	other.num_bytes = 0;
+	other.capacity_bytes = 0;
+	other.adopted = false;
+	other.adopted_data.clear();
+}
+
+void blazing_host_buffer::release() {
+	if (adopted) {
+		blazing_host_buffer_pool::getInstance().remove_external_bytes(capacity_bytes);
+		adopted_data = std::basic_string<char>();
+	} else if (ptr != nullptr) {
+		blazing_host_buffer_pool::getInstance().deallocate(ptr, capacity_bytes);
+	}
+	ptr = nullptr;
+	num_bytes = 0;
+	capacity_bytes = 0;
+	adopted = false;
+}
+
+blazing_host_buffer_pool::~blazing_host_buffer_pool() {
+	trim();
+}
+
+std::size_t blazing_host_buffer_pool::get_size_class_index(std::size_t size) {
+	if (size <= (std::size_t{1} << MIN_CLASS_SHIFT)) {
+		return 0;
+	}
+	if (size > (std::size_t{1} << MAX_CLASS_SHIFT)) {
+		return NUM_SIZE_CLASSES;
+	}
+	// 2^shift < size <= 2^(shift + 1), and that range is split in CLASSES_PER_SHIFT steps
+	std::size_t shift = 63 - __builtin_clzll(size - 1);
+	std::size_t step = (std::size_t{1} << shift) / CLASSES_PER_SHIFT;
+	std::size_t sub_class = (size - (std::size_t{1} << shift) + step - 1) / step;
+	return (shift - MIN_CLASS_SHIFT) * CLASSES_PER_SHIFT + sub_class;
+}
+
+std::size_t blazing_host_buffer_pool::get_size_class_bytes(std::size_t index) {
+	std::size_t shift = MIN_CLASS_SHIFT + index / CLASSES_PER_SHIFT;
+	std::size_t step = (std::size_t{1} << shift) / CLASSES_PER_SHIFT;
+	return (std::size_t{1} << shift) + (index % CLASSES_PER_SHIFT) * step;
+}
+
+std::size_t blazing_host_buffer_pool::get_size_class(std::size_t size) {
+	std::size_t index = get_size_class_index(size);
+	return index == NUM_SIZE_CLASSES ? size : get_size_class_bytes(index);
+}
+
+char * blazing_host_buffer_pool::allocate(std::size_t size, std::size_t & capacity) {
+	if (size == 0) {
+		capacity = 0;
+		return nullptr;
+	}
+
+	std::size_t index = get_size_class_index(size);
+	capacity = index == NUM_SIZE_CLASSES ? size : get_size_class_bytes(index);
+
+	char * ptr = nullptr;
+	if (index < NUM_SIZE_CLASSES) {
+		free_list & list = free_lists[index];
+		std::lock_guard<std::mutex> lock(list.mutex);
+		if (!list.buffers.empty()) {
+			ptr = list.buffers.back();
+			list.buffers.pop_back();
+			cached_bytes -= capacity;
+		}
+	}
+	if (ptr == nullptr) {
+		ptr = (char *)std::malloc(capacity);
+		if (ptr == nullptr) {
+			// the cached buffers of the other size classes may be enough to satisfy the request
+			trim();
+			ptr = (char *)std::malloc(capacity);
+			if (ptr == nullptr) {
+				throw std::bad_alloc();
+			}
+		}
+	}
+	used_bytes += capacity;
+	return ptr;
+}
+
+void blazing_host_buffer_pool::deallocate(char * ptr, std::size_t capacity) {
+	if (ptr == nullptr) {
+		return;
+	}
+	used_bytes -= capacity;
+
+	std::size_t index = get_size_class_index(capacity);
+	if (index < NUM_SIZE_CLASSES && cached_bytes + capacity <= max_cached_bytes) {
+		free_list & list = free_lists[index];
+		std::lock_guard<std::mutex> lock(list.mutex);
+		list.buffers.push_back(ptr);
+		cached_bytes += capacity;
+		return;
+	}
+	std::free(ptr);
+}
+
+void blazing_host_buffer_pool::trim() {
+	for (std::size_t index = 0; index < NUM_SIZE_CLASSES; index++) {
+		free_list & list = free_lists[index];
+		std::lock_guard<std::mutex> lock(list.mutex);
+		for (char * ptr : list.buffers) {
+			std::free(ptr);
+		}
+		cached_bytes -= list.buffers.size() * get_size_class_bytes(index);
+		list.buffers.clear();
+	}
+}
+
+void blazing_host_buffer_pool::set_max_cached_bytes(std::size_t max_cached_bytes) {
+	this->max_cached_bytes = max_cached_bytes;
+	if (cached_bytes > max_cached_bytes) {
+		trim();
+	}
+}
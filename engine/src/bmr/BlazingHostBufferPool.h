@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+	@brief A host buffer that comes from the blazing_host_buffer_pool, or that adopts an existing string.
+	The memory is not initialized when the buffer is created, so it is meant to be overwritten right away
+	(i.e. by a copy from the GPU or a read from a file). The memory goes back to the pool when the buffer is destroyed.
+*/
+class blazing_host_buffer {
+public:
+	blazing_host_buffer() = default;
+
+	/**
+	 * Takes an uninitialized buffer from the pool.
+	 * @param size Number of usable bytes of the buffer.
+	 */
+	explicit blazing_host_buffer(std::size_t size);
+
+	/**
+	 * Takes ownership of a buffer that was not allocated by the pool (i.e. one received from the network).
+	 * The bytes are still accounted by the pool while the buffer is alive.
+	 * @param data The buffer that is moved into this one.
+	 */
+	explicit blazing_host_buffer(std::basic_string<char> && data);
+
+	~blazing_host_buffer();
+
+	blazing_host_buffer(blazing_host_buffer && other) noexcept;
+	blazing_host_buffer & operator=(blazing_host_buffer && other) noexcept;
+
+	blazing_host_buffer(const blazing_host_buffer &) = delete;
+	blazing_host_buffer & operator=(const blazing_host_buffer &) = delete;
+
+	char * data() { return ptr; }
+
+	const char * data() const { return ptr; }
+
+	/**
+	 * @return The number of usable bytes of the buffer.
+	 */
+	std::size_t size() const { return num_bytes; }
+
+	/**
+	 * @return The number of bytes actually taken from the pool, which is the size rounded up to its size class.
+	 */
+	std::size_t capacity() const { return capacity_bytes; }
+
+private:
+	/**
+	 * Gives the memory back to the pool and leaves the buffer empty.
+	 */
+	void release();
+
+	/**
+	 * Moves the memory of another buffer into this one, which must be empty.
+	 */
+	void take(blazing_host_buffer & other);
+
+	char * ptr = nullptr; /**< The memory of the buffer. */
+	std::size_t num_bytes = 0; /**< The usable bytes. */
+	std::size_t capacity_bytes = 0; /**< The bytes of the size class the memory belongs to. */
+	bool adopted = false; /**< Whether the memory is owned by adopted_data instead of the pool. */
+	std::basic_string<char> adopted_data; /**< The buffer taken by the adopting constructor. */
+};
+
+/**
+	@brief A process wide pool of host memory used by the BlazingHostTables and the caches.
+	Requests are rounded up to size classes (four classes per power of two, from 256 bytes up to 1 GiB) and the
+	memory of released buffers is kept in a free list per size class, so spilling thousands of batches reuses the
+	same allocations instead of fragmenting the heap. The free lists survive from one query to the next up to a
+	configurable amount of cached bytes. Requests bigger than the largest size class are not pooled.
+
+	blazing_host_buffer_pool is a singleton class, and should be accessed via getInstance().
+*/
+class blazing_host_buffer_pool {
+public:
+	static blazing_host_buffer_pool & getInstance() {
+		// Myers' singleton. Thread safe and unique. Note: C++11 required.
+		static blazing_host_buffer_pool instance;
+		return instance;
+	}
+
+	/**
+	 * Takes uninitialized memory from the pool.
+	 * @param size The number of bytes requested.
+	 * @param capacity Where the number of bytes actually taken from the pool is returned.
+	 * @return The memory, or nullptr if size is zero.
+	 */
+	char * allocate(std::size_t size, std::size_t & capacity);
+
+	/**
+	 * Gives memory back to the pool. It is kept for reuse unless the pool is already caching its maximum.
+	 * @param ptr The memory returned by allocate.
+	 * @param capacity The capacity returned by allocate.
+	 */
+	void deallocate(char * ptr, std::size_t capacity);
+
+	/**
+	 * Accounts for host memory that was not allocated by the pool but is held by a blazing_host_buffer.
+	 * @param bytes The number of bytes to add to (or remove from) the used bytes.
+	 */
+	void add_external_bytes(std::size_t bytes) { used_bytes += bytes; }
+
+	void remove_external_bytes(std::size_t bytes) { used_bytes -= bytes; }
+
+	/**
+	 * Frees all the memory cached in the free lists.
+	 */
+	void trim();
+
+	/**
+	 * Sets how many bytes of released buffers the pool keeps for reuse. Cached memory above it is freed.
+	 * @param max_cached_bytes The maximum number of cached bytes.
+	 */
+	void set_max_cached_bytes(std::size_t max_cached_bytes);
+
+	/**
+	 * @return The number of bytes held by buffers that are alive.
+	 */
+	std::size_t get_used_bytes() const { return used_bytes; }
+
+	/**
+	 * @return The number of bytes kept in the free lists for reuse.
+	 */
+	std::size_t get_cached_bytes() const { return cached_bytes; }
+
+	/**
+	 * @return The size class a request is rounded up to, or the request itself if it is bigger than the largest size class.
+	 */
+	static std::size_t get_size_class(std::size_t size);
+
+private:
+	static constexpr std::size_t MIN_CLASS_SHIFT = 8;
+	static constexpr std::size_t MAX_CLASS_SHIFT = 30;
+	static constexpr std::size_t CLASSES_PER_SHIFT = 4;
+	static constexpr std::size_t NUM_SIZE_CLASSES = (MAX_CLASS_SHIFT - MIN_CLASS_SHIFT) * CLASSES_PER_SHIFT + 1;
+
+	/**
+	 * @brief The released buffers of one size class.
+	 */
+	struct free_list {
+		std::mutex mutex;
+		std::vector<char *> buffers;
+	};
+
+	blazing_host_buffer_pool() = default;
+	~blazing_host_buffer_pool();
+	blazing_host_buffer_pool(const blazing_host_buffer_pool &) = delete;
+	blazing_host_buffer_pool & operator=(const blazing_host_buffer_pool &) = delete;
+
+	/**
+	 * @return The index of the size class for a request, or NUM_SIZE_CLASSES if it is not pooled.
+	 */
+	static std::size_t get_size_class_index(std::size_t size);
+
+	/**
+	 * @return The number of bytes of a size class.
+	 */
+	static std::size_t get_size_class_bytes(std::size_t index);
+
+	std::array<free_list, NUM_SIZE_CLASSES> free_lists; /**< One free list per size class. */
+	std::atomic<std::size_t> used_bytes{0}; /**< Bytes held by buffers that are alive. */
+	std::atomic<std::size_t> cached_bytes{0}; /**< Bytes kept in the free lists. */
+	std::atomic<std::size_t> max_cached_bytes{1073741824}; /**< Cached bytes above this are freed. */
+};
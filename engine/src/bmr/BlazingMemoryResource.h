@@ -15,6 +15,7 @@
 #include <rmm/mr/device/per_device_resource.hpp>
 
 #include "config/GPUManager.cuh"
+#include "BlazingHostBufferPool.h"
 
 #include <sys/sysinfo.h>
 #include <sys/statvfs.h>
@@ -282,7 +283,7 @@ public:
 
 	virtual ~internal_blazing_host_memory_resource() = default;
 
-    // TODO
+    // only for host memory that does not come from the blazing_host_buffer_pool, which does its own accounting
     void allocate(std::size_t bytes)  {
 		used_memory_size +=  bytes;
 	}
@@ -301,7 +302,8 @@ public:
     }
 
 	size_t get_memory_used() {
-		return used_memory_size;
+		// the buffers cached by the pool for reuse are not counted, they are handed out again before the pool grows
+		return used_memory_size + blazing_host_buffer_pool::getInstance().get_used_bytes();
 	}
 
 	size_t get_total_memory() {
@@ -364,13 +366,11 @@ public:
    /** -----------------------------------------------------------------------*
    * @brief Initialize
    * 
-   * Accepts an optional rmmOptions_t struct that describes the settings used
-   * to initialize the memory manager. If no `options` is passed, default
-   * options are used.
-   * 
-   * @param[in] options Optional options to set
+   *   host_mem_resouce_consumption_thresh : The percent (as a decimal) of the free host memory that the caches can use.
+   *   host_buffer_pool_max_cached_bytes : How many bytes of released host buffers the blazing_host_buffer_pool keeps
+   *                                       for reuse across batches and queries.
    * ----------------------------------------------------------------------**/
-    void initialize(float host_mem_resouce_consumption_thresh) {
+    void initialize(float host_mem_resouce_consumption_thresh, std::size_t host_buffer_pool_max_cached_bytes = 1073741824) {
         
         std::lock_guard<std::mutex> guard(manager_mutex);
 
@@ -378,6 +378,7 @@ public:
         if (isInitialized()) return;
 
         initialized_resource.reset(new internal_blazing_host_memory_resource(host_mem_resouce_consumption_thresh));
+        blazing_host_buffer_pool::getInstance().set_max_cached_bytes(host_buffer_pool_max_cached_bytes);
 
         is_initialized = true;
     }
@@ -391,6 +392,7 @@ public:
         // finalization before initialization is a no-op
         if (isInitialized()) {
             initialized_resource.reset();
+            blazing_host_buffer_pool::getInstance().trim();
             is_initialized = false;
         }
     }
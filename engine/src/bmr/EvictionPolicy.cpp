@@ -0,0 +1,76 @@
+#include "EvictionPolicy.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ral {
+
+std::vector<std::size_t> ReverseOrderEvictionPolicy::rank(const std::vector<EvictionCandidate> & candidates) const {
+	std::vector<std::size_t> order(candidates.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&candidates](std::size_t a, std::size_t b) {
+		if (candidates[a].tree_order != candidates[b].tree_order) {
+			return candidates[a].tree_order < candidates[b].tree_order;
+		}
+		return candidates[a].queue_position > candidates[b].queue_position;
+	});
+	return order;
+}
+
+double CostAwareEvictionPolicy::time_to_consume_us(const EvictionCandidate & candidate) const {
+	if (candidate.consumer_bytes_per_second > 0) {
+		double time_us = candidate.bytes_ahead / candidate.consumer_bytes_per_second * 1000000.0;
+		return candidate.consumer_started ? time_us : settings.idle_consumer_us + time_us;
+	}
+	// nothing pulled lately, the consumer is as good as idle. The batches it pulls later still go first
+	return settings.idle_consumer_us + static_cast<double>(candidate.queue_position);
+}
+
+double CostAwareEvictionPolicy::rematerialization_cost_us(const EvictionCandidate & candidate) const {
+	// written out and read back
+	if (candidate.target_tier == 1) {
+		return settings.host_overhead_us + 2.0 * candidate.size_bytes / settings.host_bytes_per_second * 1000000.0;
+	}
+	return settings.disk_overhead_us + 2.0 * candidate.size_bytes / settings.disk_bytes_per_second * 1000000.0;
+}
+
+std::vector<std::size_t> CostAwareEvictionPolicy::rank(const std::vector<EvictionCandidate> & candidates) const {
+	std::vector<double> scores(candidates.size());
+	std::vector<bool> wasted(candidates.size());
+	for (std::size_t i = 0; i < candidates.size(); i++) {
+		double time_to_consume = time_to_consume_us(candidates[i]);
+		double cost = std::max(rematerialization_cost_us(candidates[i]), 1.0);
+		wasted[i] = time_to_consume < cost;
+		scores[i] = candidates[i].size_bytes * time_to_consume / cost;
+	}
+
+	std::vector<std::size_t> order(candidates.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		if (wasted[a] != wasted[b]) {
+			return !wasted[a];
+		}
+		return scores[a] > scores[b];
+	});
+	return order;
+}
+
+std::unique_ptr<EvictionPolicy> make_eviction_policy(std::map<std::string, std::string> config_options) {
+	auto it = config_options.find("MEMORY_MONITOR_EVICTION_POLICY");
+	if (it == config_options.end() || it->second != "cost_aware") {
+		return std::make_unique<ReverseOrderEvictionPolicy>();
+	}
+
+	CostAwareEvictionPolicy::Settings settings;
+	it = config_options.find("MEMORY_MONITOR_HOST_BANDWIDTH");
+	if (it != config_options.end()){
+		settings.host_bytes_per_second = std::stod(config_options["MEMORY_MONITOR_HOST_BANDWIDTH"]);
+	}
+	it = config_options.find("MEMORY_MONITOR_DISK_BANDWIDTH");
+	if (it != config_options.end()){
+		settings.disk_bytes_per_second = std::stod(config_options["MEMORY_MONITOR_DISK_BANDWIDTH"]);
+	}
+	return std::make_unique<CostAwareEvictionPolicy>(settings);
+}
+
+}  // namespace ral
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ral {
+
+/**
+ * @brief A batch in the GPU that the MemoryMonitor could move to a lower tier, and what is known about when it will be
+ * used again.
+ */
+struct EvictionCandidate {
+	std::size_t tree_order = 0; /**< Position of the cache in the walk of the query tree from the output node */
+	std::size_t cache_id = 0;
+	uint64_t message_sequence = 0; /**< Identifies the message in its cache, see message::get_sequence */
+	std::size_t size_bytes = 0;
+	std::size_t queue_position = 0; /**< How many batches its consumer pulls from the cache before this one */
+	std::size_t queue_length = 0; /**< How many batches the cache holds */
+	std::size_t bytes_ahead = 0; /**< How many bytes its consumer pulls from the cache before this one */
+	bool consumer_started = false; /**< Whether its consumer pulled anything from the cache yet */
+	double consumer_bytes_per_second = 0; /**< How fast its consumer pulls from the cache lately */
+	int target_tier = 1; /**< Where it would go: 1 is host memory, 2 is disk */
+};
+
+/**
+ * @brief Decides which batches the MemoryMonitor downgrades first when the device memory is over its limit.
+ */
+class EvictionPolicy {
+public:
+	virtual ~EvictionPolicy() {}
+
+	virtual std::string name() const = 0;
+
+	/**
+	 * @param candidates Every batch that can be downgraded.
+	 * @return The indexes of the candidates in the order in which they should be downgraded.
+	 */
+	virtual std::vector<std::size_t> rank(const std::vector<EvictionCandidate> & candidates) const = 0;
+};
+
+/**
+ * @brief What the MemoryMonitor always did: the caches are walked from the output node, and every cache is downgraded
+ * from its newest batch to its oldest one before moving to the next cache.
+ */
+class ReverseOrderEvictionPolicy : public EvictionPolicy {
+public:
+	std::string name() const override { return "reverse_order"; }
+
+	std::vector<std::size_t> rank(const std::vector<EvictionCandidate> & candidates) const override;
+};
+
+/**
+ * @brief Downgrades first the batches that are going to stay unused for the longest time per unit of cost to bring
+ * them back.
+ *
+ * The time until a batch is pulled is the bytes its consumer pulls before it divided by the rate at which the consumer
+ * pulls. A consumer that did not pull anything yet is assumed to need idle_consumer_us more. The cost of a batch is
+ * what it takes to write it to its target tier and read it back. Downgrading a batch that is pulled before it was even
+ * written out frees nothing for long, so those go last.
+ */
+class CostAwareEvictionPolicy : public EvictionPolicy {
+public:
+	struct Settings {
+		double host_bytes_per_second = 10e9; /**< Device to host copy bandwidth */
+		double disk_bytes_per_second = 1e9; /**< Disk write and read bandwidth */
+		int64_t host_overhead_us = 100; /**< Fixed cost of moving one batch to the host */
+		int64_t disk_overhead_us = 2000; /**< Fixed cost of moving one batch to disk, i.e. creating its file */
+		int64_t idle_consumer_us = 10000000; /**< How long until a consumer that has not pulled yet starts pulling */
+	};
+
+	CostAwareEvictionPolicy() = default;
+
+	explicit CostAwareEvictionPolicy(Settings settings) : settings(settings) {}
+
+	std::string name() const override { return "cost_aware"; }
+
+	std::vector<std::size_t> rank(const std::vector<EvictionCandidate> & candidates) const override;
+
+	/**
+	 * @return The microseconds until the candidate is expected to be pulled.
+	 */
+	double time_to_consume_us(const EvictionCandidate & candidate) const;
+
+	/**
+	 * @return The microseconds it takes to downgrade the candidate and bring it back.
+	 */
+	double rematerialization_cost_us(const EvictionCandidate & candidate) const;
+
+private:
+	Settings settings;
+};
+
+/**
+ * @brief Makes the policy set by MEMORY_MONITOR_EVICTION_POLICY, reverse_order unless it is cost_aware. The
+ * MEMORY_MONITOR_HOST_BANDWIDTH and MEMORY_MONITOR_DISK_BANDWIDTH options, in bytes per second, tune cost_aware.
+ */
+std::unique_ptr<EvictionPolicy> make_eviction_policy(std::map<std::string, std::string> config_options);
+
+}  // namespace ral
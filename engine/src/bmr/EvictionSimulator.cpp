@@ -0,0 +1,163 @@
+#include "EvictionSimulator.h"
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+
+#include "execution_graph/logic_controllers/FlowControl.h"
+
+namespace ral {
+
+EvictionTrace parse_eviction_trace(std::istream & input) {
+	EvictionTrace trace;
+	std::string line;
+	std::size_t line_number = 0;
+	while (std::getline(input, line)) {
+		line_number++;
+		std::istringstream fields(line);
+		std::string first;
+		if (!(fields >> first) || first[0] == '#') {
+			continue;
+		}
+
+		bool parsed = false;
+		if (first == "cache") {
+			std::size_t cache_id, tree_order;
+			if (fields >> cache_id >> tree_order) {
+				trace.tree_order[cache_id] = tree_order;
+				parsed = true;
+			}
+		} else {
+			EvictionTraceEvent event;
+			std::string type;
+			std::istringstream time_field(first);
+			if ((time_field >> event.time_us) && (fields >> type >> event.cache_id)) {
+				if (type == "add") {
+					event.type = EvictionTraceEvent::Type::ADD;
+					parsed = static_cast<bool>(fields >> event.size_bytes);
+				} else if (type == "pull") {
+					event.type = EvictionTraceEvent::Type::PULL;
+					parsed = true;
+				}
+			}
+			if (parsed) {
+				trace.events.push_back(event);
+			}
+		}
+		if (!parsed) {
+			throw std::runtime_error("Invalid eviction trace line " + std::to_string(line_number) + ": " + line);
+		}
+	}
+	return trace;
+}
+
+namespace {
+
+struct SimulatedBatch {
+	std::size_t size_bytes;
+	int tier; // 0 is the device
+	int64_t downgraded_us;
+};
+
+struct SimulatedCache {
+	std::deque<SimulatedBatch> batches;
+	ral::cache::ByteRate pulled{1000000};
+};
+
+}  // namespace
+
+EvictionSimulationResult EvictionSimulator::run(const EvictionTrace & trace, const EvictionPolicy & policy) const {
+	EvictionSimulationResult result;
+	CostAwareEvictionPolicy cost_model(settings.cost_model);
+	std::map<std::size_t, SimulatedCache> caches;
+	std::size_t device_bytes = 0;
+	std::size_t host_bytes = 0;
+
+	auto monitor_check = [&](int64_t now_us) {
+		if (device_bytes <= settings.device_limit_bytes) {
+			return;
+		}
+		std::vector<EvictionCandidate> candidates;
+		std::vector<SimulatedBatch *> batches;
+		for (auto & cache : caches) {
+			auto tree_order = trace.tree_order.find(cache.first);
+			std::size_t bytes_ahead = 0;
+			for (std::size_t i = 0; i < cache.second.batches.size(); i++) {
+				SimulatedBatch & batch = cache.second.batches[i];
+				if (batch.tier == 0) {
+					EvictionCandidate candidate;
+					candidate.tree_order = tree_order != trace.tree_order.end() ? tree_order->second : cache.first;
+					candidate.cache_id = cache.first;
+					candidate.message_sequence = batches.size();
+					candidate.size_bytes = batch.size_bytes;
+					candidate.queue_position = i;
+					candidate.queue_length = cache.second.batches.size();
+					candidate.bytes_ahead = bytes_ahead;
+					candidate.consumer_started = cache.second.pulled.has_rate();
+					candidate.consumer_bytes_per_second = cache.second.pulled.bytes_per_second(now_us);
+					candidates.push_back(candidate);
+					batches.push_back(&batch);
+				}
+				bytes_ahead += batch.size_bytes;
+			}
+		}
+
+		for (std::size_t index : policy.rank(candidates)) {
+			if (device_bytes <= settings.device_limit_bytes) {
+				break;
+			}
+			SimulatedBatch & batch = *batches[index];
+			EvictionCandidate & candidate = candidates[index];
+			candidate.target_tier = host_bytes + batch.size_bytes < settings.host_limit_bytes ? 1 : 2;
+			batch.tier = candidate.target_tier;
+			batch.downgraded_us = now_us;
+			device_bytes -= batch.size_bytes;
+			if (batch.tier == 1) {
+				host_bytes += batch.size_bytes;
+			}
+			result.batches_downgraded++;
+			result.bytes_downgraded += batch.size_bytes;
+			result.rematerialization_cost_us += cost_model.rematerialization_cost_us(candidate);
+		}
+		if (device_bytes > settings.device_limit_bytes) {
+			result.over_limit_checks++;
+		}
+	};
+
+	if (trace.events.empty()) {
+		return result;
+	}
+	int64_t next_check_us = trace.events.front().time_us + settings.monitor_period_us;
+	for (const EvictionTraceEvent & event : trace.events) {
+		while (next_check_us <= event.time_us) {
+			monitor_check(next_check_us);
+			next_check_us += settings.monitor_period_us;
+		}
+
+		SimulatedCache & cache = caches[event.cache_id];
+		if (event.type == EvictionTraceEvent::Type::ADD) {
+			cache.batches.push_back(SimulatedBatch{event.size_bytes, 0, 0});
+			device_bytes += event.size_bytes;
+			result.peak_device_bytes = std::max(result.peak_device_bytes, device_bytes);
+		} else if (!cache.batches.empty()) {
+			SimulatedBatch batch = cache.batches.front();
+			cache.batches.pop_front();
+			if (batch.tier == 0) {
+				device_bytes -= batch.size_bytes;
+			} else {
+				if (batch.tier == 1) {
+					host_bytes -= batch.size_bytes;
+				}
+				result.bytes_reloaded += batch.size_bytes;
+				if (event.time_us - batch.downgraded_us < settings.monitor_period_us) {
+					result.premature_reloads++;
+				}
+			}
+			cache.pulled.record(batch.size_bytes, event.time_us);
+		}
+	}
+	return result;
+}
+
+}  // namespace ral
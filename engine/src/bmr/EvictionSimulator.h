@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "EvictionPolicy.h"
+
+namespace ral {
+
+/**
+ * @brief One step of a recorded query: a batch is added to a cache or the next batch of a cache is pulled.
+ */
+struct EvictionTraceEvent {
+	enum class Type { ADD, PULL };
+
+	int64_t time_us = 0;
+	Type type = Type::ADD;
+	std::size_t cache_id = 0;
+	std::size_t size_bytes = 0; /**< Only for ADD */
+};
+
+/**
+ * @brief A recorded query that the EvictionSimulator replays.
+ *
+ * The text format has one event per line, in time order, and lines starting with # are comments:
+ *
+ *     cache <cache_id> <tree_order>
+ *     <time_us> add <cache_id> <size_bytes>
+ *     <time_us> pull <cache_id>
+ *
+ * The cache lines give the position of every cache in the walk of the query tree, which the reverse_order policy
+ * follows. A cache without one is placed by its id.
+ */
+struct EvictionTrace {
+	std::map<std::size_t, std::size_t> tree_order;
+	std::vector<EvictionTraceEvent> events;
+};
+
+/**
+ * @throws std::runtime_error if a line can not be parsed.
+ */
+EvictionTrace parse_eviction_trace(std::istream & input);
+
+/**
+ * @brief How a policy did on a trace.
+ */
+struct EvictionSimulationResult {
+	std::size_t batches_downgraded = 0;
+	std::size_t bytes_downgraded = 0;
+	std::size_t bytes_reloaded = 0; /**< Downgraded bytes that were pulled, which had to come back to the GPU */
+	std::size_t premature_reloads = 0; /**< Batches pulled less than a monitor period after being downgraded */
+	std::size_t peak_device_bytes = 0;
+	std::size_t over_limit_checks = 0; /**< Monitor checks that found the device over its limit after downgrading */
+	double rematerialization_cost_us = 0; /**< What the downgrades cost, using the cost model of cost_aware */
+};
+
+/**
+ * @brief Replays a trace against a device memory limit with a given eviction policy, the way the MemoryMonitor would
+ * run it, so policies can be compared without a GPU.
+ *
+ * Every monitor period the device usage is checked, and while it is over the limit the candidates are ranked by the
+ * policy and downgraded in that order. Downgraded batches go to the host unless host_limit_bytes is exceeded, then to
+ * disk. The consumption rate of every cache is measured from the pulls replayed so far, like a CacheMachine does.
+ */
+class EvictionSimulator {
+public:
+	struct Settings {
+		std::size_t device_limit_bytes = 0;
+		std::size_t host_limit_bytes = SIZE_MAX;
+		int64_t monitor_period_us = 50000;
+		CostAwareEvictionPolicy::Settings cost_model; /**< To report the cost of the downgrades */
+	};
+
+	explicit EvictionSimulator(Settings settings) : settings(settings) {}
+
+	EvictionSimulationResult run(const EvictionTrace & trace, const EvictionPolicy & policy) const;
+
+private:
+	Settings settings;
+};
+
+}  // namespace ral
@@ -17,29 +17,53 @@ namespace ral {
     }
 
     void MemoryMonitor::downgradeCaches(ral::batch::node* starting_node){
+        std::vector<EvictionCandidate> candidates;
+        std::vector<ral::cache::CacheMachine*> candidate_caches;
+        std::size_t tree_order = 0;
+        collectEvictionCandidates(starting_node, candidates, candidate_caches, tree_order);
+
+        // the best ranked batches that add up to what has to be freed, grouped by cache so every cache is only
+        // walked once. The caches go in the order of their best ranked batch.
+        std::vector<ral::cache::CacheMachine*> chosen_caches;
+        std::map<ral::cache::CacheMachine*, std::vector<EvictionCandidate>> chosen_candidates;
+        size_t bytes_wanted = bytes_to_free();
+        size_t bytes_chosen = 0;
+        for (std::size_t index : eviction_policy->rank(candidates)) {
+            if (bytes_chosen >= bytes_wanted){
+                break;
+            }
+            auto & cache_candidates = chosen_candidates[candidate_caches[index]];
+            if (cache_candidates.empty()){
+                chosen_caches.push_back(candidate_caches[index]);
+            }
+            cache_candidates.push_back(candidates[index]);
+            bytes_chosen += candidates[index].size_bytes;
+        }
+
+        for (auto cache : chosen_caches) {
+            // the batches pulled since they were chosen are skipped
+            cache->downgradeCacheData(chosen_candidates[cache]);
+            if (!need_to_free_memory()){
+                break;
+            }
+        }
+    }
+
+    void MemoryMonitor::collectEvictionCandidates(ral::batch::node* starting_node, std::vector<EvictionCandidate> & candidates,
+            std::vector<ral::cache::CacheMachine*> & candidate_caches, std::size_t & tree_order){
         if (starting_node->kernel_unit->get_id() != 0) { // we want to skip the output node
             for (auto iter = starting_node->kernel_unit->output_.cache_machines_.begin(); 
                     iter != starting_node->kernel_unit->output_.cache_machines_.end(); iter++) {
-                size_t amount_downgraded = 0;
-                do {
-                    amount_downgraded = iter->second->downgradeCacheData();
-                } while (amount_downgraded > 0 && need_to_free_memory()); // if amount_downgraded is 0 then there is was nothing left to downgrade
+                for (auto & candidate : iter->second->get_eviction_candidates()) {
+                    candidate.tree_order = tree_order;
+                    candidates.push_back(candidate);
+                    candidate_caches.push_back(iter->second.get());
+                }
+                tree_order++;
             }
         }
-        if (need_to_free_memory()){
-            if (starting_node->children.size() == 1){
-                downgradeCaches(starting_node->children[0].get());
-            } else if (starting_node->children.size() > 1){
-                std::vector<BlazingThread> threads;
-                for (auto node : starting_node->children){
-                    threads.push_back(BlazingThread([this, node](){
-                        this->downgradeCaches(node.get());
-                    }));
-                }
-                for(auto & thread : threads) {
-                    thread.join();
-                }
-            }            
-        } 
+        for (auto node : starting_node->children){
+            collectEvictionCandidates(node.get(), candidates, candidate_caches, tree_order);
+        }
     }
 }  // namespace ral
@@ -4,6 +4,7 @@
 #include <chrono>
 
 #include "execution_graph/logic_controllers/PhysicalPlanGenerator.h"
+#include "EvictionPolicy.h"
 
 namespace ral {
 
@@ -18,6 +19,12 @@ namespace ral {
                 if (it != config_options.end()){
                     period = std::chrono::milliseconds(std::stoull(config_options["MEMORY_MONITOR_PERIOD"]));
                 }
+                spill_ahead_ratio = 1.0;
+                it = config_options.find("MEMORY_MONITOR_SPILL_AHEAD_RATIO");
+                if (it != config_options.end()){
+                    spill_ahead_ratio = std::stod(config_options["MEMORY_MONITOR_SPILL_AHEAD_RATIO"]);
+                }
+                eviction_policy = make_eviction_policy(config_options);
             }
 
             void start();
@@ -40,12 +47,28 @@ namespace ral {
             std::chrono::milliseconds period;
             BlazingMemoryResource* resource;
             BlazingThread monitor_thread;
+            double spill_ahead_ratio; // start spilling when this fraction of the memory limit is used, below 1.0 the caches are spilled before the limit is hit
+            std::unique_ptr<EvictionPolicy> eviction_policy; // decides which batches are downgraded first
+
+            // how much has to be downgraded to get back under the limit, 0 when under it
+            size_t bytes_to_free(){
+                // the tables that are already queued to be written to disk will free their memory soon
+                size_t memory_used = resource->get_memory_used();
+                size_t pending_spill_bytes = ral::cache::get_pending_spill_bytes();
+                memory_used = memory_used > pending_spill_bytes ? memory_used - pending_spill_bytes : 0;
+                size_t memory_limit = resource->get_memory_limit() * spill_ahead_ratio;
+                return memory_used > memory_limit ? memory_used - memory_limit : 0;
+            }
 
             bool need_to_free_memory(){
-                return resource->get_memory_used() > resource->get_memory_limit();
+                return bytes_to_free() > 0;
             }
 
             void downgradeCaches(ral::batch::node* starting_node);
+
+            // gathers the batches of every cache under starting_node that could be downgraded, in the order of a walk from the output node
+            void collectEvictionCandidates(ral::batch::node* starting_node, std::vector<EvictionCandidate> & candidates,
+                std::vector<ral::cache::CacheMachine*> & candidate_caches, std::size_t & tree_order);
     };
 
 }  // namespace ral
@@ -15,13 +15,18 @@ void CommunicationData::initialize(int unixSocketId,
 	int16_t orchCommunicationPort,
 	const std::string & selfRalIp,
 	int16_t selfRalCommunicationPort,
-	int16_t selfRalProtocolPort) {
+	int16_t selfRalProtocolPort,
+	std::size_t maxConnectionsPerPeer,
+	int64_t connectionIdleTimeoutMs,
+	std::size_t maxMessagesInFlight) {
 	orchestratorIp = orchIp;
 	orchestratorPort = orchCommunicationPort;
 
 	auto address = blazingdb::transport::Address::TCP(selfRalIp, selfRalCommunicationPort, selfRalProtocolPort);
 
 	selfNode = blazingdb::transport::Node(address);
+
+	connectionPool.setLimits(maxConnectionsPerPeer, connectionIdleTimeoutMs, maxMessagesInFlight);
 }
 
 const blazingdb::transport::Node & CommunicationData::getSelfNode() { return selfNode; }
@@ -30,5 +35,7 @@ std::string CommunicationData::getOrchestratorIp() { return orchestratorIp; }
 
 int16_t CommunicationData::getOrchestratorPort() { return orchestratorPort; }
 
+network::ConnectionPool & CommunicationData::getConnectionPool() { return connectionPool; }
+
 }  // namespace communication
 }  // namespace ral
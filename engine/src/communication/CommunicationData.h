@@ -3,6 +3,7 @@
 #include <blazingdb/transport/Node.h>
 #include <memory>
 #include <string>
+#include "communication/network/ConnectionPool.h"
 
 namespace ral {
 namespace communication {
@@ -16,10 +17,18 @@ public:
 		int16_t orchCommunicationPort,
 		const std::string & selfRalIp,
 		int16_t selfRalCommunicationPort,
-		int16_t selfRalProtocolPort);
+		int16_t selfRalProtocolPort,
+		std::size_t maxConnectionsPerPeer = 8,
+		int64_t connectionIdleTimeoutMs = 60000,
+		std::size_t maxMessagesInFlight = 16);
 
 	const blazingdb::transport::Node & getSelfNode();
 
+	/**
+	 * The connections to the other nodes, reused by all the messages and queries.
+	 */
+	network::ConnectionPool & getConnectionPool();
+
 	std::string getOrchestratorIp();
 	int16_t getOrchestratorPort();
 
@@ -34,6 +43,7 @@ private:
 	std::string orchestratorIp;
 	int16_t orchestratorPort;
 	blazingdb::transport::Node selfNode;
+	network::ConnectionPool connectionPool;
 };
 
 }  // namespace communication
@@ -36,6 +36,14 @@ std::shared_ptr<Message> Factory::createColumnDataPartitionMessage(const std::st
 	return std::make_shared<ColumnDataPartitionMessage>(message_token, context_token, sender_node, columns, partition_id);
 }
 
+std::shared_ptr<Message> Factory::createHostTablesMessage(const std::string & message_token,
+														  const ContextToken & context_token,
+														  Node & sender_node,
+														  int32_t partition_id,
+														  std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> && tables) {
+	return std::make_shared<HostTablesMessage>(message_token, context_token, sender_node, std::move(tables), partition_id);
+}
+
 }  // namespace messages
 }  // namespace communication
 }  // namespace ral
@@ -36,6 +36,12 @@ struct Factory {
 																Node & sender_node,
 																int32_t partition_id,
 																const ral::frame::BlazingTableView & columns);
+
+	static std::shared_ptr<Message> createHostTablesMessage(const std::string & message_token,
+															const ContextToken & context_token,
+															Node & sender_node,
+															int32_t partition_id,
+															std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> && tables);
 };
 
 }  // namespace messages
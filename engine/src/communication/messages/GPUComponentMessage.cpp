@@ -1,4 +1,10 @@
 #include "GPUComponentMessage.h"
+#include "utilities/CommonOperations.h"
+#include "utilities/Metrics.h"
+#include "utilities/QueryTracer.h"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace ral {
 namespace communication {
@@ -119,19 +125,20 @@ std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_tabl
 	std::vector<ColumnTransport> column_offset;
 	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
 	std::tie(buffer_sizes, raw_buffers, column_offset, temp_scope_holder) = serialize_gpu_message_to_gpu_containers(table_view);
-	std::vector<std::basic_string<char>> cpu_raw_buffers;
+	std::vector<blazing_host_buffer> cpu_raw_buffers;
+	cpu_raw_buffers.reserve(buffer_sizes.size());
 	for(int index = 0; index < buffer_sizes.size(); ++index) {
-		std::basic_string<char> buffer;
-		buffer.resize(buffer_sizes[index]);
+		// the pooled buffer is not zero filled, the copy overwrites all of it
+		blazing_host_buffer buffer(buffer_sizes[index]);
 		int currentDeviceId = 0; // TODO: CHECK device_id
 		cudaSetDevice(currentDeviceId);
 		cudaMemcpy((void *)buffer.data(), raw_buffers[index], buffer_sizes[index], cudaMemcpyHostToHost);
-		cpu_raw_buffers.emplace_back(buffer);
+		cpu_raw_buffers.emplace_back(std::move(buffer));
 	}
 	return std::make_unique<ral::frame::BlazingHostTable>(column_offset, std::move(cpu_raw_buffers));
 }
 
-auto deserialize_from_gpu_raw_buffers(const std::vector<ColumnTransport> & columns_offsets,
+std::unique_ptr<ral::frame::BlazingTable> deserialize_from_gpu_raw_buffers(const std::vector<ColumnTransport> & columns_offsets,
 									  const std::vector<rmm::device_buffer> & raw_buffers) {
 	auto num_columns = columns_offsets.size();
 	std::vector<std::unique_ptr<cudf::column>> received_samples(num_columns);
@@ -181,14 +188,49 @@ auto deserialize_from_gpu_raw_buffers(const std::vector<ColumnTransport> & colum
 	return std::make_unique<ral::frame::BlazingTable>(std::move(unique_table), column_names);
 }
 
+namespace {
+
+void record_received_message(const MessageMetadata & message_metadata, std::size_t num_bytes) {
+	auto metrics = ral::utilities::MetricsRegistry::getInstance().getNetworkMetrics(
+		message_metadata.contextToken, message_metadata.messageToken);
+	metrics->messages_received.add(1);
+	metrics->bytes_received.add(num_bytes);
+}
+
+}  // namespace
+
 std::shared_ptr<ReceivedMessage> deserialize_from_gpu(const MessageMetadata & message_metadata,
 		const Address::MetaData & address_metadata,
 		const std::vector<ColumnTransport> & columns_offsets,
 		const std::vector<rmm::device_buffer> & raw_buffers) {
 
+	std::size_t num_bytes = 0;
+	for (const auto & buffer : raw_buffers) {
+		num_bytes += buffer.size();
+	}
+	record_received_message(message_metadata, num_bytes);
+	ral::utilities::TraceSpan receive_span(message_metadata.contextToken, "network", "receive " + std::string(message_metadata.messageToken));
+	receive_span.set_arg("bytes", num_bytes);
+
 	auto node = Node(Address::TCP(address_metadata.ip, address_metadata.comunication_port, address_metadata.protocol_port));
 
-	auto received_table = deserialize_from_gpu_raw_buffers(columns_offsets, raw_buffers);
+	std::unique_ptr<ral::frame::BlazingTable> received_table;
+	if (message_metadata.n_batches > 1) {
+		// a device message holds a single table, so the framed tables are concatenated
+		std::vector<std::unique_ptr<ral::frame::BlazingTable>> framed_tables;
+		std::vector<ral::frame::BlazingTableView> framed_table_views;
+		for (auto & framed_table : split_framed_tables(columns_offsets, message_metadata.n_batches)) {
+			std::vector<rmm::device_buffer> table_buffers;
+			for (std::size_t index = 0; index < framed_table.num_buffers; ++index) {
+				table_buffers.emplace_back(raw_buffers[framed_table.first_buffer + index]);
+			}
+			framed_tables.push_back(deserialize_from_gpu_raw_buffers(framed_table.columns_offsets, table_buffers));
+			framed_table_views.push_back(framed_tables.back()->toBlazingTableView());
+		}
+		received_table = ral::utilities::concatTables(framed_table_views);
+	} else {
+		received_table = deserialize_from_gpu_raw_buffers(columns_offsets, raw_buffers);
+	}
 
     return std::make_shared<ReceivedDeviceMessage>(message_metadata.messageToken,
         message_metadata.contextToken,
@@ -197,6 +239,97 @@ std::shared_ptr<ReceivedMessage> deserialize_from_gpu(const MessageMetadata & me
         message_metadata.total_row_size);
 }
 
+std::vector<FramedTable> split_framed_tables(const std::vector<ColumnTransport> & columns_offsets, int32_t num_tables) {
+	if (num_tables <= 1) {
+		return {FramedTable{columns_offsets, 0, 0}};
+	}
+	if (columns_offsets.size() % num_tables != 0) {
+		throw std::runtime_error("split_framed_tables: " + std::to_string(columns_offsets.size()) +
+			" columns can not be split into " + std::to_string(num_tables) + " tables");
+	}
+
+	std::size_t num_columns = columns_offsets.size() / num_tables;
+	std::vector<FramedTable> framed_tables;
+	std::size_t first_buffer = 0;
+	for (int32_t table_index = 0; table_index < num_tables; ++table_index) {
+		std::vector<ColumnTransport> table_columns(columns_offsets.begin() + table_index * num_columns,
+			columns_offsets.begin() + (table_index + 1) * num_columns);
+		std::size_t end_buffer = first_buffer;
+		for (auto & column : table_columns) {
+			for (int * buffer_index : {&column.data, &column.valid, &column.strings_data, &column.strings_offsets, &column.strings_nullmask}) {
+				if (*buffer_index != -1) {
+					end_buffer = std::max(end_buffer, static_cast<std::size_t>(*buffer_index) + 1);
+					*buffer_index -= first_buffer;
+				}
+			}
+		}
+		framed_tables.push_back(FramedTable{std::move(table_columns), first_buffer, end_buffer - first_buffer});
+		first_buffer = end_buffer;
+	}
+	return framed_tables;
+}
+
+std::shared_ptr<ReceivedMessage> deserialize_from_host(const MessageMetadata & message_metadata,
+		const Address::MetaData & address_metadata,
+		const std::vector<ColumnTransport> & columns_offsets,
+		std::vector<std::basic_string<char>> && raw_buffers) {
+	std::size_t num_bytes = 0;
+	for (const auto & buffer : raw_buffers) {
+		num_bytes += buffer.size();
+	}
+	record_received_message(message_metadata, num_bytes);
+	ral::utilities::TraceSpan receive_span(message_metadata.contextToken, "network", "receive " + std::string(message_metadata.messageToken));
+	receive_span.set_arg("bytes", num_bytes);
+
+	auto node = Node(Address::TCP(address_metadata.ip, address_metadata.comunication_port, address_metadata.protocol_port));
+
+	// the received buffers are adopted as they are, without copying them into the pool
+	if (message_metadata.n_batches > 1) {
+		std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> host_tables;
+		for (auto & framed_table : split_framed_tables(columns_offsets, message_metadata.n_batches)) {
+			std::vector<blazing_host_buffer> host_buffers;
+			host_buffers.reserve(framed_table.num_buffers);
+			for (std::size_t index = 0; index < framed_table.num_buffers; ++index) {
+				host_buffers.emplace_back(std::move(raw_buffers[framed_table.first_buffer + index]));
+			}
+			host_tables.push_back(std::make_unique<ral::frame::BlazingHostTable>(framed_table.columns_offsets, std::move(host_buffers)));
+		}
+		return std::make_shared<ReceivedHostMessage>(message_metadata.messageToken, message_metadata.contextToken, node, std::move(host_tables), message_metadata.partition_id);
+	}
+
+	std::vector<blazing_host_buffer> host_buffers;
+	host_buffers.reserve(raw_buffers.size());
+	for (auto & raw_buffer : raw_buffers) {
+		host_buffers.emplace_back(std::move(raw_buffer));
+	}
+	auto host_table = std::make_unique<ral::frame::BlazingHostTable>(columns_offsets, std::move(host_buffers));
+	return std::make_shared<ReceivedHostMessage>(message_metadata.messageToken, message_metadata.contextToken, node, std::move(host_table), message_metadata.total_row_size, message_metadata.partition_id);
+}
+
+GPUMessage::raw_buffer HostTablesMessage::GetRawColumns() {
+	std::vector<std::size_t> buffer_sizes;
+	std::vector<const char *> raw_buffers;
+	std::vector<ColumnTransport> column_offsets;
+	for (auto & table : tables) {
+		// the buffer indices of the table follow the buffers of the tables before it
+		int first_buffer = raw_buffers.size();
+		for (auto column : table->get_columns_offsets()) {
+			for (int * buffer_index : {&column.data, &column.valid, &column.strings_data, &column.strings_offsets, &column.strings_nullmask}) {
+				if (*buffer_index != -1) {
+					*buffer_index += first_buffer;
+				}
+			}
+			column_offsets.push_back(column);
+		}
+		for (auto & buffer : table->get_raw_buffers()) {
+			buffer_sizes.push_back(buffer.size());
+			raw_buffers.push_back(buffer.data());
+		}
+	}
+	// the buffers are in host memory, the sender copies them with cudaMemcpyDefault
+	return std::make_tuple(buffer_sizes, raw_buffers, column_offsets, std::vector<std::unique_ptr<rmm::device_buffer>>());
+}
+
 //TODO: get column size_in_bytes
 std::unique_ptr<ral::frame::BlazingTable> deserialize_from_cpu(const ral::frame::BlazingHostTable* host_table){
 	std::vector<rmm::device_buffer> gpu_raw_buffers;
@@ -43,6 +43,9 @@ using gpu_raw_buffer_container = blazingdb::transport::gpu_raw_buffer_container;
 
 gpu_raw_buffer_container serialize_gpu_message_to_gpu_containers(ral::frame::BlazingTableView table_view);
 
+std::unique_ptr<ral::frame::BlazingTable> deserialize_from_gpu_raw_buffers(const std::vector<ColumnTransport> & columns_offsets,
+									  const std::vector<rmm::device_buffer> & raw_buffers);
+
 std::shared_ptr<ReceivedMessage> deserialize_from_gpu(const MessageMetadata& message_metadata,
 														 const Address::MetaData & address_metadata,
 														 const std::vector<ColumnTransport> & columns_offsets,
@@ -50,6 +53,26 @@ std::shared_ptr<ReceivedMessage> deserialize_from_gpu(const MessageMetadata& mes
 
 std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_table(ral::frame::BlazingTableView table_view);
 
+/**
+ * The columns of one of the tables framed in a message, with the buffer indices relative to the first buffer
+ * of the table.
+ */
+struct FramedTable {
+	std::vector<ColumnTransport> columns_offsets;
+	std::size_t first_buffer;
+	std::size_t num_buffers;
+};
+
+/**
+ * Splits the columns of a message that frames num_tables tables with the same schema (see HostTablesMessage).
+ */
+std::vector<FramedTable> split_framed_tables(const std::vector<ColumnTransport> & columns_offsets, int32_t num_tables);
+
+std::shared_ptr<ReceivedMessage> deserialize_from_host(const MessageMetadata & message_metadata,
+														const Address::MetaData & address_metadata,
+														const std::vector<ColumnTransport> & columns_offsets,
+														std::vector<std::basic_string<char>> && raw_buffers);
+
 std::unique_ptr<ral::frame::BlazingTable> deserialize_from_cpu(const ral::frame::BlazingHostTable* host_table);
 
 
@@ -85,22 +108,38 @@ public:
 					  std::unique_ptr<ral::frame::BlazingHostTable> samples,
 						int64_t total_row_size = 0,
 						int32_t partition_id = 0)
-		: ReceivedMessage(messageToken, contextToken, sender_node),
-		  table(std::move(samples)) {
+		: ReceivedMessage(messageToken, contextToken, sender_node) {
+		tables.push_back(std::move(samples));
 		this->metadata().total_row_size = total_row_size;
 		this->metadata().partition_id = partition_id;
 	} 
 
-	std::unique_ptr<ral::frame::BlazingHostTable>  releaseBlazingHostTable() { return std::move(table); }
+	/**
+	 * A message that framed several tables of the same partition (see HostTablesMessage).
+	 */
+	ReceivedHostMessage(std::string const & messageToken,
+						uint32_t contextToken,
+						Node  & sender_node,
+					  std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> && samples,
+						int32_t partition_id = 0)
+		: ReceivedMessage(messageToken, contextToken, sender_node),
+		  tables(std::move(samples)) {
+		this->metadata().n_batches = tables.size();
+		this->metadata().partition_id = partition_id;
+	}
+
+	std::unique_ptr<ral::frame::BlazingHostTable>  releaseBlazingHostTable() { return std::move(tables.front()); }
+
+	std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> releaseBlazingHostTables() { return std::move(tables); }
 
-	std::unique_ptr<ral::frame::BlazingTable>  getBlazingTable() { return deserialize_from_cpu(table.get()); }
+	std::unique_ptr<ral::frame::BlazingTable>  getBlazingTable() { return deserialize_from_cpu(tables.front().get()); }
 
 	int64_t getTotalRowSize() { return this->metadata().total_row_size; };
 
 	int32_t getPartitionId() { return this->metadata().partition_id; };
 
 protected:
-	std::unique_ptr<ral::frame::BlazingHostTable> table;
+	std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> tables;
 };
 
 class GPUComponentMessage : public GPUMessage {
@@ -131,9 +170,7 @@ public:
 		const Address::MetaData & address_metadata,
 		const std::vector<ColumnTransport> & columns_offsets,
 		std::vector<std::basic_string<char>> && raw_buffers) {  
-		auto host_table = std::make_unique<ral::frame::BlazingHostTable>(columns_offsets, std::move(raw_buffers));
-		auto node = Node(Address::TCP(address_metadata.ip, address_metadata.comunication_port, address_metadata.protocol_port));
-		return std::make_shared<ReceivedHostMessage>(message_metadata.messageToken, message_metadata.contextToken, node, std::move(host_table), message_metadata.total_row_size, message_metadata.partition_id);
+		return deserialize_from_host(message_metadata, address_metadata, columns_offsets, std::move(raw_buffers));
 	}
 
 	ral::frame::BlazingTableView getTableView() { return table_view; }
@@ -142,6 +179,37 @@ protected:
 	ral::frame::BlazingTableView table_view; 
 };
 
+/**
+ * Several host tables of the same partition sent as one message, so the small partitions of many batches do not
+ * need a message each. The buffers of every table follow the ones of the table before, and metadata().n_batches
+ * tells the receiver how many tables to split the message into (see split_framed_tables).
+ */
+class HostTablesMessage : public GPUMessage {
+public:
+	HostTablesMessage(std::string const & messageToken,
+		uint32_t contextToken,
+		Node  & sender_node,
+		std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> && tables,
+		int32_t partition_id = 0)
+		: GPUMessage(messageToken, contextToken, sender_node), tables{std::move(tables)} {
+		this->metadata().n_batches = this->tables.size();
+		this->metadata().partition_id = partition_id;
+	}
+
+	virtual raw_buffer GetRawColumns() override;
+
+	std::size_t sizeInBytes() const {
+		std::size_t num_bytes = 0;
+		for (const auto & table : tables) {
+			num_bytes += table->sizeInBytes();
+		}
+		return num_bytes;
+	}
+
+private:
+	std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> tables;
+};
+
 }  // namespace messages
 }  // namespace communication
 }  // namespace ral
@@ -1,29 +1,65 @@
 #include "communication/network/Client.h"
+#include "communication/CommunicationData.h"
+#include "communication/messages/GPUComponentMessage.h"
+#include "utilities/CommonOperations.h"
+#include "utilities/Metrics.h"
+#include "utilities/QueryTracer.h"
 // #include <blazingdb/manager/Manager.h>
 #include <blazingdb/transport/Client.h>
 #include <blazingdb/transport/api.h>
+#include <stdexcept>
 
 namespace ral {
 namespace communication {
 namespace network {
 
+namespace {
+
+std::size_t get_message_size_in_bytes(GPUMessage & message) {
+	if(auto table_message = dynamic_cast<messages::GPUComponentMessage *>(&message)) {
+		return ral::utilities::get_table_size_bytes(table_message->getTableView());
+	}
+	if(auto host_tables_message = dynamic_cast<messages::HostTablesMessage *>(&message)) {
+		return host_tables_message->sizeInBytes();
+	}
+	return 0;
+}
+
+}  // namespace
+
 // concurrent::send
 Status Client::send(const Node & node, GPUMessage & message) {
+	auto metrics = ral::utilities::MetricsRegistry::getInstance().getNetworkMetrics(
+		message.metadata().contextToken, message.getMessageTokenValue());
+	std::size_t num_bytes = get_message_size_in_bytes(message);
+	metrics->messages_sent.add(1);
+	metrics->bytes_sent.add(num_bytes);
+	ral::utilities::ScopedTimer send_timer(metrics->send_time_us);
+	ral::utilities::TraceSpan send_span(message.metadata().contextToken, "network", "send " + message.getMessageTokenValue());
+	send_span.set_arg("bytes", num_bytes);
+
 	const auto & metadata = node.address().metadata();
-	auto ral_client = blazingdb::transport::ClientTCP::Make(metadata.ip, metadata.comunication_port);
-	return ral_client->Send(message);
+	auto connection = CommunicationData::getInstance().getConnectionPool().acquire(metadata.ip, metadata.comunication_port);
+	Status status = connection->Send(message);
+	connection.release();
+	return status;
 }
 
 bool Client::notifyLastMessageEvent(const Node & node, const Message::MetaData &message_metadata) {
 	const auto & metadata = node.address().metadata();
-	auto ral_client = blazingdb::transport::ClientTCP::Make(metadata.ip, metadata.comunication_port);
-	return ral_client->notifyLastMessageEvent(message_metadata);
+	auto & connectionPool = CommunicationData::getInstance().getConnectionPool();
+	// the messages before the last event could still be in flight on other connections to the node
+	if(!connectionPool.flush(metadata.ip, metadata.comunication_port)) {
+		throw std::runtime_error("Client::notifyLastMessageEvent: " + std::string(metadata.ip) + " failed to process a message");
+	}
+	auto connection = connectionPool.acquire(metadata.ip, metadata.comunication_port);
+	bool notified = connection->notifyLastMessageEvent(message_metadata);
+	connection.release();
+	return notified;
 }
 
 void Client::closeConnections() {
-	// for (auto& c : ral_clients) {
-	//   ral_clients[c.first]->Close();
-	// }
+	CommunicationData::getInstance().getConnectionPool().closeConnections();
 }
 
 
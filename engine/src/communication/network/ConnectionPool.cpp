@@ -0,0 +1,218 @@
+#include "communication/network/ConnectionPool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace ral {
+namespace communication {
+namespace network {
+
+PooledConnection::PooledConnection(ConnectionPool * pool, const std::string & peer, std::shared_ptr<blazingdb::transport::Client> client)
+	: pool{pool}, peer{peer}, client{std::move(client)} {}
+
+PooledConnection::PooledConnection(PooledConnection && other)
+	: pool{other.pool}, peer{std::move(other.peer)}, client{std::move(other.client)} {
+	other.client = nullptr;
+}
+
+PooledConnection::~PooledConnection() {
+	if(client != nullptr) {
+		pool->giveBack(peer, client, false);
+	}
+}
+
+void PooledConnection::release() {
+	if(client != nullptr) {
+		pool->giveBack(peer, client, true);
+		client = nullptr;
+	}
+}
+
+ConnectionPool::ConnectionPool(std::size_t max_connections_per_peer, int64_t idle_timeout_ms, std::size_t max_messages_in_flight)
+	: maxConnectionsPerPeer{std::max<std::size_t>(max_connections_per_peer, 1)}, idleTimeout{idle_timeout_ms},
+	  maxMessagesInFlight{std::max<std::size_t>(max_messages_in_flight, 1)} {}
+
+ConnectionPool::~ConnectionPool() {
+	closeConnections();
+}
+
+void ConnectionPool::setLimits(std::size_t max_connections_per_peer, int64_t idle_timeout_ms, std::size_t max_messages_in_flight) {
+	std::lock_guard<std::mutex> lock(mutex);
+	maxConnectionsPerPeer = std::max<std::size_t>(max_connections_per_peer, 1);
+	idleTimeout = std::chrono::milliseconds(idle_timeout_ms);
+	maxMessagesInFlight = std::max<std::size_t>(max_messages_in_flight, 1);
+	connectionOpened.notify_all();
+}
+
+std::string ConnectionPool::getPeerKey(const std::string & ip, int16_t port) {
+	return ip + ":" + std::to_string(port);
+}
+
+PooledConnection ConnectionPool::acquire(const std::string & ip, int16_t port) {
+	std::string peerKey = getPeerKey(ip, port);
+	std::vector<std::shared_ptr<blazingdb::transport::Client>> expired;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	Peer & peer = peers[peerKey];
+	std::list<Connection>::iterator chosen;
+	bool open = false;
+	while(true) {
+		auto now = clock::now();
+		auto leastUsed = peer.connections.end();
+		std::size_t numConnections = 0;
+		for(auto it = peer.connections.begin(); it != peer.connections.end();) {
+			if(it->client != nullptr && it->numUsers == 0 && now - it->lastUse > idleTimeout) {
+				expired.push_back(std::move(it->client));
+				it = peer.connections.erase(it);
+				continue;
+			}
+			if(!it->failed) {
+				numConnections++;
+				if(it->client != nullptr && (leastUsed == peer.connections.end() || it->numUsers < leastUsed->numUsers)) {
+					leastUsed = it;
+				}
+			}
+			++it;
+		}
+
+		if(leastUsed != peer.connections.end() && (leastUsed->numUsers == 0 || numConnections >= maxConnectionsPerPeer)) {
+			chosen = leastUsed;
+			break;
+		}
+		if(numConnections < maxConnectionsPerPeer) {
+			// reserve the connection before opening it, so the limit holds while the lock is not held
+			chosen = peer.connections.emplace(peer.connections.end());
+			open = true;
+			break;
+		}
+		// all the connections are still being opened
+		connectionOpened.wait(lock);
+	}
+	chosen->numUsers++;
+	std::shared_ptr<blazingdb::transport::Client> client = chosen->client;
+	std::size_t maxMessages = maxMessagesInFlight;
+	lock.unlock();
+
+	for(auto & expiredClient : expired) {
+		expiredClient->Close();
+	}
+	if(open) {
+		try {
+			client = blazingdb::transport::ClientTCP::Make(ip, port, maxMessages);
+		} catch(...) {
+			lock.lock();
+			peer.connections.erase(chosen);
+			connectionOpened.notify_all();
+			throw;
+		}
+		lock.lock();
+		chosen->client = client;
+		chosen->lastUse = clock::now();
+		connectionOpened.notify_all();
+		lock.unlock();
+	}
+	return PooledConnection(this, peerKey, std::move(client));
+}
+
+bool ConnectionPool::flush(const std::string & ip, int16_t port) {
+	std::string peerKey = getPeerKey(ip, port);
+	std::vector<std::shared_ptr<blazingdb::transport::Client>> clients;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto peer = peers.find(peerKey);
+		if(peer == peers.end()) {
+			return true;
+		}
+		// the connections being opened can not have messages sent before this call
+		for(auto & connection : peer->second.connections) {
+			if(connection.client != nullptr && !connection.failed) {
+				connection.numUsers++;
+				clients.push_back(connection.client);
+			}
+		}
+	}
+
+	bool processed = true;
+	std::exception_ptr error;
+	for(auto & client : clients) {
+		bool healthy = true;
+		try {
+			processed = client->Flush() && processed;
+		} catch(...) {
+			healthy = false;
+			if(!error) {
+				error = std::current_exception();
+			}
+		}
+		giveBack(peerKey, client, healthy);
+	}
+	if(error) {
+		std::rethrow_exception(error);
+	}
+	return processed;
+}
+
+void ConnectionPool::giveBack(const std::string & peerKey, const std::shared_ptr<blazingdb::transport::Client> & client, bool healthy) {
+	std::shared_ptr<blazingdb::transport::Client> failedClient;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Peer & peer = peers[peerKey];
+		auto connection = std::find_if(peer.connections.begin(), peer.connections.end(),
+			[&client](const Connection & connection) { return connection.client == client; });
+		if(connection != peer.connections.end()) {
+			connection->numUsers--;
+			connection->lastUse = clock::now();
+			connection->failed = connection->failed || !healthy;
+			if(connection->failed && connection->numUsers == 0) {
+				failedClient = std::move(connection->client);
+				peer.connections.erase(connection);
+				connectionOpened.notify_all();
+			}
+		}
+	}
+	if(failedClient != nullptr) {
+		failedClient->Close();
+	}
+}
+
+void ConnectionPool::closeConnections() {
+	std::vector<std::shared_ptr<blazingdb::transport::Client>> idle;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(auto & peer : peers) {
+			auto & connections = peer.second.connections;
+			for(auto it = connections.begin(); it != connections.end();) {
+				if(it->client != nullptr && it->numUsers == 0) {
+					idle.push_back(std::move(it->client));
+					it = connections.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+		connectionOpened.notify_all();
+	}
+	for(auto & client : idle) {
+		client->Close();
+	}
+}
+
+std::size_t ConnectionPool::getNumConnections(const std::string & ip, int16_t port) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = peers.find(getPeerKey(ip, port));
+	return it == peers.end() ? 0 : it->second.connections.size();
+}
+
+std::size_t ConnectionPool::getNumIdleConnections(const std::string & ip, int16_t port) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = peers.find(getPeerKey(ip, port));
+	if(it == peers.end()) {
+		return 0;
+	}
+	return std::count_if(it->second.connections.begin(), it->second.connections.end(),
+		[](const Connection & connection) { return connection.client != nullptr && connection.numUsers == 0; });
+}
+
+}  // namespace network
+}  // namespace communication
+}  // namespace ral
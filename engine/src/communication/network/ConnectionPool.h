@@ -0,0 +1,118 @@
+#pragma once
+
+#include <blazingdb/transport/Client.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace communication {
+namespace network {
+
+class ConnectionPool;
+
+/**
+ * A connection to a peer taken from the ConnectionPool. Connections are multiplexed, so other threads can be using
+ * the same connection at the same time. It stays in the pool only if release() is called, so a connection that was
+ * left in an unknown state (e.g. because a send threw) is closed instead of reused.
+ */
+class PooledConnection {
+public:
+	PooledConnection(ConnectionPool * pool, const std::string & peer, std::shared_ptr<blazingdb::transport::Client> client);
+	PooledConnection(PooledConnection && other);
+	PooledConnection & operator=(PooledConnection &&) = delete;
+	PooledConnection(const PooledConnection &) = delete;
+	PooledConnection & operator=(const PooledConnection &) = delete;
+	~PooledConnection();
+
+	blazingdb::transport::Client * operator->() { return client.get(); }
+
+	/**
+	 * Returns the connection to the pool. Call it after a request completed successfully.
+	 */
+	void release();
+
+private:
+	ConnectionPool * pool;
+	std::string peer;
+	std::shared_ptr<blazingdb::transport::Client> client;
+};
+
+/**
+ * Long lived connections to the other nodes, so sending a message does not need to create a zmq context and socket
+ * and connect it every time.
+ *
+ * Several messages can be in flight on a connection (see blazingdb::transport::Client), so acquire() hands out the
+ * connection with the fewest users and only opens a new one, up to max_connections_per_peer, when all of them are in
+ * use. Connections that were not used for longer than idle_timeout_ms are closed, and so are the ones that failed.
+ */
+class ConnectionPool {
+public:
+	ConnectionPool(std::size_t max_connections_per_peer = 8, int64_t idle_timeout_ms = 60000, std::size_t max_messages_in_flight = 16);
+	~ConnectionPool();
+
+	ConnectionPool(const ConnectionPool &) = delete;
+	ConnectionPool & operator=(const ConnectionPool &) = delete;
+
+	/**
+	 * @param max_messages_in_flight How many messages each new connection can have sent and not acknowledged yet.
+	 */
+	void setLimits(std::size_t max_connections_per_peer, int64_t idle_timeout_ms, std::size_t max_messages_in_flight);
+
+	/**
+	 * Returns the least used connection to the peer, or opens a new one if all of them are in use and the peer has
+	 * connections left.
+	 */
+	PooledConnection acquire(const std::string & ip, int16_t port);
+
+	/**
+	 * Waits until the peer processed the messages sent before through any of its connections. Returns false if the
+	 * peer failed to process any of them.
+	 */
+	bool flush(const std::string & ip, int16_t port);
+
+	/**
+	 * Closes all the idle connections.
+	 */
+	void closeConnections();
+
+	std::size_t getNumConnections(const std::string & ip, int16_t port);
+	std::size_t getNumIdleConnections(const std::string & ip, int16_t port);
+
+private:
+	friend class PooledConnection;
+
+	using clock = std::chrono::steady_clock;
+
+	struct Connection {
+		std::shared_ptr<blazingdb::transport::Client> client;  /**< nullptr while it is being opened */
+		std::size_t numUsers = 0;  /**< leases and flushes using it */
+		bool failed = false;  /**< it is closed when its last user is done */
+		clock::time_point lastUse;
+	};
+
+	struct Peer {
+		std::list<Connection> connections;
+	};
+
+	static std::string getPeerKey(const std::string & ip, int16_t port);
+
+	void giveBack(const std::string & peer, const std::shared_ptr<blazingdb::transport::Client> & client, bool healthy);
+
+	std::mutex mutex;
+	std::condition_variable connectionOpened;
+	std::size_t maxConnectionsPerPeer;
+	std::chrono::milliseconds idleTimeout;
+	std::size_t maxMessagesInFlight;
+	std::map<std::string, Peer> peers;
+};
+
+}  // namespace network
+}  // namespace communication
+}  // namespace ral
@@ -7,12 +7,14 @@ namespace network {
 
 unsigned short Server::port_ = 8000;
 bool Server::use_batch_processing_ = false;
+int Server::num_receive_workers_ = 4;
 std::map<int, Server *> servers_;
 
 // [static]
-void Server::start(unsigned short port, bool use_batch_processing) {
+void Server::start(unsigned short port, bool use_batch_processing, int num_receive_workers) {
 	port_ = port;
 	use_batch_processing_ = use_batch_processing;
+	num_receive_workers_ = num_receive_workers;
 	if(servers_.find(port_) != servers_.end()) {
 		throw std::runtime_error("[server-ral] with the same port");
 	}
@@ -27,9 +29,9 @@ Server & Server::getInstance() { return *servers_[port_]; }
 
 Server::Server() {
 	if (use_batch_processing_ == true) {
-		comm_server = CommServer::BatchProcessing(port_);
+		comm_server = CommServer::BatchProcessing(port_, num_receive_workers_);
 	} else {
-		comm_server = CommServer::TCP(port_);
+		comm_server = CommServer::TCP(port_, num_receive_workers_);
 	};
 	setEndPoints();
 	comm_server->Run();
@@ -16,7 +16,7 @@ using HostCallback = blazingdb::transport::HostCallback;
 
 class Server {
 public:
-	static void start(unsigned short port = 8000, bool use_batch_processing = false);
+	static void start(unsigned short port = 8000, bool use_batch_processing = false, int num_receive_workers = 4);
 
 	static void close();
 
@@ -55,6 +55,7 @@ private:
 private:
 	static unsigned short port_;
 	static bool use_batch_processing_;
+	static int num_receive_workers_;
 };
 
 }  // namespace network
@@ -18,6 +18,8 @@
 #include <spdlog/spdlog.h>
 #include "CodeTimer.h"
 #include "error.hpp"
+#include "utilities/QueryTracer.h"
+#include "distribution/primitives.h"
 
 using namespace fmt::literals;
 
@@ -152,7 +154,36 @@ std::unique_ptr<PartitionedResultSet> runQuery(int32_t masterIndex,
 
 	Context queryContext{ctxToken, contextNodes, contextNodes[masterIndex], "", config_options};
 	ral::communication::network::Server::getInstance().registerContext(ctxToken);
-	
+
+	bool trace_query = false;
+	auto trace_it = config_options.find("ENABLE_QUERY_TRACE");
+	if (trace_it != config_options.end()) {
+		trace_query = trace_it->second == "1" || trace_it->second == "True" || trace_it->second == "true";
+	}
+	if (trace_query) {
+		ral::utilities::QueryTracer::getInstance().startQuery(ctxToken);
+	}
+	auto finish_trace = [&]() {
+		if (trace_query) {
+			std::string trace_dir = "blazing_log";
+			auto dir_it = config_options.find("BLAZING_LOGGING_DIRECTORY");
+			if (dir_it != config_options.end()) {
+				trace_dir = dir_it->second;
+			}
+			int32_t ral_id = queryContext.getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode());
+			std::string trace_path = trace_dir + "/query_trace_" + std::to_string(ral_id) + "_" + std::to_string(ctxToken) + ".json";
+			if (!ral::utilities::QueryTracer::getInstance().finishQuery(ctxToken, ral_id, trace_path)) {
+				std::shared_ptr<spdlog::logger> batch_logger = spdlog::get("batch_logger");
+				batch_logger->warn("{query_id}|{step}|{substep}|{info}|{duration}||||",
+									"query_id"_a=ctxToken,
+									"step"_a=queryContext.getQueryStep(),
+									"substep"_a=queryContext.getQuerySubstep(),
+									"info"_a="Could not write the query trace to " + trace_path,
+									"duration"_a="");
+			}
+		}
+	};
+
 	try {
 
 		CodeTimer eventTimer(true);
@@ -176,8 +207,12 @@ std::unique_ptr<PartitionedResultSet> runQuery(int32_t masterIndex,
 		}
 
 		result->skipdata_analysis_fail = false;
+		finish_trace();
+		ral::distribution::releasePartitionSendBuffers(ctxToken);
 		return result;
 	} catch(const std::exception & e) {
+		finish_trace();
+		ral::distribution::releasePartitionSendBuffers(ctxToken);
 		std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
 		logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
 									"query_id"_a=queryContext.getContextToken(),
@@ -275,6 +310,10 @@ std::unique_ptr<ResultSet> runSkipData(ral::frame::BlazingTableView metadata,
 }
 
 
+std::vector<ral::utilities::MetricsSample> getMetricsSnapshot() {
+	return ral::utilities::MetricsRegistry::getInstance().snapshot();
+}
+
 TableScanInfo getTableScanInfo(std::string logicalPlan){
 
 	std::vector<std::string> relational_algebra_steps, table_names;
@@ -370,3 +409,15 @@ std::pair<std::unique_ptr<ResultSet>, error_code_t> performPartition_C(
 		return std::make_pair(std::move(result), E_EXCEPTION);
 	}
 }
+
+std::pair<std::vector<ral::utilities::MetricsSample>, error_code_t> getMetricsSnapshot_C() {
+
+	std::vector<ral::utilities::MetricsSample> result;
+
+	try {
+		result = getMetricsSnapshot();
+		return std::make_pair(std::move(result), E_SUCCESS);
+	} catch (std::exception& e) {
+		return std::make_pair(std::move(result), E_EXCEPTION);
+	}
+}
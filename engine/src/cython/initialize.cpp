@@ -33,6 +33,10 @@
 #include "communication/network/Server.h"
 #include <bmr/initializer.h>
 #include <bmr/BlazingMemoryResource.h>
+#include "execution_graph/logic_controllers/CacheMachine.h"
+#include "io/data_parser/metadata/parquet_metadata_cache.h"
+#include "execution_graph/logic_controllers/ExpressionPlanCache.h"
+#include "utilities/QueryTracer.h"
 
 #include "error.hpp"
 
@@ -155,6 +159,13 @@ void initialize(int ralId,
 		logging_dir = "";
 	}
 
+	// installed before the server starts, as nothing may log while the output is swapped
+	config_it = config_options.find("LOGGING_ASYNC");
+	if (config_it != config_options.end()){
+		Library::Logging::ServiceLogging::getInstance().setAsyncOutput(
+			config_it->second == "1" || config_it->second == "True" || config_it->second == "true");
+	}
+
 	std::string allocator_logging_file = "";
 	if (enable_logging && !logging_directory_missing){
 		allocator_logging_file = logging_dir + "/allocator." + std::to_string(ralId) + ".log";
@@ -190,17 +201,80 @@ void initialize(int ralId,
 		num_buffers = std::stoi(config_options["TRANSPORT_POOL_NUM_BUFFERS"]);
 	}
 	blazingdb::transport::io::setPinnedBufferProvider(buffers_size, num_buffers);
+	blazingdb::transport::io::getPinnedBufferProvider().setWaitObserver([](int64_t begin_us, int64_t end_us) {
+		ral::utilities::QueryTracer::getInstance().record(ral::utilities::QueryTracer::ANY_QUERY,
+			"network", "PinnedBufferProvider wait", begin_us, end_us);
+	});
 
 	//to avoid redundancy the default value or user defined value for this parameter is placed on the pyblazing side
 	assert( config_options.find("BLAZ_HOST_MEM_CONSUMPTION_THRESHOLD") != config_options.end() );
 	float host_memory_quota = std::stof(config_options["BLAZ_HOST_MEM_CONSUMPTION_THRESHOLD"]);
 
-	blazing_host_memory_resource::getInstance().initialize(host_memory_quota);
+	size_t host_buffer_pool_max_cached_bytes = 1073741824;
+	iter = config_options.find("HOST_BUFFER_POOL_MAX_CACHED_BYTES");
+	if (iter != config_options.end()){
+		host_buffer_pool_max_cached_bytes = std::stoull(config_options["HOST_BUFFER_POOL_MAX_CACHED_BYTES"]);
+	}
+
+	blazing_host_memory_resource::getInstance().initialize(host_memory_quota, host_buffer_pool_max_cached_bytes);
+
+	size_t cache_io_num_threads = 2;
+	iter = config_options.find("CACHE_IO_NUM_THREADS");
+	if (iter != config_options.end()){
+		cache_io_num_threads = std::stoi(config_options["CACHE_IO_NUM_THREADS"]);
+	}
+	ral::cache::initialize_cache_io_pool(cache_io_num_threads);
+
+	size_t parquet_metadata_cache_max_entries = 10000;
+	iter = config_options.find("PARQUET_METADATA_CACHE_MAX_ENTRIES");
+	if (iter != config_options.end()){
+		parquet_metadata_cache_max_entries = std::stoull(config_options["PARQUET_METADATA_CACHE_MAX_ENTRIES"]);
+	}
+	std::string parquet_metadata_cache_directory = "";
+	iter = config_options.find("PARQUET_METADATA_CACHE_DIRECTORY");
+	if (iter != config_options.end()){
+		parquet_metadata_cache_directory = config_options["PARQUET_METADATA_CACHE_DIRECTORY"];
+	}
+	size_t parquet_value_filter_max_bytes = 0;
+	iter = config_options.find("PARQUET_VALUE_FILTER_MAX_BYTES");
+	if (iter != config_options.end()){
+		parquet_value_filter_max_bytes = std::stoull(config_options["PARQUET_VALUE_FILTER_MAX_BYTES"]);
+	}
+	ral::io::parquet_metadata_cache::getInstance().initialize(parquet_metadata_cache_max_entries, parquet_metadata_cache_directory, parquet_value_filter_max_bytes);
+
+	size_t expression_plan_cache_max_entries = 1000;
+	iter = config_options.find("EXPRESSION_PLAN_CACHE_MAX_ENTRIES");
+	if (iter != config_options.end()){
+		expression_plan_cache_max_entries = std::stoull(config_options["EXPRESSION_PLAN_CACHE_MAX_ENTRIES"]);
+	}
+	ral::processor::expression_plan_cache::getInstance().initialize(expression_plan_cache_max_entries);
+
+	size_t max_connections_per_peer = 8;
+	iter = config_options.find("TRANSPORT_MAX_CONNECTIONS_PER_PEER");
+	if (iter != config_options.end()){
+		max_connections_per_peer = std::stoull(config_options["TRANSPORT_MAX_CONNECTIONS_PER_PEER"]);
+	}
+	int64_t connection_idle_timeout_ms = 60000;
+	iter = config_options.find("TRANSPORT_CONNECTION_IDLE_TIMEOUT_MS");
+	if (iter != config_options.end()){
+		connection_idle_timeout_ms = std::stoll(config_options["TRANSPORT_CONNECTION_IDLE_TIMEOUT_MS"]);
+	}
+
+	size_t max_messages_in_flight = 16;
+	iter = config_options.find("TRANSPORT_MAX_MESSAGES_IN_FLIGHT");
+	if (iter != config_options.end()){
+		max_messages_in_flight = std::stoull(config_options["TRANSPORT_MAX_MESSAGES_IN_FLIGHT"]);
+	}
+	int num_receive_workers = 4;
+	iter = config_options.find("TRANSPORT_RECEIVE_WORKERS");
+	if (iter != config_options.end()){
+		num_receive_workers = std::stoi(config_options["TRANSPORT_RECEIVE_WORKERS"]);
+	}
 
 	auto & communicationData = ral::communication::CommunicationData::getInstance();
-	communicationData.initialize(ralId, "1.1.1.1", 0, ralHost, ralCommunicationPort, 0);
+	communicationData.initialize(ralId, "1.1.1.1", 0, ralHost, ralCommunicationPort, 0, max_connections_per_peer, connection_idle_timeout_ms, max_messages_in_flight);
 
-	ral::communication::network::Server::start(ralCommunicationPort, true);
+	ral::communication::network::Server::start(ralCommunicationPort, true, num_receive_workers);
 
 	if(singleNode == true) {
 		ral::communication::network::Server::getInstance().close();
@@ -313,6 +387,10 @@ void initialize(int ralId,
 void finalize() {
 	ral::communication::network::Client::closeConnections();
 	ral::communication::network::Server::getInstance().close();
+	// writes what is left in the async log output before exit
+	Library::Logging::ServiceLogging::getInstance().setAsyncOutput(false);
+	// the plans hold device scalars, which have to go before the memory resource
+	ral::processor::expression_plan_cache::getInstance().clear();
 	BlazingRMMFinalize();
 	spdlog::shutdown();
 	cudaDeviceReset();
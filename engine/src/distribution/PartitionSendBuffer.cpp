@@ -0,0 +1,57 @@
+#include "distribution/PartitionSendBuffer.h"
+
+#include <blazingdb/transport/ColumnTransport.h>
+
+namespace ral {
+namespace distribution {
+
+namespace {
+
+std::string getNodeKey(const blazingdb::transport::Node & node) {
+	const auto & metadata = node.address().metadata();
+	return std::string(metadata.ip) + ":" + std::to_string(metadata.comunication_port);
+}
+
+}  // namespace
+
+PartitionSendBuffer::PartitionSendBuffer(std::size_t max_bytes, int64_t max_delay_ms)
+	: maxBytes{max_bytes}, maxDelay{max_delay_ms} {}
+
+std::vector<PartitionSendBuffer::Batch> PartitionSendBuffer::add(const blazingdb::transport::Node & destination,
+	int32_t partition_id,
+	std::unique_ptr<ral::frame::BlazingHostTable> table) {
+	std::vector<Batch> ready;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto now = clock::now();
+
+	auto key = std::make_pair(getNodeKey(destination), partition_id);
+	auto it = pending.find(key);
+	if(it == pending.end()) {
+		it = pending.emplace(key, PendingBatch{Batch{destination, partition_id, {}}, 0, now}).first;
+	}
+	it->second.num_bytes += table->sizeInBytes();
+	it->second.batch.tables.push_back(std::move(table));
+
+	for(auto batch = pending.begin(); batch != pending.end();) {
+		if(batch->second.num_bytes >= maxBytes || now - batch->second.first_added >= maxDelay) {
+			ready.push_back(std::move(batch->second.batch));
+			batch = pending.erase(batch);
+		} else {
+			++batch;
+		}
+	}
+	return ready;
+}
+
+std::vector<PartitionSendBuffer::Batch> PartitionSendBuffer::takeAll() {
+	std::vector<Batch> ready;
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto & batch : pending) {
+		ready.push_back(std::move(batch.second.batch));
+	}
+	pending.clear();
+	return ready;
+}
+
+}  // namespace distribution
+}  // namespace ral
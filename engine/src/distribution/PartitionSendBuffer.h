@@ -0,0 +1,72 @@
+#pragma once
+
+#include <blazingdb/transport/Node.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "execution_graph/logic_controllers/BlazingHostTable.h"
+
+namespace ral {
+namespace distribution {
+
+/**
+ * Accumulates the small partitions sent to the same node with the same partition id, so the partitions of many input
+ * batches are sent as one message (see HostTablesMessage) instead of one message each.
+ *
+ * The partitions are added already copied to host memory, since the batch they come from is released once it was
+ * distributed. The partitions of a node and partition id are taken out for sending once they add up to max_bytes, or
+ * once the oldest of them waited for max_delay_ms. The delay is only checked when a partition is added, so whatever is
+ * still buffered after the last partition has to be taken out with takeAll().
+ */
+class PartitionSendBuffer {
+public:
+	/**
+	 * The partitions to send in a single message.
+	 */
+	struct Batch {
+		blazingdb::transport::Node destination;
+		int32_t partition_id;
+		std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> tables;
+	};
+
+	PartitionSendBuffer(std::size_t max_bytes, int64_t max_delay_ms);
+
+	/**
+	 * Whether a partition of this size is buffered at all. Partitions as big as max_bytes are better sent right away.
+	 */
+	bool accepts(std::size_t num_bytes) const { return num_bytes < maxBytes; }
+
+	/**
+	 * Adds a partition and returns the batches that are ready to be sent: the one of this partition if it is full,
+	 * and any other batch that waited for too long.
+	 */
+	std::vector<Batch> add(const blazingdb::transport::Node & destination, int32_t partition_id,
+		std::unique_ptr<ral::frame::BlazingHostTable> table);
+
+	/**
+	 * Returns all the buffered batches and leaves the buffer empty.
+	 */
+	std::vector<Batch> takeAll();
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct PendingBatch {
+		Batch batch;
+		std::size_t num_bytes = 0;
+		clock::time_point first_added;
+	};
+
+	std::mutex mutex;
+	const std::size_t maxBytes;
+	const std::chrono::milliseconds maxDelay;
+	std::map<std::pair<std::string, int32_t>, PendingBatch> pending;  /**< by node and partition id */
+};
+
+}  // namespace distribution
+}  // namespace ral
@@ -1,10 +1,13 @@
 #include "distribution/primitives.h"
+#include "distribution/PartitionSendBuffer.h"
 #include "CalciteExpressionParsing.h"
 #include "communication/CommunicationData.h"
 #include "communication/network/Client.h"
 #include "communication/network/Server.h"
 #include "utilities/StringUtils.h"
 #include <cmath>
+#include <map>
+#include <mutex>
 
 #include <cudf/search.hpp>
 #include <cudf/sorting.hpp>
@@ -191,21 +194,88 @@ std::vector<NodeColumnView> partitionData(Context * context,
 	return partitioned_node_column_views;
 }
 
-void distributeTablePartitions(Context * context, std::vector<NodeColumnView> & partitions, const std::vector<int32_t> & part_ids) {
+namespace {
 
-	std::string context_comm_token = context->getContextCommunicationToken();
-	const uint32_t context_token = context->getContextToken();
-	const std::string message_id = ColumnDataPartitionMessage::MessageID() + "_" + context_comm_token;
+std::mutex partition_send_buffers_mutex;
+std::map<std::pair<uint32_t, std::string>, std::shared_ptr<PartitionSendBuffer>> partition_send_buffers;  // by context token and message id
 
-	auto self_node = CommunicationData::getInstance().getSelfNode();
+/**
+ * The buffer for the partitions of a query sent with message_id, or nullptr if small partitions are not coalesced.
+ */
+std::shared_ptr<PartitionSendBuffer> getPartitionSendBuffer(Context * context, const std::string & message_id) {
+	std::size_t max_bytes = 4194304; // 4 MB
+	int64_t max_delay_ms = 100;
+	std::map<std::string, std::string> config_options = context->getConfigOptions();
+	auto it = config_options.find("PARTITION_SEND_BUFFER_BYTE_SIZE");
+	if (it != config_options.end()){
+		max_bytes = std::stoull(config_options["PARTITION_SEND_BUFFER_BYTE_SIZE"]);
+	}
+	it = config_options.find("PARTITION_SEND_BUFFER_MAX_DELAY_MS");
+	if (it != config_options.end()){
+		max_delay_ms = std::stoll(config_options["PARTITION_SEND_BUFFER_MAX_DELAY_MS"]);
+	}
+	if (max_bytes == 0) {
+		return nullptr;
+	}
 
+	std::lock_guard<std::mutex> lock(partition_send_buffers_mutex);
+	auto & send_buffer = partition_send_buffers[std::make_pair(context->getContextToken(), message_id)];
+	if (send_buffer == nullptr) {
+		send_buffer = std::make_shared<PartitionSendBuffer>(max_bytes, max_delay_ms);
+	}
+	return send_buffer;
+}
+
+/**
+ * Removes the buffer for the partitions of a query sent with message_id, which can be nullptr if it had none.
+ */
+std::shared_ptr<PartitionSendBuffer> releasePartitionSendBuffer(uint32_t context_token, const std::string & message_id) {
+	std::lock_guard<std::mutex> lock(partition_send_buffers_mutex);
+	auto it = partition_send_buffers.find(std::make_pair(context_token, message_id));
+	if (it == partition_send_buffers.end()) {
+		return nullptr;
+	}
+	auto send_buffer = it->second;
+	partition_send_buffers.erase(it);
+	return send_buffer;
+}
+
+int getMaxSendMessageThreads(Context * context) {
 	int max_message_threads = 20;
 	std::map<std::string, std::string> config_options = context->getConfigOptions();
 	auto it = config_options.find("MAX_SEND_MESSAGE_THREADS");
 	if (it != config_options.end()){
 		max_message_threads = std::stoi(config_options["MAX_SEND_MESSAGE_THREADS"]);
 	}
-	ctpl::thread_pool<BlazingThread> pool(max_message_threads);
+	return max_message_threads;
+}
+
+void sendPartitionBatches(ctpl::thread_pool<BlazingThread> & pool, std::vector<std::future<void>> & futures,
+		const std::string & message_id, uint32_t context_token, Node self_node,
+		std::vector<PartitionSendBuffer::Batch> && batches) {
+	for (auto & batch : batches) {
+		auto shared_batch = std::make_shared<PartitionSendBuffer::Batch>(std::move(batch));
+		futures.push_back(pool.push(([message_id, context_token, self_node, shared_batch](int thread_id) mutable {
+			auto message = Factory::createHostTablesMessage(message_id, context_token, self_node, shared_batch->partition_id, std::move(shared_batch->tables));
+			Client::send(shared_batch->destination, *message);
+		})));
+	}
+}
+
+}  // namespace
+
+void distributeTablePartitions(Context * context, std::vector<NodeColumnView> & partitions, const std::vector<int32_t> & part_ids) {
+
+	std::string context_comm_token = context->getContextCommunicationToken();
+	const uint32_t context_token = context->getContextToken();
+	const std::string message_id = ColumnDataPartitionMessage::MessageID() + "_" + context_comm_token;
+
+	auto self_node = CommunicationData::getInstance().getSelfNode();
+
+	// the small partitions are held back and sent together with the ones of the next batches
+	std::shared_ptr<PartitionSendBuffer> send_buffer = getPartitionSendBuffer(context, message_id);
+
+	ctpl::thread_pool<BlazingThread> pool(getMaxSendMessageThreads(context));
 	std::vector<std::future<void>> futures;
 	for (auto i = 0; i < partitions.size(); i++){
 		auto & nodeColumn = partitions[i];
@@ -218,6 +288,13 @@ void distributeTablePartitions(Context * context, std::vector<NodeColumnView> &
 			auto destination_node = nodeColumn.first;
 			int partition_id = part_ids.size() > i ? part_ids[i] : 0; // if part_ids is not set, then it does not matter and we can just use 0 as the partition_id
 
+			if (send_buffer != nullptr && send_buffer->accepts(ral::utilities::get_table_size_bytes(columns))) {
+				auto host_table = ral::communication::messages::serialize_gpu_message_to_host_table(columns);
+				sendPartitionBatches(pool, futures, message_id, context_token, self_node,
+					send_buffer->add(destination_node, partition_id, std::move(host_table)));
+				continue;
+			}
+
 			futures.push_back(pool.push(([message_id, context_token, self_node, destination_node, columns, partition_id](int thread_id) mutable {
 				auto message = Factory::createColumnDataPartitionMessage(message_id, context_token, self_node, partition_id, columns);
 				Client::send(destination_node, *message);
@@ -236,12 +313,33 @@ void distributeTablePartitions(Context * context, std::vector<NodeColumnView> &
 	pool.stop(true);
 }
 
+void releasePartitionSendBuffers(uint32_t context_token) {
+	std::lock_guard<std::mutex> lock(partition_send_buffers_mutex);
+	auto it = partition_send_buffers.lower_bound(std::make_pair(context_token, std::string()));
+	while (it != partition_send_buffers.end() && it->first.first == context_token) {
+		it = partition_send_buffers.erase(it);
+	}
+}
+
 void notifyLastTablePartitions(Context * context, std::string message_id) {
 	std::string context_comm_token = context->getContextCommunicationToken();
 	const uint32_t context_token = context->getContextToken();
 	const std::string full_message_id = message_id + "_" + context_comm_token;
 
 	auto self_node = CommunicationData::getInstance().getSelfNode();
+
+	// the partitions still buffered have to arrive before the last event
+	std::shared_ptr<PartitionSendBuffer> send_buffer = releasePartitionSendBuffer(context_token, full_message_id);
+	if (send_buffer != nullptr) {
+		ctpl::thread_pool<BlazingThread> pool(getMaxSendMessageThreads(context));
+		std::vector<std::future<void>> futures;
+		sendPartitionBatches(pool, futures, full_message_id, context_token, self_node, send_buffer->takeAll());
+		for(int i = 0; i < futures.size(); i++){
+			futures[i].get();
+		}
+		pool.stop(true);
+	}
+
 	auto nodes = context->getAllNodes();
 	for(std::size_t i = 0; i < nodes.size(); ++i) {
 		if(!(nodes[i] == self_node)) {
@@ -261,13 +359,7 @@ void distributePartitions(Context * context, std::vector<NodeColumnView> & parti
 
 	auto self_node = CommunicationData::getInstance().getSelfNode();
 	
-	int max_message_threads = 20;
-	std::map<std::string, std::string> config_options = context->getConfigOptions();
-	auto it = config_options.find("MAX_SEND_MESSAGE_THREADS");
-	if (it != config_options.end()){
-		max_message_threads = std::stoi(config_options["MAX_SEND_MESSAGE_THREADS"]);
-	}
-	ctpl::thread_pool<BlazingThread> pool(max_message_threads);
+	ctpl::thread_pool<BlazingThread> pool(getMaxSendMessageThreads(context));
 	std::vector<std::future<void>> futures;
 	for(auto & nodeColumn : partitions) {
 		if(nodeColumn.first == self_node) {
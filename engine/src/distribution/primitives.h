@@ -41,6 +41,10 @@ namespace distribution {
 
 	void notifyLastTablePartitions(Context * context, std::string message_id);
 
+	// Drops the partitions of a query that distributeTablePartitions still holds back, for the queries that fail or
+	// are cancelled before notifyLastTablePartitions sends them. Called when the query is torn down.
+	void releasePartitionSendBuffers(uint32_t context_token);
+
 	void distributePartitions(Context * context, std::vector<NodeColumnView> & partitions);
 
 	std::vector<NodeColumn> collectPartitions(Context * context);
@@ -25,77 +25,90 @@ public:
 	ComputeAggregateKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
 		: kernel{kernel_id, queryString, context, kernel_type::ComputeAggregateKernel} {
         this->query_graph = query_graph;
+
+        std::tie(this->group_column_indices, this->aggregation_input_expressions, this->aggregation_types,
+            this->aggregation_column_assigned_aliases) = ral::operators::parseGroupByExpression(this->expression);
 	}
 
     bool can_you_throttle_my_input() {
 		return true;
 	}
 
-	virtual kstatus run() {
-		CodeTimer timer;
+    /**
+     * Indicates whether the kernel can be executed as a sequence of per batch tasks.
+     * @return true Each batch is aggregated independently, the partial results are merged by MergeAggregateKernel.
+     */
+    bool is_task_based() {
+        return true;
+    }
+
+    /**
+     * Aggregates one batch and adds the result to the output cache.
+     * @param batch The batch to process.
+     */
+    void process_batch(std::unique_ptr<ral::frame::BlazingTable> batch) {
         CodeTimer eventTimer(false);
+        eventTimer.start();
 
-        std::vector<std::string> aggregation_input_expressions, aggregation_column_assigned_aliases;
-        std::tie(this->group_column_indices, aggregation_input_expressions, this->aggregation_types,
-            aggregation_column_assigned_aliases) = ral::operators::parseGroupByExpression(this->expression);
+        auto log_input_num_rows = batch ? batch->num_rows() : 0;
+        auto log_input_num_bytes = batch ? batch->sizeInBytes() : 0;
+
+        try {
+            std::unique_ptr<ral::frame::BlazingTable> output;
+            if(this->aggregation_types.size() == 0) {
+                output = ral::operators::compute_groupby_without_aggregations(
+                        batch->toBlazingTableView(), this->group_column_indices);
+            } else if (this->group_column_indices.size() == 0) {
+                output = ral::operators::compute_aggregations_without_groupby(
+                        batch->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases);
+            } else {
+                output = ral::operators::compute_aggregations_with_groupby(
+                    batch->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases, group_column_indices);
+            }
+
+            eventTimer.stop();
+
+            if(output){
+                auto log_output_num_rows = output->num_rows();
+                auto log_output_num_bytes = output->sizeInBytes();
+
+                events_logger->info("{ral_id}|{query_id}|{kernel_id}|{input_num_rows}|{input_num_bytes}|{output_num_rows}|{output_num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
+                                "ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
+                                "query_id"_a=context->getContextToken(),
+                                "kernel_id"_a=this->get_id(),
+                                "input_num_rows"_a=log_input_num_rows,
+                                "input_num_bytes"_a=log_input_num_bytes,
+                                "output_num_rows"_a=log_output_num_rows,
+                                "output_num_bytes"_a=log_output_num_bytes,
+                                "event_type"_a="compute",
+                                "timestamp_begin"_a=eventTimer.start_time(),
+                                "timestamp_end"_a=eventTimer.end_time());
+            }
+
+            this->add_to_output_cache(std::move(output));
+            batch_count++;
+        } catch(const std::exception& e) {
+            // TODO add retry here
+            logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
+                        "query_id"_a=context->getContextToken(),
+                        "step"_a=context->getQueryStep(),
+                        "substep"_a=context->getQuerySubstep(),
+                        "info"_a="In ComputeAggregate kernel batch {} for {}. What: {}"_format(batch_count, expression, e.what()),
+                        "duration"_a="");
+            throw;
+        }
+    }
+
+	virtual kstatus run() {
+		CodeTimer timer;
 
         bool ordered = false; // If we start using sort based aggregations this may need to change
         BatchSequence input(this->input_cache(), this, ordered);
-        int batch_count = 0;
         while (input.wait_for_next()) {
 
             this->output_cache()->wait_if_cache_is_saturated();
             auto batch = input.next();
-
-            eventTimer.start();
-
-            auto log_input_num_rows = batch ? batch->num_rows() : 0;
-            auto log_input_num_bytes = batch ? batch->sizeInBytes() : 0;
-
-            try {
-                std::unique_ptr<ral::frame::BlazingTable> output;
-                if(this->aggregation_types.size() == 0) {
-                    output = ral::operators::compute_groupby_without_aggregations(
-                            batch->toBlazingTableView(), this->group_column_indices);
-                } else if (this->group_column_indices.size() == 0) {
-                    output = ral::operators::compute_aggregations_without_groupby(
-                            batch->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases);
-                } else {
-                    output = ral::operators::compute_aggregations_with_groupby(
-                        batch->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases, group_column_indices);
-                }
-
-                eventTimer.stop();
-
-                if(output){
-                    auto log_output_num_rows = output->num_rows();
-                    auto log_output_num_bytes = output->sizeInBytes();
-
-                    events_logger->info("{ral_id}|{query_id}|{kernel_id}|{input_num_rows}|{input_num_bytes}|{output_num_rows}|{output_num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
-                                    "ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
-                                    "query_id"_a=context->getContextToken(),
-                                    "kernel_id"_a=this->get_id(),
-                                    "input_num_rows"_a=log_input_num_rows,
-                                    "input_num_bytes"_a=log_input_num_bytes,
-                                    "output_num_rows"_a=log_output_num_rows,
-                                    "output_num_bytes"_a=log_output_num_bytes,
-                                    "event_type"_a="compute",
-                                    "timestamp_begin"_a=eventTimer.start_time(),
-                                    "timestamp_end"_a=eventTimer.end_time());
-                }
-
-                this->add_to_output_cache(std::move(output));
-                batch_count++;
-            } catch(const std::exception& e) {
-                // TODO add retry here
-                logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
-                            "query_id"_a=context->getContextToken(),
-                            "step"_a=context->getQueryStep(),
-                            "substep"_a=context->getQuerySubstep(),
-                            "info"_a="In ComputeAggregate kernel batch {} for {}. What: {}"_format(batch_count, expression, e.what()),
-                            "duration"_a="");
-                throw;
-            }
+            process_batch(std::move(batch));
         }
 
         logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
@@ -131,6 +144,9 @@ public:
 private:
     std::vector<AggregateKind> aggregation_types;
     std::vector<int> group_column_indices;
+    std::vector<std::string> aggregation_input_expressions;
+    std::vector<std::string> aggregation_column_assigned_aliases;
+    int batch_count = 0; /**< Number of batches processed so far. */
 };
 
 class DistributeAggregateKernel : public kernel {
@@ -272,6 +288,16 @@ private:
 };
 
 
+/**
+ * Merges the partial aggregations of the ComputeAggregateKernel (or the ones received from the other nodes).
+ *
+ * By default the partials are merged as they arrive instead of waiting for all of them: the batches are kept in a
+ * CacheMachine, so they are spilled to host memory or disk when the GPU is full, and once two or more partials of the
+ * same level add up to MERGE_AGGREGATE_PARTIAL_BYTE_SIZE they are merged into one partial of the next level. This is a
+ * tree of merges, so every row is merged a logarithmic number of times even when the merges do not shrink the data.
+ * What is left on every level is merged once all the input arrived. Setting MERGE_AGGREGATE_PARTIAL_BYTE_SIZE to 0
+ * merges all the input at once at the end.
+ */
 class MergeAggregateKernel : public kernel {
 public:
 	MergeAggregateKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
@@ -287,70 +313,60 @@ public:
         CodeTimer timer;
         CodeTimer eventTimer(false);
 
-        std::vector<std::unique_ptr<ral::frame::BlazingTable>> tablesToConcat;
-		std::vector<ral::frame::BlazingTableView> tableViewsToConcat;
+        std::vector<std::string> aggregation_input_expressions, aggregation_column_assigned_aliases;
+        std::tie(this->group_column_indices, aggregation_input_expressions, this->aggregation_types,
+            aggregation_column_assigned_aliases) = ral::operators::parseGroupByExpression(this->expression);
+
+        std::size_t partial_byte_size = 268435456; // 256 MB
+        std::map<std::string, std::string> config_options = context->getConfigOptions();
+        auto it = config_options.find("MERGE_AGGREGATE_PARTIAL_BYTE_SIZE");
+        if (it != config_options.end()){
+            partial_byte_size = std::stoull(config_options["MERGE_AGGREGATE_PARTIAL_BYTE_SIZE"]);
+        }
+        // aggregations without groupby only hold an empty table on the nodes other than the master, they are just passed on
+        bool merge_incrementally = partial_byte_size > 0 && (this->group_column_indices.size() > 0 || this->aggregation_types.size() == 0 ||
+            context->isMasterNode(ral::communication::CommunicationData::getInstance().getSelfNode()));
 
-        // This Kernel needs all of the input before it can do any output. So lets wait until all the input is available
-        this->input_cache()->wait_until_finished();
+        std::unique_ptr<ral::cache::CacheMachine> partials_cache;
+        if (merge_incrementally) {
+            partials_cache = std::make_unique<ral::cache::CacheMachine>(context);
+        } else {
+            // This Kernel needs all of the input before it can do any output. So lets wait until all the input is available
+            this->input_cache()->wait_until_finished();
+        }
 
         bool ordered = false; // If we start using sort based aggregations this may need to change
         BatchSequence input(this->input_cache(), this, ordered);
         int batch_count=0;
+        std::vector<std::unique_ptr<ral::frame::BlazingTable>> tablesToMerge;
         try {
             while (input.wait_for_next()) {
                 auto batch = input.next();
-                // std::cout<<"MergeAggregateKernel batch "<<batch_count<<std::endl;
-                // ral::utilities::print_blazing_table_view_schema(batch->toBlazingTableView(), "MergeAggregateKernel_batch" + std::to_string(batch_count));
                 batch_count++;
-                tableViewsToConcat.emplace_back(batch->toBlazingTableView());
-                tablesToConcat.emplace_back(std::move(batch));
+                if (merge_incrementally) {
+                    addPartial(*partials_cache, 0, std::move(batch), partial_byte_size);
+                } else {
+                    tablesToMerge.emplace_back(std::move(batch));
+                }
             }
             eventTimer.start();
 
-			if( ral::utilities::checkIfConcatenatingStringsWillOverflow(tableViewsToConcat)) {
-				logger->warn("{query_id}|{step}|{substep}|{info}",
-								"query_id"_a=(context ? std::to_string(context->getContextToken()) : ""),
-								"step"_a=(context ? std::to_string(context->getQueryStep()) : ""),
-								"substep"_a=(context ? std::to_string(context->getQuerySubstep()) : ""),
-								"info"_a="In MergeAggregateKernel::run Concatenating Strings will overflow strings length");
-			}
-            auto concatenated = ral::utilities::concatTables(tableViewsToConcat);
-
-            auto log_input_num_rows = concatenated ? concatenated->num_rows() : 0;
-            auto log_input_num_bytes = concatenated ? concatenated->sizeInBytes() : 0;
-
-            std::vector<int> group_column_indices;
-            std::vector<std::string> aggregation_input_expressions, aggregation_column_assigned_aliases;
-            std::vector<AggregateKind> aggregation_types;
-            std::tie(group_column_indices, aggregation_input_expressions, aggregation_types,
-                aggregation_column_assigned_aliases) = ral::operators::parseGroupByExpression(this->expression);
-
-            std::vector<int> mod_group_column_indices;
-            std::vector<std::string> mod_aggregation_input_expressions, mod_aggregation_column_assigned_aliases, merging_column_names;
-            std::vector<AggregateKind> mod_aggregation_types;
-            std::tie(mod_group_column_indices, mod_aggregation_input_expressions, mod_aggregation_types,
-                mod_aggregation_column_assigned_aliases) = ral::operators::modGroupByParametersForMerge(
-                group_column_indices, aggregation_types, concatenated->names());
-
-            std::unique_ptr<ral::frame::BlazingTable> output;
-            if(aggregation_types.size() == 0) {
-                output = ral::operators::compute_groupby_without_aggregations(
-                        concatenated->toBlazingTableView(), mod_group_column_indices);
-            } else if (group_column_indices.size() == 0) {
-                // aggregations without groupby are only merged on the master node
-                if(context->isMasterNode(ral::communication::CommunicationData::getInstance().getSelfNode())) {
-                    output = ral::operators::compute_aggregations_without_groupby(
-                            concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
-                            mod_aggregation_column_assigned_aliases);
-                } else {
-                    // with aggregations without groupby the distribution phase should deposit an empty dataframe with the right schema into the cache, which is then output here
-                    output = std::move(concatenated);
+            if (merge_incrementally) {
+                for (std::size_t level = 0; level < partial_levels.size(); level++) {
+                    for (auto && partial : takePartials(*partials_cache, level)) {
+                        tablesToMerge.emplace_back(std::move(partial));
+                    }
                 }
-            } else {
-                output = ral::operators::compute_aggregations_with_groupby(
-                        concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
-                        mod_aggregation_column_assigned_aliases, mod_group_column_indices);
             }
+
+            std::size_t log_input_num_rows = 0;
+            std::size_t log_input_num_bytes = 0;
+            for (auto & table : tablesToMerge) {
+                log_input_num_rows += table->num_rows();
+                log_input_num_bytes += table->sizeInBytes();
+            }
+
+            std::unique_ptr<ral::frame::BlazingTable> output = mergePartials(tablesToMerge);
             // ral::utilities::print_blazing_table_view_schema(output->toBlazingTableView(), "MergeAggregateKernel_output");
             eventTimer.stop();
 
@@ -399,7 +415,99 @@ public:
     }
 
 private:
+    /**
+     * The partials of one level of the merge tree that are in the partials cache.
+     */
+    struct PartialLevel {
+        std::vector<std::string> message_ids;
+        std::size_t num_bytes = 0;
+    };
+
+    /**
+     * Adds a partial to a level of the merge tree, and merges the level into the next one once it has more than one
+     * partial and they add up to partial_byte_size.
+     */
+    void addPartial(ral::cache::CacheMachine & partials_cache, std::size_t level,
+            std::unique_ptr<ral::frame::BlazingTable> partial, std::size_t partial_byte_size) {
+        if (partial_levels.size() <= level) {
+            partial_levels.resize(level + 1);
+        }
+        auto & partial_level = partial_levels[level];
+        std::string message_id = "partial_" + std::to_string(level) + "_" + std::to_string(num_partials_added++);
+        partial_level.num_bytes += partial->sizeInBytes();
+        partial_level.message_ids.push_back(message_id);
+        // empty partials are kept too, so every message id can be pulled back
+        partials_cache.addToCache(std::move(partial), message_id, true);
+
+        if (partial_level.message_ids.size() > 1 && partial_level.num_bytes >= partial_byte_size) {
+            auto partials = takePartials(partials_cache, level);
+            auto merged = mergePartials(partials);
+            partials.clear();
+            addPartial(partials_cache, level + 1, std::move(merged), partial_byte_size);
+        }
+    }
+
+    /**
+     * Pulls all the partials of a level of the merge tree out of the partials cache.
+     */
+    std::vector<std::unique_ptr<ral::frame::BlazingTable>> takePartials(ral::cache::CacheMachine & partials_cache, std::size_t level) {
+        std::vector<std::unique_ptr<ral::frame::BlazingTable>> partials;
+        for (auto & message_id : partial_levels[level].message_ids) {
+            partials.push_back(partials_cache.pullCacheData(message_id)->decache());
+        }
+        partial_levels[level] = PartialLevel{};
+        return partials;
+    }
+
+    /**
+     * Concatenates partial aggregations and merges them. The output has the same schema as the partials, so it can be
+     * merged again.
+     */
+    std::unique_ptr<ral::frame::BlazingTable> mergePartials(const std::vector<std::unique_ptr<ral::frame::BlazingTable>> & partials) {
+        std::vector<ral::frame::BlazingTableView> tableViewsToConcat;
+        for (auto & partial : partials) {
+            tableViewsToConcat.emplace_back(partial->toBlazingTableView());
+        }
+        if( ral::utilities::checkIfConcatenatingStringsWillOverflow(tableViewsToConcat)) {
+            logger->warn("{query_id}|{step}|{substep}|{info}",
+                            "query_id"_a=(context ? std::to_string(context->getContextToken()) : ""),
+                            "step"_a=(context ? std::to_string(context->getQueryStep()) : ""),
+                            "substep"_a=(context ? std::to_string(context->getQuerySubstep()) : ""),
+                            "info"_a="In MergeAggregateKernel::run Concatenating Strings will overflow strings length");
+        }
+        auto concatenated = ral::utilities::concatTables(tableViewsToConcat);
+
+        std::vector<int> mod_group_column_indices;
+        std::vector<std::string> mod_aggregation_input_expressions, mod_aggregation_column_assigned_aliases;
+        std::vector<AggregateKind> mod_aggregation_types;
+        std::tie(mod_group_column_indices, mod_aggregation_input_expressions, mod_aggregation_types,
+            mod_aggregation_column_assigned_aliases) = ral::operators::modGroupByParametersForMerge(
+            this->group_column_indices, this->aggregation_types, concatenated->names());
+
+        if(this->aggregation_types.size() == 0) {
+            return ral::operators::compute_groupby_without_aggregations(
+                    concatenated->toBlazingTableView(), mod_group_column_indices);
+        } else if (this->group_column_indices.size() == 0) {
+            // aggregations without groupby are only merged on the master node
+            if(context->isMasterNode(ral::communication::CommunicationData::getInstance().getSelfNode())) {
+                return ral::operators::compute_aggregations_without_groupby(
+                        concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
+                        mod_aggregation_column_assigned_aliases);
+            } else {
+                // with aggregations without groupby the distribution phase should deposit an empty dataframe with the right schema into the cache, which is then output here
+                return concatenated;
+            }
+        } else {
+            return ral::operators::compute_aggregations_with_groupby(
+                    concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
+                    mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+        }
+    }
 
+    std::vector<int> group_column_indices;
+    std::vector<AggregateKind> aggregation_types;
+    std::vector<PartialLevel> partial_levels;  /**< the partials not merged yet, by level of the merge tree */
+    std::size_t num_partials_added = 0;
 };
 
 
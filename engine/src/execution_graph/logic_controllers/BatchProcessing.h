@@ -20,6 +20,8 @@
 #include <src/operators/GroupBy.h>
 #include <src/utilities/DebuggingUtils.h>
 #include <stack>
+#include <deque>
+#include <numeric>
 #include <mutex>
 #include "io/DataLoader.h"
 #include "io/Schema.h"
@@ -106,6 +108,10 @@ public:
 			auto num_rows = output->num_rows();
 			auto num_bytes = output->sizeInBytes();
 
+			if(kernel) {
+				kernel->record_input_metrics(num_rows, num_bytes, cacheEventTimer);
+			}
+
 			if(cache_events_logger != nullptr) {
 				cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
 							"ral_id"_a=cache->get_context()->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
@@ -190,6 +196,10 @@ public:
 			auto num_rows = output->num_rows();
 			auto num_bytes = output->sizeInBytes();
 
+			if(kernel) {
+				kernel->record_input_metrics(num_rows, num_bytes, cacheEventTimer);
+			}
+
 			cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
 							"ral_id"_a=cache->get_context()->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
 							"query_id"_a=cache->get_context()->getContextToken(),
@@ -265,9 +275,14 @@ public:
 					}	else{
 						auto concreteMessage = std::static_pointer_cast<ReceivedHostMessage>(message);
 						assert(concreteMessage != nullptr);
-						auto host_table = concreteMessage->releaseBlazingHostTable();
-						host_table->setPartitionId(concreteMessage->getPartitionId());
-						this->host_cache->addToCache(std::move(host_table), message_id);
+						// a message can frame several tables of the same partition
+						for (auto & host_table : concreteMessage->releaseBlazingHostTables()) {
+							if (this->kernel) {
+								this->kernel->metrics->network_bytes_in.add(host_table->sizeInBytes());
+							}
+							host_table->setPartitionId(concreteMessage->getPartitionId());
+							this->host_cache->addToCache(std::move(host_table), message_id);
+						}
 					}
 			}
 		});
@@ -301,6 +316,10 @@ public:
 			auto num_rows = output->num_rows();
 			auto num_bytes = output->sizeInBytes();
 
+			if(kernel) {
+				kernel->record_input_metrics(num_rows, num_bytes, cacheEventTimer);
+			}
+
 			cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
 							"ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
 							"query_id"_a=context->getContextToken(),
@@ -335,7 +354,7 @@ public:
 	 * @param context Shared context associated to the running query.
 	 */
 	DataSourceSequence(ral::io::data_loader &loader, ral::io::Schema & schema, std::shared_ptr<Context> context)
-		: context(context), loader(loader), schema(schema), batch_index{0}, cur_file_index{0}, cur_row_group_index{0}, n_batches{0}
+		: context(context), loader(loader), schema(schema), batch_index{0}, files_dispatched{0}, cur_file_index{0}, cur_row_group_index{0}, n_batches{0}, batch_num_bytes{0}
 	{
 		// n_partitions{n_partitions}: TODO Update n_batches using data_loader
 		this->provider = loader.get_provider();
@@ -353,6 +372,12 @@ public:
 		} else {
 			n_batches = n_files;
 		}
+
+		std::map<std::string, std::string> config_options = context->getConfigOptions();
+		auto it = config_options.find("NUM_BYTES_PER_TABLE_SCAN_BATCH");
+		if (it != config_options.end()){
+			batch_num_bytes = std::stoull(config_options["NUM_BYTES_PER_TABLE_SCAN_BATCH"]);
+		}
 	}
 
 	/**
@@ -363,7 +388,7 @@ public:
 	RecordBatch next() {
 		std::unique_lock<std::mutex> lock(mutex_);
 
-		if (!has_next()) {
+		if (!has_next_unsafe()) {
 			return nullptr;
 		}
 
@@ -373,13 +398,26 @@ public:
 		}
 
 		if(is_gdf_parser){
-			auto ret = loader.load_batch(context.get(), projections, schema, ral::io::data_handle(), 0, std::vector<cudf::size_type>(1, cur_row_group_index));
+			auto ret = load(ral::io::data_handle(), 0, std::vector<cudf::size_type>(1, cur_row_group_index));
 			batch_index++;
 			cur_row_group_index++;
 
 			return std::move(ret);
 		}
 
+		if (batch_num_bytes > 0) {
+			std::vector<file_slice> slices = get_next_slices(lock);
+			if (slices.empty()) {
+				// the units of the last files were taken by other threads while this one waited
+				return nullptr;
+			}
+			batch_index++;
+
+			lock.unlock();
+
+			return load_slices(slices);
+		}
+
 		// a file handle that we can use in case errors occur to tell the user which file had parsing issues
 		assert(this->provider->has_next());
 
@@ -392,7 +430,7 @@ public:
 
 		lock.unlock();
 
-		auto ret = loader.load_batch(context.get(), projections, schema, local_cur_data_handle, local_cur_file_index, local_all_row_groups);
+		auto ret = load(local_cur_data_handle, local_cur_file_index, local_all_row_groups);
 		return std::move(ret);
 	}
 
@@ -402,7 +440,8 @@ public:
 	 * @return false The data source is empty or all batches have already been processed.
 	 */
 	bool has_next() {
-		return (is_empty_data_source && batch_index < 1) || (is_gdf_parser && batch_index.load() < n_batches) || (cur_file_index < n_files);
+		std::unique_lock<std::mutex> lock(mutex_);
+		return has_next_unsafe();
 	}
 
 	/**
@@ -413,12 +452,26 @@ public:
 		this->projections = projections;
 	}
 
+	/**
+	 * Sets a filter that is applied to every batch while it is loaded, so the columns the filter does not read are
+	 * loaded only for the row groups with rows that pass it.
+	 * @param filter_condition The condition of the filter, over the projected columns.
+	 */
+	void set_filter(const std::string & filter_condition) {
+		this->filter_condition = filter_condition;
+	}
+
 	/**
 	 * Get the batch index.
+	 * When batching by row groups a file can span several batches and several files can share one,
+	 * so progress is reported as the number of files that have been completely handed out.
 	 * @note This function can be called from a parallel thread, so we want it to be thread safe.
 	 * @return The current batch index.
 	 */
 	size_t get_batch_index() {
+		if (batch_num_bytes > 0 && !is_gdf_parser && !is_empty_data_source) {
+			return files_dispatched.load();
+		}
 		return batch_index.load();
 	}
 
@@ -431,17 +484,192 @@ public:
 	}
 
 private:
+	/**
+	 * @brief A set of row groups from a single file that can be loaded with one load_batch call.
+	 */
+	struct file_slice {
+		ral::io::data_handle handle; /**< Handle of the file the row groups belong to. */
+		size_t file_index; /**< Index of the file in the schema. */
+		std::vector<cudf::size_type> row_group_ids; /**< Row groups to load. */
+		std::shared_ptr<const std::vector<cudf::size_type>> rowgroup_num_rows; /**< Rows of every row group of the file, for the filter. */
+	};
+
+	/**
+	 * @brief The smallest piece of a file that can be handed to a batch, and its estimated size once loaded.
+	 */
+	struct load_unit {
+		ral::io::data_handle handle; /**< Handle of the file the unit belongs to. */
+		size_t file_index; /**< Index of the file in the schema. */
+		std::vector<cudf::size_type> row_group_ids; /**< Row groups of the unit. Empty means the whole file. */
+		size_t num_bytes; /**< Estimated number of bytes of the unit. */
+		bool is_last_of_file; /**< Whether the file has no units after this one. */
+		std::shared_ptr<const std::vector<cudf::size_type>> rowgroup_num_rows; /**< Rows of every row group of the file, shared by its units. Only set when there is a filter. */
+	};
+
+	/**
+	 * Same as has_next, with mutex_ already held. A file that is being split counts as pending, its units are not
+	 * appended yet.
+	 */
+	bool has_next_unsafe() {
+		return (is_empty_data_source && batch_index < 1) || (is_gdf_parser && batch_index.load() < n_batches) || (cur_file_index < n_files)
+			|| !pending_units.empty() || files_being_split > 0;
+	}
+
+	/**
+	 * Splits a file into load units.
+	 * Parsers that know the size of each row group produce one unit per row group, otherwise the whole file is one unit.
+	 * The rows of the row groups are looked up here too when there is a filter, so loading does not need the footer.
+	 * @note It may read the footer of the file, so it must be called without holding the mutex.
+	 */
+	std::vector<load_unit> get_load_units(ral::io::data_handle handle, size_t file_index) {
+		std::vector<load_unit> units;
+		std::vector<int> row_group_ids = this->all_row_groups[file_index];
+		std::vector<size_t> rowgroup_sizes = this->parser->get_rowgroup_sizes_in_bytes(handle, schema, projections);
+		std::shared_ptr<const std::vector<cudf::size_type>> rowgroup_num_rows;
+		if (!filter_condition.empty()) {
+			rowgroup_num_rows = std::make_shared<const std::vector<cudf::size_type>>(this->parser->get_rowgroup_num_rows(handle));
+		}
+
+		if (rowgroup_sizes.empty()) {
+			size_t file_size = 0;
+			if (handle.fileHandle != nullptr) {
+				auto size_result = handle.fileHandle->GetSize();
+				if (size_result.ok()) {
+					file_size = size_result.ValueOrDie();
+				}
+			}
+			units.push_back({handle, file_index, std::vector<cudf::size_type>(row_group_ids.begin(), row_group_ids.end()), file_size, true, rowgroup_num_rows});
+			return units;
+		}
+
+		if (row_group_ids.empty()) { // no row groups were pruned, so all of them are going to be read
+			row_group_ids.resize(rowgroup_sizes.size());
+			std::iota(row_group_ids.begin(), row_group_ids.end(), 0);
+		}
+		for (int row_group_id : row_group_ids) {
+			size_t num_bytes = row_group_id < rowgroup_sizes.size() ? rowgroup_sizes[row_group_id] : 0;
+			units.push_back({handle, file_index, std::vector<cudf::size_type>(1, row_group_id), num_bytes, false, rowgroup_num_rows});
+		}
+		if (units.empty()) { // a file without row groups still needs to produce its (empty) batch
+			units.push_back({handle, file_index, std::vector<cudf::size_type>(), 0, false, rowgroup_num_rows});
+		}
+		units.back().is_last_of_file = true;
+		return units;
+	}
+
+	/**
+	 * Collects the row groups for the next batch, until the batch reaches NUM_BYTES_PER_TABLE_SCAN_BATCH.
+	 * Big files are split across several batches and small files are coalesced into a single one.
+	 * A batch always gets at least one unit, even if that unit alone is over the budget.
+	 * When there are no units left the next file is split into units. The lock is released meanwhile, so the other
+	 * threads keep taking units while the footer of the file is read.
+	 * @param lock The lock of the mutex, held when it is called.
+	 * @return The file slices that make up the next batch.
+	 */
+	std::vector<file_slice> get_next_slices(std::unique_lock<std::mutex> & lock) {
+		std::vector<file_slice> slices;
+		size_t num_bytes = 0;
+		while (num_bytes < batch_num_bytes) {
+			if (pending_units.empty()) {
+				if (cur_file_index >= n_files) {
+					break;
+				}
+				ral::io::data_handle handle = this->provider->get_next();
+				size_t file_index = cur_file_index;
+				cur_file_index++;
+
+				files_being_split++;
+				lock.unlock();
+				std::vector<load_unit> units;
+				try {
+					units = get_load_units(handle, file_index);
+				} catch (...) {
+					lock.lock();
+					files_being_split--;
+					throw;
+				}
+				lock.lock();
+				files_being_split--;
+
+				pending_units.insert(pending_units.end(), std::make_move_iterator(units.begin()), std::make_move_iterator(units.end()));
+				continue;
+			}
+
+			load_unit & unit = pending_units.front();
+			if (num_bytes > 0 && num_bytes + unit.num_bytes > batch_num_bytes) {
+				break;
+			}
+
+			if (slices.empty() || slices.back().file_index != unit.file_index) {
+				slices.push_back({unit.handle, unit.file_index, {}, unit.rowgroup_num_rows});
+			}
+			slices.back().row_group_ids.insert(slices.back().row_group_ids.end(), unit.row_group_ids.begin(), unit.row_group_ids.end());
+			num_bytes += unit.num_bytes;
+			if (unit.is_last_of_file) {
+				files_dispatched++;
+			}
+			pending_units.pop_front();
+		}
+		return slices;
+	}
+
+	/**
+	 * Loads every file slice of a batch and concatenates them into a single table.
+	 * @param slices The file slices of the batch.
+	 * @return Unique pointer to a BlazingTable containing the whole batch.
+	 */
+	RecordBatch load_slices(const std::vector<file_slice> & slices) {
+		if (slices.size() == 1) {
+			return load(slices[0].handle, slices[0].file_index, slices[0].row_group_ids, slices[0].rowgroup_num_rows);
+		}
+
+		std::vector<std::unique_ptr<ral::frame::BlazingTable>> tables;
+		std::vector<ral::frame::BlazingTableView> table_views;
+		for (auto & slice : slices) {
+			tables.push_back(load(slice.handle, slice.file_index, slice.row_group_ids, slice.rowgroup_num_rows));
+			table_views.push_back(tables.back()->toBlazingTableView());
+		}
+
+		if (ral::utilities::checkIfConcatenatingStringsWillOverflow(table_views)) {
+			auto logger = spdlog::get("batch_logger");
+			if (logger != nullptr) {
+				logger->warn("{query_id}|||{info}|||||",
+							"query_id"_a=context->getContextToken(),
+							"info"_a="In DataSourceSequence::load_slices Concatenating will overflow strings length, consider lowering NUM_BYTES_PER_TABLE_SCAN_BATCH");
+			}
+		}
+		return ral::utilities::concatTables(table_views);
+	}
+
+	/**
+	 * Loads the projected columns of some row groups of a file, applying the filter if there is one.
+	 * @param rowgroup_num_rows The rows of every row group of the file, the filter asks the parser for them when null.
+	 */
+	RecordBatch load(ral::io::data_handle handle, size_t file_index, std::vector<cudf::size_type> row_group_ids,
+		std::shared_ptr<const std::vector<cudf::size_type>> rowgroup_num_rows = nullptr) {
+		if (filter_condition.empty()) {
+			return loader.load_batch(context.get(), projections, schema, handle, file_index, row_group_ids);
+		}
+		return loader.load_filtered_batch(context.get(), projections, filter_condition, schema, handle, file_index, row_group_ids,
+			rowgroup_num_rows ? *rowgroup_num_rows : std::vector<cudf::size_type>());
+	}
+
 	std::shared_ptr<ral::io::data_provider> provider; /**< Data provider associated to the data loader. */
 	std::shared_ptr<ral::io::data_parser> parser; /**< Data parser associated to the data loader. */
 
 	std::shared_ptr<Context> context; /**< Pointer to the shared query context. */
 	std::vector<int> projections; /**< List of columns that will be selected if they were previously settled. */
+	std::string filter_condition; /**< Filter applied while loading, empty if there is none. */
 	ral::io::data_loader loader; /**< Data loader responsible for executing the batching load. */
 	ral::io::Schema  schema; /**< Table schema associated to the data to be loaded. */
 	size_t cur_file_index; /**< Current file index. */
 	size_t cur_row_group_index; /**< Current rowgroup index. */
 	std::vector<std::vector<int>> all_row_groups;
 	std::atomic<size_t> batch_index; /**< Current batch index. */
+	std::atomic<size_t> files_dispatched; /**< Number of files whose row groups have all been handed out, when batching by row groups. */
+	size_t batch_num_bytes; /**< Target size of a batch when batching by row groups. Zero means one batch per file. */
+	std::deque<load_unit> pending_units; /**< Units of the files already split that have not been handed out yet. */
+	size_t files_being_split = 0; /**< Files whose units are being computed with the mutex released. */
 	size_t n_batches; /**< Number of batches. */
 	size_t n_files; /**< Number of files. */
 	bool is_empty_data_source; /**< Indicates whether the data source is empty. */
@@ -621,12 +849,23 @@ public:
 			table_scan_kernel_num_threads = std::stoi(config_options["TABLE_SCAN_KERNEL_NUM_THREADS"]);
 		}
 
+		// the filter columns are read first and the others only for the row groups where some row passes the filter
+		bool late_materialization = true;
+		it = config_options.find("TABLE_SCAN_LATE_MATERIALIZATION");
+		if (it != config_options.end()){
+			late_materialization = it->second == "1" || it->second == "True" || it->second == "true";
+		}
+		bool filter_on_load = late_materialization && is_filtered_bindable_scan(expression);
+		if (filter_on_load) {
+			input.set_filter(get_named_expression(expression, "filters"));
+		}
+
 		bool has_limit = this->has_limit_;
 		size_t limit_ = this->limit_rows_;
 		cudf::size_type current_rows = 0;
 		std::vector<BlazingThread> threads;
 		for (int i = 0; i < table_scan_kernel_num_threads; i++) {
-			threads.push_back(BlazingThread([expression = this->expression, &limit_, &has_limit, &current_rows, this]() {
+			threads.push_back(BlazingThread([expression = this->expression, filter_on_load, &limit_, &has_limit, &current_rows, this]() {
 
 				CodeTimer eventTimer(false);
 
@@ -639,7 +878,7 @@ public:
 						auto log_input_num_rows = batch->num_rows();
 						auto log_input_num_bytes = batch->sizeInBytes();
 
-						if(is_filtered_bindable_scan(expression)) {
+						if(is_filtered_bindable_scan(expression) && !filter_on_load) {
 							auto columns = ral::processor::process_filter(batch->toBlazingTableView(), expression, this->context.get());
 							current_rows += columns->num_rows();
 							columns->setNames(fix_column_aliases(columns->names(), expression));
@@ -768,6 +1007,62 @@ public:
 		return true;
 	}
 
+	/**
+	 * Indicates whether the kernel can be executed as a sequence of per batch tasks.
+	 * @return true Each batch is projected independently.
+	 */
+	bool is_task_based() {
+		return true;
+	}
+
+	/**
+	 * Projects one batch and adds the result to the output cache.
+	 * @param batch The batch to process.
+	 */
+	void process_batch(std::unique_ptr<ral::frame::BlazingTable> batch) {
+		CodeTimer eventTimer(false);
+		try {
+			auto log_input_num_rows = batch ? batch->num_rows() : 0;
+			auto log_input_num_bytes = batch ? batch->sizeInBytes() : 0;
+
+			eventTimer.start();
+			auto columns = ral::processor::process_project(std::move(batch), expression, context.get());
+			eventTimer.stop();
+
+			if(columns){
+				auto log_output_num_rows = columns->num_rows();
+				auto log_output_num_bytes = columns->sizeInBytes();
+				if(events_logger != nullptr) {
+					events_logger->info("{ral_id}|{query_id}|{kernel_id}|{input_num_rows}|{input_num_bytes}|{output_num_rows}|{output_num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
+								"ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
+								"query_id"_a=context->getContextToken(),
+								"kernel_id"_a=this->get_id(),
+								"input_num_rows"_a=log_input_num_rows,
+								"input_num_bytes"_a=log_input_num_bytes,
+								"output_num_rows"_a=log_output_num_rows,
+								"output_num_bytes"_a=log_output_num_bytes,
+								"event_type"_a="compute",
+								"timestamp_begin"_a=eventTimer.start_time(),
+								"timestamp_end"_a=eventTimer.end_time());
+				}
+			}
+
+			this->add_to_output_cache(std::move(columns));
+			batch_count++;
+		} catch(const std::exception& e) {
+			// TODO add retry here
+			if(logger != nullptr) {
+				logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
+										"query_id"_a=context->getContextToken(),
+										"step"_a=context->getQueryStep(),
+										"substep"_a=context->getQuerySubstep(),
+										"info"_a="In Projection kernel batch {} for {}. What: {}"_format(batch_count, expression, e.what()),
+										"duration"_a="");
+			}
+			throw;
+		}
+	}
+
 	/**
 	 * Executes the batch processing.
 	 * Loads the data from their input port, and after processing it,
@@ -776,55 +1071,13 @@ public:
 	 */
 	virtual kstatus run() {
 		CodeTimer timer;
-		CodeTimer eventTimer(false);
 
 		BatchSequence input(this->input_cache(), this);
-		int batch_count = 0;
 		while (input.wait_for_next()) {
-			try {
-				this->output_cache()->wait_if_cache_is_saturated();
+			this->output_cache()->wait_if_cache_is_saturated();
 
-				auto batch = input.next();
-
-				auto log_input_num_rows = batch ? batch->num_rows() : 0;
-				auto log_input_num_bytes = batch ? batch->sizeInBytes() : 0;
-
-				eventTimer.start();
-				auto columns = ral::processor::process_project(std::move(batch), expression, context.get());
-				eventTimer.stop();
-
-				if(columns){
-					auto log_output_num_rows = columns->num_rows();
-					auto log_output_num_bytes = columns->sizeInBytes();
-					if(events_logger != nullptr) {
-						events_logger->info("{ral_id}|{query_id}|{kernel_id}|{input_num_rows}|{input_num_bytes}|{output_num_rows}|{output_num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
-									"ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
-									"query_id"_a=context->getContextToken(),
-									"kernel_id"_a=this->get_id(),
-									"input_num_rows"_a=log_input_num_rows,
-									"input_num_bytes"_a=log_input_num_bytes,
-									"output_num_rows"_a=log_output_num_rows,
-									"output_num_bytes"_a=log_output_num_bytes,
-									"event_type"_a="compute",
-									"timestamp_begin"_a=eventTimer.start_time(),
-									"timestamp_end"_a=eventTimer.end_time());
-					}
-				}
-
-				this->add_to_output_cache(std::move(columns));
-				batch_count++;
-			} catch(const std::exception& e) {
-				// TODO add retry here
-				if(logger != nullptr) {
-					logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
-											"query_id"_a=context->getContextToken(),
-											"step"_a=context->getQueryStep(),
-											"substep"_a=context->getQuerySubstep(),
-											"info"_a="In Projection kernel batch {} for {}. What: {}"_format(batch_count, expression, e.what()),
-											"duration"_a="");
-				}
-				throw;
-			}
+			auto batch = input.next();
+			process_batch(std::move(batch));
 		}
 
 		if(logger != nullptr) {
@@ -840,7 +1093,7 @@ public:
 	}
 
 private:
-
+	int batch_count = 0; /**< Number of batches processed so far. */
 };
 
 /**
@@ -870,6 +1123,57 @@ public:
 		return true;
 	}
 
+	/**
+	 * Indicates whether the kernel can be executed as a sequence of per batch tasks.
+	 * @return true Each batch is filtered independently.
+	 */
+	bool is_task_based() {
+		return true;
+	}
+
+	/**
+	 * Filters one batch and adds the result to the output cache.
+	 * @param batch The batch to process.
+	 */
+	void process_batch(std::unique_ptr<ral::frame::BlazingTable> batch) {
+		CodeTimer eventTimer(false);
+		try {
+			auto log_input_num_rows = batch->num_rows();
+			auto log_input_num_bytes = batch->sizeInBytes();
+
+			eventTimer.start();
+			auto columns = ral::processor::process_filter(batch->toBlazingTableView(), expression, context.get());
+			eventTimer.stop();
+
+			auto log_output_num_rows = columns->num_rows();
+			auto log_output_num_bytes = columns->sizeInBytes();
+
+			events_logger->info("{ral_id}|{query_id}|{kernel_id}|{input_num_rows}|{input_num_bytes}|{output_num_rows}|{output_num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
+							"ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
+							"query_id"_a=context->getContextToken(),
+							"kernel_id"_a=this->get_id(),
+							"input_num_rows"_a=log_input_num_rows,
+							"input_num_bytes"_a=log_input_num_bytes,
+							"output_num_rows"_a=log_output_num_rows,
+							"output_num_bytes"_a=log_output_num_bytes,
+							"event_type"_a="compute",
+							"timestamp_begin"_a=eventTimer.start_time(),
+							"timestamp_end"_a=eventTimer.end_time());
+
+			this->add_to_output_cache(std::move(columns));
+			batch_count++;
+		} catch(const std::exception& e) {
+			// TODO add retry here
+			logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
+										"query_id"_a=context->getContextToken(),
+										"step"_a=context->getQueryStep(),
+										"substep"_a=context->getQuerySubstep(),
+										"info"_a="In Filter kernel batch {} for {}. What: {}"_format(batch_count, expression, e.what()),
+										"duration"_a="");
+			throw;
+		}
+	}
+
 	/**
 	 * Executes the batch processing.
 	 * Loads the data from their input port, and after processing it,
@@ -878,50 +1182,13 @@ public:
 	 */
 	virtual kstatus run() {
 		CodeTimer timer;
-		CodeTimer eventTimer(false);
 
 		BatchSequence input(this->input_cache(), this);
-		int batch_count = 0;
 		while (input.wait_for_next()) {
-			try {
-				this->output_cache()->wait_if_cache_is_saturated();
-
-				auto batch = input.next();
+			this->output_cache()->wait_if_cache_is_saturated();
 
-				auto log_input_num_rows = batch->num_rows();
-				auto log_input_num_bytes = batch->sizeInBytes();
-
-				eventTimer.start();
-				auto columns = ral::processor::process_filter(batch->toBlazingTableView(), expression, context.get());
-				eventTimer.stop();
-
-				auto log_output_num_rows = columns->num_rows();
-				auto log_output_num_bytes = columns->sizeInBytes();
-
-				events_logger->info("{ral_id}|{query_id}|{kernel_id}|{input_num_rows}|{input_num_bytes}|{output_num_rows}|{output_num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
-								"ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
-								"query_id"_a=context->getContextToken(),
-								"kernel_id"_a=this->get_id(),
-								"input_num_rows"_a=log_input_num_rows,
-								"input_num_bytes"_a=log_input_num_bytes,
-								"output_num_rows"_a=log_output_num_rows,
-								"output_num_bytes"_a=log_output_num_bytes,
-								"event_type"_a="compute",
-								"timestamp_begin"_a=eventTimer.start_time(),
-								"timestamp_end"_a=eventTimer.end_time());
-
-				this->add_to_output_cache(std::move(columns));
-				batch_count++;
-			} catch(const std::exception& e) {
-				// TODO add retry here
-				logger->error("{query_id}|{step}|{substep}|{info}|{duration}||||",
-											"query_id"_a=context->getContextToken(),
-											"step"_a=context->getQueryStep(),
-											"substep"_a=context->getQuerySubstep(),
-											"info"_a="In Filter kernel batch {} for {}. What: {}"_format(batch_count, expression, e.what()),
-											"duration"_a="");
-				throw;
-			}
+			auto batch = input.next();
+			process_batch(std::move(batch));
 		}
 
 		logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
@@ -955,7 +1222,7 @@ public:
     }
 
 private:
-
+	int batch_count = 0; /**< Number of batches processed so far. */
 };
 
 /**
@@ -1031,6 +1298,7 @@ public:
 			if(temp_output){
 				auto num_rows = temp_output->num_rows();
 				auto num_bytes = temp_output->sizeInBytes();
+				record_input_metrics(num_rows, num_bytes, cacheEventTimer);
 
 				cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
 								"ral_id"_a=context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
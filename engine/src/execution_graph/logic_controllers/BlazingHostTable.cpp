@@ -5,23 +5,17 @@
 #include <string>
 #include "cudf/column/column_view.hpp"
 #include "cudf/table/table_view.hpp"
-#include "bmr/BlazingMemoryResource.h"
 
 
 namespace ral {
 namespace frame {
 
 BlazingHostTable::BlazingHostTable(const std::vector<ColumnTransport> &columns_offsets,
-                                   std::vector<std::basic_string<char>> &&raw_buffers)
+                                   std::vector<blazing_host_buffer> &&raw_buffers)
         : columns_offsets{columns_offsets}, raw_buffers{std::move(raw_buffers)} {
-    auto size = sizeInBytes();
-    blazing_host_memory_resource::getInstance().allocate(size);
 }
 
-BlazingHostTable::~BlazingHostTable() {
-    auto size = sizeInBytes();
-    blazing_host_memory_resource::getInstance().deallocate(size);
-}
+BlazingHostTable::~BlazingHostTable() = default;
 
 std::vector<cudf::data_type> BlazingHostTable::get_schema() const {
     std::vector<cudf::data_type> data_types(this->num_columns());
@@ -67,9 +61,17 @@ const std::vector<ColumnTransport> &BlazingHostTable::get_columns_offsets() cons
     return columns_offsets;
 }
 
-const std::vector<std::basic_string<char>> &BlazingHostTable::get_raw_buffers() const {
+const std::vector<blazing_host_buffer> &BlazingHostTable::get_raw_buffers() const {
     return raw_buffers;
 }
 
+std::vector<blazing_host_buffer> BlazingHostTable::release_raw_buffers() {
+    return std::move(raw_buffers);
+}
+
+void BlazingHostTable::set_raw_buffers(std::vector<blazing_host_buffer> &&raw_buffers) {
+    this->raw_buffers = std::move(raw_buffers);
+}
+
 }  // namespace frame
 }  // namespace ral
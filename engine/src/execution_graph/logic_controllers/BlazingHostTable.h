@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include "cudf/table/table.hpp"
+#include "bmr/BlazingHostBufferPool.h"
 
 namespace blazingdb {
 namespace transport {
@@ -20,12 +21,13 @@ using ColumnTransport = blazingdb::transport::ColumnTransport;
 /**
 	@brief A class that represents the BlazingTable store in host memory.
     This implementation uses only raw buffers and offtets that represent a BlazingTable.
+    The raw buffers come from the blazing_host_buffer_pool, which also accounts for them in the host memory resource.
     The reference to implement this class was based on the way how BlazingTable objects are send/received 
     by the communication library.
 */ 
 class BlazingHostTable {
 public:
-    BlazingHostTable(const std::vector<ColumnTransport> &columns_offsets, std::vector<std::basic_string<char>> &&raw_buffers);
+    BlazingHostTable(const std::vector<ColumnTransport> &columns_offsets, std::vector<blazing_host_buffer> &&raw_buffers);
 
     ~BlazingHostTable();
 
@@ -45,11 +47,21 @@ public:
 
     const std::vector<ColumnTransport> & get_columns_offsets() const ;
 
-    const std::vector<std::basic_string<char>> & get_raw_buffers() const ;
+    const std::vector<blazing_host_buffer> & get_raw_buffers() const ;
+
+    /**
+     * Moves the raw buffers out of the table, which is left without buffers.
+     */
+    std::vector<blazing_host_buffer> release_raw_buffers() ;
+
+    /**
+     * Replaces the raw buffers of the table, i.e. by the ones taken by release_raw_buffers once transformed.
+     */
+    void set_raw_buffers(std::vector<blazing_host_buffer> &&raw_buffers) ;
 
 private:
     std::vector<ColumnTransport> columns_offsets;
-    std::vector<std::basic_string<char>> raw_buffers;
+    std::vector<blazing_host_buffer> raw_buffers;
     size_t part_id;
 };
 
@@ -1,7 +1,13 @@
 #include "CacheMachine.h"
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <random>
-#include <cudf/io/orc.hpp>
+#include <unordered_set>
+#include <cuda_runtime.h>
+#include <cudf/utilities/error.hpp>
 #include <src/utilities/CommonOperations.h>
 #include "communication/CommunicationData.h"
 #include <stdio.h>
@@ -11,6 +17,9 @@ namespace ral {
 namespace cache {
 
 std::size_t CacheMachine::cache_count(900000000);
+std::atomic<std::size_t> CacheMachine::num_adaptive_caches(0);
+
+const std::size_t NUM_MESSAGES_TO_PREFETCH = 2; /**< How many of the next messages pullFromCache prefetches. */
 
 std::string randomString(std::size_t length) {
 	const std::string characters = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
@@ -28,50 +37,517 @@ std::string randomString(std::size_t length) {
 	return random_string;
 }
 
-size_t CacheDataLocalFile::fileSizeInBytes() const {
-	struct stat st;
+namespace {
+
+const size_t SPILL_FILE_ALIGNMENT = 4096; /**< Alignment of the header and of every buffer in a spill file. O_DIRECT needs at least the logical block size. */
+const size_t SPILL_FILE_IO_CHUNK_SIZE = 64 * 1024 * 1024; /**< Largest single read or write done on a spill file. */
+const char SPILL_FILE_MAGIC[8] = {'B', 'S', 'Q', 'L', 'S', 'P', 'L', '1'};
+
+/**
+* The header at the start of a spill file. It is followed by the
+* ColumnTransport of every column and the size of every buffer.
+*/
+struct spill_file_header {
+	char magic[8];
+	uint64_t num_columns;
+	uint64_t num_buffers;
+	uint64_t header_size; /**< Where the first buffer starts. */
+};
+
+size_t round_up_to_alignment(size_t num_bytes) {
+	return ((num_bytes + SPILL_FILE_ALIGNMENT - 1) / SPILL_FILE_ALIGNMENT) * SPILL_FILE_ALIGNMENT;
+}
 
-	if(stat(this->filePath_.c_str(), &st) == 0)
-		return (st.st_size);
-	else
-		throw;
+const size_t MAX_IDLE_STAGING_BUFFERS = 8; /**< How many released staging buffers are kept for the next spill reads and writes. */
+
+struct staging_memory {
+	void * data;
+	bool pinned;
+};
+
+std::mutex idle_staging_buffers_mutex;
+std::vector<staging_memory> idle_staging_buffers;
+
+/**
+* A page aligned host buffer, as O_DIRECT requires. It is also pinned, so the copies between it and the GPU are done
+* by DMA and not through the pageable staging of the driver.
+*
+* Pinning tens of MiB costs as much as the copy itself, so buffers of SPILL_FILE_IO_CHUNK_SIZE are allocated pinned
+* once and go back to a small free list when released. Only larger requests (a header bigger than a chunk) allocate
+* their own memory.
+*/
+struct aligned_host_buffer {
+	aligned_host_buffer(size_t size) : size(round_up_to_alignment(std::max(size, SPILL_FILE_ALIGNMENT))) {
+		if (this->size <= SPILL_FILE_IO_CHUNK_SIZE) {
+			this->size = SPILL_FILE_IO_CHUNK_SIZE;
+			pooled = true;
+			std::lock_guard<std::mutex> lock(idle_staging_buffers_mutex);
+			if (!idle_staging_buffers.empty()) {
+				data = idle_staging_buffers.back().data;
+				pinned = idle_staging_buffers.back().pinned;
+				idle_staging_buffers.pop_back();
+				return;
+			}
+		}
+		// cudaMallocHost memory is page aligned
+		pinned = cudaMallocHost(&data, this->size) == cudaSuccess;
+		if (!pinned) {
+			// over the limit of locked memory, the copies still work from pageable memory
+			cudaGetLastError();
+			if (posix_memalign(&data, SPILL_FILE_ALIGNMENT, this->size) != 0) {
+				throw std::bad_alloc();
+			}
+		}
+	}
+	~aligned_host_buffer() {
+		if (pooled) {
+			std::lock_guard<std::mutex> lock(idle_staging_buffers_mutex);
+			if (idle_staging_buffers.size() < MAX_IDLE_STAGING_BUFFERS) {
+				idle_staging_buffers.push_back({data, pinned});
+				return;
+			}
+		}
+		if (pinned) {
+			cudaFreeHost(data);
+		} else {
+			free(data);
+		}
+	}
+	aligned_host_buffer(const aligned_host_buffer &) = delete;
+	aligned_host_buffer & operator=(const aligned_host_buffer &) = delete;
+
+	void * data = nullptr;
+	size_t size;
+	bool pinned = false;
+	bool pooled = false;
+};
+
+int open_spill_file(const std::string & path, int flags, bool & use_direct_io) {
+	int fd = -1;
+	if (use_direct_io) {
+		fd = open(path.c_str(), flags | O_DIRECT, 0600);
+		if (fd == -1 && errno == EINVAL) {
+			// the filesystem does not support O_DIRECT, e.g. tmpfs
+			use_direct_io = false;
+		}
+	}
+	if (!use_direct_io) {
+		fd = open(path.c_str(), flags, 0600);
+	}
+	if (fd == -1) {
+		throw std::runtime_error("Could not open spill file " + path + ": " + std::strerror(errno));
+	}
+	return fd;
+}
+
+void write_fully(int fd, const char * data, size_t num_bytes, size_t offset, const std::string & path) {
+	while (num_bytes > 0) {
+		ssize_t written = pwrite(fd, data, num_bytes, offset);
+		if (written == -1) {
+			if (errno == EINTR) continue;
+			throw std::runtime_error("Could not write spill file " + path + ": " + std::strerror(errno));
+		}
+		data += written;
+		offset += written;
+		num_bytes -= written;
+	}
+}
+
+void read_fully(int fd, char * data, size_t num_bytes, size_t offset, const std::string & path) {
+	while (num_bytes > 0) {
+		ssize_t num_read = pread(fd, data, num_bytes, offset);
+		if (num_read == -1) {
+			if (errno == EINTR) continue;
+			throw std::runtime_error("Could not read spill file " + path + ": " + std::strerror(errno));
+		}
+		if (num_read == 0) {
+			throw std::runtime_error("Spill file " + path + " is shorter than expected");
+		}
+		data += num_read;
+		offset += num_read;
+		num_bytes -= num_read;
+	}
+}
+
+std::unique_ptr<ral::execution::executor> cache_io_pool;
+std::atomic<size_t> pending_spill_bytes{0};
+
+}  // namespace
+
+void initialize_cache_io_pool(std::size_t num_threads) {
+	if (num_threads > 0) {
+		cache_io_pool = std::make_unique<ral::execution::executor>(num_threads);
+	} else {
+		cache_io_pool.reset();
+	}
+}
+
+ral::execution::executor * get_cache_io_pool() {
+	return cache_io_pool.get();
+}
+
+size_t get_pending_spill_bytes() {
+	return pending_spill_bytes;
+}
+
+void CPUCacheData::compress(HostColumnCompressor & compressor) {
+	const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets = host_table->get_columns_offsets();
+	std::vector<blazing_host_buffer> raw_buffers = host_table->release_raw_buffers();
+
+	std::vector<int> buffer_columns(raw_buffers.size(), -1);
+	for(std::size_t column = 0; column < columns_offsets.size(); column++) {
+		const blazingdb::transport::ColumnTransport & transport = columns_offsets[column];
+		for(int index : {transport.data, transport.valid, transport.strings_data, transport.strings_offsets, transport.strings_nullmask}) {
+			if(index >= 0 && index < static_cast<int>(buffer_columns.size())) {
+				buffer_columns[index] = column;
+			}
+		}
+	}
+
+	std::vector<std::size_t> sizes(raw_buffers.size());
+	for(std::size_t i = 0; i < raw_buffers.size(); i++) {
+		sizes[i] = raw_buffers[i].size();
+	}
+	std::vector<HostCompressionCodec> codecs = compressor.compress(raw_buffers, buffer_columns);
+	host_table->set_raw_buffers(std::move(raw_buffers));
+
+	if(std::any_of(codecs.begin(), codecs.end(), [](HostCompressionCodec codec) { return codec != HostCompressionCodec::NONE; })) {
+		buffer_codecs = std::move(codecs);
+		raw_buffer_sizes = std::move(sizes);
+	}
+}
+
+void CPUCacheData::decompress() {
+	if(buffer_codecs.empty() || host_table == nullptr) {
+		return;
+	}
+	std::vector<blazing_host_buffer> raw_buffers = host_table->release_raw_buffers();
+	for(std::size_t i = 0; i < raw_buffers.size(); i++) {
+		if(buffer_codecs[i] != HostCompressionCodec::NONE) {
+			raw_buffers[i] = decompress_host_buffer(buffer_codecs[i], raw_buffers[i], raw_buffer_sizes[i]);
+		}
+	}
+	host_table->set_raw_buffers(std::move(raw_buffers));
+	buffer_codecs.clear();
+	raw_buffer_sizes.clear();
+}
+
+size_t CPUCacheData::hostSizeInBytes() const {
+	size_t total_size = 0;
+	for(const blazing_host_buffer & buffer : host_table->get_raw_buffers()) {
+		total_size += buffer.size();
+	}
+	return total_size;
+}
+
+size_t CacheDataLocalFile::fileSizeInBytes() const {
+	return state->file_size_in_bytes;
 }
 
 size_t CacheDataLocalFile::sizeInBytes() const {
 	return size_in_bytes;
 }
 
+void CacheDataLocalFile::write_file(file_state & state) {
+	int fd = open_spill_file(state.file_path, O_WRONLY | O_CREAT | O_TRUNC, state.use_direct_io);
+	try {
+		size_t max_buffer_size = state.buffer_sizes.empty() ? 0 : *std::max_element(state.buffer_sizes.begin(), state.buffer_sizes.end());
+		aligned_host_buffer staging(std::max(std::min(max_buffer_size, SPILL_FILE_IO_CHUNK_SIZE), state.header_size));
+
+		std::memset(staging.data, 0, state.header_size);
+		spill_file_header * header = (spill_file_header *)staging.data;
+		std::memcpy(header->magic, SPILL_FILE_MAGIC, sizeof(SPILL_FILE_MAGIC));
+		header->num_columns = state.columns_offsets.size();
+		header->num_buffers = state.buffer_sizes.size();
+		header->header_size = state.header_size;
+		char * position_in_header = (char *)staging.data + sizeof(spill_file_header);
+		std::memcpy(position_in_header, state.columns_offsets.data(), state.columns_offsets.size() * sizeof(blazingdb::transport::ColumnTransport));
+		position_in_header += state.columns_offsets.size() * sizeof(blazingdb::transport::ColumnTransport);
+		for (size_t buffer_size : state.buffer_sizes) {
+			uint64_t size = buffer_size;
+			std::memcpy(position_in_header, &size, sizeof(uint64_t));
+			position_in_header += sizeof(uint64_t);
+		}
+		write_fully(fd, (const char *)staging.data, state.header_size, 0, state.file_path);
+
+		size_t file_offset = state.header_size;
+		for (size_t index = 0; index < state.buffer_sizes.size(); index++) {
+			size_t buffer_size = state.buffer_sizes[index];
+			for (size_t position = 0; position < buffer_size; position += staging.size) {
+				size_t num_bytes = std::min(staging.size, buffer_size - position);
+				CUDA_TRY(cudaMemcpy(staging.data, state.raw_buffers[index] + position, num_bytes, cudaMemcpyDeviceToHost));
+				size_t aligned_num_bytes = round_up_to_alignment(num_bytes);
+				std::memset((char *)staging.data + num_bytes, 0, aligned_num_bytes - num_bytes);
+				write_fully(fd, (const char *)staging.data, aligned_num_bytes, file_offset + position, state.file_path);
+			}
+			file_offset += round_up_to_alignment(buffer_size);
+		}
+	} catch (...) {
+		close(fd);
+		remove(state.file_path.c_str());
+		throw;
+	}
+	close(fd);
+}
+
+void CacheDataLocalFile::read_file(file_state & state, const std::function<void(size_t, size_t, const char *, size_t)> & sink) {
+	bool direct_io = state.use_direct_io;
+	int fd = open_spill_file(state.file_path, O_RDONLY, direct_io);
+	try {
+		size_t max_buffer_size = state.buffer_sizes.empty() ? 0 : *std::max_element(state.buffer_sizes.begin(), state.buffer_sizes.end());
+		aligned_host_buffer staging(std::min(max_buffer_size, SPILL_FILE_IO_CHUNK_SIZE));
+
+		read_fully(fd, (char *)staging.data, SPILL_FILE_ALIGNMENT, 0, state.file_path);
+		const spill_file_header * header = (const spill_file_header *)staging.data;
+		if (std::memcmp(header->magic, SPILL_FILE_MAGIC, sizeof(SPILL_FILE_MAGIC)) != 0 || header->num_buffers != state.buffer_sizes.size()) {
+			throw std::runtime_error("Spill file " + state.file_path + " does not match the table that was spilled");
+		}
+
+		size_t file_offset = state.header_size;
+		for (size_t index = 0; index < state.buffer_sizes.size(); index++) {
+			size_t buffer_size = state.buffer_sizes[index];
+			for (size_t position = 0; position < buffer_size; position += staging.size) {
+				size_t num_bytes = std::min(staging.size, buffer_size - position);
+				// the padding after every buffer lets us read whole aligned blocks
+				read_fully(fd, (char *)staging.data, round_up_to_alignment(num_bytes), file_offset + position, state.file_path);
+				sink(index, position, (const char *)staging.data, num_bytes);
+			}
+			file_offset += round_up_to_alignment(buffer_size);
+		}
+	} catch (...) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+}
+
+void CacheDataLocalFile::release_table_unsafe(file_state & state) {
+	pending_spill_bytes -= state.pending_spill_bytes;
+	state.pending_spill_bytes = 0;
+	state.raw_buffers.clear();
+	state.temp_scope_holder.clear();
+	state.table = nullptr;
+}
+
+void CacheDataLocalFile::discard_unsafe(file_state & state) {
+	release_table_unsafe(state);
+	state.host_buffers.clear();
+	remove(state.file_path.c_str());
+	state.status = file_status::DECACHED;
+}
+
+void CacheDataLocalFile::run_write_job(std::shared_ptr<file_state> state) {
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		if (state->status != file_status::WRITE_PENDING) {
+			// it was decached or discarded before we got to it
+			return;
+		}
+		state->status = file_status::WRITING;
+	}
+
+	std::string error;
+	try {
+		write_file(*state);
+	} catch (const std::exception & e) {
+		error = e.what();
+	} catch (...) {
+		error = "unknown error";
+	}
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	if (error.empty()) {
+		state->status = file_status::ON_DISK;
+		release_table_unsafe(*state);
+	} else {
+		// the table stays in GPU memory and decache will hand it back as it is
+		state->status = file_status::WRITE_FAILED;
+		pending_spill_bytes -= state->pending_spill_bytes;
+		state->pending_spill_bytes = 0;
+		auto logger = spdlog::get("batch_logger");
+		if(logger != nullptr) {
+			logger->error("|||{info}|||||",
+										"info"_a="Writing spill file {} failed. What: {}"_format(state->file_path, error));
+		}
+	}
+	if (state->discarded) {
+		discard_unsafe(*state);
+	}
+	state->condition_variable.notify_all();
+}
+
+void CacheDataLocalFile::run_prefetch_job(std::shared_ptr<file_state> state) {
+	std::vector<blazing_host_buffer> host_buffers;
+	bool prefetched = true;
+	try {
+		for (size_t buffer_size : state->buffer_sizes) {
+			host_buffers.emplace_back(buffer_size);
+		}
+		read_file(*state, [&host_buffers](size_t index, size_t position, const char * data, size_t num_bytes) {
+			std::memcpy(host_buffers[index].data() + position, data, num_bytes);
+		});
+	} catch (...) {
+		// decache will read the file again and report the error if there is one
+		prefetched = false;
+	}
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	if (prefetched) {
+		state->host_buffers = std::move(host_buffers);
+		state->status = file_status::IN_HOST;
+	} else {
+		state->status = file_status::ON_DISK;
+	}
+	if (state->discarded) {
+		discard_unsafe(*state);
+	}
+	state->condition_variable.notify_all();
+}
+
 std::unique_ptr<ral::frame::BlazingTable> CacheDataLocalFile::decache() {
-	cudf::io::orc_reader_options read_opts = cudf::io::orc_reader_options::builder(cudf::io::source_info{this->filePath_});
-	auto result = cudf::io::read_orc(read_opts);
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->condition_variable.wait(lock, [this] {
+		return state->status != file_status::WRITING && state->status != file_status::PREFETCHING;
+	});
+
+	if (state->status == file_status::WRITE_PENDING || state->status == file_status::WRITE_FAILED) {
+		// the table never made it to disk, so there is nothing to read
+		std::unique_ptr<ral::frame::BlazingTable> table = std::move(state->table);
+		release_table_unsafe(*state);
+		state->status = file_status::DECACHED;
+		return table;
+	}
+
+	std::vector<rmm::device_buffer> gpu_raw_buffers;
+	for (size_t buffer_size : state->buffer_sizes) {
+		gpu_raw_buffers.emplace_back(buffer_size);
+	}
+	if (state->status == file_status::IN_HOST) {
+		std::vector<blazing_host_buffer> host_buffers = std::move(state->host_buffers);
+		state->host_buffers.clear();
+		state->status = file_status::DECACHED;
+		lock.unlock();
 
-	// Remove temp orc files
-	const char *orc_path_file = this->filePath_.c_str();
-	remove(orc_path_file);
-	return std::make_unique<ral::frame::BlazingTable>(std::move(result.tbl), this->names());
+		size_t max_buffer_size = state->buffer_sizes.empty() ? 0 : *std::max_element(state->buffer_sizes.begin(), state->buffer_sizes.end());
+		aligned_host_buffer staging(std::min(max_buffer_size, SPILL_FILE_IO_CHUNK_SIZE));
+		for (size_t index = 0; index < host_buffers.size(); index++) {
+			for (size_t position = 0; position < host_buffers[index].size(); position += staging.size) {
+				size_t num_bytes = std::min(staging.size, host_buffers[index].size() - position);
+				std::memcpy(staging.data, host_buffers[index].data() + position, num_bytes);
+				CUDA_TRY(cudaMemcpy((char *)gpu_raw_buffers[index].data() + position, staging.data, num_bytes, cudaMemcpyHostToDevice));
+			}
+		}
+		host_buffers.clear();
+	} else {
+		state->status = file_status::DECACHED;
+		lock.unlock();
+
+		read_file(*state, [&gpu_raw_buffers](size_t index, size_t position, const char * data, size_t num_bytes) {
+			CUDA_TRY(cudaMemcpy((char *)gpu_raw_buffers[index].data() + position, data, num_bytes, cudaMemcpyHostToDevice));
+		});
+	}
+
+	// Remove temp spill files
+	remove(state->file_path.c_str());
+
+	auto table = ral::communication::messages::deserialize_from_gpu_raw_buffers(state->columns_offsets, gpu_raw_buffers);
+	table->setNames(this->names());
+	return table;
+}
+
+void CacheDataLocalFile::prefetch() {
+	ral::execution::executor * io_pool = get_cache_io_pool();
+	if (io_pool == nullptr) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	if (state->status != file_status::ON_DISK) {
+		return;
+	}
+	auto & host_memory = blazing_host_memory_resource::getInstance();
+	if (host_memory.get_memory_used() + state->buffers_num_bytes > host_memory.get_memory_limit()) {
+		// no room in host memory, decache will read it straight into the GPU
+		return;
+	}
+	state->status = file_status::PREFETCHING;
+	lock.unlock();
+
+	std::shared_ptr<file_state> job_state = state;
+	io_pool->add_task([job_state]() { CacheDataLocalFile::run_prefetch_job(job_state); });
 }
 
-CacheDataLocalFile::CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string orc_files_path)
-	: CacheData(CacheDataType::LOCAL_FILE, table->names(), table->get_schema(), table->num_rows())
+CacheDataLocalFile::CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string files_path, bool use_direct_io, bool async_write)
+	: CacheData(CacheDataType::LOCAL_FILE, table->names(), table->get_schema(), table->num_rows()), state(std::make_shared<file_state>())
 {
 	this->size_in_bytes = table->sizeInBytes();
-	this->filePath_ = orc_files_path + "/.blazing-temp-" + randomString(64) + ".orc";
-
-	cudf::io::table_metadata metadata;
-	for(auto name : table->names()) {
-		metadata.column_names.emplace_back(name);
+	state->file_path = files_path + "/.blazing-temp-" + randomString(64) + ".spill";
+	state->use_direct_io = use_direct_io;
+
+	std::tie(state->buffer_sizes, state->raw_buffers, state->columns_offsets, state->temp_scope_holder) =
+		ral::communication::messages::serialize_gpu_message_to_gpu_containers(table->toBlazingTableView());
+
+	state->header_size = round_up_to_alignment(sizeof(spill_file_header)
+		+ state->columns_offsets.size() * sizeof(blazingdb::transport::ColumnTransport)
+		+ state->buffer_sizes.size() * sizeof(uint64_t));
+	state->file_size_in_bytes = state->header_size;
+	for (size_t buffer_size : state->buffer_sizes) {
+		state->buffers_num_bytes += buffer_size;
+		state->file_size_in_bytes += round_up_to_alignment(buffer_size);
 	}
 
-	cudf::io::orc_writer_options out_opts = cudf::io::orc_writer_options::builder(cudf::io::sink_info{this->filePath_}, table->view())
-		.metadata(&metadata);
+	ral::execution::executor * io_pool = get_cache_io_pool();
+	if (async_write && io_pool != nullptr) {
+		state->table = std::move(table);
+		state->status = file_status::WRITE_PENDING;
+		state->pending_spill_bytes = this->size_in_bytes;
+		pending_spill_bytes += this->size_in_bytes;
 
-	cudf::io::write_orc(out_opts);
+		std::shared_ptr<file_state> job_state = state;
+		io_pool->add_task([job_state]() { CacheDataLocalFile::run_write_job(job_state); });
+	} else {
+		write_file(*state);
+		state->raw_buffers.clear();
+		state->temp_scope_holder.clear();
+		state->status = file_status::ON_DISK;
+	}
+}
+
+CacheDataLocalFile::~CacheDataLocalFile() {
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->discarded = true;
+	if (state->status != file_status::WRITING && state->status != file_status::PREFETCHING && state->status != file_status::DECACHED) {
+		discard_unsafe(*state);
+	}
+	// otherwise the job that is running cleans up when it finishes
 }
+
 std::unique_ptr<GPUCacheDataMetaData> cast_cache_data_to_gpu_with_meta(std::unique_ptr<CacheData> base_pointer){
 	return std::unique_ptr<GPUCacheDataMetaData>(static_cast<GPUCacheDataMetaData *>(base_pointer.release()));
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// the host compression is chosen per query, a compressor learns the columns of one cache
+static std::unique_ptr<HostColumnCompressor> make_host_compressor(Context * context) {
+	if (context == nullptr) {
+		return nullptr;
+	}
+	std::map<std::string, std::string> config_options = context->getConfigOptions();
+	auto it = config_options.find("CACHE_HOST_COMPRESSION");
+	if (it == config_options.end()) {
+		return nullptr;
+	}
+	HostCompressionCodec codec = parse_host_compression_codec(it->second);
+	if (codec == HostCompressionCodec::NONE) {
+		return nullptr;
+	}
+	double max_ratio = 0.8;
+	it = config_options.find("CACHE_HOST_COMPRESSION_MAX_RATIO");
+	if (it != config_options.end()) {
+		max_ratio = std::stod(it->second);
+	}
+	return std::make_unique<HostColumnCompressor>(codec, max_ratio);
+}
+
 CacheMachine::CacheMachine(std::shared_ptr<Context> context): ctx(context), cache_id(CacheMachine::cache_count)
 {
 	CacheMachine::cache_count++;
@@ -101,6 +577,9 @@ CacheMachine::CacheMachine(std::shared_ptr<Context> context): ctx(context), cach
 							"is_kernel"_a=0, //false
 							"kernel_type"_a="cache");
 	}
+
+	metrics = ral::utilities::MetricsRegistry::getInstance().registerCache(context ? context->getContextToken() : -1, cache_id);
+	host_compressor = make_host_compressor(context.get());
 }
 
 CacheMachine::CacheMachine(std::shared_ptr<Context> context, std::size_t flow_control_bytes_threshold) : ctx(context), cache_id(CacheMachine::cache_count)
@@ -132,9 +611,58 @@ CacheMachine::CacheMachine(std::shared_ptr<Context> context, std::size_t flow_co
 							"is_kernel"_a=0, //false
 							"kernel_type"_a="cache");
 	}
+
+	metrics = ral::utilities::MetricsRegistry::getInstance().registerCache(context ? context->getContextToken() : -1, cache_id);
+	host_compressor = make_host_compressor(context.get());
 }
 
-CacheMachine::~CacheMachine() {}
+CacheMachine::~CacheMachine() {
+	if (adaptive_flow_control) {
+		CacheMachine::num_adaptive_caches--;
+	}
+}
+
+void CacheMachine::enable_adaptive_flow_control(int64_t target_latency_ms, std::size_t min_bytes) {
+	if (!adaptive_flow_control) {
+		CacheMachine::num_adaptive_caches++;
+	}
+	adaptive_flow_control = std::make_unique<AdaptiveFlowControl>(target_latency_ms, min_bytes);
+}
+
+static int64_t flow_control_now_us() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::unique_ptr<CPUCacheData> CacheMachine::make_cpu_cache_data(std::unique_ptr<ral::frame::BlazingTable> table) {
+	std::unique_ptr<CPUCacheData> cache_data;
+	if (host_compressor) {
+		ral::utilities::TraceSpan compress_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "compress host table");
+		cache_data = std::make_unique<CPUCacheData>(std::move(table), *host_compressor);
+	} else {
+		cache_data = std::make_unique<CPUCacheData>(std::move(table));
+	}
+	metrics->spill_bytes_host_compressed.add(cache_data->hostSizeInBytes());
+	return cache_data;
+}
+
+void CacheMachine::flow_control_bytes_added(std::size_t num_bytes) {
+	flow_control_bytes_count += num_bytes;
+	if (adaptive_flow_control) {
+		adaptive_flow_control->record_added(num_bytes, flow_control_now_us());
+	}
+}
+
+void CacheMachine::flow_control_bytes_pulled(std::size_t num_bytes) {
+	flow_control_bytes_count -= num_bytes;
+	pulled_rate.record(num_bytes, flow_control_now_us());
+	if (adaptive_flow_control) {
+		adaptive_flow_control->record_pulled(num_bytes, flow_control_now_us());
+	}
+	std::shared_ptr<std::function<void()>> listener = std::atomic_load(&this->pull_listener);
+	if (listener && *listener) {
+		(*listener)();
+	}
+}
 
 Context * CacheMachine::get_context() const {
 	return ctx.get();
@@ -183,11 +711,14 @@ void CacheMachine::addHostFrameToCache(std::unique_ptr<ral::frame::BlazingHostTa
 		}
 
 		std::unique_lock<std::mutex> lock(flow_control_mutex);
-		flow_control_bytes_count += host_table->sizeInBytes();
+		flow_control_bytes_added(host_table->sizeInBytes());
 		lock.unlock();
 
 		num_rows_added += host_table->num_rows();
 		num_bytes_added += host_table->sizeInBytes();
+		metrics->batches_added.add(1);
+		metrics->rows_added.add(host_table->num_rows());
+		metrics->bytes_added.add(host_table->sizeInBytes());
 		auto cache_data = std::make_unique<CPUCacheData>(std::move(host_table));
 		auto item =	std::make_unique<message>(std::move(cache_data), message_id);
 		this->waitingCache->put(std::move(item));
@@ -209,11 +740,14 @@ void CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 	// we dont want to add empty tables to a cache, unless we have never added anything
 	if ((!this->something_added || cache_data->num_rows() > 0) || always_add){
 		std::unique_lock<std::mutex> lock(flow_control_mutex);
-		flow_control_bytes_count += cache_data->sizeInBytes();
+		flow_control_bytes_added(cache_data->sizeInBytes());
 		lock.unlock();
 
 		num_rows_added += cache_data->num_rows();
 		num_bytes_added += cache_data->sizeInBytes();
+		metrics->batches_added.add(1);
+		metrics->rows_added.add(cache_data->num_rows());
+		metrics->bytes_added.add(cache_data->sizeInBytes());
 		int cacheIndex = 0;
 		while(cacheIndex < this->memory_resources.size()) {
 			auto memory_to_use = (this->memory_resources[cacheIndex]->get_memory_used() + cache_data->sizeInBytes());
@@ -244,6 +778,9 @@ void CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 								"kernel_id"_a=message_id,
 								"rows"_a=cache_data->num_rows());
 						}
+						metrics->spill_bytes_host.add(cache_data->sizeInBytes());
+						ral::utilities::TraceSpan spill_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "spill to host");
+						spill_span.set_arg("bytes", cache_data->sizeInBytes());
 
 						auto item = std::make_unique<message>(std::move(cache_data), message_id);
 						this->waitingCache->put(std::move(item));
@@ -258,6 +795,9 @@ void CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 								"kernel_id"_a=message_id,
 								"rows"_a=cache_data->num_rows());
 						}
+						metrics->spill_bytes_disk.add(cache_data->sizeInBytes());
+						ral::utilities::TraceSpan spill_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "spill to disk");
+						spill_span.set_arg("bytes", cache_data->sizeInBytes());
 
 						// BlazingMutableThread t([cache_data = std::move(cache_data), this, cacheIndex, message_id]() mutable {
 						auto item = std::make_unique<message>(std::move(cache_data), message_id);
@@ -284,11 +824,14 @@ void CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, c
 			}
 		}
 		std::unique_lock<std::mutex> lock(flow_control_mutex);
-		flow_control_bytes_count += table->sizeInBytes();
+		flow_control_bytes_added(table->sizeInBytes());
 		lock.unlock();
 
 		num_rows_added += table->num_rows();
 		num_bytes_added += table->sizeInBytes();
+		metrics->batches_added.add(1);
+		metrics->rows_added.add(table->num_rows());
+		metrics->bytes_added.add(table->sizeInBytes());
 		int cacheIndex = 0;
 		while(cacheIndex < memory_resources.size()) {
 			auto memory_to_use = (this->memory_resources[cacheIndex]->get_memory_used() + table->sizeInBytes());
@@ -323,8 +866,11 @@ void CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, c
 								"kernel_id"_a=message_id,
 								"rows"_a=table->num_rows());
 						}
+						metrics->spill_bytes_host.add(table->sizeInBytes());
+						ral::utilities::TraceSpan spill_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "spill to host");
+						spill_span.set_arg("bytes", table->sizeInBytes());
 
-						auto cache_data = std::make_unique<CPUCacheData>(std::move(table));
+						auto cache_data = make_cpu_cache_data(std::move(table));
 						auto item =	std::make_unique<message>(std::move(cache_data), message_id);
 						this->waitingCache->put(std::move(item));
 					} else if(cacheIndex == 2) {
@@ -338,16 +884,24 @@ void CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, c
 								"kernel_id"_a=message_id,
 								"rows"_a=table->num_rows());
 						}
+						metrics->spill_bytes_disk.add(table->sizeInBytes());
+						ral::utilities::TraceSpan spill_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "spill to disk");
+						spill_span.set_arg("bytes", table->sizeInBytes());
 
 						// BlazingMutableThread t([table = std::move(table), this, cacheIndex, message_id]() mutable {
-						// want to get only cache directory where orc files should be saved
+						// want to get only cache directory where spill files should be saved
 						std::map<std::string, std::string> config_options = ctx->getConfigOptions();
 						auto it = config_options.find("BLAZING_CACHE_DIRECTORY");
-						std::string orc_files_path;
+						std::string spill_files_path;
 						if (it != config_options.end()) {
-							orc_files_path = config_options["BLAZING_CACHE_DIRECTORY"];
+							spill_files_path = config_options["BLAZING_CACHE_DIRECTORY"];
 						}
-						auto cache_data = std::make_unique<CacheDataLocalFile>(std::move(table), orc_files_path);
+						bool use_direct_io = false;
+						it = config_options.find("BLAZING_CACHE_DIRECT_IO");
+						if (it != config_options.end()) {
+							use_direct_io = std::stoi(config_options["BLAZING_CACHE_DIRECT_IO"]) != 0;
+						}
+						auto cache_data = std::make_unique<CacheDataLocalFile>(std::move(table), spill_files_path, use_direct_io, true);
 						auto item =	std::make_unique<message>(std::move(cache_data), message_id);
 						this->waitingCache->put(std::move(item));
 						// NOTE: Wait don't kill the main process until the last thread is finished!
@@ -368,24 +922,36 @@ void CacheMachine::wait_until_finished() {
 
 
 std::unique_ptr<ral::frame::BlazingTable> CacheMachine::get_or_wait(size_t index) {
+	CodeTimer wait_timer;
 	std::unique_ptr<message> message_data = waitingCache->get_or_wait(std::to_string(index));
+	metrics->pull_wait_time_us.record(wait_timer.elapsed_time<std::chrono::microseconds>());
 	if (message_data == nullptr) {
 		return nullptr;
 	}
 
 	std::unique_ptr<ral::frame::BlazingTable> output = message_data->get_data().decache();
+	metrics->batches_pulled.add(1);
+	metrics->rows_pulled.add(output->num_rows());
+	metrics->bytes_pulled.add(output->sizeInBytes());
 	std::unique_lock<std::mutex> lock(flow_control_mutex);
-	flow_control_bytes_count -= output->sizeInBytes();
+	flow_control_bytes_pulled(output->sizeInBytes());
 	flow_control_condition_variable.notify_all();
 	return std::move(output);
 }
 
 std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullFromCache() {
+	CodeTimer wait_timer;
 	std::unique_ptr<message> message_data = waitingCache->pop_or_wait();
+	metrics->pull_wait_time_us.record(wait_timer.elapsed_time<std::chrono::microseconds>());
 	if (message_data == nullptr) {
 		return nullptr;
 	}
 
+	// while this one is decached and processed, the next ones can be read from disk
+	waitingCache->visit_next(NUM_MESSAGES_TO_PREFETCH, [](message & next_message) {
+		next_message.get_data().prefetch();
+	});
+
 	if(logger != nullptr) {
 		logger->trace("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}|rows|{rows}",
 								"query_id"_a=(ctx ? std::to_string(ctx->getContextToken()) : ""),
@@ -398,15 +964,20 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullFromCache() {
 	}
 
 	std::unique_ptr<ral::frame::BlazingTable> output = message_data->get_data().decache();
+	metrics->batches_pulled.add(1);
+	metrics->rows_pulled.add(output->num_rows());
+	metrics->bytes_pulled.add(output->sizeInBytes());
 	std::unique_lock<std::mutex> lock(flow_control_mutex);
-	flow_control_bytes_count -= output->sizeInBytes();
+	flow_control_bytes_pulled(output->sizeInBytes());
 	flow_control_condition_variable.notify_all();
 	return std::move(output);
 }
 
 
 std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData(std::string message_id) {
+	CodeTimer wait_timer;
 	std::unique_ptr<message> message_data = waitingCache->get_or_wait(message_id);
+	metrics->pull_wait_time_us.record(wait_timer.elapsed_time<std::chrono::microseconds>());
 	if (message_data == nullptr) {
 		return nullptr;
 	}
@@ -422,8 +993,11 @@ std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData(std::string m
 								"rows"_a=message_data->get_data().num_rows());
 	}
 	std::unique_ptr<ral::cache::CacheData> output = message_data->release_data();
+	metrics->batches_pulled.add(1);
+	metrics->rows_pulled.add(output->num_rows());
+	metrics->bytes_pulled.add(output->sizeInBytes());
 	std::unique_lock<std::mutex> lock(flow_control_mutex);
-	flow_control_bytes_count -= output->sizeInBytes();
+	flow_control_bytes_pulled(output->sizeInBytes());
 	flow_control_condition_variable.notify_all();
 	return std::move(output);
 }
@@ -433,7 +1007,7 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullUnorderedFromCache()
 
 	std::unique_ptr<message> message_data = nullptr;
 	{ // scope for lock
-		std::unique_lock<std::mutex> lock = this->waitingCache->lock();
+		auto lock = this->waitingCache->lock();
 		std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
 		std::vector<std::unique_ptr<message>> remaining_messages;
 		for(size_t i = 0; i < all_messages.size(); i++) {
@@ -459,8 +1033,11 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullUnorderedFromCache()
 		}
 
 		std::unique_ptr<ral::frame::BlazingTable> output = message_data->get_data().decache();
+		metrics->batches_pulled.add(1);
+		metrics->rows_pulled.add(output->num_rows());
+		metrics->bytes_pulled.add(output->sizeInBytes());
 		std::unique_lock<std::mutex> lock(flow_control_mutex);
-		flow_control_bytes_count -= output->sizeInBytes();
+		flow_control_bytes_pulled(output->sizeInBytes());
 		flow_control_condition_variable.notify_all();
 		return std::move(output);
 	} else {
@@ -469,7 +1046,9 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullUnorderedFromCache()
 }
 
 std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData() {
+	CodeTimer wait_timer;
 	std::unique_ptr<message> message_data = waitingCache->pop_or_wait();
+	metrics->pull_wait_time_us.record(wait_timer.elapsed_time<std::chrono::microseconds>());
 	if (message_data == nullptr) {
 		return nullptr;
 	}
@@ -486,27 +1065,49 @@ std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData() {
 	}
 
 	std::unique_ptr<ral::cache::CacheData> output = message_data->release_data();
+	metrics->batches_pulled.add(1);
+	metrics->rows_pulled.add(output->num_rows());
+	metrics->bytes_pulled.add(output->sizeInBytes());
 	std::unique_lock<std::mutex> lock(flow_control_mutex);
-	flow_control_bytes_count -= output->sizeInBytes();
+	flow_control_bytes_pulled(output->sizeInBytes());
 	flow_control_condition_variable.notify_all();
 	return std::move(output);
 }
 
 
 bool CacheMachine::thresholds_are_met(std::size_t bytes_count){
+	if (!adaptive_flow_control) {
+		return bytes_count > this->flow_control_bytes_threshold;
+	}
 
-	return bytes_count > this->flow_control_bytes_threshold;
+	// what the cache can still take before the device memory and then the host memory reach their limits, split
+	// evenly among the caches with adaptive flow control. Anything over the device limit is spilled to host memory.
+	std::size_t headroom = 0;
+	for (std::size_t index = 0; index < 2 && index < memory_resources.size(); index++) {
+		std::size_t memory_used = memory_resources[index]->get_memory_used();
+		std::size_t memory_limit = memory_resources[index]->get_memory_limit();
+		if (memory_used < memory_limit) {
+			headroom += memory_limit - memory_used;
+		}
+	}
+	std::size_t memory_share = headroom / std::max<std::size_t>(CacheMachine::num_adaptive_caches.load(), 1);
+	std::size_t budget = adaptive_flow_control->get_budget(memory_share, flow_control_now_us());
+	return bytes_count > std::min(budget, this->flow_control_bytes_threshold);
 }
 
 void CacheMachine::wait_if_cache_is_saturated() {
 
 	CodeTimer blazing_timer;
+	// the adaptive budget also grows when other caches free memory, without this cache being pulled
+	auto wait_period = adaptive_flow_control ? 100ms : 60000ms;
+	int64_t next_timeout_warning_ms = 59000;
 
 	std::unique_lock<std::mutex> lock(flow_control_mutex);
-	while(!flow_control_condition_variable.wait_for(lock, 60000ms, [&, this] {
+	while(!flow_control_condition_variable.wait_for(lock, wait_period, [&, this] {
 			bool cache_not_saturated = !thresholds_are_met(flow_control_bytes_count);
 
-			if (!cache_not_saturated && blazing_timer.elapsed_time() > 59000){
+			if (!cache_not_saturated && blazing_timer.elapsed_time() > next_timeout_warning_ms){
+				next_timeout_warning_ms += 60000;
 				if(logger != nullptr) {
 					logger->warn("{query_id}|{step}|{substep}|{info}|{duration}||||",
 									"query_id"_a=(ctx ? std::to_string(ctx->getContextToken()) : ""),
@@ -520,68 +1121,141 @@ void CacheMachine::wait_if_cache_is_saturated() {
 		})){}
 }
 
+bool CacheMachine::is_saturated() {
+	std::unique_lock<std::mutex> lock(flow_control_mutex);
+	return thresholds_are_met(flow_control_bytes_count);
+}
+
 // take the first cacheData in this CacheMachine that it can find (looking in reverse order) that is in the GPU put it in RAM or Disk as oppropriate
 // this function does not change the order of the caches
 size_t CacheMachine::downgradeCacheData() {
 	size_t bytes_downgraded = 0;
-	std::unique_lock<std::mutex> lock = this->waitingCache->lock();
+	auto lock = this->waitingCache->lock();
 	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
 	for(int i = all_messages.size() - 1; i >= 0; i--) {
 		if (all_messages[i]->get_data().get_type() == CacheDataType::GPU){
+			bytes_downgraded = downgrade_message_unsafe(all_messages[i]);
+			break;
+		}
+	}
+	
+	this->waitingCache->put_all_unsafe(std::move(all_messages));
+	return bytes_downgraded;
+}
 
-			std::unique_ptr<ral::frame::BlazingTable> table = all_messages[i]->get_data().decache();
+std::vector<EvictionCandidate> CacheMachine::get_eviction_candidates() {
+	bool consumer_started = metrics->batches_pulled.get() > 0;
+	double consumer_bytes_per_second;
+	{
+		std::lock_guard<std::mutex> lock(flow_control_mutex);
+		consumer_bytes_per_second = pulled_rate.bytes_per_second(flow_control_now_us());
+	}
 
-			std::string message_id = all_messages[i]->get_message_id();
-			bytes_downgraded += table->sizeInBytes();
-			int cacheIndex = 1; // starting at RAM cache
-			while(cacheIndex < memory_resources.size()) {
-				auto memory_to_use = (this->memory_resources[cacheIndex]->get_memory_used() + table->sizeInBytes());
-				if( memory_to_use < this->memory_resources[cacheIndex]->get_memory_limit()) {
-					if(cacheIndex == 1) {
-						if(logger != nullptr) {
-							logger->trace("{query_id}|{step}|{substep}|{info}||kernel_id|{kernel_id}|rows|{rows}",
-								"query_id"_a=(ctx ? std::to_string(ctx->getContextToken()) : ""),
-								"step"_a=(ctx ? std::to_string(ctx->getQueryStep()) : ""),
-								"substep"_a=(ctx ? std::to_string(ctx->getQuerySubstep()) : ""),
-								"info"_a="Downgraded CacheData to CPU cache",
-								"kernel_id"_a=message_id,
-								"rows"_a=table->num_rows());
-						}
+	std::vector<EvictionCandidate> candidates;
+	auto lock = this->waitingCache->lock();
+	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
+	std::size_t bytes_ahead = 0;
+	for(std::size_t i = 0; i < all_messages.size(); i++) {
+		CacheData & cache_data = all_messages[i]->get_data();
+		std::size_t size_bytes = cache_data.sizeInBytes();
+		if (cache_data.get_type() == CacheDataType::GPU){
+			EvictionCandidate candidate;
+			candidate.cache_id = cache_id;
+			candidate.message_sequence = all_messages[i]->get_sequence();
+			candidate.size_bytes = size_bytes;
+			candidate.queue_position = i;
+			candidate.queue_length = all_messages.size();
+			candidate.bytes_ahead = bytes_ahead;
+			candidate.consumer_started = consumer_started;
+			candidate.consumer_bytes_per_second = consumer_bytes_per_second;
+			auto host_memory = this->memory_resources[1];
+			candidate.target_tier = host_memory->get_memory_used() + size_bytes < host_memory->get_memory_limit() ? 1 : 2;
+			candidates.push_back(candidate);
+		}
+		bytes_ahead += size_bytes;
+	}
+	this->waitingCache->put_all_unsafe(std::move(all_messages));
+	return candidates;
+}
 
-						auto cache_data = std::make_unique<CPUCacheData>(std::move(table));
-						auto new_message =	std::make_unique<message>(std::move(cache_data), message_id);
-						all_messages[i] = std::move(new_message);
-					} else if(cacheIndex == 2) {
-						if(logger != nullptr) {
-							logger->trace("{query_id}|{step}|{substep}|{info}||kernel_id|{kernel_id}|rows|{rows}",
-								"query_id"_a=(ctx ? std::to_string(ctx->getContextToken()) : ""),
-								"step"_a=(ctx ? std::to_string(ctx->getQueryStep()) : ""),
-								"substep"_a=(ctx ? std::to_string(ctx->getQuerySubstep()) : ""),
-								"info"_a="Downgraded CacheData to Disk cache",
-								"kernel_id"_a=message_id,
-								"rows"_a=table->num_rows());
-						}
+size_t CacheMachine::downgradeCacheData(const std::vector<EvictionCandidate> & candidates) {
+	std::unordered_set<uint64_t> sequences;
+	for (auto & candidate : candidates) {
+		sequences.insert(candidate.message_sequence);
+	}
 
-						// want to get only cache directory where orc files should be saved
-						std::map<std::string, std::string> config_options = ctx->getConfigOptions();
-						auto it = config_options.find("BLAZING_CACHE_DIRECTORY");
-						std::string orc_files_path;
-						if (it != config_options.end()) {
-							orc_files_path = config_options["BLAZING_CACHE_DIRECTORY"];
-						}
-						auto cache_data = std::make_unique<CacheDataLocalFile>(std::move(table), orc_files_path);
-						auto new_message = std::make_unique<message>(std::move(cache_data), message_id);
-						all_messages[i] = std::move(new_message);						
-					}					
-					break;
+	size_t bytes_downgraded = 0;
+	auto lock = this->waitingCache->lock();
+	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
+	for(auto & message_data : all_messages) {
+		if (sequences.count(message_data->get_sequence()) > 0 && message_data->get_data().get_type() == CacheDataType::GPU){
+			bytes_downgraded += downgrade_message_unsafe(message_data);
+		}
+	}
+	this->waitingCache->put_all_unsafe(std::move(all_messages));
+	return bytes_downgraded;
+}
+
+size_t CacheMachine::downgrade_message_unsafe(std::unique_ptr<message> & message_data) {
+	std::unique_ptr<ral::frame::BlazingTable> table = message_data->get_data().decache();
+
+	std::string message_id = message_data->get_message_id();
+	size_t bytes_downgraded = table->sizeInBytes();
+	int cacheIndex = 1; // starting at RAM cache
+	while(cacheIndex < memory_resources.size()) {
+		auto memory_to_use = (this->memory_resources[cacheIndex]->get_memory_used() + table->sizeInBytes());
+		if( memory_to_use < this->memory_resources[cacheIndex]->get_memory_limit()) {
+			if(cacheIndex == 1) {
+				if(logger != nullptr) {
+					logger->trace("{query_id}|{step}|{substep}|{info}||kernel_id|{kernel_id}|rows|{rows}",
+						"query_id"_a=(ctx ? std::to_string(ctx->getContextToken()) : ""),
+						"step"_a=(ctx ? std::to_string(ctx->getQueryStep()) : ""),
+						"substep"_a=(ctx ? std::to_string(ctx->getQuerySubstep()) : ""),
+						"info"_a="Downgraded CacheData to CPU cache",
+						"kernel_id"_a=message_id,
+						"rows"_a=table->num_rows());
 				}
-				cacheIndex++;
-			}
+				metrics->spill_bytes_host.add(table->sizeInBytes());
+				ral::utilities::TraceSpan spill_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "spill to host");
+				spill_span.set_arg("bytes", table->sizeInBytes());
+
+				auto cache_data = make_cpu_cache_data(std::move(table));
+				auto new_message =	std::make_unique<message>(std::move(cache_data), message_id);
+				message_data = std::move(new_message);
+			} else if(cacheIndex == 2) {
+				if(logger != nullptr) {
+					logger->trace("{query_id}|{step}|{substep}|{info}||kernel_id|{kernel_id}|rows|{rows}",
+						"query_id"_a=(ctx ? std::to_string(ctx->getContextToken()) : ""),
+						"step"_a=(ctx ? std::to_string(ctx->getQueryStep()) : ""),
+						"substep"_a=(ctx ? std::to_string(ctx->getQuerySubstep()) : ""),
+						"info"_a="Downgraded CacheData to Disk cache",
+						"kernel_id"_a=message_id,
+						"rows"_a=table->num_rows());
+				}
+				metrics->spill_bytes_disk.add(table->sizeInBytes());
+				ral::utilities::TraceSpan spill_span(ctx ? ctx->getContextToken() : ral::utilities::QueryTracer::ANY_QUERY, "spill", "spill to disk");
+				spill_span.set_arg("bytes", table->sizeInBytes());
+
+				// want to get only cache directory where spill files should be saved
+				std::map<std::string, std::string> config_options = ctx->getConfigOptions();
+				auto it = config_options.find("BLAZING_CACHE_DIRECTORY");
+				std::string spill_files_path;
+				if (it != config_options.end()) {
+					spill_files_path = config_options["BLAZING_CACHE_DIRECTORY"];
+				}
+				bool use_direct_io = false;
+				it = config_options.find("BLAZING_CACHE_DIRECT_IO");
+				if (it != config_options.end()) {
+					use_direct_io = std::stoi(config_options["BLAZING_CACHE_DIRECT_IO"]) != 0;
+				}
+				auto cache_data = std::make_unique<CacheDataLocalFile>(std::move(table), spill_files_path, use_direct_io, true);
+				auto new_message = std::make_unique<message>(std::move(cache_data), message_id);
+				message_data = std::move(new_message);						
+			}					
 			break;
 		}
+		cacheIndex++;
 	}
-	
-	this->waitingCache->put_all_unsafe(std::move(all_messages));
 	return bytes_downgraded;
 }
 
@@ -612,18 +1286,23 @@ std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCac
 	std::string message_id = "";
 
 	do {
+		CodeTimer wait_timer;
 		message_data = waitingCache->pop_or_wait();
+		metrics->pull_wait_time_us.record(wait_timer.elapsed_time<std::chrono::microseconds>());
 		if (message_data == nullptr){
 			break;
 		}
 		auto& cache_data = message_data->get_data();
+		metrics->batches_pulled.add(1);
+		metrics->rows_pulled.add(cache_data.num_rows());
+		metrics->bytes_pulled.add(cache_data.sizeInBytes());
 		total_bytes += cache_data.sizeInBytes();
 		message_id = message_data->get_message_id();
 		collected_messages.push_back(std::move(message_data));
 
 		// we need to decrement here and not at the end, otherwise we can end up with a dead lock
 		std::unique_lock<std::mutex> lock(flow_control_mutex);
-		flow_control_bytes_count -= cache_data.sizeInBytes();
+		flow_control_bytes_pulled(cache_data.sizeInBytes());
 		flow_control_condition_variable.notify_all();
 
 	} while (concat_all || (total_bytes + waitingCache->get_next_size_in_bytes()) <= this->concat_cache_num_bytes);
@@ -637,6 +1316,10 @@ std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCac
 		output = std::move(data->decache());
 		num_rows = output->num_rows();
 	}	else {
+		// read all the disk resident ones in parallel while we decache them in order
+		for (auto & collected_message : collected_messages) {
+			collected_message->get_data().prefetch();
+		}
 		std::vector<std::unique_ptr<ral::frame::BlazingTable>> tables_holder;
 		std::vector<ral::frame::BlazingTableView> table_views;
 		for (int i = 0; i < collected_messages.size(); i++){
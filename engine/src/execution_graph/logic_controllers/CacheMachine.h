@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <future>
 #include <memory>
 #include <condition_variable>
@@ -8,6 +12,7 @@
 #include <queue>
 #include <string>
 #include <typeindex>
+#include <unordered_map>
 #include <vector>
 #include <limits>
 #include <map>
@@ -23,12 +28,18 @@
 
 #include "error.hpp"
 #include "CodeTimer.h"
+#include "utilities/Metrics.h"
+#include "utilities/QueryTracer.h"
 #include <blazingdb/manager/Context.h>
 #include <communication/messages/GPUComponentMessage.h>
 #include "execution_graph/logic_controllers/BlazingColumn.h"
 #include "execution_graph/logic_controllers/BlazingColumnOwner.h"
 #include "execution_graph/logic_controllers/BlazingColumnView.h"
+#include "execution_graph/logic_controllers/FlowControl.h"
+#include "execution_graph/logic_controllers/HostCompression.h"
+#include "execution_graph/logic_controllers/taskflow/executor.h"
 #include <bmr/BlazingMemoryResource.h>
+#include "bmr/EvictionPolicy.h"
 #include "communication/CommunicationData.h"
 
 
@@ -101,6 +112,12 @@ public:
 	*/
 	virtual size_t sizeInBytes() const = 0;
 
+	/**
+	* Starts moving the data closer to the GPU in the background, so a later
+	* decache() does not have to wait for it. Does nothing by default.
+	*/
+	virtual void prefetch() {}
+
 	/**
 	* Destructor
 	*/
@@ -351,6 +368,21 @@ private:
 		this->host_table = ral::communication::messages::serialize_gpu_message_to_host_table(gpu_table->toBlazingTableView());
  	}
 
+	/**
+ 	* Constructor
+	* Takes a GPU based ral::frame::BlazingTable and converts it CPU version
+	* that is stored in a ral::frame::BlazingHostTable, with the buffers that
+	* compress well compressed.
+	* @param table The BlazingTable that is converted to a BlazingHostTable and
+	* stored.
+	* @param compressor Decides which buffers are compressed and how.
+ 	*/
+ 	CPUCacheData(std::unique_ptr<ral::frame::BlazingTable> gpu_table, HostColumnCompressor & compressor)
+		: CPUCacheData(std::move(gpu_table))
+	{
+		compress(compressor);
+ 	}
+
 	/**
  	* Constructor
  	* Takes a GPU based ral::frame::BlazingHostTable and stores it in this
@@ -366,6 +398,7 @@ private:
 	* @return A unique_ptr to a BlazingTable
  	*/
  	std::unique_ptr<ral::frame::BlazingTable> decache() override {
+		decompress();
  		return ral::communication::messages::deserialize_from_cpu(host_table.get());
  	}
 
@@ -378,6 +411,7 @@ private:
 	* BlazingTable.
  	*/
 	std::unique_ptr<ral::frame::BlazingHostTable> releaseHostTable() {
+		decompress();
  		return std::move(host_table);
  	}
 
@@ -385,42 +419,99 @@ private:
 	* Get the amount of CPU memory consumed by this CacheData
 	* Having this function allows us to have one api for seeing the consumption
 	* of all the CacheData objects that are currently in Caches.
-	* @return The number of bytes the BlazingHostTable consumes.
+	* @return The number of bytes the BlazingHostTable consumes once decompressed.
 	*/
  	size_t sizeInBytes() const override { return host_table->sizeInBytes(); }
+
+	/**
+	* Get the amount of CPU memory actually held, which is less than sizeInBytes
+	* when some buffers are compressed.
+	* @return The number of bytes of the buffers.
+	*/
+	size_t hostSizeInBytes() const;
 	/**
 	* Destructor
 	*/
  	virtual ~CPUCacheData() {}
 
+private:
+	/// Replaces the buffers of the host table by their compressed version where the compressor says so.
+	void compress(HostColumnCompressor & compressor);
+
+	/// Brings the host table back to uncompressed buffers, it is a no-op if nothing was compressed.
+	void decompress();
+
+	std::vector<HostCompressionCodec> buffer_codecs; /**< How every buffer of host_table is compressed, empty if none is */
+	std::vector<std::size_t> raw_buffer_sizes; /**< The sizes of the buffers of host_table before compressing them */
+
 protected:
 	 std::unique_ptr<ral::frame::BlazingHostTable> host_table; /**< The CPU representation of a DataFrame  */
  };
 
 /**
-* A CacheData that stores is data in an ORC file.
+* Creates the pool of threads that writes and prefetches CacheDataLocalFile in
+* the background. Calling it again replaces the pool.
+* @param num_threads Number of I/O threads. With 0 all the disk I/O is done
+* synchronously by the thread that creates or decaches the CacheData.
+*/
+void initialize_cache_io_pool(std::size_t num_threads);
+
+/**
+* Get the pool of threads that does the disk I/O of the caches.
+* @return The pool or nullptr if the disk I/O is synchronous.
+*/
+ral::execution::executor * get_cache_io_pool();
+
+/**
+* Get the number of GPU bytes that are queued to be written to disk.
+* They will be freed soon, so the MemoryMonitor does not need to spill more for them.
+* @return The number of bytes of the tables that are waiting to be written.
+*/
+size_t get_pending_spill_bytes();
+
+/**
+* A CacheData that stores is data in a local file.
 * This allows us to cache onto filesystems to allow larger queries to run on
 * limited resources. This is the least performant cache in most instances.
+*
+* The file is a raw dump of the buffers of the columns (data, validity,
+* string offsets and chars) as they are laid out in GPU memory, the same
+* buffers and ColumnTransport metadata used to send tables between nodes.
+* The file starts with a small header, and every buffer starts at a
+* SPILL_FILE_ALIGNMENT boundary so the file can be written and read with
+* large aligned requests, optionally bypassing the page cache with O_DIRECT.
+*
+* When there is a cache io pool the file can be written in the background, in
+* which case decaching it before it is written gives back the table without
+* touching the disk, and it can be prefetched into host memory ahead of decache.
 */
 class CacheDataLocalFile : public CacheData {
 public:
 
 	/**
 	* Constructor
-	* @param table The BlazingTable that is converted into an ORC file and stored
-	* on disk.
-	* @ param orc_files_path The path where the file should be stored.
+	* @param table The BlazingTable whose buffers are written to a file on disk.
+	* @param files_path The path where the file should be stored.
+	* @param use_direct_io Whether the file is written and read with O_DIRECT.
+	* It falls back to buffered I/O if the filesystem does not support it.
+	* @param async_write Whether the file is written by the cache io pool. The
+	* table keeps its GPU memory until it is written. Ignored if there is no pool.
 	*/
-	CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string orc_files_path);
+	CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string files_path, bool use_direct_io = false, bool async_write = false);
 
 	/**
-	* Constructor
-	* @param table The BlazingTable that is converted into an ORC file and stored
-	* on disk.
-	* @ param orc_files_path The path where the file should be stored.
+	* Reads the buffers back into GPU memory and removes the file.
+	* Waits for a background write or prefetch that is already running.
+	* @return The BlazingTable that was stored in the file.
 	*/
 	std::unique_ptr<ral::frame::BlazingTable> decache() override;
 
+	/**
+	* Reads the file into host memory in the cache io pool, if there is a pool
+	* and enough host memory.
+	*/
+	void prefetch() override;
+
 	/**
  	* Get the amount of GPU memory that the decached BlazingTable WOULD consume.
  	* Having this function allows us to have one api for seeing how much GPU
@@ -433,24 +524,92 @@ public:
 	* Get the amount of disk space consumed by this CacheData
 	* Having this function allows us to have one api for seeing the consumption
 	* of all the CacheData objects that are currently in Caches.
-	* @return The number of bytes the ORC file consumes.
+	* @return The number of bytes the file consumes. It is the header plus every
+	* buffer rounded up to SPILL_FILE_ALIGNMENT.
 	*/
 	size_t fileSizeInBytes() const;
 
 	/**
-	* Destructor
+	* Destructor. Removes the file if it was not decached.
 	*/
-	virtual ~CacheDataLocalFile() {}
+	virtual ~CacheDataLocalFile();
 
 	/**
-	* Get the file path of the ORC file.
-	* @return The path to the ORC file.
+	* Get the file path of the spill file.
+	* @return The path to the spill file.
 	*/
-	std::string filePath() const { return filePath_; }
+	std::string filePath() const { return state->file_path; }
 
 private:
-	std::string filePath_; /**< The path to the ORC file. Is usually generated randomly. */
-	size_t size_in_bytes; /**< The size of the file being stored. */
+	/**
+	* Where the data of a CacheDataLocalFile is.
+	*/
+	enum class file_status {
+		WRITE_PENDING, /**< The table is in GPU memory, queued to be written. */
+		WRITING, /**< The table is being written by the cache io pool. */
+		WRITE_FAILED, /**< The background write failed. The table is still in GPU memory. */
+		ON_DISK, /**< The data is only in the file. */
+		PREFETCHING, /**< The file is being read into host memory by the cache io pool. */
+		IN_HOST, /**< The data is in the file and in host memory. */
+		DECACHED /**< The data was decached or discarded. */
+	};
+
+	/**
+	* Everything the background jobs need. It is shared with them so it outlives
+	* the CacheDataLocalFile if it is destroyed while a job is running.
+	*/
+	struct file_state {
+		std::mutex mutex;
+		std::condition_variable condition_variable; /**< Notified when a background job finishes. */
+		file_status status = file_status::ON_DISK;
+		bool discarded = false; /**< The CacheDataLocalFile was destroyed, the last job cleans up. */
+		std::string file_path; /**< The path to the spill file. Is usually generated randomly. */
+		bool use_direct_io; /**< Whether the file is opened with O_DIRECT. */
+		std::vector<blazingdb::transport::ColumnTransport> columns_offsets; /**< Describes how the buffers make up each column. */
+		std::vector<size_t> buffer_sizes; /**< The size of every buffer, in the order they are in the file. */
+		size_t buffers_num_bytes = 0; /**< The sum of buffer_sizes. */
+		size_t header_size = 0; /**< Where the first buffer starts in the file. */
+		size_t file_size_in_bytes = 0; /**< The size of the file, including the header and the padding. */
+		std::unique_ptr<ral::frame::BlazingTable> table; /**< The table while it is not written yet. */
+		std::vector<const char *> raw_buffers; /**< The GPU buffers of table. */
+		std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder; /**< Buffers raw_buffers points to that are not owned by table. */
+		size_t pending_spill_bytes = 0; /**< What this file adds to get_pending_spill_bytes. */
+		std::vector<blazing_host_buffer> host_buffers; /**< The buffers read by prefetch. */
+	};
+
+	/**
+	* Writes the header and the GPU buffers of the table to the file.
+	*/
+	static void write_file(file_state & state);
+
+	/**
+	* Reads the buffers of the file in chunks.
+	* @param sink Called with the buffer index, the position in the buffer, and the bytes read.
+	*/
+	static void read_file(file_state & state, const std::function<void(size_t, size_t, const char *, size_t)> & sink);
+
+	/**
+	* Writes the file in the cache io pool and then frees the GPU memory of the table.
+	*/
+	static void run_write_job(std::shared_ptr<file_state> state);
+
+	/**
+	* Reads the file into host memory in the cache io pool.
+	*/
+	static void run_prefetch_job(std::shared_ptr<file_state> state);
+
+	/**
+	* Lets go of the table and of its share of get_pending_spill_bytes. The mutex must be held.
+	*/
+	static void release_table_unsafe(file_state & state);
+
+	/**
+	* Frees everything the file_state holds and removes the file. The mutex must be held.
+	*/
+	static void discard_unsafe(file_state & state);
+
+	std::shared_ptr<file_state> state; /**< Shared with the background jobs. */
+	size_t size_in_bytes; /**< The size of the table being stored. */
 };
 
 using frame_type = std::unique_ptr<ral::frame::BlazingTable>;
@@ -464,7 +623,7 @@ using frame_type = std::unique_ptr<ral::frame::BlazingTable>;
 class message { //TODO: the cache_data object can store its id. This is not needed.
 public:
 	message(std::unique_ptr<CacheData> content, std::string message_id = "")
-		: data(std::move(content)), message_id(message_id)
+		: data(std::move(content)), message_id(message_id), sequence(next_sequence())
 	{
 		assert(data != nullptr);
 	}
@@ -473,13 +632,22 @@ public:
 
 	std::string get_message_id() const { return (message_id); }
 
+	/// Unique in the process, unlike the message_id, and never reused, unlike the address of the data.
+	uint64_t get_sequence() const { return sequence; }
+
 	CacheData& get_data() const { return *data; }
 
 	std::unique_ptr<CacheData> release_data() { return std::move(data); }
 
 protected:
+	static uint64_t next_sequence() {
+		static std::atomic<uint64_t> counter{1};
+		return counter.fetch_add(1, std::memory_order_relaxed);
+	}
+
 	const std::string message_id;
 	std::unique_ptr<CacheData> data;
+	const uint64_t sequence;
 };
 
 /**
@@ -488,20 +656,70 @@ protected:
 * queue when they exist and wait for things when they don't without consuming
 * many compute resources.This is accomplished through the use of a
 * condition_variable and mutex locks.
+*
+* Producers and consumers do not share a lock. The messages are kept in a
+* linked list that starts with a dummy node, so put only locks the tail and
+* pops only lock the head. Every message is also indexed by its message_id in a
+* striped hash map, so get_or_wait finds its message without scanning the queue.
+* A message taken by id is only marked as taken and is unlinked by the pops
+* once it reaches the head. The number of messages, bytes and rows are kept as
+* running totals.
 */
 class WaitingQueue {
 public:
 	using message_ptr = std::unique_ptr<message>;
 
+	/**
+	* Locks both ends of a WaitingQueue, see WaitingQueue::lock().
+	* When released it wakes up the threads that are waiting on the WaitingQueue,
+	* as the messages may have changed while it was held.
+	*/
+	class exclusive_lock {
+	public:
+		exclusive_lock(WaitingQueue * queue)
+			: queue(queue), head_lock(queue->head_mutex_), tail_lock(queue->tail_mutex_) {}
+
+		exclusive_lock(exclusive_lock && other)
+			: queue(other.queue), head_lock(std::move(other.head_lock)), tail_lock(std::move(other.tail_lock)) {
+			other.queue = nullptr;
+		}
+
+		exclusive_lock(const exclusive_lock &) = delete;
+		exclusive_lock & operator=(const exclusive_lock &) = delete;
+		exclusive_lock & operator=(exclusive_lock &&) = delete;
+
+		~exclusive_lock() {
+			if (queue != nullptr) {
+				tail_lock.unlock();
+				head_lock.unlock();
+				queue->notify_waiters();
+			}
+		}
+
+	private:
+		WaitingQueue * queue;
+		std::unique_lock<std::mutex> head_lock;
+		std::unique_lock<std::mutex> tail_lock;
+	};
+
 	/**
 	* Constructor
 	*/
-	WaitingQueue(int timeout = 60000) : finished{false}, timeout(timeout) {}
+	WaitingQueue(int timeout = 60000) : finished{false}, timeout(timeout) {
+		head = new node();
+		tail = head;
+	}
 
 	/**
 	* Destructor
 	*/
-	~WaitingQueue() = default;
+	~WaitingQueue() {
+		while (head != nullptr) {
+			node * next = head->next.load();
+			delete head;
+			head = next;
+		}
+	}
 
 	WaitingQueue(WaitingQueue &&) = delete;
 	WaitingQueue(const WaitingQueue &) = delete;
@@ -509,17 +727,31 @@ public:
 	WaitingQueue & operator=(const WaitingQueue &) = delete;
 
 	/**
-	* Put a message onto the WaitingQueue using unique_lock.
-	* This message aquires a unique_lock and then pushes a message onto the
-	* WaitingQueue. It then increments the processed count and notifies the
-	* WaitingQueue's condition variable.
+	* Put a message onto the WaitingQueue.
+	* The message is indexed by its id and appended to the tail, which is the
+	* only lock put acquires. It then increments the processed count and wakes
+	* up the threads waiting on the WaitingQueue, if any.
 	* @param item the message_ptr being added to the WaitingQueue
 	*/
 	void put(message_ptr item) {
-		std::unique_lock<std::mutex> lock(mutex_);
-		putWaitingQueue(std::move(item));
+		node * new_node = make_node(std::move(item));
+		{
+			std::unique_lock<std::mutex> lock(tail_mutex_);
+			push_back_unsafe(new_node);
+		}
 		processed++;
-		condition_variable_.notify_all();
+		notify_waiters();
+		notify_event_listener();
+	}
+
+	/**
+	* Registers a callback that is invoked, without holding the lock, every time
+	* a message is put or the WaitingQueue is finished. Used by task based
+	* kernels to get scheduled only when there is something to do.
+	* @param listener The callback. An empty function removes the listener.
+	*/
+	void set_event_listener(std::function<void()> listener) {
+		std::atomic_store(&this->event_listener, std::make_shared<std::function<void()>>(listener));
 	}
 
 	/**
@@ -537,9 +769,12 @@ public:
 	* indefinitely.
 	*/
 	void finish() {
-		std::unique_lock<std::mutex> lock(mutex_);
 		this->finished = true;
+		{
+			std::unique_lock<std::mutex> lock(wait_mutex_);
+		}
 		condition_variable_.notify_all();
+		notify_event_listener();
 	}
 
 	/**
@@ -560,13 +795,20 @@ public:
 
 	void wait_for_count(int count){
 
-		std::unique_lock<std::mutex> lock(mutex_);
-		condition_variable_.wait(lock, [&, this] () {
-			if (count > this->processed){
-				throw std::runtime_error("WaitingQueue::wait_for_count encountered " + std::to_string(this->processed) + " when expecting " + std::to_string(count));
-			}
-			return count == this->processed;
-		});
+		num_waiters++;
+		std::unique_lock<std::mutex> lock(wait_mutex_);
+		try {
+			condition_variable_.wait(lock, [&, this] () {
+				if (count > this->processed){
+					throw std::runtime_error("WaitingQueue::wait_for_count encountered " + std::to_string(this->processed) + " when expecting " + std::to_string(count));
+				}
+				return count == this->processed;
+			});
+		} catch (...) {
+			num_waiters--;
+			throw;
+		}
+		num_waiters--;
 	}
 
 	/**
@@ -578,27 +820,13 @@ public:
 	* the WaitingQueue is empty and finished.
 	*/
 	message_ptr pop_or_wait() {
-
-		CodeTimer blazing_timer;
-		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms, [&, this] {
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst) or !this->empty();
-				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
-					auto logger = spdlog::get("batch_logger");
-					if(logger != nullptr) {
-						logger->warn("|||{info}|{duration}||||",
-											"info"_a="WaitingQueue pop_or_wait timed out",
-											"duration"_a=blazing_timer.elapsed_time());
-					}
-				}
-				return done_waiting;
-			})){}
-
-		if(this->message_queue_.size() == 0) {
-			return nullptr;
-		}
-		auto data = std::move(this->message_queue_.front());
-		this->message_queue_.pop_front();
+		message_ptr data;
+		wait_until("WaitingQueue pop_or_wait timed out", [&data, this] {
+			// messages are not put after finish, so if the pop finds nothing we are done
+			bool was_finished = this->finished.load(std::memory_order_seq_cst);
+			data = this->try_pop();
+			return data != nullptr || was_finished;
+		});
 		return std::move(data);
 	}
 	/**
@@ -607,20 +835,9 @@ public:
 	* is the case. Returns false if the WaitingQueue is both finished and empty.
 	*/
 	bool wait_for_next() {
-		CodeTimer blazing_timer;
-		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms, [&, this] {
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst) or !this->empty();
-				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
-					auto logger = spdlog::get("batch_logger");
-					if(logger != nullptr) {
-						logger->warn("|||{info}|{duration}||||",
-											"info"_a="WaitingQueue wait_for_next timed out",
-											"duration"_a=blazing_timer.elapsed_time());
-					}
-				}
-				return done_waiting;
-			})){}
+		wait_until("WaitingQueue wait_for_next timed out", [this] {
+			return this->finished.load(std::memory_order_seq_cst) or !this->empty();
+		});
 
 		if(this->empty()) {
 			return false;
@@ -632,7 +849,6 @@ public:
 	* @return A bool which is true if the WaitingQueue is not empty.
 	*/
 	bool has_next_now() {
-		std::unique_lock<std::mutex> lock(mutex_);
 		return !this->empty();
 	}
 
@@ -643,20 +859,9 @@ public:
 	* contains.
 	*/
 	void wait_until_finished() {
-		CodeTimer blazing_timer;
-		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms, [&blazing_timer, this] {
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst);
-				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
-					auto logger = spdlog::get("batch_logger");
-					if(logger != nullptr) {
-					   logger->warn("|||{info}|{duration}||||",
-										   "info"_a="WaitingQueue wait_until_finished timed out",
- 										   "duration"_a=blazing_timer.elapsed_time());
-					}
-				}
-				return done_waiting;
-			})){}
+		wait_until("WaitingQueue wait_until_finished timed out", [this] {
+			return this->finished.load(std::memory_order_seq_cst);
+		});
 	}
 
 	/**
@@ -668,27 +873,25 @@ public:
 	* WaitingQueue unless the WaitingQueue has already had finished() called.
 	*/
 	void wait_until_num_bytes(size_t num_bytes) {
-		CodeTimer blazing_timer;
-		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms, [&blazing_timer, num_bytes, this] {
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst);
-				if (!done_waiting) {
-					size_t total_bytes = 0;
-					for (int i = 0; i < message_queue_.size(); i++){
-						total_bytes += message_queue_[i]->get_data().sizeInBytes();
-					}
-					done_waiting = total_bytes > num_bytes;
-				}
-				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
-					auto logger = spdlog::get("batch_logger");
-					if(logger != nullptr) {
-						logger->warn("|||{info}|{duration}||||",
-											"info"_a="WaitingQueue wait_until_finished timed out",
-											"duration"_a=blazing_timer.elapsed_time());
-					}
-				}
-				return done_waiting;
-			})){}
+		wait_until("WaitingQueue wait_until_num_bytes timed out", [num_bytes, this] {
+			return this->finished.load(std::memory_order_seq_cst) or this->get_num_bytes() > num_bytes;
+		});
+	}
+
+	/**
+	* Get the number of bytes of all the messages in the WaitingQueue.
+	* @return The sum of sizeInBytes of every message currently queued.
+	*/
+	size_t get_num_bytes() {
+		return total_bytes.load();
+	}
+
+	/**
+	* Get the number of rows of all the messages in the WaitingQueue.
+	* @return The sum of num_rows of every message currently queued.
+	*/
+	size_t get_num_rows() {
+		return total_rows.load();
 	}
 
 	/**
@@ -699,11 +902,32 @@ public:
 	* @return The number of bytes consumed by the next message.
 	*/
 	size_t get_next_size_in_bytes(){
-		std::unique_lock<std::mutex> lock(mutex_);
-		if (message_queue_.size() > 0){
-			message_queue_[0]->get_data().sizeInBytes();
-		} else {
-			return 0;
+		std::unique_lock<std::mutex> lock(head_mutex_);
+		for (node * current = head->next.load(); current != nullptr; current = current->next.load()) {
+			if (!current->taken) {
+				return current->num_bytes;
+			}
+		}
+		return 0;
+	}
+
+	/**
+	* Calls a function on the next messages, without taking them out of the
+	* WaitingQueue. Used to start moving them closer to the GPU ahead of time.
+	* @param num_messages How many messages to visit at most.
+	* @param visitor The function. It runs holding the locks of the
+	* WaitingQueue, so it should be quick and must not use the WaitingQueue.
+	*/
+	void visit_next(size_t num_messages, const std::function<void(message &)> & visitor) {
+		std::unique_lock<std::mutex> lock(head_mutex_);
+		size_t num_visited = 0;
+		for (node * current = head->next.load(); current != nullptr && num_visited < num_messages; current = current->next.load()) {
+			index_stripe & stripe = get_index_stripe(current->message_id);
+			std::unique_lock<std::mutex> stripe_lock(stripe.mutex);
+			if (!current->taken) {
+				visitor(*current->item);
+				num_visited++;
+			}
 		}
 	}
 
@@ -719,58 +943,43 @@ public:
 	* be able to arrive because the WaitingQueue is finished.
 	*/
 	message_ptr get_or_wait(std::string message_id) {
-		CodeTimer blazing_timer;
-		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms, [message_id, &blazing_timer, this] {
-				auto result = std::any_of(this->message_queue_.cbegin(),
-							this->message_queue_.cend(), [&](auto &e) {
-								return e->get_message_id() == message_id;
-							});
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst) or result;
-				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
-					auto logger = spdlog::get("batch_logger");
-					if(logger != nullptr) {
-						logger->warn("|||{info}|{duration}|message_id|{message_id}||",
-											"info"_a="WaitingQueue get_or_wait timed out",
-											"duration"_a=blazing_timer.elapsed_time(),
-											"message_id"_a=message_id);
-					}
-				}
-				return done_waiting;
-			})){}
-		if(this->message_queue_.size() == 0) {
-			return nullptr;
-		}
-		while (true){
-			auto data = this->pop_unsafe();
-			if (data->get_message_id() == message_id){
-				return std::move(data);
-			} else {
-				putWaitingQueue(std::move(data));
-			}
-		}
+		message_ptr data;
+		wait_until("WaitingQueue get_or_wait timed out", [&data, &message_id, this] {
+			bool was_finished = this->finished.load(std::memory_order_seq_cst);
+			data = this->try_take(message_id);
+			return data != nullptr || was_finished;
+		}, message_id);
+		return std::move(data);
 	}
 
 	/**
 	* Pop the front element WITHOUT thread safety.
 	* Allos us to pop from the front in situations where we have already acquired
-	* a unique_lock on this WaitingQueue's mutex.
+	* the lock() of this WaitingQueue. Messages already taken by get_or_wait are
+	* unlinked on the way.
 	* @return The first message in the WaitingQueue.
 	*/
 	message_ptr pop_unsafe() {
-		if(this->message_queue_.size() == 0) {
-			return nullptr;
+		while (true) {
+			node * first = head->next.load(std::memory_order_acquire);
+			if (first == nullptr) {
+				return nullptr;
+			}
+			message_ptr data = take_node(first);
+			// first becomes the new dummy head, whether we took it or get_or_wait already did
+			delete head;
+			head = first;
+			if (data != nullptr) {
+				return std::move(data);
+			}
 		}
-		auto data = std::move(this->message_queue_.front());
-		this->message_queue_.pop_front();
-		return std::move(data);
 	}
 
 	/**
 	 * gets all the messages
 	 */
 	std::vector<message_ptr> get_all(){
-		std::unique_lock<std::mutex> lock(mutex_);
+		auto lock = this->lock();
 		return get_all_unsafe();
 	}
 
@@ -782,30 +991,18 @@ public:
 	* WaitingQueue.
 	*/
 	std::vector<message_ptr> get_all_or_wait() {
-		CodeTimer blazing_timer;
-		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms,  [&blazing_timer, this] {
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst);
-				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
-					auto logger = spdlog::get("batch_logger");
-					if(logger != nullptr) {
-						logger->warn("|||{info}|{duration}||||",
-											"info"_a="WaitingQueue get_all_or_wait timed out",
-											"duration"_a=blazing_timer.elapsed_time());
-					}
-				}
-				return done_waiting;
-			})){}
-		return get_all_unsafe();
+		wait_until_finished();
+		return get_all();
 	}
 
 	/**
-	* A function that returns a unique_lock using the WaitingQueue's mutex.
-	* @return A unique_lock
+	* Locks both ends of the WaitingQueue.
+	* No message can be put or popped until the returned lock goes out of scope,
+	* which is what get_all_unsafe and put_all_unsafe need.
+	* @return An exclusive_lock over the WaitingQueue
 	*/
-	std::unique_lock<std::mutex> lock(){
-		std::unique_lock<std::mutex> lock(mutex_);
-		return std::move(lock);
+	exclusive_lock lock(){
+		return exclusive_lock(this);
 	}
 
 	/**
@@ -814,10 +1011,11 @@ public:
 	*/
 	std::vector<message_ptr> get_all_unsafe() {
 		std::vector<message_ptr> messages;
-		for(message_ptr & it : message_queue_) {
-			messages.emplace_back(std::move(it));
+		message_ptr data = pop_unsafe();
+		while (data != nullptr) {
+			messages.emplace_back(std::move(data));
+			data = pop_unsafe();
 		}
-		message_queue_.clear();
 		return messages;
 	}
 
@@ -827,36 +1025,228 @@ public:
 	*/
 	void put_all_unsafe(std::vector<message_ptr> messages) {
 		for(size_t i = 0; i < messages.size(); i++) {
-			putWaitingQueue(std::move(messages[i]));
+			push_back_unsafe(make_node(std::move(messages[i])));
 		}
 	}
 
 
 private:
+	/**
+	* A message in the linked list of the WaitingQueue.
+	*/
+	struct node {
+		message_ptr item; /**< The message. Moved out when the node is taken. */
+		std::string message_id; /**< Copy of the message id, used to find the node in the index. */
+		size_t num_bytes = 0; /**< sizeInBytes of the message when it was put. */
+		size_t num_rows = 0; /**< num_rows of the message when it was put. */
+		std::atomic<bool> taken{false}; /**< Set, under the lock of its index stripe, when the message is taken. */
+		std::atomic<node *> next{nullptr}; /**< Next node. Written under the tail lock, read under the head lock. */
+	};
+
+	/**
+	* One part of the index from message_id to the nodes that are not taken yet,
+	* in the order they were put.
+	*/
+	struct index_stripe {
+		std::mutex mutex;
+		std::unordered_map<std::string, std::deque<node *>> nodes;
+	};
+
+	static constexpr size_t NUM_INDEX_STRIPES = 16;
+
+	/**
+	* Get the part of the index a message_id belongs to.
+	* @param message_id The id of the message.
+	* @return The index_stripe for that id.
+	*/
+	index_stripe & get_index_stripe(const std::string & message_id) {
+		return index_[std::hash<std::string>{}(message_id) % NUM_INDEX_STRIPES];
+	}
+
 	/**
 	* Checks if the WaitingQueue is empty.
+	* Takes the head lock so that it never sees the WaitingQueue in the middle of
+	* a get_all_unsafe/put_all_unsafe.
 	* @return A bool indicating if the WaitingQueue is empty.
 	*/
 	bool empty() {
-		return this->message_queue_.size() == 0;
+		std::unique_lock<std::mutex> lock(head_mutex_);
+		return this->num_messages.load() == 0;
+	}
+
+	/**
+	* Creates the node for a message, adds it to the running totals and indexes it.
+	* The node is indexed before it is linked so a linked node can always be found
+	* by its id until it is taken.
+	* @param item The message.
+	* @return The node, ready to be linked at the tail.
+	*/
+	node * make_node(message_ptr item) {
+		node * new_node = new node();
+		new_node->message_id = item->get_message_id();
+		new_node->num_bytes = item->get_data().sizeInBytes();
+		new_node->num_rows = item->get_data().num_rows();
+		new_node->item = std::move(item);
+
+		num_messages++;
+		total_bytes += new_node->num_bytes;
+		total_rows += new_node->num_rows;
+
+		index_stripe & stripe = get_index_stripe(new_node->message_id);
+		std::unique_lock<std::mutex> lock(stripe.mutex);
+		stripe.nodes[new_node->message_id].push_back(new_node);
+		return new_node;
+	}
+
+	/**
+	* Links a node at the tail. The tail lock must be held.
+	* @param new_node The node to link.
+	*/
+	void push_back_unsafe(node * new_node) {
+		tail->next.store(new_node, std::memory_order_release);
+		tail = new_node;
+	}
+
+	/**
+	* Takes the message of a node unless it was already taken.
+	* @param candidate The node. It must be indexed or already taken.
+	* @return The message, or nullptr if it was already taken.
+	*/
+	message_ptr take_node(node * candidate) {
+		index_stripe & stripe = get_index_stripe(candidate->message_id);
+		std::unique_lock<std::mutex> lock(stripe.mutex);
+		if (candidate->taken) {
+			return nullptr;
+		}
+		auto it = stripe.nodes.find(candidate->message_id);
+		it->second.erase(std::find(it->second.begin(), it->second.end(), candidate));
+		if (it->second.empty()) {
+			stripe.nodes.erase(it);
+		}
+		return take_node_unsafe(candidate);
+	}
+
+	/**
+	* Marks a node as taken and removes it from the running totals. The lock of
+	* its index stripe must be held and the node must already be out of the index.
+	* @param candidate The node.
+	* @return The message of the node.
+	*/
+	message_ptr take_node_unsafe(node * candidate) {
+		candidate->taken = true;
+		num_messages--;
+		total_bytes -= candidate->num_bytes;
+		total_rows -= candidate->num_rows;
+		return std::move(candidate->item);
 	}
+
 	/**
-	* Adds a message to the WaitingQueue
-	* @param item The message to add to the WaitingQueue.
+	* Pops the first message if there is one, without waiting.
+	* @return The first message or nullptr if there is none.
 	*/
+	message_ptr try_pop() {
+		std::unique_lock<std::mutex> lock(head_mutex_);
+		return pop_unsafe();
+	}
 
-	void putWaitingQueue(message_ptr item) { message_queue_.emplace_back(std::move(item)); }
+	/**
+	* Takes the oldest message with a given id if there is one, without waiting.
+	* @param message_id The id of the message.
+	* @return The message or nullptr if there is none.
+	*/
+	message_ptr try_take(const std::string & message_id) {
+		index_stripe & stripe = get_index_stripe(message_id);
+		std::unique_lock<std::mutex> lock(stripe.mutex);
+		auto it = stripe.nodes.find(message_id);
+		if (it == stripe.nodes.end()) {
+			return nullptr;
+		}
+		node * candidate = it->second.front();
+		it->second.pop_front();
+		if (it->second.empty()) {
+			stripe.nodes.erase(it);
+		}
+		return take_node_unsafe(candidate);
+	}
+
+	/**
+	* Blocks until a condition is true, logging a warning while it takes too long.
+	* @param info The message to log when it is taking too long.
+	* @param predicate The condition. It is evaluated holding wait_mutex_.
+	* @param message_id The message we are waiting for, if any, for the log.
+	*/
+	template <typename Predicate>
+	void wait_until(const std::string & info, Predicate predicate, const std::string & message_id = "") {
+		CodeTimer blazing_timer;
+		num_waiters++;
+		std::unique_lock<std::mutex> lock(wait_mutex_);
+		while(!condition_variable_.wait_for(lock, timeout*1ms, [&] {
+				// this read pairs with the increment in put, so either we see the new message
+				// or put sees num_waiters and notifies us
+				this->processed.load();
+				bool done_waiting = predicate();
+				if (!done_waiting && blazing_timer.elapsed_time() > 59000){
+					auto logger = spdlog::get("batch_logger");
+					if(logger != nullptr) {
+						if (message_id.empty()) {
+							logger->warn("|||{info}|{duration}||||",
+												"info"_a=info,
+												"duration"_a=blazing_timer.elapsed_time());
+						} else {
+							logger->warn("|||{info}|{duration}|message_id|{message_id}||",
+												"info"_a=info,
+												"duration"_a=blazing_timer.elapsed_time(),
+												"message_id"_a=message_id);
+						}
+					}
+				}
+				return done_waiting;
+			})){}
+		num_waiters--;
+	}
+
+	/**
+	* Wakes up the threads waiting on the WaitingQueue. Only takes the wait lock
+	* when someone is waiting.
+	*/
+	void notify_waiters() {
+		if (num_waiters.load() > 0) {
+			{
+				// makes sure a waiter that already checked its condition is sleeping before we notify
+				std::unique_lock<std::mutex> lock(wait_mutex_);
+			}
+			condition_variable_.notify_all();
+		}
+	}
+
+	/**
+	* Invokes the event listener, if any.
+	*/
+	void notify_event_listener() {
+		std::shared_ptr<std::function<void()>> listener = std::atomic_load(&this->event_listener);
+		if (listener && *listener) {
+			(*listener)();
+		}
+	}
 
 private:
-	std::mutex mutex_; /**< This mutex is used for making access to the
-											WaitingQueue thread-safe. */
-	std::deque<message_ptr> message_queue_; /**< */
+	std::mutex head_mutex_; /**< Taken by the consumers to pop from the head. */
+	std::mutex tail_mutex_; /**< Taken by the producers to link at the tail. */
+	node * head; /**< Dummy node before the first message. Protected by head_mutex_. */
+	node * tail; /**< Last node. Protected by tail_mutex_. */
+	std::array<index_stripe, NUM_INDEX_STRIPES> index_; /**< Nodes not taken yet by message_id. */
+	std::atomic<size_t> num_messages{0}; /**< Number of messages not taken yet. */
+	std::atomic<size_t> total_bytes{0}; /**< Sum of the sizeInBytes of the messages not taken yet. */
+	std::atomic<size_t> total_rows{0}; /**< Sum of the num_rows of the messages not taken yet. */
 	std::atomic<bool> finished; /**< Indicates if this WaitingQueue is finished. */
+	std::mutex wait_mutex_; /**< Only used to sleep on condition_variable_. */
 	std::condition_variable condition_variable_; /**< Used to notify waiting
 																								functions*/
-	int processed = 0; /**< Count of messages added to the WaitingQueue. */
+	std::atomic<size_t> num_waiters{0}; /**< Number of threads sleeping on condition_variable_. */
+	std::atomic<int> processed{0}; /**< Count of messages added to the WaitingQueue. */
 
 	int timeout; /**< timeout period in ms used by the wait_for to log that the condition_variable has been waiting for a long time. */
+	std::shared_ptr<std::function<void()>> event_listener; /**< Invoked after every put and finish. See set_event_listener. */
 };
 
 
@@ -911,6 +1301,23 @@ public:
 	bool has_next_now() {
 		return this->waitingCache->has_next_now();
 	}
+
+	/**
+	* Indicates if a pull would return right away, either with data or with nullptr because the cache is finished.
+	* Task based kernels only pull from caches that are ready, so they never block an executor worker.
+	*/
+	virtual bool ready_to_pull() {
+		return this->waitingCache->has_next_now() || this->waitingCache->is_finished();
+	}
+
+	/**
+	* Registers a callback invoked every time data is added to the cache or the cache is finished.
+	* @param listener The callback. An empty function removes the listener.
+	*/
+	void set_event_listener(std::function<void()> listener) {
+		this->waitingCache->set_event_listener(listener);
+	}
+
 	virtual std::unique_ptr<ral::frame::BlazingTable> pullFromCache();
 
 
@@ -925,6 +1332,30 @@ public:
 
 	virtual void wait_if_cache_is_saturated();
 
+	/**
+	* Indicates if the cache is over its flow control budget, without waiting like wait_if_cache_is_saturated.
+	* Task based kernels check their output with it, so they never block an executor worker.
+	*/
+	bool is_saturated();
+
+	/**
+	* Registers a callback invoked every time data is pulled from the cache, so that a producer that found the cache
+	* saturated knows when to check it again. It is invoked holding the flow control lock, so it must not use the cache.
+	* @param listener The callback. An empty function removes the listener.
+	*/
+	void set_pull_listener(std::function<void()> listener) {
+		std::atomic_store(&this->pull_listener, std::make_shared<std::function<void()>>(listener));
+	}
+
+	/**
+	* Makes the flow control budget of the cache follow the rate at which it is consumed and the memory left, instead
+	* of only the fixed flow_control_bytes_threshold, which still applies as a maximum.
+	* Must be called before the cache is used.
+	* @param target_latency_ms How long the data held by the cache should take its consumer to pull.
+	* @param min_bytes The budget never goes below this, for consumers that wait for an amount of data before pulling.
+	*/
+	void enable_adaptive_flow_control(int64_t target_latency_ms, std::size_t min_bytes);
+
 	void wait_for_count(int count){
 		return this->waitingCache->wait_for_count(count);
 	}
@@ -932,8 +1363,31 @@ public:
 	// this function does not change the order of the caches
 	virtual size_t downgradeCacheData();
 
+	/**
+	* Describes every batch of this CacheMachine that is in the GPU, so that an EvictionPolicy can choose which ones to
+	* downgrade. The tree_order of the candidates is left for the caller to set.
+	*/
+	virtual std::vector<EvictionCandidate> get_eviction_candidates();
+
+	/**
+	* Puts the batches described by the candidates in RAM or Disk as appropriate, the ones still in this CacheMachine
+	* and in the GPU, in a single pass over the cache. This function does not change the order of the caches
+	* @return The bytes downgraded, the batches pulled or downgraded since the candidates were made are skipped.
+	*/
+	size_t downgradeCacheData(const std::vector<EvictionCandidate> & candidates);
+
 
 protected:
+	/// The flow control accounting of every batch added or pulled. Must be called with flow_control_mutex held.
+	void flow_control_bytes_added(std::size_t num_bytes);
+	void flow_control_bytes_pulled(std::size_t num_bytes);
+
+	/// Copies a table to the host tier, compressed if CACHE_HOST_COMPRESSION is set.
+	std::unique_ptr<CPUCacheData> make_cpu_cache_data(std::unique_ptr<ral::frame::BlazingTable> table);
+
+	/// Moves a message that is in the GPU to RAM or Disk. Must be called with the waitingCache locked.
+	size_t downgrade_message_unsafe(std::unique_ptr<message> & message_data);
+
 	static std::size_t cache_count;
 
 	/// This property represents a waiting queue object which stores all CacheData Objects
@@ -954,7 +1408,13 @@ protected:
 	std::size_t flow_control_bytes_count;
 	std::mutex flow_control_mutex;
 	std::condition_variable flow_control_condition_variable;
+	std::unique_ptr<AdaptiveFlowControl> adaptive_flow_control; /**< nullptr unless enable_adaptive_flow_control was called */
+	static std::atomic<std::size_t> num_adaptive_caches; /**< The caches sharing the memory headroom */
+	std::unique_ptr<HostColumnCompressor> host_compressor; /**< nullptr unless CACHE_HOST_COMPRESSION is set */
+	ByteRate pulled_rate{1000000}; /**< How fast the consumer pulls, for the EvictionPolicy. Guarded by flow_control_mutex */
+	std::shared_ptr<std::function<void()>> pull_listener; /**< Invoked after every pull. See set_pull_listener. */
 
+	std::shared_ptr<ral::utilities::CacheMetrics> metrics; /**< Rows, bytes and spills going through the cache. */
 };
 
 /**
@@ -1070,10 +1530,21 @@ public:
 		return pullFromCache();
 	}
 
+	bool ready_to_pull() override {
+		if (this->waitingCache->is_finished()) {
+			return true;
+		}
+		return !concat_all && this->waitingCache->get_num_bytes() > this->concat_cache_num_bytes;
+	}
+
 	size_t downgradeCacheData() override { // dont want to be able to downgrage concatenating caches
 		return 0;
 	}
 
+	std::vector<EvictionCandidate> get_eviction_candidates() override {
+		return {};
+	}
+
   private:
   	std::size_t concat_cache_num_bytes;
 	bool concat_all;
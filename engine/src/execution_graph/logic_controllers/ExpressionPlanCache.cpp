@@ -0,0 +1,73 @@
+#include "ExpressionPlanCache.h"
+
+namespace ral {
+namespace processor {
+
+void expression_plan_cache::initialize(std::size_t max_entries) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->max_entries = max_entries;
+	while (lru_keys.size() > max_entries) {
+		entries.erase(lru_keys.back());
+		lru_keys.pop_back();
+	}
+}
+
+std::string expression_plan_cache::get_key(const std::vector<std::string> & expressions, const cudf::table_view & table) {
+	std::string key;
+	for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+		key += std::to_string(static_cast<int32_t>(table.column(i).type().id()));
+		key += ',';
+	}
+	key += '|';
+	for (const std::string & expression : expressions) {
+		// length prefixed, so no two lists of expressions get the same key
+		key += std::to_string(expression.size());
+		key += ':';
+		key += expression;
+	}
+	return key;
+}
+
+std::shared_ptr<const expression_plan> expression_plan_cache::get(const std::string & key) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = entries.find(key);
+	if (it == entries.end()) {
+		return nullptr;
+	}
+	lru_keys.splice(lru_keys.begin(), lru_keys, it->second.second);
+	return it->second.first;
+}
+
+void expression_plan_cache::put(const std::string & key, std::shared_ptr<const expression_plan> plan) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (max_entries == 0) {
+		return;
+	}
+	auto it = entries.find(key);
+	if (it != entries.end()) {
+		// another batch made the same plan at the same time
+		lru_keys.splice(lru_keys.begin(), lru_keys, it->second.second);
+		it->second.first = plan;
+		return;
+	}
+	lru_keys.push_front(key);
+	entries.emplace(key, std::make_pair(plan, lru_keys.begin()));
+	while (lru_keys.size() > max_entries) {
+		entries.erase(lru_keys.back());
+		lru_keys.pop_back();
+	}
+}
+
+void expression_plan_cache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	lru_keys.clear();
+}
+
+std::size_t expression_plan_cache::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+} // namespace processor
+} // namespace ral
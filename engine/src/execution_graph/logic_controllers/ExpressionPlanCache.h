@@ -0,0 +1,104 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cudf/scalar/scalar.hpp>
+#include <cudf/table/table_view.hpp>
+#include <cudf/types.hpp>
+
+#include "Interpreter/interpreter_cpp.h"
+#include "parser/expression_tree.hpp"
+
+namespace ral {
+namespace processor {
+
+/**
+ * What evaluate_expressions derives from a list of expressions and the schema of its input, which does not depend on
+ * the rows of a batch.
+ */
+struct expression_plan {
+	/**
+	 * The expressions once rewritten and parsed, before their string functions are evaluated. Every batch evaluates a
+	 * clone of them unless the plan is compiled.
+	 */
+	std::vector<parser::parse_tree> trees;
+
+	/**
+	 * Whether the rest of the plan is set. It is not when an expression has a function that is evaluated on the rows
+	 * (i.e. string functions), as the interpreter plan is made after them.
+	 */
+	bool compiled = false;
+
+	/** Whether the interpreter plan needs too many registers, then the expressions are evaluated in two halves. */
+	bool split = false;
+
+	enum class output_kind { LITERAL, INPUT_COLUMN, INTERPRETED };
+
+	/** One per expression. */
+	std::vector<output_kind> output_kinds;
+	std::vector<std::unique_ptr<cudf::scalar>> literal_scalars; /**< The value of the LITERAL outputs, nullptr for the others */
+	std::vector<cudf::size_type> input_column_indices; /**< The column copied by the INPUT_COLUMN outputs */
+	std::vector<cudf::data_type> output_types; /**< The type of the INTERPRETED outputs */
+
+	/** The interpreter plan of the INTERPRETED outputs, with the columns of the batch it reads. */
+	std::vector<cudf::size_type> interpreter_input_columns;
+	std::vector<interops::column_index_type> left_inputs;
+	std::vector<interops::column_index_type> right_inputs;
+	std::vector<interops::column_index_type> outputs;
+	std::vector<interops::column_index_type> final_output_positions;
+	std::vector<interops::column_index_type> final_output_ops;
+	std::vector<operator_type> operators;
+	std::vector<std::unique_ptr<cudf::scalar>> left_scalars;
+	std::vector<std::unique_ptr<cudf::scalar>> right_scalars;
+};
+
+/**
+ * Keeps the expression_plan of every list of expressions evaluated lately, so the kernels that evaluate the same
+ * expressions on thousands of batches only rewrite and parse them once. Entries are keyed by the expressions and the
+ * column types of the input, and evicted in LRU order. The plans are immutable once added, so any number of batches
+ * can use one at the same time.
+ */
+class expression_plan_cache {
+public:
+	static expression_plan_cache & getInstance() {
+		static expression_plan_cache instance;
+		return instance;
+	}
+
+	/**
+	 * @param max_entries How many plans are kept. 0 disables the cache.
+	 */
+	void initialize(std::size_t max_entries);
+
+	static std::string get_key(const std::vector<std::string> & expressions, const cudf::table_view & table);
+
+	/**
+	 * Returns the plan of a key, or nullptr if there is none.
+	 */
+	std::shared_ptr<const expression_plan> get(const std::string & key);
+
+	void put(const std::string & key, std::shared_ptr<const expression_plan> plan);
+
+	void clear();
+
+	std::size_t size();
+
+	expression_plan_cache(const expression_plan_cache &) = delete;
+	expression_plan_cache & operator=(const expression_plan_cache &) = delete;
+
+private:
+	expression_plan_cache() = default;
+
+	std::mutex mutex;
+	std::size_t max_entries = 1000;
+	std::list<std::string> lru_keys;  /**< most recently used first */
+	std::unordered_map<std::string, std::pair<std::shared_ptr<const expression_plan>, std::list<std::string>::iterator>> entries;
+};
+
+} // namespace processor
+} // namespace ral
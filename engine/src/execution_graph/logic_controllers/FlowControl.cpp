@@ -0,0 +1,60 @@
+#include "FlowControl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ral {
+namespace cache {
+
+void ByteRate::record(std::size_t num_bytes, int64_t now_us) {
+	if(first_record_us < 0) {
+		first_record_us = now_us;
+	} else if(now_us > last_record_us) {
+		decayed_bytes *= std::exp(-static_cast<double>(now_us - last_record_us) / time_constant_us);
+	}
+	decayed_bytes += num_bytes;
+	last_record_us = std::max(last_record_us, now_us);
+}
+
+double ByteRate::bytes_per_second(int64_t now_us) const {
+	if(first_record_us < 0) {
+		return 0;
+	}
+	double since_last_us = static_cast<double>(std::max<int64_t>(now_us - last_record_us, 0));
+	// at the beginning the bytes were recorded over less than a time constant, this weighs them by the elapsed time
+	// instead, which is not less than a tenth of the time constant so the first batch does not look infinitely fast
+	double since_first_us = static_cast<double>(std::max<int64_t>(now_us - first_record_us, std::max<int64_t>(time_constant_us / 10, 1)));
+	double window_us = time_constant_us * (1.0 - std::exp(-since_first_us / time_constant_us));
+	return decayed_bytes * std::exp(-since_last_us / time_constant_us) / window_us * 1000000.0;
+}
+
+AdaptiveFlowControl::AdaptiveFlowControl(int64_t target_latency_ms, std::size_t min_bytes)
+	: target_latency_us(target_latency_ms * 1000), min_bytes(min_bytes),
+	  produced(std::max<int64_t>(target_latency_ms * 1000, 1)), consumed(std::max<int64_t>(target_latency_ms * 1000, 1)) {}
+
+void AdaptiveFlowControl::record_added(std::size_t num_bytes, int64_t now_us) {
+	max_batch_bytes = std::max(max_batch_bytes, num_bytes);
+	produced.record(num_bytes, now_us);
+}
+
+void AdaptiveFlowControl::record_pulled(std::size_t num_bytes, int64_t now_us) {
+	consumed.record(num_bytes, now_us);
+}
+
+std::size_t AdaptiveFlowControl::get_budget(std::size_t memory_share, int64_t now_us) const {
+	std::size_t budget = memory_share;
+	// until the consumer pulls something its rate is unknown, and it may just not have started yet
+	if(consumed.has_rate()) {
+		double consumer_rate = consumed.bytes_per_second(now_us);
+		if(produced.bytes_per_second(now_us) > consumer_rate) {
+			double latency_bytes = consumer_rate * target_latency_us / 1000000.0;
+			if(latency_bytes < static_cast<double>(budget)) {
+				budget = static_cast<std::size_t>(latency_bytes);
+			}
+		}
+	}
+	return std::max(budget, std::max(min_bytes, max_batch_bytes));
+}
+
+}  // namespace cache
+}  // namespace ral
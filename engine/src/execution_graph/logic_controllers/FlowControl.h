@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ral {
+namespace cache {
+
+/**
+ * @brief Estimates the rate at which bytes go through a cache. Every byte weighs exp(-age / time_constant), so the
+ * rate follows the recent past and goes down by itself when nothing goes through anymore.
+ */
+class ByteRate {
+public:
+	explicit ByteRate(int64_t time_constant_us) : time_constant_us(time_constant_us) {}
+
+	void record(std::size_t num_bytes, int64_t now_us);
+
+	/**
+	 * @return The bytes per second at now_us, or 0 if nothing was recorded yet.
+	 */
+	double bytes_per_second(int64_t now_us) const;
+
+	bool has_rate() const { return first_record_us >= 0; }
+
+private:
+	const int64_t time_constant_us;
+	double decayed_bytes = 0;
+	int64_t last_record_us = -1;
+	int64_t first_record_us = -1;
+};
+
+/**
+ * @brief Sizes the flow control budget of a cache from the rates at which its producer adds and its consumer pulls
+ * data, and from the memory left.
+ *
+ * The cache may use its share of the device and host memory headroom. When the producer is faster than the consumer,
+ * the cache does not need to hold more than what the consumer pulls within the target latency, so the producer is held
+ * back before it forces spills. When the consumer is faster, the cache drains by itself and only the memory share
+ * applies. The budget never goes below min_bytes nor below the biggest batch added, so a producer can always add the
+ * next batch to an empty cache and a consumer that needs min_bytes to make progress gets them.
+ *
+ * Not thread safe, the CacheMachine calls it with its flow control mutex held.
+ */
+class AdaptiveFlowControl {
+public:
+	AdaptiveFlowControl(int64_t target_latency_ms, std::size_t min_bytes);
+
+	void record_added(std::size_t num_bytes, int64_t now_us);
+
+	void record_pulled(std::size_t num_bytes, int64_t now_us);
+
+	/**
+	 * @param memory_share The bytes of device and host memory this cache may still take.
+	 * @return How many bytes the cache may hold before its producer has to wait.
+	 */
+	std::size_t get_budget(std::size_t memory_share, int64_t now_us) const;
+
+private:
+	const int64_t target_latency_us;
+	const std::size_t min_bytes;
+	std::size_t max_batch_bytes = 0;
+	ByteRate produced;
+	ByteRate consumed;
+};
+
+}  // namespace cache
+}  // namespace ral
@@ -0,0 +1,148 @@
+#include "HostCompression.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <lz4.h>
+#include <zstd.h>
+
+namespace ral {
+namespace cache {
+
+HostCompressionCodec parse_host_compression_codec(const std::string & name) {
+	if (name.empty() || name == "none") {
+		return HostCompressionCodec::NONE;
+	} else if (name == "lz4") {
+		return HostCompressionCodec::LZ4;
+	} else if (name == "zstd") {
+		return HostCompressionCodec::ZSTD;
+	}
+	throw std::runtime_error("Unknown host compression codec: " + name);
+}
+
+blazing_host_buffer compress_host_buffer(HostCompressionCodec codec, const blazing_host_buffer & buffer) {
+	// the compressed size is not known before compressing, so it goes through a buffer of the pool sized to the bound
+	// of the codec, which goes back to the free list of the pool once the compressed bytes are copied out
+	blazing_host_buffer scratch;
+	std::size_t compressed_size = 0;
+	if (codec == HostCompressionCodec::LZ4) {
+		if (buffer.size() > LZ4_MAX_INPUT_SIZE) {
+			return blazing_host_buffer();
+		}
+		scratch = blazing_host_buffer(LZ4_compressBound(static_cast<int>(buffer.size())));
+		int result = LZ4_compress_default(buffer.data(), scratch.data(), static_cast<int>(buffer.size()), static_cast<int>(scratch.size()));
+		compressed_size = result > 0 ? result : 0;
+	} else if (codec == HostCompressionCodec::ZSTD) {
+		scratch = blazing_host_buffer(ZSTD_compressBound(buffer.size()));
+		std::size_t result = ZSTD_compress(scratch.data(), scratch.size(), buffer.data(), buffer.size(), 1);
+		compressed_size = ZSTD_isError(result) ? 0 : result;
+	}
+	if (compressed_size == 0 || compressed_size >= buffer.size()) {
+		return blazing_host_buffer();
+	}
+
+	blazing_host_buffer compressed(compressed_size);
+	std::memcpy(compressed.data(), scratch.data(), compressed_size);
+	return compressed;
+}
+
+blazing_host_buffer decompress_host_buffer(HostCompressionCodec codec, const blazing_host_buffer & buffer, std::size_t raw_size) {
+	blazing_host_buffer raw(raw_size);
+	bool valid = false;
+	if (codec == HostCompressionCodec::LZ4) {
+		int result = LZ4_decompress_safe(buffer.data(), raw.data(), static_cast<int>(buffer.size()), static_cast<int>(raw_size));
+		valid = result >= 0 && static_cast<std::size_t>(result) == raw_size;
+	} else if (codec == HostCompressionCodec::ZSTD) {
+		std::size_t result = ZSTD_decompress(raw.data(), raw_size, buffer.data(), buffer.size());
+		valid = !ZSTD_isError(result) && result == raw_size;
+	}
+	if (!valid) {
+		throw std::runtime_error("Corrupt compressed host buffer");
+	}
+	return raw;
+}
+
+HostColumnCompressor::HostColumnCompressor(HostCompressionCodec codec, double max_ratio, std::size_t min_buffer_bytes,
+	std::size_t reprobe_interval)
+	: codec(codec), max_ratio(max_ratio), min_buffer_bytes(min_buffer_bytes), reprobe_interval(reprobe_interval) {}
+
+bool HostColumnCompressor::should_compress(int column) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (column >= static_cast<int>(columns.size())) {
+		columns.resize(column + 1);
+	}
+	ColumnStats & stats = columns[column];
+	if (!stats.measured || stats.ratio <= max_ratio) {
+		return true;
+	}
+	stats.batches_since_probe++;
+	return stats.batches_since_probe >= reprobe_interval;
+}
+
+void HostColumnCompressor::record(int column, std::size_t raw_bytes, std::size_t compressed_bytes) {
+	double ratio = static_cast<double>(compressed_bytes) / raw_bytes;
+	std::lock_guard<std::mutex> lock(mutex);
+	ColumnStats & stats = columns[column];
+	// the last batches weigh the most, so a column that changes is noticed in a few batches
+	stats.ratio = stats.measured ? (stats.ratio + ratio) / 2 : ratio;
+	stats.measured = true;
+	stats.batches_since_probe = 0;
+}
+
+double HostColumnCompressor::get_column_ratio(int column) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (column < 0 || column >= static_cast<int>(columns.size()) || !columns[column].measured) {
+		return 1.0;
+	}
+	return columns[column].ratio;
+}
+
+std::vector<HostCompressionCodec> HostColumnCompressor::compress(std::vector<blazing_host_buffer> & buffers,
+	const std::vector<int> & buffer_columns) {
+	std::vector<HostCompressionCodec> codecs(buffers.size(), HostCompressionCodec::NONE);
+	if (codec == HostCompressionCodec::NONE) {
+		return codecs;
+	}
+
+	// the buffers of a column are decided and measured together
+	std::vector<std::size_t> raw_bytes;
+	std::vector<std::size_t> compressed_bytes;
+	std::vector<int> decision; // -1 undecided, 0 skip, 1 compress
+	for (std::size_t i = 0; i < buffers.size(); i++) {
+		int column = i < buffer_columns.size() ? buffer_columns[i] : -1;
+		if (column < 0 || buffers[i].size() < min_buffer_bytes) {
+			continue;
+		}
+		if (column >= static_cast<int>(decision.size())) {
+			decision.resize(column + 1, -1);
+			raw_bytes.resize(column + 1, 0);
+			compressed_bytes.resize(column + 1, 0);
+		}
+		if (decision[column] < 0) {
+			decision[column] = should_compress(column) ? 1 : 0;
+		}
+		if (decision[column] == 0) {
+			continue;
+		}
+
+		raw_bytes[column] += buffers[i].size();
+		blazing_host_buffer compressed = compress_host_buffer(codec, buffers[i]);
+		if (compressed.size() == 0 || compressed.size() > buffers[i].size() * max_ratio) {
+			compressed_bytes[column] += buffers[i].size();
+			continue;
+		}
+		compressed_bytes[column] += compressed.size();
+		buffers[i] = std::move(compressed);
+		codecs[i] = codec;
+	}
+
+	for (std::size_t column = 0; column < decision.size(); column++) {
+		if (decision[column] == 1 && raw_bytes[column] > 0) {
+			record(column, raw_bytes[column], compressed_bytes[column]);
+		}
+	}
+	return codecs;
+}
+
+}  // namespace cache
+}  // namespace ral
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bmr/BlazingHostBufferPool.h"
+
+namespace ral {
+namespace cache {
+
+enum class HostCompressionCodec : int8_t { NONE = 0, LZ4 = 1, ZSTD = 2 };
+
+/**
+ * @param name none, lz4 or zstd
+ * @throws std::runtime_error if the codec is unknown.
+ */
+HostCompressionCodec parse_host_compression_codec(const std::string & name);
+
+/**
+ * @brief Compresses the host buffers of the batches of one cache.
+ *
+ * Every batch keeps the same columns, so the ratio obtained on a column is a good guess for the next batches. A column
+ * whose buffers compress worse than max_ratio is stored as is, and tried again only every reprobe_interval batches,
+ * so incompressible columns (i.e. random keys or doubles) cost almost nothing. Buffers smaller than min_buffer_bytes
+ * are never compressed.
+ *
+ * Thread safe, a cache can be downgraded and added to at the same time.
+ */
+class HostColumnCompressor {
+public:
+	HostColumnCompressor(HostCompressionCodec codec, double max_ratio, std::size_t min_buffer_bytes = 4096,
+		std::size_t reprobe_interval = 16);
+
+	HostCompressionCodec get_codec() const { return codec; }
+
+	/**
+	 * Replaces the buffers that compress well by their compressed version.
+	 * @param buffers The buffers of one batch.
+	 * @param buffer_columns The column every buffer belongs to.
+	 * @return The codec of every buffer, NONE for the ones that were left as they were.
+	 */
+	std::vector<HostCompressionCodec> compress(std::vector<blazing_host_buffer> & buffers, const std::vector<int> & buffer_columns);
+
+	/**
+	 * @return The measured compressed size over raw size of a column, 1.0 if it was never compressed.
+	 */
+	double get_column_ratio(int column) const;
+
+private:
+	struct ColumnStats {
+		double ratio = 1.0;
+		bool measured = false;
+		std::size_t batches_since_probe = 0;
+	};
+
+	bool should_compress(int column);
+
+	void record(int column, std::size_t raw_bytes, std::size_t compressed_bytes);
+
+	const HostCompressionCodec codec;
+	const double max_ratio;
+	const std::size_t min_buffer_bytes;
+	const std::size_t reprobe_interval;
+	mutable std::mutex mutex;
+	std::vector<ColumnStats> columns;
+};
+
+/**
+ * @return A copy of the buffer compressed with the codec, or an empty buffer if it does not get smaller.
+ */
+blazing_host_buffer compress_host_buffer(HostCompressionCodec codec, const blazing_host_buffer & buffer);
+
+/**
+ * @param raw_size The size of the buffer before it was compressed.
+ * @throws std::runtime_error if the buffer is corrupt.
+ */
+blazing_host_buffer decompress_host_buffer(HostCompressionCodec codec, const blazing_host_buffer & buffer, std::size_t raw_size);
+
+}  // namespace cache
+}  // namespace ral
@@ -50,6 +50,17 @@ std::unique_ptr<ral::frame::BlazingTable> applyBooleanFilter(
     filteredTable),table.names());
 }
 
+std::unique_ptr<ral::frame::BlazingColumn> evaluate_filter_condition(
+  const ral::frame::BlazingTableView & table,
+  const std::string & condition) {
+
+  std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table = evaluate_expressions(table.view(), {condition});
+
+  RAL_EXPECTS(evaluated_table.size() == 1 && evaluated_table[0]->view().type().id() == cudf::type_id::BOOL8, "Expression does not evaluate to a boolean mask");
+
+  return std::move(evaluated_table[0]);
+}
+
 std::unique_ptr<ral::frame::BlazingTable> process_filter(
   const ral::frame::BlazingTableView & table_view,
   const std::string & query_part,
@@ -64,11 +75,9 @@ std::unique_ptr<ral::frame::BlazingTable> process_filter(
 		conditional_expression = get_named_expression(query_part, "filters");
 	}
 
-  std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table = evaluate_expressions(table_view.view(), {conditional_expression});
-
-  RAL_EXPECTS(evaluated_table.size() == 1 && evaluated_table[0]->view().type().id() == cudf::type_id::BOOL8, "Expression does not evaluate to a boolean mask");
+  std::unique_ptr<ral::frame::BlazingColumn> bool_mask = evaluate_filter_condition(table_view, conditional_expression);
 
-  return applyBooleanFilter(table_view, evaluated_table[0]->view());
+  return applyBooleanFilter(table_view, bool_mask->view());
 }
 
 
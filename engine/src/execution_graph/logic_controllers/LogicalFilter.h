@@ -3,6 +3,7 @@
 #include <blazingdb/manager/Context.h>
 
 #include "LogicPrimitives.h"
+#include "execution_graph/logic_controllers/BlazingColumn.h"
 
 namespace ral{
 
@@ -17,6 +18,13 @@ std::unique_ptr<ral::frame::BlazingTable> applyBooleanFilter(
   const ral::frame::BlazingTableView & table,
   const CudfColumnView & boolValues);
 
+/**
+Evaluates the condition of a filter, i.e. >($0, 5), into a boolean mask
+*/
+std::unique_ptr<ral::frame::BlazingColumn> evaluate_filter_condition(
+  const ral::frame::BlazingTableView & table,
+  const std::string & condition);
+
 std::unique_ptr<ral::frame::BlazingTable> process_filter(
   const ral::frame::BlazingTableView & table,
   const std::string & query_part,
@@ -25,6 +25,7 @@
 #include "utilities/CommonOperations.h"
 #include "utilities/transform.hpp"
 #include "Interpreter/interpreter_cpp.h"
+#include "ExpressionPlanCache.h"
 
 namespace ral {
 namespace processor {
@@ -492,6 +493,7 @@ public:
 
             std::string computed_var_token = "$" + std::to_string(table.num_columns() + computed_columns.size());
             computed_columns.push_back(std::move(computed_col));
+            num_evaluated++;
 
             return new parser::variable_node(computed_var_token);
         }
@@ -509,9 +511,15 @@ public:
 
     std::vector<std::unique_ptr<cudf::column>> release_computed_columns() { return std::move(computed_columns); }
 
+    /**
+     * @return Whether a function was evaluated on the rows of the table, which makes the trees depend on the batch.
+     */
+    bool evaluated_any() const { return num_evaluated > 0; }
+
 private:
     cudf::table_view table;
     std::vector<std::unique_ptr<cudf::column>> computed_columns;
+    size_t num_evaluated = 0;
 };
 
 struct expr_output_type_visitor : public ral::parser::node_visitor
@@ -562,12 +570,99 @@ private:
 	cudf::table_view table_;
 };
 
+namespace {
+
+std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions_in_halves(
+    const cudf::table_view & table,
+    const std::vector<std::string> & expressions) {
+    size_t const half_size = expressions.size() / 2;
+    std::vector<std::string> split_lo(expressions.begin(), expressions.begin() + half_size);
+    std::vector<std::string> split_hi(expressions.begin() + half_size, expressions.end());
+    auto out_cols_lo = evaluate_expressions(table, split_lo);
+    auto out_cols_hi = evaluate_expressions(table, split_hi);
+
+    std::move(out_cols_hi.begin(), out_cols_hi.end(), std::back_inserter(out_cols_lo));
+    return std::move(out_cols_lo);
+}
+
+std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_compiled_plan(
+    const expression_plan & plan,
+    const cudf::table_view & table) {
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> out_columns(plan.output_kinds.size());
+    std::vector<cudf::mutable_column_view> interpreter_out_column_views;
+
+    for(size_t i = 0; i < plan.output_kinds.size(); i++){
+        if (plan.output_kinds[i] == expression_plan::output_kind::LITERAL) {
+            out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(cudf::make_column_from_scalar(*plan.literal_scalars[i], table.num_rows()));
+        } else if (plan.output_kinds[i] == expression_plan::output_kind::INPUT_COLUMN) {
+            out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::make_unique<cudf::column>(table.column(plan.input_column_indices[i])));
+        } else {
+            auto new_column = cudf::make_fixed_width_column(plan.output_types[i], table.num_rows(), cudf::mask_state::UNINITIALIZED);
+            interpreter_out_column_views.push_back(new_column->mutable_view());
+            out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::move(new_column));
+        }
+    }
+
+    if(!interpreter_out_column_views.empty()){
+        cudf::mutable_table_view out_table_view(interpreter_out_column_views);
+
+        interops::perform_interpreter_operation(out_table_view,
+                                                table.select(plan.interpreter_input_columns),
+                                                plan.left_inputs,
+                                                plan.right_inputs,
+                                                plan.outputs,
+                                                plan.final_output_positions,
+                                                plan.operators,
+                                                plan.left_scalars,
+                                                plan.right_scalars,
+                                                table.num_rows(),
+                                                plan.final_output_ops);
+    }
+
+    return std::move(out_columns);
+}
+
+} // namespace
+
 std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
     const cudf::table_view & table,
     const std::vector<std::string> & expressions) {
     using interops::column_index_type;
 
+    std::string plan_key = expression_plan_cache::get_key(expressions, table);
+    std::shared_ptr<const expression_plan> cached_plan = expression_plan_cache::getInstance().get(plan_key);
+    if (cached_plan && cached_plan->compiled) {
+        if (cached_plan->split) {
+            return evaluate_expressions_in_halves(table, expressions);
+        }
+        return evaluate_compiled_plan(*cached_plan, table);
+    }
+
+    // the rewriting and parsing of the expressions is done once, then every batch starts from a clone of the trees
+    std::shared_ptr<expression_plan> new_plan;
+    std::vector<parser::parse_tree> parsed_trees;
+    if (cached_plan) {
+        for (auto & tree : cached_plan->trees) {
+            parsed_trees.push_back(tree.clone());
+        }
+    } else {
+        new_plan = std::make_shared<expression_plan>();
+        for(size_t i = 0; i < expressions.size(); i++){
+            std::string expression = replace_calcite_regex(expressions[i]);
+            expression = expand_if_logical_op(expression);
+            parser::parse_tree tree;
+            tree.build(expression);
+            tree.transform_to_custom_op();
+            new_plan->trees.push_back(tree.clone());
+            parsed_trees.push_back(std::move(tree));
+        }
+    }
+
     std::vector<std::unique_ptr<ral::frame::BlazingColumn>> out_columns(expressions.size());
+    std::vector<expression_plan::output_kind> output_kinds(expressions.size(), expression_plan::output_kind::INTERPRETED);
+    std::vector<std::unique_ptr<cudf::scalar>> literal_scalars(expressions.size());
+    std::vector<cudf::size_type> input_column_indices(expressions.size(), -1);
+    std::vector<cudf::data_type> output_types(expressions.size());
 
     std::vector<bool> column_used(table.num_columns(), false);
     std::vector<std::pair<int, int>> out_idx_computed_idx_pair;
@@ -577,21 +672,21 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
 
     function_evaluator_transformer evaluator{table};
     for(size_t i = 0; i < expressions.size(); i++){
-        std::string expression = replace_calcite_regex(expressions[i]);
-        expression = expand_if_logical_op(expression);
-        parser::parse_tree tree;
-        tree.build(expression);
-        tree.transform_to_custom_op();
+        parser::parse_tree & tree = parsed_trees[i];
         tree.transform(evaluator);
 
         if (tree.root().type == parser::node_type::LITERAL) {
             cudf::data_type literal_type = static_cast<const ral::parser::literal_node&>(tree.root()).type();
             std::unique_ptr<cudf::scalar> literal_scalar = get_scalar_from_string(tree.root().value, literal_type);
             out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(cudf::make_column_from_scalar(*literal_scalar, table.num_rows()));
+            output_kinds[i] = expression_plan::output_kind::LITERAL;
+            literal_scalars[i] = std::move(literal_scalar);
         } else if (tree.root().type == parser::node_type::VARIABLE) {
             cudf::size_type idx = static_cast<const ral::parser::variable_node&>(tree.root()).index();
             if (idx < table.num_columns()) {
                 out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::make_unique<cudf::column>(table.column(idx)));
+                output_kinds[i] = expression_plan::output_kind::INPUT_COLUMN;
+                input_column_indices[i] = idx;
             } else {
                 out_idx_computed_idx_pair.push_back({i, idx - table.num_columns()});
             }
@@ -600,6 +695,7 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
 	        tree.visit(visitor);
 
             cudf::data_type expr_out_type = visitor.get_expr_output_type();
+            output_types[i] = expr_out_type;
 
             auto new_column = cudf::make_fixed_width_column(expr_out_type, table.num_rows(), cudf::mask_state::UNINITIALIZED);
             interpreter_out_column_views.push_back(new_column->mutable_view());
@@ -616,6 +712,9 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
         }
     }
 
+    // without functions evaluated on the rows, everything above only depends on the expressions and the column types
+    bool compile_plan = new_plan && !evaluator.evaluated_any();
+
     auto computed_columns = evaluator.release_computed_columns();
     for (auto &&p : out_idx_computed_idx_pair) {
         out_columns[p.first] = std::make_unique<ral::frame::BlazingColumnOwner>(std::move(computed_columns[p.second]));
@@ -649,43 +748,39 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
     std::vector<column_index_type> right_inputs;
     std::vector<column_index_type> outputs;
     std::vector<column_index_type> final_output_positions;
+    std::vector<column_index_type> final_output_ops;
     std::vector<operator_type> operators;
     std::vector<std::unique_ptr<cudf::scalar>> left_scalars;
     std::vector<std::unique_ptr<cudf::scalar>> right_scalars;
 
-    for (size_t i = 0; i < expr_tree_vector.size(); i++) {
-        final_output_positions.push_back(interops_input_table.num_columns() + i);
-
-        interops::add_expression_to_interpreter_plan(expr_tree_vector[i],
-                                                    col_idx_map,
-                                                    interops_input_table.num_columns() + interpreter_out_column_views.size(),
-                                                    interops_input_table.num_columns() + i,
-                                                    left_inputs,
-                                                    right_inputs,
-                                                    outputs,
-                                                    operators,
-                                                    left_scalars,
-                                                    right_scalars);
-    }
+    interops::add_expressions_to_interpreter_plan(expr_tree_vector,
+                                                col_idx_map,
+                                                interops_input_table.num_columns(),
+                                                left_inputs,
+                                                right_inputs,
+                                                outputs,
+                                                final_output_positions,
+                                                final_output_ops,
+                                                operators,
+                                                left_scalars,
+                                                right_scalars);
 
-    // TODO: Find a proper solution for plan with input or output index greater than 63
+    // The registers are reused once their values are no longer needed, so only plans with more than 64 input columns
+    // or values alive at the same time are left to split
 	auto max_left_it = std::max_element(left_inputs.begin(), left_inputs.end());
 	auto max_right_it = std::max_element(right_inputs.begin(), right_inputs.end());
 	auto max_out_it = std::max_element(outputs.begin(), outputs.end());
-    if (!expr_tree_vector.empty() && std::max(std::max(*max_left_it, *max_right_it), *max_out_it) >= 64) {
+    if (!expr_tree_vector.empty() && (interops_input_table.num_columns() > 64 || std::max(std::max(*max_left_it, *max_right_it), *max_out_it) >= 64)) {
         out_columns.clear();
         computed_columns.clear();
 
-        size_t const half_size = expressions.size() / 2;
-        std::vector<std::string> split_lo(expressions.begin(), expressions.begin() + half_size);
-        std::vector<std::string> split_hi(expressions.begin() + half_size, expressions.end());
-        auto out_cols_lo = evaluate_expressions(table, split_lo);
-        auto out_cols_hi = evaluate_expressions(table, split_hi);
-
-        std::move(out_cols_hi.begin(), out_cols_hi.end(), std::back_inserter(out_cols_lo));
-        return std::move(out_cols_lo);
+        if (new_plan) {
+            new_plan->compiled = compile_plan;
+            new_plan->split = true;
+            expression_plan_cache::getInstance().put(plan_key, new_plan);
+        }
+        return evaluate_expressions_in_halves(table, expressions);
     }
-    // END
 
     if(!expr_tree_vector.empty()){
         cudf::mutable_table_view out_table_view(interpreter_out_column_views);
@@ -699,7 +794,28 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
                                                 operators,
                                                 left_scalars,
                                                 right_scalars,
-                                                table.num_rows());
+                                                table.num_rows(),
+                                                final_output_ops);
+    }
+
+    if (new_plan) {
+        if (compile_plan) {
+            new_plan->compiled = true;
+            new_plan->output_kinds = std::move(output_kinds);
+            new_plan->literal_scalars = std::move(literal_scalars);
+            new_plan->input_column_indices = std::move(input_column_indices);
+            new_plan->output_types = std::move(output_types);
+            new_plan->interpreter_input_columns = std::move(input_col_indices);
+            new_plan->left_inputs = std::move(left_inputs);
+            new_plan->right_inputs = std::move(right_inputs);
+            new_plan->outputs = std::move(outputs);
+            new_plan->final_output_positions = std::move(final_output_positions);
+            new_plan->final_output_ops = std::move(final_output_ops);
+            new_plan->operators = std::move(operators);
+            new_plan->left_scalars = std::move(left_scalars);
+            new_plan->right_scalars = std::move(right_scalars);
+        }
+        expression_plan_cache::getInstance().put(plan_key, new_plan);
     }
 
     return std::move(out_columns);
@@ -282,11 +282,29 @@ struct tree_processor {
 			if (it != config_options.end()){
 				flow_control_bytes_threshold = std::stoull(config_options["FLOW_CONTROL_BYTES_THRESHOLD"]);
 			}
-			cache_settings default_throttled_cache_machine_config = cache_settings{.type = CacheType::SIMPLE, .num_partitions = 1, .context = context->clone(),
-						.flow_control_bytes_threshold = flow_control_bytes_threshold};
-
 			auto child_kernel_type = child->kernel_unit->get_type_id();
 			auto parent_kernel_type = parent->kernel_unit->get_type_id();
+
+			bool adaptive_flow_control = false;
+			it = config_options.find("FLOW_CONTROL_ADAPTIVE");
+			if (it != config_options.end()){
+				adaptive_flow_control = it->second == "1" || it->second == "True" || it->second == "true";
+			}
+			// a kernel with several inputs can wait on one of them while the others fill up, so the rate at which it pulls
+			// an input drops to nothing and an adaptive budget would hold back the producer of that input
+			bool parent_has_several_inputs = children.size() > 1 || parent_kernel_type == kernel_type::PartwiseJoinKernel
+				|| parent_kernel_type == kernel_type::PartitionKernel || parent_kernel_type == kernel_type::PartitionSingleNodeKernel;
+			if (parent_has_several_inputs) {
+				adaptive_flow_control = false;
+			}
+			int64_t flow_control_target_latency_ms = 1000;
+			it = config_options.find("FLOW_CONTROL_TARGET_LATENCY_MS");
+			if (it != config_options.end()){
+				flow_control_target_latency_ms = std::stoll(config_options["FLOW_CONTROL_TARGET_LATENCY_MS"]);
+			}
+			cache_settings default_throttled_cache_machine_config = cache_settings{.type = CacheType::SIMPLE, .num_partitions = 1, .context = context->clone(),
+						.flow_control_bytes_threshold = flow_control_bytes_threshold, .adaptive_flow_control = adaptive_flow_control, .flow_control_target_latency_ms = flow_control_target_latency_ms};
+
 			if (children.size() > 1) {
 				char index_char = 'a' + index;
 				port_name = std::string("input_");
@@ -306,7 +324,7 @@ struct tree_processor {
 					bool right_concat_all = join_type == ral::batch::LEFT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
 					bool concat_all = index == 0 ? left_concat_all : right_concat_all;
 					cache_settings join_cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
-						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = join_partition_size_thresh, .concat_all = concat_all};
+						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = join_partition_size_thresh, .concat_all = concat_all, .adaptive_flow_control = adaptive_flow_control, .flow_control_target_latency_ms = flow_control_target_latency_ms};
 						
 					query_graph += link(*child->kernel_unit, (*parent->kernel_unit)[port_name], join_cache_machine_config);
 
@@ -333,9 +351,9 @@ struct tree_processor {
 					bool left_concat_all = join_type == ral::batch::RIGHT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
 					bool right_concat_all = join_type == ral::batch::LEFT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
 					cache_settings left_cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
-						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = join_partition_size_thresh, .concat_all = left_concat_all};
+						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = join_partition_size_thresh, .concat_all = left_concat_all, .adaptive_flow_control = adaptive_flow_control, .flow_control_target_latency_ms = flow_control_target_latency_ms};
 					cache_settings right_cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
-						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = join_partition_size_thresh, .concat_all = right_concat_all};
+						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = join_partition_size_thresh, .concat_all = right_concat_all, .adaptive_flow_control = adaptive_flow_control, .flow_control_target_latency_ms = flow_control_target_latency_ms};
 					
 					query_graph += link((*(child->kernel_unit))["output_a"], (*(parent->kernel_unit))["input_a"], left_cache_machine_config);
 					query_graph += link((*(child->kernel_unit))["output_b"], (*(parent->kernel_unit))["input_b"], right_cache_machine_config);
@@ -365,7 +383,7 @@ struct tree_processor {
 					}
 					if (parent->kernel_unit->can_you_throttle_my_input()){
 						cache_settings cache_machine_config = cache_settings{.type = CacheType::FOR_EACH, .num_partitions = max_num_order_by_partitions_per_node,
-								.context = context->clone(), .flow_control_bytes_threshold = flow_control_bytes_threshold};
+								.context = context->clone(), .flow_control_bytes_threshold = flow_control_bytes_threshold, .adaptive_flow_control = adaptive_flow_control, .flow_control_target_latency_ms = flow_control_target_latency_ms};
 						query_graph += link(*child->kernel_unit, *parent->kernel_unit, cache_machine_config);
 					} else {
 						ral::cache::cache_settings cache_machine_config;
@@ -383,7 +401,7 @@ struct tree_processor {
 					}
 					
 					cache_settings cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
-						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = concat_cache_num_bytes, .concat_all = false};
+						.flow_control_bytes_threshold = flow_control_bytes_threshold, .concat_cache_num_bytes = concat_cache_num_bytes, .concat_all = false, .adaptive_flow_control = adaptive_flow_control, .flow_control_target_latency_ms = flow_control_target_latency_ms};
 					query_graph += link(*child->kernel_unit, *parent->kernel_unit, cache_machine_config);
 
 				} else {
@@ -0,0 +1,128 @@
+#include "executor.h"
+
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+namespace ral {
+namespace execution {
+
+namespace {
+thread_local executor * current_executor = nullptr;
+thread_local std::size_t current_worker_index = 0;
+
+void log_task_error(std::exception_ptr error) {
+	std::string what = "unknown error";
+	try {
+		std::rethrow_exception(error);
+	} catch(const std::exception & e) {
+		what = e.what();
+	} catch(...) {
+	}
+	auto logger = spdlog::get("batch_logger");
+	if(logger != nullptr) {
+		logger->error("|||{}|||||", "A task of the executor failed. What: " + what);
+	}
+}
+}  // namespace
+
+executor::executor(std::size_t num_threads) : next_queue{0}, pending_tasks{0}, stopping{false} {
+	num_threads = num_threads == 0 ? 1 : num_threads;
+	for(std::size_t i = 0; i < num_threads; i++) {
+		queues.push_back(std::make_unique<worker_queue>());
+	}
+	for(std::size_t i = 0; i < num_threads; i++) {
+		workers.emplace_back([this, i]() { this->worker_loop(i); });
+	}
+}
+
+executor::~executor() {
+	{
+		std::unique_lock<std::mutex> lock(idle_mutex);
+		stopping = true;
+	}
+	idle_condition_variable.notify_all();
+	for(auto & worker : workers) {
+		worker.join();
+	}
+}
+
+void executor::add_task(task new_task, error_handler on_error) {
+	std::size_t queue_index = current_executor == this ? current_worker_index : next_queue++ % queues.size();
+	{
+		// taking the lock makes sure a worker that just found no work is already waiting when we notify
+		std::unique_lock<std::mutex> lock(idle_mutex);
+		pending_tasks++;
+	}
+	{
+		std::unique_lock<std::mutex> lock(queues[queue_index]->mutex);
+		queues[queue_index]->tasks.push_back({std::move(new_task), std::move(on_error)});
+	}
+	idle_condition_variable.notify_one();
+}
+
+bool executor::take_task(std::size_t worker_index, queued_task & next_task) {
+	{
+		worker_queue & own = *queues[worker_index];
+		std::unique_lock<std::mutex> lock(own.mutex);
+		if(!own.tasks.empty()) {
+			next_task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+	for(std::size_t offset = 1; offset < queues.size(); offset++) {
+		worker_queue & victim = *queues[(worker_index + offset) % queues.size()];
+		std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+		if(lock.owns_lock() && !victim.tasks.empty()) {
+			next_task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void executor::run_task(queued_task & next_task) {
+	try {
+		next_task.run();
+	} catch(...) {
+		// letting it leave the worker would terminate the process
+		std::exception_ptr error = std::current_exception();
+		if(!next_task.on_error) {
+			log_task_error(error);
+			return;
+		}
+		try {
+			next_task.on_error(error);
+		} catch(...) {
+			log_task_error(std::current_exception());
+		}
+	}
+}
+
+void executor::worker_loop(std::size_t worker_index) {
+	current_executor = this;
+	current_worker_index = worker_index;
+
+	while(true) {
+		queued_task next_task;
+		if(take_task(worker_index, next_task)) {
+			pending_tasks--;
+			run_task(next_task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(idle_mutex);
+		if(stopping && pending_tasks == 0) {
+			break;
+		}
+		// a steal attempt can miss a task when the victim deque is locked, so we only sleep while nothing is pending
+		idle_condition_variable.wait_for(lock, std::chrono::milliseconds(10), [this] { return stopping || pending_tasks > 0; });
+	}
+
+	current_executor = nullptr;
+}
+
+}  // namespace execution
+}  // namespace ral
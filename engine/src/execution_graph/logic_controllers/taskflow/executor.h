@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ral {
+namespace execution {
+
+/**
+	@brief A fixed size pool of workers that run short lived tasks.
+	Every worker owns a deque of tasks. Tasks added from a worker go to the back of its own deque
+	and are taken LIFO to keep the data hot, while idle workers steal from the front of the other deques.
+	The number of workers is independent of how many tasks (or kernels) are waiting to run.
+*/
+class executor {
+public:
+	using task = std::function<void()>;
+	using error_handler = std::function<void(std::exception_ptr)>;
+
+	/**
+	 * Constructor for the executor
+	 * @param num_threads Number of workers. At least one worker is always created.
+	 */
+	executor(std::size_t num_threads);
+
+	/**
+	 * Destructor. Waits for the workers to run all the tasks that were already added.
+	 */
+	~executor();
+
+	executor(const executor &) = delete;
+	executor & operator=(const executor &) = delete;
+
+	/**
+	 * Adds a task to the executor.
+	 * If called from one of the workers the task goes to that worker's own deque, otherwise the deques are used round robin.
+	 * An exception thrown by the task never leaves the worker, the worker keeps running the next tasks.
+	 * @param new_task The task to run.
+	 * @param on_error Gets the exception thrown by the task. If there is none the exception is logged.
+	 */
+	void add_task(task new_task, error_handler on_error = nullptr);
+
+	/**
+	 * @return The number of workers of the executor.
+	 */
+	std::size_t num_threads() const { return workers.size(); }
+
+private:
+	/**
+	 * @brief A task and what to do when it throws.
+	 */
+	struct queued_task {
+		task run;
+		error_handler on_error;
+	};
+
+	/**
+	 * @brief The deque of tasks owned by one worker.
+	 */
+	struct worker_queue {
+		std::mutex mutex;
+		std::deque<queued_task> tasks;
+	};
+
+	/**
+	 * Takes a task from the worker's own deque, or steals one from another worker.
+	 * @param worker_index The index of the worker looking for work.
+	 * @param next_task Where the task is returned.
+	 * @return true if a task was found.
+	 */
+	bool take_task(std::size_t worker_index, queued_task & next_task);
+
+	/**
+	 * Runs a task, handing what it throws to its error handler.
+	 * @param next_task The task to run.
+	 */
+	void run_task(queued_task & next_task);
+
+	/**
+	 * The loop every worker runs until the executor is destroyed.
+	 * @param worker_index The index of the worker.
+	 */
+	void worker_loop(std::size_t worker_index);
+
+	std::vector<std::unique_ptr<worker_queue>> queues; /**< One deque per worker. */
+	std::vector<std::thread> workers; /**< The worker threads. */
+	std::atomic<std::size_t> next_queue; /**< Round robin counter for tasks added from outside the workers. */
+	std::atomic<std::size_t> pending_tasks; /**< Number of tasks added but not yet taken by a worker. */
+	std::atomic<bool> stopping; /**< Set when the executor is being destroyed. */
+	std::mutex idle_mutex; /**< Protects sleeping workers from missing a wake up. */
+	std::condition_variable idle_condition_variable; /**< Wakes up idle workers when tasks are added. */
+};
+
+}  // namespace execution
+}  // namespace ral
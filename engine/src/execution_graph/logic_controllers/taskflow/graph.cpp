@@ -1,9 +1,115 @@
 #include "graph.h"
+#include "executor.h"
 #include "operators/OrderBy.h"
 
 namespace ral {
 namespace cache {
 
+namespace {
+
+/**
+ * @brief Keeps track of the task based kernels of one execution of the graph.
+ */
+struct kernel_task_state {
+	std::mutex mutex;
+	std::condition_variable condition_variable;
+	std::size_t running_kernels = 0; /**< Task based kernels that have not finished their output yet. */
+	std::exception_ptr exception; /**< First exception thrown by a task, rethrown by graph::execute. */
+};
+
+void schedule_kernel_task(kernel * source, ral::execution::executor * task_executor, std::shared_ptr<kernel_task_state> state);
+
+void finish_kernel_task(kernel * source, std::shared_ptr<kernel_task_state> state) {
+	if (source->task_finished.exchange(true)) {
+		return;
+	}
+	source->output_.finish();
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->running_kernels--;
+	state->condition_variable.notify_all();
+}
+
+/**
+ * Whether the kernel has a batch to process and room in its output for the result. A kernel with a saturated output
+ * is scheduled again when its output is pulled, the same way the kernels with a thread wait_if_cache_is_saturated.
+ */
+bool kernel_task_can_run(kernel * source) {
+	return source->input_cache()->ready_to_pull() && !source->output_cache()->is_saturated();
+}
+
+// the first error of the kernels is rethrown by execute. Finishing the output lets the rest of the graph drain instead
+// of waiting forever
+void fail_kernel_task(kernel * source, std::shared_ptr<kernel_task_state> state, std::exception_ptr error) {
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		if (!state->exception) {
+			state->exception = error;
+		}
+	}
+	finish_kernel_task(source, state);
+}
+
+// pulls and processes a single batch, so that the workers go round all the kernels that have data ready
+void run_kernel_task(kernel * source, ral::execution::executor * task_executor, std::shared_ptr<kernel_task_state> state) {
+	auto input_cache = source->input_cache();
+	try {
+		if (!source->task_finished && kernel_task_can_run(source)) {
+			CodeTimer cacheEventTimer(false);
+			cacheEventTimer.start();
+			auto batch = input_cache->pullFromCache();
+			cacheEventTimer.stop();
+
+			if (batch) {
+				source->record_input_metrics(batch->num_rows(), batch->sizeInBytes(), cacheEventTimer);
+
+				if(source->cache_events_logger != nullptr) {
+					source->cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
+								"ral_id"_a=source->context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
+								"query_id"_a=source->context->getContextToken(),
+								"source"_a=input_cache->get_id(),
+								"sink"_a=source->get_id(),
+								"num_rows"_a=batch->num_rows(),
+								"num_bytes"_a=batch->sizeInBytes(),
+								"event_type"_a="removeCache",
+								"timestamp_begin"_a=cacheEventTimer.start_time(),
+								"timestamp_end"_a=cacheEventTimer.end_time());
+				}
+				CodeTimer process_timer;
+				ral::utilities::TraceSpan compute_span(source->context->getContextToken(), "kernel",
+					"compute " + get_kernel_type_name(source->get_type_id()) + " " + std::to_string(source->get_id()));
+				compute_span.set_arg("rows", batch->num_rows());
+				source->process_batch(std::move(batch));
+				source->metrics->compute_time_us.add(process_timer.elapsed_time<std::chrono::microseconds>());
+			}
+		}
+	} catch (...) {
+		fail_kernel_task(source, state, std::current_exception());
+		return;
+	}
+
+	// clear the flag before checking for more work, so an event arriving in between is never lost
+	source->task_scheduled = false;
+	if (input_cache->is_finished() && !input_cache->has_next_now()) {
+		finish_kernel_task(source, state);
+	} else if (kernel_task_can_run(source)) {
+		schedule_kernel_task(source, task_executor, state);
+	}
+}
+
+void schedule_kernel_task(kernel * source, ral::execution::executor * task_executor, std::shared_ptr<kernel_task_state> state) {
+	if (source->task_finished || source->task_scheduled.exchange(true)) {
+		return;
+	}
+	task_executor->add_task([source, task_executor, state]() {
+		run_kernel_task(source, task_executor, state);
+	}, [source, state](std::exception_ptr error) {
+		// what run_kernel_task throws after processing the batch, i.e. while rescheduling
+		fail_kernel_task(source, state, error);
+	});
+}
+
+}  // namespace
+
 	kpair graph::operator+=(kpair p) {
 		std::string source_port_name = std::to_string(p.src->get_id());
 		std::string target_port_name = std::to_string(p.dst->get_id());
@@ -34,9 +140,18 @@ namespace cache {
 		}
 	}
 
-	void graph::execute(const std::size_t max_kernel_run_threads) {
+	void graph::execute(const std::size_t max_kernel_run_threads, const std::size_t executor_num_threads) {
 		check_and_complete_work_flow();
 
+		// kernels that can run batch by batch are scheduled on the executor only when their input has data,
+		// so they don't hold a thread of the pool for the whole query. The rest still get a thread each.
+		std::unique_ptr<ral::execution::executor> task_executor;
+		if (executor_num_threads > 0) {
+			task_executor = std::make_unique<ral::execution::executor>(executor_num_threads);
+		}
+		auto task_state = std::make_shared<kernel_task_state>();
+		std::vector<kernel *> task_kernels;
+
 		ctpl::thread_pool<BlazingThread> pool(max_kernel_run_threads);
 		std::vector<std::future<void>> futures;
 		std::set<std::pair<size_t, size_t>> visited;
@@ -62,8 +177,33 @@ namespace cache {
 						if(visited.find(edge_id) == visited.end()) {
 							visited.insert(edge_id);
 							Q.push_back(target_id);
+							if (task_executor && source->is_task_based() && source->input_.count() == 1) {
+								if (std::find(task_kernels.begin(), task_kernels.end(), source) == task_kernels.end()) {
+									task_kernels.push_back(source);
+									{
+										std::unique_lock<std::mutex> lock(task_state->mutex);
+										task_state->running_kernels++;
+									}
+									ral::execution::executor * executor_ptr = task_executor.get();
+									source->input_cache()->set_event_listener([source, executor_ptr, task_state]() {
+										schedule_kernel_task(source, executor_ptr, task_state);
+									});
+									source->output_cache()->set_pull_listener([source, executor_ptr, task_state]() {
+										schedule_kernel_task(source, executor_ptr, task_state);
+									});
+									schedule_kernel_task(source, executor_ptr, task_state);
+								}
+								continue;
+							}
 							futures.push_back(pool.push([this, source, source_id, edge] (int thread_id) {
-								auto state = source->run();
+								CodeTimer run_timer;
+								kstatus state;
+								{
+									ral::utilities::TraceSpan run_span(source->context->getContextToken(), "kernel",
+										"run " + get_kernel_type_name(source->get_type_id()) + " " + std::to_string(source->get_id()));
+									state = source->run();
+								}
+								source->metrics->compute_time_us.add(run_timer.elapsed_time<std::chrono::microseconds>());
 								if(state == kstatus::proceed) {
 									source->output_.finish();
 								} else if (edge.target != -1) { // not a dummy node
@@ -80,16 +220,32 @@ namespace cache {
 				Q.push_back(source_id);
 			}
 		}
+		auto remove_listeners = [&task_kernels]() {
+			for (kernel * task_kernel : task_kernels) {
+				task_kernel->input_cache()->set_event_listener(nullptr);
+				task_kernel->output_cache()->set_pull_listener(nullptr);
+			}
+		};
+
 		// Lets iterate through the futures to check for exceptions
 		for(int i = 0; i < futures.size(); i++){
 			try {
 				futures[i].get();
 			} catch (const std::exception& e) {
+				remove_listeners();
 				throw;		
 			}
 		}
 		// lets wait untill all tasks are done
 		pool.stop(true);
+
+		std::unique_lock<std::mutex> lock(task_state->mutex);
+		task_state->condition_variable.wait(lock, [&task_state] { return task_state->running_kernels == 0; });
+		lock.unlock();
+		remove_listeners();
+		if (task_state->exception) {
+			std::rethrow_exception(task_state->exception);
+		}
 	}
 
 	void graph::show() {
@@ -17,6 +17,11 @@ static std::shared_ptr<ral::cache::CacheMachine> create_cache_machine( const cac
 		machine =  std::make_shared<ral::cache::ConcatenatingCacheMachine>(config.context, config.flow_control_bytes_threshold, 
 			config.concat_cache_num_bytes, config.concat_all);
 	}
+	// a cache that concatenates all its data is only pulled once it is finished, so it can not hold back its producer
+	if (config.adaptive_flow_control && !(config.type == CacheType::CONCATENATING && config.concat_all)) {
+		std::size_t min_bytes = config.type == CacheType::CONCATENATING ? config.concat_cache_num_bytes : 0;
+		machine->enable_adaptive_flow_control(config.flow_control_target_latency_ms, min_bytes);
+	}
 	return machine;
 }
 
@@ -60,7 +65,7 @@ public:
 
 	void check_and_complete_work_flow();
 
-	void execute(const std::size_t max_kernel_run_threads);
+	void execute(const std::size_t max_kernel_run_threads, const std::size_t executor_num_threads = 0);
 
 	void show();
 
@@ -5,6 +5,8 @@
 #include "graph.h"
 #include "communication/CommunicationData.h"
 #include "CodeTimer.h"
+#include "utilities/Metrics.h"
+#include "utilities/QueryTracer.h"
 
 namespace ral {
 namespace cache {
@@ -47,6 +49,9 @@ public:
 								"is_kernel"_a=1, //true
 								"kernel_type"_a=get_kernel_type_name(this->get_type_id()));
 		}
+
+		metrics = ral::utilities::MetricsRegistry::getInstance().registerKernel(
+			this->context ? this->context->getContextToken() : -1, this->get_id(), get_kernel_type_name(this->get_type_id()));
 	}
 
 	/**
@@ -76,6 +81,24 @@ public:
 	 */
 	virtual kstatus run() = 0;
 
+	/**
+	 * @brief Indicates whether the kernel can be executed as a sequence of per batch tasks
+	 * instead of one long lived call to run(). Task based kernels must implement process_batch().
+	 *
+	 * @return true If the kernel can be scheduled on the task executor.
+	 */
+	virtual bool is_task_based() { return false; }
+
+	/**
+	 * @brief Processes one batch pulled from the input cache and adds the result to the output cache.
+	 * The executor calls it for at most one batch of the kernel at a time, in input order.
+	 *
+	 * @param batch The batch to process.
+	 */
+	virtual void process_batch(std::unique_ptr<ral::frame::BlazingTable> batch) {
+		throw std::runtime_error("process_batch is not implemented for kernel " + get_kernel_type_name(this->get_type_id()));
+	}
+
 	kernel_pair operator[](const std::string & portname) { return std::make_pair(this, portname); }
 
 	/**
@@ -145,6 +168,7 @@ public:
 		this->output_.get_cache(cache_id)->addToCache(std::move(table), message_id);
 
 		cacheEventTimer.stop();
+		record_output_metrics(num_rows, num_bytes, cacheEventTimer);
 
 		if(cache_events_logger != nullptr) {
 			cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
@@ -180,6 +204,7 @@ public:
 		this->output_.get_cache(cache_id)->addCacheData(std::move(cache_data), message_id);
 
 		cacheEventTimer.stop();
+		record_output_metrics(num_rows, num_bytes, cacheEventTimer);
 
 		if(cache_events_logger != nullptr) {
 			cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
@@ -215,6 +240,7 @@ public:
 		this->output_.get_cache(cache_id)->addHostFrameToCache(std::move(host_table), message_id);
 
 		cacheEventTimer.stop();
+		record_output_metrics(num_rows, num_bytes, cacheEventTimer);
 
 		if(cache_events_logger != nullptr) {
 			cache_events_logger->info("{ral_id}|{query_id}|{source}|{sink}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}",
@@ -230,6 +256,27 @@ public:
 		}
 	}
 
+	/**
+	 * @brief Updates the input metrics of the kernel with a batch pulled from an input cache, and traces the pull.
+	 *
+	 * @param num_rows The rows of the batch.
+	 * @param num_bytes The bytes of the batch.
+	 * @param cacheEventTimer The timer around the pull, which is how long the kernel waited for the batch.
+	 */
+	void record_input_metrics(std::size_t num_rows, std::size_t num_bytes, CodeTimer & cacheEventTimer) const {
+		metrics->batches_in.add(1);
+		metrics->rows_in.add(num_rows);
+		metrics->bytes_in.add(num_bytes);
+		metrics->input_wait_time_us.record(cacheEventTimer.elapsed_time<std::chrono::microseconds>());
+
+		auto & tracer = ral::utilities::QueryTracer::getInstance();
+		if(tracer.is_enabled()) {
+			tracer.record(context->getContextToken(), "cache", "pullCache " + std::to_string(kernel_id),
+				cacheEventTimer.start_time<std::chrono::microseconds>(), cacheEventTimer.end_time<std::chrono::microseconds>(),
+				"rows", num_rows);
+		}
+	}
+
 	/**
 	 * @brief Returns the current context.
 	 */
@@ -295,7 +342,22 @@ public:
 	}
 
 protected:
-
+	/**
+	 * @brief Updates the output metrics of the kernel with a batch added to an output cache, and traces the add.
+	 */
+	void record_output_metrics(std::size_t num_rows, std::size_t num_bytes, CodeTimer & cacheEventTimer) {
+		metrics->batches_out.add(1);
+		metrics->rows_out.add(num_rows);
+		metrics->bytes_out.add(num_bytes);
+		metrics->output_time_us.record(cacheEventTimer.elapsed_time<std::chrono::microseconds>());
+
+		auto & tracer = ral::utilities::QueryTracer::getInstance();
+		if(tracer.is_enabled()) {
+			tracer.record(context->getContextToken(), "cache", "addCache " + std::to_string(kernel_id),
+				cacheEventTimer.start_time<std::chrono::microseconds>(), cacheEventTimer.end_time<std::chrono::microseconds>(),
+				"rows", num_rows);
+		}
+	}
 
 public:
 	std::string expression; /**< Stores the logical expression being processed. */
@@ -304,6 +366,8 @@ public:
 	const std::size_t kernel_id; /**< Stores the current kernel identifier. */
 	std::int32_t parent_id_; /**< Stores the parent kernel identifier if any. */
 	bool execution_done = false; /**< Indicates whether the execution is complete. */
+	std::atomic<bool> task_scheduled{false}; /**< Indicates whether a task of this kernel is queued or running in the executor. */
+	std::atomic<bool> task_finished{false}; /**< Indicates whether a task based kernel has already finished its output. */
 	kernel_type kernel_type_id; /**< Stores the id of the kernel type. */
 	std::shared_ptr<graph> query_graph; /**< Stores a pointer to the current execution graph. */
 	std::shared_ptr<Context> context; /**< Shared context of the running query. */
@@ -314,6 +378,7 @@ public:
 	std::shared_ptr<spdlog::logger> logger;
 	std::shared_ptr<spdlog::logger> events_logger;
 	std::shared_ptr<spdlog::logger> cache_events_logger;
+	std::shared_ptr<ral::utilities::KernelMetrics> metrics; /**< Rows, bytes and time going through the kernel. */
 };
 
 
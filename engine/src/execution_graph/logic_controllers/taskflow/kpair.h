@@ -22,6 +22,8 @@ struct cache_settings {
 	std::size_t flow_control_bytes_threshold = std::numeric_limits<std::size_t>::max();
 	std::size_t concat_cache_num_bytes = 400000000;
 	bool concat_all = false; ///< Applicable only for concatenating caches
+	bool adaptive_flow_control = false; ///< See CacheMachine::enable_adaptive_flow_control
+	int64_t flow_control_target_latency_ms = 1000;
 };
 
 using kernel_pair = std::pair<kernel *, std::string>;
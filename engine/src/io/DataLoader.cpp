@@ -1,6 +1,7 @@
 
 #include "DataLoader.h"
 
+#include <map>
 #include <numeric>
 
 #include "utilities/CommonOperations.h"
@@ -10,8 +11,14 @@
 #include "blazingdb/concurrency/BlazingThread.h"
 #include <cudf/filling.hpp>
 #include <cudf/column/column_factories.hpp>
+#include <cudf/concatenate.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/reduction.hpp>
+#include <cudf/scalar/scalar.hpp>
 #include "CalciteExpressionParsing.h"
 #include "execution_graph/logic_controllers/LogicalFilter.h"
+#include "parser/expression_utils.hpp"
+#include "error.hpp"
 
 #include <spdlog/spdlog.h>
 using namespace fmt::literals;
@@ -99,13 +106,147 @@ std::unique_ptr<ral::frame::BlazingTable> data_loader::load_batch(
 	}
 }
 
+namespace {
+
+std::unique_ptr<ral::frame::BlazingTable> apply_condition(std::unique_ptr<ral::frame::BlazingTable> table, const std::string & condition) {
+	if (table->num_rows() == 0) {
+		return table;
+	}
+	std::unique_ptr<ral::frame::BlazingColumn> bool_mask = ral::processor::evaluate_filter_condition(table->toBlazingTableView(), condition);
+	return ral::processor::applyBooleanFilter(table->toBlazingTableView(), bool_mask->view());
+}
+
+}  // namespace
+
+std::unique_ptr<ral::frame::BlazingTable> data_loader::load_filtered_batch(
+	Context * context,
+	const std::vector<int> & column_indices_in,
+	const std::string & condition,
+	const Schema & schema,
+	data_handle file_data_handle,
+	size_t file_index,
+	std::vector<cudf::size_type> row_group_ids,
+	std::vector<cudf::size_type> rowgroup_num_rows) {
+
+	std::vector<int> column_indices = column_indices_in;
+	if (column_indices.size() == 0) {  // including all columns by default
+		column_indices.resize(schema.get_num_columns());
+		std::iota(column_indices.begin(), column_indices.end(), 0);
+	}
+
+	std::vector<int> filter_positions = get_column_references(condition);
+	if (rowgroup_num_rows.empty()) {
+		rowgroup_num_rows = parser->get_rowgroup_num_rows(file_data_handle);
+	}
+	if (filter_positions.empty() || filter_positions.size() == column_indices.size() || rowgroup_num_rows.empty()) {
+		// there are no columns left to read after the filter, or no row groups to skip
+		return apply_condition(load_batch(context, column_indices, schema, file_data_handle, file_index, row_group_ids), condition);
+	}
+
+	// the filter is evaluated over a table with only the columns it reads
+	std::map<int, int> filter_column_positions;
+	std::vector<int> filter_column_indices;
+	std::vector<int> payload_column_indices;
+	std::vector<bool> is_filter_column(column_indices.size(), false);
+	for (int position : filter_positions) {
+		filter_column_positions[position] = filter_column_indices.size();
+		filter_column_indices.push_back(column_indices[position]);
+		is_filter_column[position] = true;
+	}
+	for (size_t position = 0; position < column_indices.size(); position++) {
+		if (!is_filter_column[position]) {
+			payload_column_indices.push_back(column_indices[position]);
+		}
+	}
+
+	if (row_group_ids.empty()) {  // no row groups were pruned, so all of them are going to be read
+		row_group_ids.resize(rowgroup_num_rows.size());
+		std::iota(row_group_ids.begin(), row_group_ids.end(), 0);
+	}
+
+	std::unique_ptr<ral::frame::BlazingTable> filter_table = load_batch(context, filter_column_indices, schema, file_data_handle, file_index, row_group_ids);
+	if (filter_table->num_rows() == 0) {
+		return schema.makeEmptyBlazingTable(column_indices);
+	}
+	std::unique_ptr<ral::frame::BlazingColumn> bool_mask = ral::processor::evaluate_filter_condition(
+		filter_table->toBlazingTableView(), remap_column_references(condition, filter_column_positions));
+
+	cudf::size_type num_rows_in_row_groups = 0;
+	for (cudf::size_type row_group_id : row_group_ids) {
+		num_rows_in_row_groups += static_cast<size_t>(row_group_id) < rowgroup_num_rows.size() ? rowgroup_num_rows[row_group_id] : 0;
+	}
+
+	// the row groups where some row passes the filter, and the ranges of rows they span in the filter table
+	std::vector<cudf::size_type> surviving_row_group_ids;
+	std::vector<cudf::size_type> surviving_row_ranges;
+	if (num_rows_in_row_groups == filter_table->num_rows()) {
+		cudf::size_type row_group_begin = 0;
+		for (cudf::size_type row_group_id : row_group_ids) {
+			cudf::size_type row_group_end = row_group_begin + rowgroup_num_rows[row_group_id];
+			if (row_group_end > row_group_begin) {
+				cudf::column_view row_group_mask = cudf::slice(bool_mask->view(), {row_group_begin, row_group_end})[0];
+				std::unique_ptr<cudf::scalar> any_passed = cudf::reduce(row_group_mask, cudf::make_any_aggregation(), cudf::data_type{cudf::type_id::BOOL8});
+				if (any_passed->is_valid() && static_cast<cudf::scalar_type_t<bool> *>(any_passed.get())->value()) {
+					surviving_row_group_ids.push_back(row_group_id);
+					if (!surviving_row_ranges.empty() && surviving_row_ranges.back() == row_group_begin) {
+						surviving_row_ranges.back() = row_group_end;
+					} else {
+						surviving_row_ranges.push_back(row_group_begin);
+						surviving_row_ranges.push_back(row_group_end);
+					}
+				}
+			}
+			row_group_begin = row_group_end;
+		}
+	} else {
+		// the parser did not read the row groups we expected, so the rows can not be matched to them
+		surviving_row_group_ids = row_group_ids;
+		surviving_row_ranges = {0, filter_table->num_rows()};
+	}
+
+	if (surviving_row_group_ids.empty()) {
+		return schema.makeEmptyBlazingTable(column_indices);
+	}
+
+	std::unique_ptr<ral::frame::BlazingTable> payload_table = load_batch(context, payload_column_indices, schema, file_data_handle, file_index, surviving_row_group_ids);
+
+	// the rows of the filter columns and of the mask that belong to the row groups that were read
+	std::vector<cudf::column_view> filter_and_mask_columns(filter_table->view().begin(), filter_table->view().end());
+	filter_and_mask_columns.push_back(bool_mask->view());
+	cudf::table_view filter_and_mask(filter_and_mask_columns);
+	std::unique_ptr<cudf::table> surviving_filter_and_mask;
+	if (surviving_row_ranges.size() > 2 || surviving_row_ranges[1] - surviving_row_ranges[0] < filter_table->num_rows()) {
+		surviving_filter_and_mask = cudf::concatenate(cudf::slice(filter_and_mask, surviving_row_ranges));
+		filter_and_mask = surviving_filter_and_mask->view();
+	}
+	RAL_EXPECTS(filter_and_mask.num_rows() == payload_table->num_rows(), "In load_filtered_batch the columns read after the filter do not match the filter columns");
+
+	std::vector<cudf::column_view> columns;
+	std::vector<std::string> names;
+	size_t filter_column_counter = 0;
+	size_t payload_column_counter = 0;
+	for (size_t position = 0; position < column_indices.size(); position++) {
+		if (is_filter_column[position]) {
+			columns.push_back(filter_and_mask.column(filter_column_counter));
+			names.push_back(filter_table->names()[filter_column_counter]);
+			filter_column_counter++;
+		} else {
+			columns.push_back(payload_table->view().column(payload_column_counter));
+			names.push_back(payload_table->names()[payload_column_counter]);
+			payload_column_counter++;
+		}
+	}
+
+	return ral::processor::applyBooleanFilter(ral::frame::BlazingTableView(cudf::table_view(columns), names),
+		filter_and_mask.column(filter_and_mask.num_columns() - 1));
+}
 
 void data_loader::get_schema(Schema & schema, std::vector<std::pair<std::string, cudf::type_id>> non_file_columns) {
 	bool got_schema = false;
 	while (!got_schema && this->provider->has_next()){
 		data_handle handle = this->provider->get_next();
 		if (handle.fileHandle != nullptr){
-			this->parser->parse_schema(handle.fileHandle, schema);
+			this->parser->parse_schema(handle, schema);
 			if (schema.get_num_columns() > 0){
 				got_schema = true;
 				schema.add_file(handle.uri.toString(true));
@@ -136,14 +277,10 @@ std::unique_ptr<ral::frame::BlazingTable> data_loader::get_metadata(int offset)
 	std::vector<std::unique_ptr<ral::frame::BlazingTable>> metadata_batches;
 	std::vector<ral::frame::BlazingTableView> metadata_batche_views;
 	while(this->provider->has_next()){
-		std::vector<std::shared_ptr<arrow::io::RandomAccessFile>> files;
 		std::vector<data_handle> handles = this->provider->get_some(NUM_FILES_AT_A_TIME);
-		for(auto handle : handles) {
-			files.push_back(handle.fileHandle);
-		}
-		metadata_batches.emplace_back(this->parser->get_metadata(files,  offset));
+		metadata_batches.emplace_back(this->parser->get_metadata(handles,  offset));
 		metadata_batche_views.emplace_back(metadata_batches.back()->toBlazingTableView());
-		offset += files.size();
+		offset += handles.size();
 		this->provider->close_file_handles();
 	}
 	this->provider->reset();
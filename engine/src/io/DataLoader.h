@@ -49,6 +49,24 @@ public:
 		size_t file_index,
 		std::vector<cudf::size_type> row_group_ids);
 
+	/**
+	 * Same as load_batch followed by a filter, but it reads only the columns the filter needs first. The other columns
+	 * are read only for the row groups where some row passes the filter, so a selective filter reads a fraction of the
+	 * file. File types without row groups are read whole and then filtered.
+	 * @param condition The condition of the filter, over the positions of column_indices_in.
+	 * @param rowgroup_num_rows The rows of every row group of the file, as returned by the parser. They are asked to
+	 * the parser when empty.
+	 */
+	std::unique_ptr<ral::frame::BlazingTable> load_filtered_batch(
+		Context * context,
+		const std::vector<int> & column_indices_in,
+		const std::string & condition,
+		const Schema & schema,
+		data_handle file_data_handle,
+		size_t file_index,
+		std::vector<cudf::size_type> row_group_ids,
+		std::vector<cudf::size_type> rowgroup_num_rows = {});
+
 	void get_schema(Schema & schema, std::vector<std::pair<std::string, cudf::type_id>> non_file_columns);
 
 	std::unique_ptr<ral::frame::BlazingTable> get_metadata(int offset);
@@ -9,6 +9,7 @@
 #define DATAPARSER_H_
 
 #include "../Schema.h"
+#include "../data_provider/DataProvider.h"
 #include "execution_graph/logic_controllers/LogicPrimitives.h"
 #include "arrow/io/interfaces.h"
 #include <memory>
@@ -35,9 +36,35 @@ public:
 	virtual void parse_schema(
 		std::shared_ptr<arrow::io::RandomAccessFile> file, ral::io::Schema & schema) = 0;
 
-	virtual std::unique_ptr<ral::frame::BlazingTable> get_metadata(std::vector<std::shared_ptr<arrow::io::RandomAccessFile>> files, int offset) {
+	/**
+	 * Same as parse_schema but it also knows where the file comes from, so the parser can cache what it reads.
+	 */
+	virtual void parse_schema(ral::io::data_handle handle, ral::io::Schema & schema) {
+		parse_schema(handle.fileHandle, schema);
+	}
+
+	virtual std::unique_ptr<ral::frame::BlazingTable> get_metadata(std::vector<ral::io::data_handle> handles, int offset) {
 		return nullptr;
 	}
+
+	/**
+	 * returns the estimated number of bytes that each row group of the file will take once the selected columns are loaded.
+	 * An empty vector means the file type has no row groups and the file can only be loaded as a whole.
+	 */
+	virtual std::vector<size_t> get_rowgroup_sizes_in_bytes(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices) {
+		return {};
+	}
+
+	/**
+	 * returns the number of rows of each row group of the file.
+	 * An empty vector means the file type has no row groups.
+	 */
+	virtual std::vector<cudf::size_type> get_rowgroup_num_rows(ral::io::data_handle handle) {
+		return {};
+	}
 };
 
 } /* namespace io */
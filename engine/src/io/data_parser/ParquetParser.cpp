@@ -4,6 +4,7 @@
 #include "ParquetParser.h"
 #include "utilities/CommonOperations.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include <arrow/io/file.h>
@@ -69,12 +70,14 @@ std::unique_ptr<ral::frame::BlazingTable> parquet_parser::parse_batch(
 	return nullptr;
 }
 
-void parquet_parser::parse_schema(
-	std::shared_ptr<arrow::io::RandomAccessFile> file, ral::io::Schema & schema) {
+namespace {
 
-	auto parquet_reader = parquet::ParquetFileReader::Open(file);
-	if (parquet_reader->metadata()->num_rows() == 0) {
-		parquet_reader->Close();
+/**
+ * Reads the names and types of the columns the way cudf reads them. Files without rows have no columns.
+ */
+void read_cudf_schema(std::shared_ptr<arrow::io::RandomAccessFile> file, int64_t num_rows,
+	std::vector<std::string> & column_names, std::vector<cudf::type_id> & column_types) {
+	if (num_rows == 0) {
 		return; // if the file has no rows, we dont want cudf_io to try to read it
 	}
 
@@ -88,41 +91,169 @@ void parquet_parser::parse_schema(
 	cudf_io::table_with_metadata table_out = cudf_io::read_parquet(pq_args);
 
 	for(size_t i = 0; i < table_out.tbl->num_columns(); i++) {
-		cudf::type_id type = table_out.tbl->get_column(i).type().id();
+		column_types.push_back(table_out.tbl->get_column(i).type().id());
+		column_names.push_back(table_out.metadata.column_names.at(i));
+	}
+}
+
+void add_columns_to_schema(const std::vector<std::string> & column_names,
+	const std::vector<cudf::type_id> & column_types, ral::io::Schema & schema) {
+	for(size_t i = 0; i < column_names.size(); i++) {
 		size_t file_index = i;
 		bool is_in_file = true;
-		std::string name = table_out.metadata.column_names.at(i);
-		schema.add_column(name, type, file_index, is_in_file);
+		schema.add_column(column_names[i], column_types[i], file_index, is_in_file);
+	}
+}
+
+/**
+ * Returns what the footer of a file has from the parquet metadata cache, reading the footer and adding it to the cache
+ * when the file is not there.
+ */
+std::shared_ptr<const parquet_file_metadata> get_file_metadata(const ral::io::data_handle & handle) {
+	auto & metadata_cache = parquet_metadata_cache::getInstance();
+	std::string key = metadata_cache.get_key(handle.uri);
+	std::shared_ptr<const parquet_file_metadata> metadata = key.empty() ? nullptr : metadata_cache.get(key);
+	if (metadata == nullptr) {
+		auto parquet_reader = parquet::ParquetFileReader::Open(handle.fileHandle);
+		std::shared_ptr<parquet_file_metadata> new_metadata = read_parquet_file_metadata(parquet_reader->metadata());
+		if (!key.empty()) {
+			metadata_cache.put(key, new_metadata);
+		}
+		metadata = new_metadata;
+	}
+	return metadata;
+}
+
+} // namespace
+
+void parquet_parser::parse_schema(
+	std::shared_ptr<arrow::io::RandomAccessFile> file, ral::io::Schema & schema) {
+
+	auto parquet_reader = parquet::ParquetFileReader::Open(file);
+	int64_t num_rows = parquet_reader->metadata()->num_rows();
+	if (num_rows == 0) {
+		parquet_reader->Close();
+		return;
+	}
+
+	std::vector<std::string> column_names;
+	std::vector<cudf::type_id> column_types;
+	read_cudf_schema(file, num_rows, column_names, column_types);
+	add_columns_to_schema(column_names, column_types, schema);
+}
+
+void parquet_parser::parse_schema(ral::io::data_handle handle, ral::io::Schema & schema) {
+	auto & metadata_cache = parquet_metadata_cache::getInstance();
+	std::string key = metadata_cache.get_key(handle.uri);
+	std::shared_ptr<const parquet_file_metadata> metadata = key.empty() ? nullptr : metadata_cache.get(key);
+
+	if (metadata == nullptr || !metadata->has_cudf_schema) {
+		std::shared_ptr<parquet_file_metadata> new_metadata;
+		if (metadata == nullptr) {
+			auto parquet_reader = parquet::ParquetFileReader::Open(handle.fileHandle);
+			new_metadata = read_parquet_file_metadata(parquet_reader->metadata());
+			if (new_metadata->num_rows == 0) {
+				parquet_reader->Close();
+			}
+		} else {
+			new_metadata = std::make_shared<parquet_file_metadata>(*metadata);
+		}
+		read_cudf_schema(handle.fileHandle, new_metadata->num_rows, new_metadata->cudf_column_names, new_metadata->cudf_column_types);
+		new_metadata->has_cudf_schema = true;
+		if (!key.empty()) {
+			metadata_cache.put(key, new_metadata);
+		}
+		metadata = new_metadata;
 	}
+
+	add_columns_to_schema(metadata->cudf_column_names, metadata->cudf_column_types, schema);
 }
 
 
-std::unique_ptr<ral::frame::BlazingTable> parquet_parser::get_metadata(std::vector<std::shared_ptr<arrow::io::RandomAccessFile>> files, int offset){
-	std::vector<size_t> num_row_groups(files.size());
-	BlazingThread threads[files.size()];
-	std::vector<std::unique_ptr<parquet::ParquetFileReader>> parquet_readers(files.size());
-	for(int file_index = 0; file_index < files.size(); file_index++) {
+std::unique_ptr<ral::frame::BlazingTable> parquet_parser::get_metadata(std::vector<ral::io::data_handle> handles, int offset){
+	auto & metadata_cache = parquet_metadata_cache::getInstance();
+	std::size_t value_filter_max_bytes = metadata_cache.get_value_filter_max_bytes();
+	std::vector<std::shared_ptr<const parquet_file_metadata>> files_metadata(handles.size());
+	std::vector<BlazingThread> threads(handles.size());
+	for(int file_index = 0; file_index < handles.size(); file_index++) {
 		threads[file_index] = BlazingThread([&, file_index]() {
-		  parquet_readers[file_index] =
-			  std::move(parquet::ParquetFileReader::Open(files[file_index]));
-		  std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_readers[file_index]->metadata();
-		  const parquet::SchemaDescriptor * schema = file_metadata->schema();
-		  num_row_groups[file_index] = file_metadata->num_row_groups();
+		  std::string key = metadata_cache.get_key(handles[file_index].uri);
+		  if (!key.empty()) {
+			  files_metadata[file_index] = metadata_cache.get(key);
+		  }
+		  // the cached entries may come from parse_schema or from another setting, without the value filters we want
+		  if (files_metadata[file_index] == nullptr || files_metadata[file_index]->value_filter_max_bytes != value_filter_max_bytes) {
+			  auto parquet_reader = parquet::ParquetFileReader::Open(handles[file_index].fileHandle);
+			  std::shared_ptr<parquet_file_metadata> metadata = files_metadata[file_index] == nullptr
+				  ? read_parquet_file_metadata(parquet_reader->metadata())
+				  : std::make_shared<parquet_file_metadata>(*files_metadata[file_index]);
+			  read_parquet_value_filters(*parquet_reader, value_filter_max_bytes, *metadata);
+			  parquet_reader->Close();
+			  if (!key.empty()) {
+				  metadata_cache.put(key, metadata);
+			  }
+			  files_metadata[file_index] = metadata;
+		  }
 		});
 	}
 
-	for(int file_index = 0; file_index < files.size(); file_index++) {
+	for(int file_index = 0; file_index < handles.size(); file_index++) {
 		threads[file_index].join();
 	}
 
-	size_t total_num_row_groups =
-		std::accumulate(num_row_groups.begin(), num_row_groups.end(), size_t(0));
+	size_t total_num_row_groups = 0;
+	for (auto & metadata : files_metadata) {
+		total_num_row_groups += metadata->num_row_groups;
+	}
+
+	return get_minmax_metadata(files_metadata, total_num_row_groups, offset);
+}
+
+std::vector<size_t> parquet_parser::get_rowgroup_sizes_in_bytes(
+	ral::io::data_handle handle,
+	const Schema & schema,
+	std::vector<int> column_indices)
+{
+	std::vector<size_t> rowgroup_sizes;
+	if(handle.fileHandle == nullptr) {
+		return rowgroup_sizes;
+	}
+
+	std::shared_ptr<const parquet_file_metadata> metadata = get_file_metadata(handle);
 
-	auto minmax_metadata_table = get_minmax_metadata(parquet_readers, total_num_row_groups, offset);
-	for (auto &reader : parquet_readers) {
-		reader->Close();
+	// only the column chunks of the projected columns are going to be decoded
+	std::vector<int> column_chunk_indices;
+	for(size_t column_i = 0; column_i < column_indices.size(); column_i++) {
+		auto it = std::find(metadata->column_names.begin(), metadata->column_names.end(), schema.get_name(column_indices[column_i]));
+		if(it != metadata->column_names.end()) {
+			column_chunk_indices.push_back(it - metadata->column_names.begin());
+		}
 	}
-	return std::move(minmax_metadata_table);
+
+	rowgroup_sizes.resize(metadata->num_row_groups);
+	for(int row_group_index = 0; row_group_index < metadata->num_row_groups; row_group_index++) {
+		if(column_chunk_indices.empty()) {
+			rowgroup_sizes[row_group_index] = metadata->row_group_byte_sizes[row_group_index];
+		} else {
+			size_t row_group_size = 0;
+			for(int column_chunk_index : column_chunk_indices) {
+				row_group_size += metadata->column_chunk_sizes[column_chunk_index][row_group_index];
+			}
+			rowgroup_sizes[row_group_index] = row_group_size;
+		}
+	}
+	return rowgroup_sizes;
+}
+
+std::vector<cudf::size_type> parquet_parser::get_rowgroup_num_rows(ral::io::data_handle handle) {
+	std::vector<cudf::size_type> rowgroup_num_rows;
+	if(handle.fileHandle == nullptr) {
+		return rowgroup_num_rows;
+	}
+
+	std::shared_ptr<const parquet_file_metadata> metadata = get_file_metadata(handle);
+	rowgroup_num_rows.assign(metadata->row_group_num_rows.begin(), metadata->row_group_num_rows.end());
+	return rowgroup_num_rows;
 }
 
 } /* namespace io */
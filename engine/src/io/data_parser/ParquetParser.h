@@ -31,8 +31,29 @@ public:
 
 	void parse_schema(std::shared_ptr<arrow::io::RandomAccessFile> file, Schema & schema);
 
-	std::unique_ptr<ral::frame::BlazingTable> get_metadata(std::vector<std::shared_ptr<arrow::io::RandomAccessFile>> files, int offset);
+	/**
+	 * Uses the schema in the parquet metadata cache when the file is there, otherwise reads it and adds it to the cache.
+	 */
+	void parse_schema(ral::io::data_handle handle, Schema & schema);
+
+	/**
+	 * Returns the row group statistics of the files. Only the footers of the files missing from the parquet metadata
+	 * cache are read.
+	 */
+	std::unique_ptr<ral::frame::BlazingTable> get_metadata(std::vector<ral::io::data_handle> handles, int offset);
+
+	/**
+	 * Takes the sizes from the parquet metadata cache, so the footer is only read if the file is not there.
+	 */
+	std::vector<size_t> get_rowgroup_sizes_in_bytes(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices);
 
+	/**
+	 * Takes the row counts from the parquet metadata cache, so the footer is only read if the file is not there.
+	 */
+	std::vector<cudf::size_type> get_rowgroup_num_rows(ral::io::data_handle handle);
 };
 
 } /* namespace io */
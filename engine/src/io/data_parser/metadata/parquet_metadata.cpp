@@ -9,6 +9,14 @@
 #include "blazingdb/concurrency/BlazingThread.h"
 #include "utilities/CommonOperations.h"
 #include <cudf/column/column_factories.hpp>
+#include <cudf/null_mask.hpp>
+#include <cudf/utilities/bit.hpp>
+#include <algorithm>
+#include <cstring>
+
+#include <parquet/column_page.h>
+
+#include "skip_data/value_filter.hpp"
 
 std::unique_ptr<ral::frame::BlazingTable> makeMetadataTable(std::vector<std::string> col_names) {
 	const int ncols = col_names.size();
@@ -291,138 +299,405 @@ std::unique_ptr<cudf::column> make_empty_column(cudf::data_type type) {
   return std::make_unique<cudf::column>(type, 0, rmm::device_buffer{});
 }
 
-std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
-	std::vector<std::unique_ptr<parquet::ParquetFileReader>> &parquet_readers,
-	size_t total_num_row_groups, int metadata_offset) {
+// whether a column gets its min and max in min_strings and max_strings
+bool has_string_stats(parquet::Type::type physical, parquet::ConvertedType::type logical) {
+	return physical == parquet::Type::type::BYTE_ARRAY
+		&& (logical == parquet::ConvertedType::type::NONE || logical == parquet::ConvertedType::type::UTF8);
+}
 
-	if (parquet_readers.size() == 0){
-		return nullptr;
-	}
+// A prefix of the min is still a lower bound of the column chunk
+std::string truncate_min_string(const std::string & min) {
+	return min.substr(0, std::min(min.size(), PARQUET_STRING_STATISTICS_MAX_LENGTH));
+}
 
-	std::vector<std::string> metadata_names;
-	std::vector<cudf::data_type> metadata_dtypes;
-	std::vector<size_t> columns_with_metadata;
+// A prefix of the max is an upper bound once its last byte is incremented, dropping the trailing bytes that can not be.
+// Returns false if there is no such bound, i.e. the prefix is all 0xff
+bool truncate_max_string(const std::string & max, std::string & truncated) {
+	if (max.size() <= PARQUET_STRING_STATISTICS_MAX_LENGTH) {
+		truncated = max;
+		return true;
+	}
+	truncated = max.substr(0, PARQUET_STRING_STATISTICS_MAX_LENGTH);
+	while (!truncated.empty() && static_cast<unsigned char>(truncated.back()) == 0xff) {
+		truncated.pop_back();
+	}
+	if (truncated.empty()) {
+		return false;
+	}
+	truncated.back() = static_cast<char>(static_cast<unsigned char>(truncated.back()) + 1);
+	return true;
+}
 
-	// NOTE: we must try to use and load always a parquet reader that row groups > 0
-	int valid_parquet_reader = -1;
+// whether a column gets value filters, see read_parquet_value_filters
+bool has_value_filters(parquet::Type::type physical, parquet::ConvertedType::type logical) {
+	switch (logical) {
+	case parquet::ConvertedType::type::NONE:
+		return physical == parquet::Type::type::BYTE_ARRAY || physical == parquet::Type::type::INT32 || physical == parquet::Type::type::INT64;
+	case parquet::ConvertedType::type::UTF8:
+		return physical == parquet::Type::type::BYTE_ARRAY;
+	case parquet::ConvertedType::type::INT_8:
+	case parquet::ConvertedType::type::INT_16:
+	case parquet::ConvertedType::type::INT_32:
+	case parquet::ConvertedType::type::INT_64:
+		return true;
+	default:
+		return false;
+	}
+}
 
-	for (int i = 0; i < parquet_readers.size(); ++i) {
-		if (parquet_readers[i]->metadata()->num_row_groups() == 0) {
-			continue;
+// Whether all the data pages of a column chunk are dictionary encoded, so its dictionary has all its values. A chunk
+// that fell back to plain pages lists PLAIN (or another value encoding) among its encodings.
+bool is_fully_dictionary_encoded(const parquet::ColumnChunkMetaData & column_chunk) {
+	if (!column_chunk.has_dictionary_page()) {
+		return false;
+	}
+	for (auto encoding : column_chunk.encodings()) {
+		if (encoding != parquet::Encoding::PLAIN_DICTIONARY && encoding != parquet::Encoding::RLE_DICTIONARY
+			&& encoding != parquet::Encoding::RLE && encoding != parquet::Encoding::BIT_PACKED) {
+			return false;
 		}
-
-		valid_parquet_reader = i;
-		break;
 	}
+	return true;
+}
 
-	if (valid_parquet_reader == -1){
-		const int ncols = parquet_readers[0]->metadata()->schema()->num_columns();
-		std::vector<std::string> col_names;
-		col_names.resize(ncols);
-		for (int i =0; i < ncols; ++i) {
-			col_names[i] = parquet_readers[0]->metadata()->schema()->Column(i)->name();
+// The hashes of the values of a plain encoded dictionary page, see hash_value
+std::vector<uint64_t> hash_dictionary_values(const parquet::DictionaryPage & page, parquet::Type::type physical) {
+	std::vector<uint64_t> hashes;
+	hashes.reserve(page.num_values());
+	const uint8_t * data = page.data();
+	const uint8_t * end = data + page.size();
+	for (int32_t i = 0; i < page.num_values(); i++) {
+		if (physical == parquet::Type::type::BYTE_ARRAY) {
+			uint32_t length;
+			if (end - data < 4) {
+				return {};
+			}
+			std::memcpy(&length, data, 4);
+			data += 4;
+			if (static_cast<uint64_t>(end - data) < length) {
+				return {};
+			}
+			hashes.push_back(ral::skip_data::hash_value(std::string(reinterpret_cast<const char *>(data), length)));
+			data += length;
+		} else if (physical == parquet::Type::type::INT32) {
+			int32_t value;
+			if (end - data < 4) {
+				return {};
+			}
+			std::memcpy(&value, data, 4);
+			data += 4;
+			hashes.push_back(ral::skip_data::hash_value(std::to_string(value)));
+		} else {
+			int64_t value;
+			if (end - data < 8) {
+				return {};
+			}
+			std::memcpy(&value, data, 8);
+			data += 8;
+			hashes.push_back(ral::skip_data::hash_value(std::to_string(value)));
 		}
-		return makeMetadataTable(col_names);
 	}
+	return hashes;
+}
 
-	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_readers[valid_parquet_reader]->metadata();
+std::shared_ptr<ral::io::parquet_file_metadata> read_parquet_file_metadata(
+	std::shared_ptr<parquet::FileMetaData> file_metadata) {
+
+	auto metadata = std::make_shared<ral::io::parquet_file_metadata>();
+	metadata->num_rows = file_metadata->num_rows();
+	metadata->num_row_groups = file_metadata->num_row_groups();
 
-	int num_row_groups = file_metadata->num_row_groups();
 	const parquet::SchemaDescriptor *schema = file_metadata->schema();
+	const int num_columns = schema->num_columns();
+	metadata->column_names.resize(num_columns);
+	metadata->physical_types.resize(num_columns);
+	metadata->converted_types.resize(num_columns);
+	metadata->row_group_byte_sizes.resize(metadata->num_row_groups);
+	metadata->row_group_num_rows.resize(metadata->num_row_groups);
+	metadata->column_chunk_sizes.resize(num_columns);
+	metadata->stats_set.resize(num_columns);
+	metadata->min_values.resize(num_columns);
+	metadata->max_values.resize(num_columns);
+	metadata->min_strings.resize(num_columns);
+	metadata->max_strings.resize(num_columns);
+	metadata->value_filters.resize(num_columns);
+
+	std::vector<int> columns_with_stats;
+	std::vector<int> columns_with_string_stats;
+	for (int colIndex = 0; colIndex < num_columns; colIndex++) {
+		const parquet::ColumnDescriptor *column = schema->Column(colIndex);
+		metadata->column_names[colIndex] = column->name();
+		metadata->physical_types[colIndex] = column->physical_type();
+		metadata->converted_types[colIndex] = column->converted_type();
+		if (to_dtype(column->physical_type(), column->converted_type()) != cudf::type_id::STRING) {
+			columns_with_stats.push_back(colIndex);
+		} else if (has_string_stats(column->physical_type(), column->converted_type())) {
+			columns_with_string_stats.push_back(colIndex);
+		}
+	}
 
-	if (num_row_groups > 0) {
-		auto row_group_index = 0;
-		auto groupReader = parquet_readers[valid_parquet_reader]->RowGroup(row_group_index);
-		auto *rowGroupMetadata = groupReader->metadata();
-		for (int colIndex = 0; colIndex < file_metadata->num_columns(); colIndex++) {
+	// the min and max of column i are in 2 * i and 2 * i + 1, as set_min_max expects
+	std::vector<std::vector<int64_t>> minmax_table(2 * num_columns);
+	for (int row_group_index = 0; row_group_index < metadata->num_row_groups; row_group_index++) {
+		auto rowGroupMetadata = file_metadata->RowGroup(row_group_index);
+		metadata->row_group_byte_sizes[row_group_index] = rowGroupMetadata->total_byte_size();
+		metadata->row_group_num_rows[row_group_index] = rowGroupMetadata->num_rows();
+		for (int colIndex = 0; colIndex < num_columns; colIndex++) {
+			metadata->column_chunk_sizes[colIndex].push_back(rowGroupMetadata->ColumnChunk(colIndex)->total_uncompressed_size());
+		}
+		for (int colIndex : columns_with_stats) {
 			const parquet::ColumnDescriptor *column = schema->Column(colIndex);
 			auto columnMetaData = rowGroupMetadata->ColumnChunk(colIndex);
-			auto physical_type = column->physical_type();
-			auto logical_type = column->converted_type();
-			cudf::data_type dtype = cudf::data_type (to_dtype(physical_type, logical_type)) ;
-
-			if (columnMetaData->is_stats_set() && dtype.id() != cudf::type_id::STRING) {
+			if (columnMetaData->is_stats_set()) {
 				auto statistics = columnMetaData->statistics();
-					auto col_name_min = "min_" + std::to_string(colIndex) + "_" + column->name();
-					metadata_dtypes.push_back(dtype);
-					metadata_names.push_back(col_name_min);
-
-					auto col_name_max = "max_" + std::to_string(colIndex)  + "_" + column->name();
-					metadata_dtypes.push_back(dtype);
-					metadata_names.push_back(col_name_max);
-
-					columns_with_metadata.push_back(colIndex);
+				set_min_max(minmax_table, colIndex * 2, column->physical_type(), column->converted_type(), statistics);
+				metadata->stats_set[colIndex].push_back(1);
+			} else {
+				// keeps the values aligned with the row groups
+				minmax_table[colIndex * 2].push_back(0);
+				minmax_table[colIndex * 2 + 1].push_back(0);
+				metadata->stats_set[colIndex].push_back(0);
+			}
+		}
+		for (int colIndex : columns_with_string_stats) {
+			auto columnMetaData = rowGroupMetadata->ColumnChunk(colIndex);
+			std::string min, max;
+			bool stats_set = false;
+			if (columnMetaData->is_stats_set() && columnMetaData->statistics()->HasMinMax()) {
+				auto statistics = std::static_pointer_cast<parquet::ByteArrayStatistics>(columnMetaData->statistics());
+				min = truncate_min_string(std::string(reinterpret_cast<const char *>(statistics->min().ptr), statistics->min().len));
+				stats_set = truncate_max_string(std::string(reinterpret_cast<const char *>(statistics->max().ptr), statistics->max().len), max);
 			}
+			metadata->min_strings[colIndex].push_back(stats_set ? min : "");
+			metadata->max_strings[colIndex].push_back(stats_set ? max : "");
+			metadata->stats_set[colIndex].push_back(stats_set);
 		}
+	}
+	for (int colIndex = 0; colIndex < num_columns; colIndex++) {
+		metadata->min_values[colIndex] = std::move(minmax_table[colIndex * 2]);
+		metadata->max_values[colIndex] = std::move(minmax_table[colIndex * 2 + 1]);
+	}
+	return metadata;
+}
+
+void read_parquet_value_filters(parquet::ParquetFileReader & parquet_reader, std::size_t max_bytes,
+	ral::io::parquet_file_metadata & metadata) {
+
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_reader.metadata();
+	const parquet::SchemaDescriptor *schema = file_metadata->schema();
+	metadata.value_filters.assign(schema->num_columns(), {});
+	metadata.value_filter_max_bytes = max_bytes;
+	if (max_bytes == 0) {
+		return;
+	}
 
-		metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT32});
-		metadata_names.push_back("file_handle_index");
-		metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT32});
-		metadata_names.push_back("row_group_index");
-	}
-
-	size_t num_metadata_cols = metadata_names.size();
-
-	std::vector<std::vector<std::vector<int64_t>>> minmax_metadata_table_per_file(parquet_readers.size());
-
-	size_t file_index = 0;
-	std::vector<BlazingThread> threads(parquet_readers.size());
-	std::mutex guard;
-	for (size_t file_index = 0; file_index < parquet_readers.size(); file_index++){
-		// NOTE: It is really important to mantain the `file_index order` in order to match the same order in HiveMetadata
-		threads[file_index] = BlazingThread([&guard, metadata_offset,  &parquet_readers, file_index,
-									&minmax_metadata_table_per_file, num_metadata_cols, columns_with_metadata](){
-
-		std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_readers[file_index]->metadata();
-
-		if (file_metadata->num_row_groups() > 0){
-			std::vector<std::vector<int64_t>> this_minmax_metadata_table(num_metadata_cols);
-
-			int num_row_groups = file_metadata->num_row_groups();
-			const parquet::SchemaDescriptor *schema = file_metadata->schema();
-
-			for (int row_group_index = 0; row_group_index < num_row_groups; row_group_index++) {
-				auto groupReader = parquet_readers[file_index]->RowGroup(row_group_index);
-				auto *rowGroupMetadata = groupReader->metadata();
-				for (int col_count = 0; col_count < columns_with_metadata.size(); col_count++) {
-					const parquet::ColumnDescriptor *column = schema->Column(columns_with_metadata[col_count]);
-					auto columnMetaData = rowGroupMetadata->ColumnChunk(columns_with_metadata[col_count]);
-					if (columnMetaData->is_stats_set()) {
-						auto statistics = columnMetaData->statistics();
-						set_min_max(this_minmax_metadata_table,
-									col_count * 2,
-									column->physical_type(),
-									column->converted_type(),
-									statistics);
+	for (int colIndex = 0; colIndex < schema->num_columns(); colIndex++) {
+		const parquet::ColumnDescriptor *column = schema->Column(colIndex);
+		if (!has_value_filters(column->physical_type(), column->converted_type())) {
+			continue;
+		}
+		for (int row_group_index = 0; row_group_index < file_metadata->num_row_groups(); row_group_index++) {
+			std::string filter;
+			try {
+				auto columnMetaData = file_metadata->RowGroup(row_group_index)->ColumnChunk(colIndex);
+				if (is_fully_dictionary_encoded(*columnMetaData)) {
+					// the dictionary page is the first page of the chunk
+					std::shared_ptr<parquet::Page> page = parquet_reader.RowGroup(row_group_index)->GetColumnPageReader(colIndex)->NextPage();
+					if (page != nullptr && page->type() == parquet::PageType::DICTIONARY_PAGE) {
+						auto dictionary_page = std::static_pointer_cast<parquet::DictionaryPage>(page);
+						if (dictionary_page->encoding() == parquet::Encoding::PLAIN || dictionary_page->encoding() == parquet::Encoding::PLAIN_DICTIONARY) {
+							filter = ral::skip_data::make_value_filter(hash_dictionary_values(*dictionary_page, column->physical_type()), max_bytes);
+						}
 					}
 				}
-				this_minmax_metadata_table[this_minmax_metadata_table.size() - 2].push_back(metadata_offset + file_index);
-				this_minmax_metadata_table[this_minmax_metadata_table.size() - 1].push_back(row_group_index);
+			} catch (const std::exception &) {
+				// without a filter the row group is never skipped by it
+				filter.clear();
 			}
+			metadata.value_filters[colIndex].push_back(filter);
+		}
+	}
+}
+
+// appends the value of a row group to a metadata column. Floats are packed in the int64 storage, see set_min_max
+void append_minmax_value(std::vector<int64_t> &metadata_column, const std::vector<int64_t> &values,
+	int row_group_index, cudf::type_id dtype) {
+	metadata_column.push_back(0);
+	if (dtype == cudf::type_id::FLOAT32) {
+		reinterpret_cast<float*>(metadata_column.data())[metadata_column.size() - 1] =
+			reinterpret_cast<const float*>(values.data())[row_group_index];
+	} else {
+		metadata_column.back() = values[row_group_index];
+	}
+}
+
+// the min or max of a string column in a row group, false when the row group has none
+bool get_string_stat(const ral::io::parquet_file_metadata &metadata, size_t colIndex, int row_group_index,
+	bool is_min, std::string &value) {
+	if (colIndex >= metadata.stats_set.size() || static_cast<size_t>(row_group_index) >= metadata.stats_set[colIndex].size()
+		|| !metadata.stats_set[colIndex][row_group_index]) {
+		return false;
+	}
+	value = is_min ? metadata.min_strings[colIndex][row_group_index] : metadata.max_strings[colIndex][row_group_index];
+	return true;
+}
+
+// the rows that are not valid are null
+std::unique_ptr<cudf::column> make_strings_column_from(const std::vector<std::string> &strings, const std::vector<bool> &valid = {}) {
+	std::vector<char> chars;
+	std::vector<cudf::size_type> offsets(1, 0);
+	offsets.reserve(strings.size() + 1);
+	for (auto &value : strings) {
+		chars.insert(chars.end(), value.begin(), value.end());
+		offsets.push_back(chars.size());
+	}
+	if (std::find(valid.begin(), valid.end(), false) == valid.end()) {
+		return cudf::make_strings_column(chars, offsets);
+	}
+
+	std::vector<cudf::bitmask_type> null_mask(cudf::num_bitmask_words(valid.size()), 0);
+	cudf::size_type null_count = 0;
+	for (size_t row = 0; row < valid.size(); row++) {
+		if (valid[row]) {
+			cudf::set_bit_unsafe(null_mask.data(), row);
+		} else {
+			null_count++;
+		}
+	}
+	return cudf::make_strings_column(chars, offsets, null_mask, null_count);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
+	const std::vector<std::shared_ptr<const ral::io::parquet_file_metadata>> &files_metadata,
+	size_t total_num_row_groups, int metadata_offset) {
+
+	if (files_metadata.size() == 0){
+		return nullptr;
+	}
+
+	// NOTE: we must try to use and load always a parquet file that row groups > 0
+	int valid_parquet_file = -1;
 
-			guard.lock();
-			minmax_metadata_table_per_file[file_index] = std::move(this_minmax_metadata_table);
-			guard.unlock();
+	for (int i = 0; i < files_metadata.size(); ++i) {
+		if (files_metadata[i]->num_row_groups == 0) {
+			continue;
 		}
-		});
+
+		valid_parquet_file = i;
+		break;
 	}
-	for (size_t file_index = 0; file_index < parquet_readers.size(); file_index++){
-		threads[file_index].join();
+
+	if (valid_parquet_file == -1){
+		return makeMetadataTable(files_metadata[0]->column_names);
 	}
 
-	std::vector<std::vector<int64_t>> minmax_metadata_table = minmax_metadata_table_per_file[valid_parquet_reader];
-	for (size_t i = valid_parquet_reader + 1; i < 	minmax_metadata_table_per_file.size(); i++) {
-		for (size_t j = 0; j < 	minmax_metadata_table_per_file[i].size(); j++) {
-			std::copy(minmax_metadata_table_per_file[i][j].begin(), minmax_metadata_table_per_file[i][j].end(), std::back_inserter(minmax_metadata_table[j]));
+	const ral::io::parquet_file_metadata &file_metadata = *files_metadata[valid_parquet_file];
+
+	// every metadata column is either a fixed width min or max, a string min or max or a value filter
+	enum class metadata_source { MIN, MAX, MIN_STRING, MAX_STRING, VALUE_FILTER };
+	std::vector<std::string> metadata_names;
+	std::vector<cudf::data_type> metadata_dtypes;
+	std::vector<std::pair<metadata_source, size_t>> metadata_sources;
+
+	for (int colIndex = 0; colIndex < file_metadata.column_names.size(); colIndex++) {
+		auto physical_type = static_cast<parquet::Type::type>(file_metadata.physical_types[colIndex]);
+		auto logical_type = static_cast<parquet::ConvertedType::type>(file_metadata.converted_types[colIndex]);
+		cudf::data_type dtype = cudf::data_type (to_dtype(physical_type, logical_type)) ;
+		std::string suffix = std::to_string(colIndex) + "_" + file_metadata.column_names[colIndex];
+
+		if (dtype.id() != cudf::type_id::STRING && file_metadata.stats_set[colIndex][0]) {
+			metadata_dtypes.push_back(dtype);
+			metadata_names.push_back("min_" + suffix);
+			metadata_sources.emplace_back(metadata_source::MIN, colIndex);
+
+			metadata_dtypes.push_back(dtype);
+			metadata_names.push_back("max_" + suffix);
+			metadata_sources.emplace_back(metadata_source::MAX, colIndex);
+		} else if (has_string_stats(physical_type, logical_type)) {
+			// decided by the type alone, so every worker produces the same columns. The row groups without a min and
+			// max get nulls, which skip data never prunes
+			metadata_dtypes.push_back(dtype);
+			metadata_names.push_back("min_" + suffix);
+			metadata_sources.emplace_back(metadata_source::MIN_STRING, colIndex);
+
+			metadata_dtypes.push_back(dtype);
+			metadata_names.push_back("max_" + suffix);
+			metadata_sources.emplace_back(metadata_source::MAX_STRING, colIndex);
+		}
+
+		// decided by the type and the setting alone too. An empty filter means the row group may have any value
+		if (file_metadata.value_filter_max_bytes > 0 && has_value_filters(physical_type, logical_type)) {
+			metadata_dtypes.push_back(cudf::data_type{cudf::type_id::STRING});
+			metadata_names.push_back("filter_" + suffix);
+			metadata_sources.emplace_back(metadata_source::VALUE_FILTER, colIndex);
+		}
+	}
+
+	metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT32});
+	metadata_names.push_back("file_handle_index");
+	metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT32});
+	metadata_names.push_back("row_group_index");
+
+	// NOTE: It is really important to mantain the `file_index order` in order to match the same order in HiveMetadata
+	std::vector<std::vector<int64_t>> minmax_metadata_table(metadata_names.size());
+	std::vector<std::vector<std::string>> string_metadata_table(metadata_names.size());
+	std::vector<std::vector<bool>> string_metadata_valid(metadata_names.size());
+	for (size_t index = 0; index < metadata_names.size(); index++) {
+		if (metadata_dtypes[index].id() == cudf::type_id::STRING) {
+			string_metadata_table[index].reserve(total_num_row_groups);
+			string_metadata_valid[index].reserve(total_num_row_groups);
+		} else {
+			minmax_metadata_table[index].reserve(total_num_row_groups);
+		}
+	}
+	for (size_t file_index = valid_parquet_file; file_index < files_metadata.size(); file_index++) {
+		const ral::io::parquet_file_metadata &this_file_metadata = *files_metadata[file_index];
+
+		for (int row_group_index = 0; row_group_index < this_file_metadata.num_row_groups; row_group_index++) {
+			for (size_t index = 0; index < metadata_sources.size(); index++) {
+				size_t colIndex = metadata_sources[index].second;
+				switch (metadata_sources[index].first) {
+				case metadata_source::MIN:
+				case metadata_source::MAX:
+					if (colIndex < this_file_metadata.stats_set.size() && !this_file_metadata.stats_set[colIndex].empty()
+						&& this_file_metadata.stats_set[colIndex][row_group_index]) {
+						auto &values = metadata_sources[index].first == metadata_source::MIN ? this_file_metadata.min_values[colIndex] : this_file_metadata.max_values[colIndex];
+						append_minmax_value(minmax_metadata_table[index], values, row_group_index, metadata_dtypes[index].id());
+					}
+					break;
+				case metadata_source::MIN_STRING:
+				case metadata_source::MAX_STRING: {
+					std::string value;
+					bool valid = get_string_stat(this_file_metadata, colIndex, row_group_index, metadata_sources[index].first == metadata_source::MIN_STRING, value);
+					string_metadata_table[index].push_back(value);
+					string_metadata_valid[index].push_back(valid);
+					break;
+				}
+				case metadata_source::VALUE_FILTER: {
+					// the row groups without a filter may have any value
+					bool has_filter = colIndex < this_file_metadata.value_filters.size()
+						&& static_cast<size_t>(row_group_index) < this_file_metadata.value_filters[colIndex].size();
+					string_metadata_table[index].push_back(has_filter ? ral::skip_data::to_hex(this_file_metadata.value_filters[colIndex][row_group_index]) : "");
+					string_metadata_valid[index].push_back(true);
+					break;
+				}
+				}
+			}
+			minmax_metadata_table[minmax_metadata_table.size() - 2].push_back(metadata_offset + file_index);
+			minmax_metadata_table[minmax_metadata_table.size() - 1].push_back(row_group_index);
 		}
 	}
 
 	std::vector<std::unique_ptr<cudf::column>> minmax_metadata_gdf_table(minmax_metadata_table.size());
 	for (size_t index = 0; index < 	minmax_metadata_table.size(); index++) {
-		auto vector = minmax_metadata_table[index];
 		auto dtype = metadata_dtypes[index];
-		auto content =  get_typed_vector_content(dtype.id(), vector);
-		minmax_metadata_gdf_table[index] = make_cudf_column_from(dtype, content, total_num_row_groups);
+		if (dtype.id() == cudf::type_id::STRING) {
+			minmax_metadata_gdf_table[index] = make_strings_column_from(string_metadata_table[index], string_metadata_valid[index]);
+		} else {
+			auto &vector = minmax_metadata_table[index];
+			auto content =  get_typed_vector_content(dtype.id(), vector);
+			minmax_metadata_gdf_table[index] = make_cudf_column_from(dtype, content, total_num_row_groups);
+		}
 	}
 
 	auto table = std::make_unique<cudf::table>(std::move(minmax_metadata_gdf_table));
@@ -12,9 +12,35 @@
 #include <parquet/api/reader.h>
 #include <execution_graph/logic_controllers/LogicPrimitives.h>
 
+#include "parquet_metadata_cache.h"
 
+/**
+ * Reads the schema and the row group statistics out of the footer of a parquet file.
+ */
+std::shared_ptr<ral::io::parquet_file_metadata> read_parquet_file_metadata(
+	std::shared_ptr<parquet::FileMetaData> file_metadata);
+
+/**
+ * How many bytes of the min and max of a string column chunk are kept, see parquet_file_metadata.
+ */
+constexpr std::size_t PARQUET_STRING_STATISTICS_MAX_LENGTH = 64;
+
+/**
+ * Builds the value filters of the column chunks of a file that only have dictionary encoded pages, from their
+ * dictionary pages. Each filter has at most max_bytes, and none is built if it is 0.
+ */
+void read_parquet_value_filters(parquet::ParquetFileReader & parquet_reader, std::size_t max_bytes,
+	ral::io::parquet_file_metadata & metadata);
+
+/**
+ * Makes the table skip data runs on: the min and max of every column, including the strings, with one row per row
+ * group. When value filters are enabled, the columns of a type that can have them also get a filter_<index>_<name>
+ * column with the filter of every row group in hex. Which columns there are depends only on the schema and the
+ * settings, never on the statistics of the files, so every worker makes the same ones. A string min or max the row
+ * group does not have is null, and an empty filter may contain any value.
+ */
 std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
-	std::vector<std::unique_ptr<parquet::ParquetFileReader>> &parquet_readers,
+	const std::vector<std::shared_ptr<const ral::io::parquet_file_metadata>> &files_metadata,
 	size_t total_num_row_groups, int metadata_offset);
 
 #endif	// BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_H_
@@ -0,0 +1,335 @@
+#include "parquet_metadata_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "Config/BlazingContext.h"
+
+using namespace fmt::literals;
+
+namespace ral {
+namespace io {
+
+namespace {
+
+const char PERSISTED_ENTRY_MAGIC[] = "BSQLPQM4";
+
+template <typename T>
+void write_value(std::ostream & output, const T & value) {
+	output.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void write_string(std::ostream & output, const std::string & value) {
+	write_value<uint64_t>(output, value.size());
+	output.write(value.data(), value.size());
+}
+
+template <typename T>
+void write_vector(std::ostream & output, const std::vector<T> & values) {
+	write_value<uint64_t>(output, values.size());
+	output.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+void write_strings(std::ostream & output, const std::vector<std::string> & values) {
+	write_value<uint64_t>(output, values.size());
+	for (auto & value : values) {
+		write_string(output, value);
+	}
+}
+
+/**
+ * @return Whether the input still holds num_items of item_size bytes, so a corrupt length is never used to allocate.
+ */
+bool has_remaining(std::istream & input, uint64_t num_items, uint64_t item_size) {
+	std::streampos position = input.tellg();
+	input.seekg(0, std::ios::end);
+	std::streampos end = input.tellg();
+	input.seekg(position);
+	if (position == std::streampos(-1) || end == std::streampos(-1)) {
+		return false;
+	}
+	return num_items <= static_cast<uint64_t>(end - position) / item_size;
+}
+
+template <typename T>
+bool read_value(std::istream & input, T & value) {
+	return (bool)input.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+bool read_string(std::istream & input, std::string & value) {
+	uint64_t size;
+	if (!read_value(input, size) || !has_remaining(input, size, 1)) {
+		return false;
+	}
+	value.resize(size);
+	return (bool)input.read(&value[0], size);
+}
+
+template <typename T>
+bool read_vector(std::istream & input, std::vector<T> & values) {
+	uint64_t size;
+	if (!read_value(input, size) || !has_remaining(input, size, sizeof(T))) {
+		return false;
+	}
+	values.resize(size);
+	return (bool)input.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+}
+
+bool read_strings(std::istream & input, std::vector<std::string> & values) {
+	uint64_t size;
+	// every string takes at least its length field
+	if (!read_value(input, size) || !has_remaining(input, size, sizeof(uint64_t))) {
+		return false;
+	}
+	values.resize(size);
+	for (auto & value : values) {
+		if (!read_string(input, value)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void write_metadata(std::ostream & output, const std::string & key, const parquet_file_metadata & metadata) {
+	output.write(PERSISTED_ENTRY_MAGIC, sizeof(PERSISTED_ENTRY_MAGIC));
+	write_string(output, key);
+	write_value(output, metadata.num_rows);
+	write_value(output, metadata.num_row_groups);
+
+	write_value<uint64_t>(output, metadata.column_names.size());
+	for (auto & name : metadata.column_names) {
+		write_string(output, name);
+	}
+	write_vector(output, metadata.physical_types);
+	write_vector(output, metadata.converted_types);
+	write_vector(output, metadata.row_group_byte_sizes);
+	write_vector(output, metadata.row_group_num_rows);
+	for (size_t column = 0; column < metadata.column_names.size(); column++) {
+		write_vector(output, metadata.column_chunk_sizes[column]);
+		write_vector(output, metadata.stats_set[column]);
+		write_vector(output, metadata.min_values[column]);
+		write_vector(output, metadata.max_values[column]);
+		write_strings(output, metadata.min_strings[column]);
+		write_strings(output, metadata.max_strings[column]);
+		write_strings(output, metadata.value_filters[column]);
+	}
+	write_value<uint64_t>(output, metadata.value_filter_max_bytes);
+
+	write_value(output, metadata.has_cudf_schema);
+	write_value<uint64_t>(output, metadata.cudf_column_names.size());
+	for (auto & name : metadata.cudf_column_names) {
+		write_string(output, name);
+	}
+	write_vector(output, metadata.cudf_column_types);
+}
+
+std::shared_ptr<parquet_file_metadata> read_metadata(std::istream & input, const std::string & key) {
+	char magic[sizeof(PERSISTED_ENTRY_MAGIC)];
+	std::string persisted_key;
+	if (!input.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != std::string(PERSISTED_ENTRY_MAGIC, sizeof(PERSISTED_ENTRY_MAGIC))
+		|| !read_string(input, persisted_key) || persisted_key != key) {
+		// a different format version, or another key with the same hash
+		return nullptr;
+	}
+
+	auto metadata = std::make_shared<parquet_file_metadata>();
+	uint64_t num_columns;
+	if (!read_value(input, metadata->num_rows) || !read_value(input, metadata->num_row_groups) || !read_value(input, num_columns)
+		|| !has_remaining(input, num_columns, sizeof(uint64_t))) {
+		return nullptr;
+	}
+	metadata->column_names.resize(num_columns);
+	for (auto & name : metadata->column_names) {
+		if (!read_string(input, name)) {
+			return nullptr;
+		}
+	}
+	if (!read_vector(input, metadata->physical_types) || !read_vector(input, metadata->converted_types)
+		|| !read_vector(input, metadata->row_group_byte_sizes) || !read_vector(input, metadata->row_group_num_rows)) {
+		return nullptr;
+	}
+	metadata->column_chunk_sizes.resize(num_columns);
+	metadata->stats_set.resize(num_columns);
+	metadata->min_values.resize(num_columns);
+	metadata->max_values.resize(num_columns);
+	metadata->min_strings.resize(num_columns);
+	metadata->max_strings.resize(num_columns);
+	metadata->value_filters.resize(num_columns);
+	for (size_t column = 0; column < num_columns; column++) {
+		if (!read_vector(input, metadata->column_chunk_sizes[column]) || !read_vector(input, metadata->stats_set[column])
+			|| !read_vector(input, metadata->min_values[column])
+			|| !read_vector(input, metadata->max_values[column]) || !read_strings(input, metadata->min_strings[column])
+			|| !read_strings(input, metadata->max_strings[column]) || !read_strings(input, metadata->value_filters[column])) {
+			return nullptr;
+		}
+	}
+	uint64_t value_filter_max_bytes;
+	if (!read_value(input, value_filter_max_bytes)) {
+		return nullptr;
+	}
+	metadata->value_filter_max_bytes = value_filter_max_bytes;
+
+	uint64_t num_cudf_columns;
+	if (!read_value(input, metadata->has_cudf_schema) || !read_value(input, num_cudf_columns)
+		|| !has_remaining(input, num_cudf_columns, sizeof(uint64_t))) {
+		return nullptr;
+	}
+	metadata->cudf_column_names.resize(num_cudf_columns);
+	for (auto & name : metadata->cudf_column_names) {
+		if (!read_string(input, name)) {
+			return nullptr;
+		}
+	}
+	if (!read_vector(input, metadata->cudf_column_types)) {
+		return nullptr;
+	}
+	return metadata;
+}
+
+} // namespace
+
+void parquet_metadata_cache::initialize(std::size_t max_entries, const std::string & directory, std::size_t value_filter_max_bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->max_entries = max_entries;
+	this->directory = directory;
+	this->value_filter_max_bytes = value_filter_max_bytes;
+	while (entries.size() > max_entries) {
+		entries.erase(lru_keys.back());
+		lru_keys.pop_back();
+	}
+}
+
+std::size_t parquet_metadata_cache::get_value_filter_max_bytes() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return value_filter_max_bytes;
+}
+
+std::string parquet_metadata_cache::get_key(const Uri & uri) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (max_entries == 0) {
+			return "";
+		}
+	}
+
+	FileStatus file_status;
+	try {
+		file_status = BlazingContext::getInstance()->getFileSystemManager()->getFileStatus(uri);
+	} catch (const std::exception & e) {
+		return "";
+	}
+	if (!file_status.isFile() || file_status.getModificationTime() == 0) {
+		// without the modification time we can not tell if the file was rewritten
+		return "";
+	}
+	return uri.toString(true) + "|" + std::to_string(file_status.getFileSize()) + "|" + std::to_string(file_status.getModificationTime());
+}
+
+std::shared_ptr<const parquet_file_metadata> parquet_metadata_cache::get(const std::string & key) {
+	std::string file_path;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(key);
+		if (it != entries.end()) {
+			lru_keys.splice(lru_keys.begin(), lru_keys, it->second.second);
+			return it->second.first;
+		}
+		if (directory.empty()) {
+			return nullptr;
+		}
+		file_path = get_file_path(key);
+	}
+
+	// read whole, the entries are small and the length checks of the readers seek to the end many times
+	std::ifstream file(file_path, std::ios::binary);
+	if (!file) {
+		return nullptr;
+	}
+	std::stringstream input;
+	input << file.rdbuf();
+	std::shared_ptr<const parquet_file_metadata> metadata = read_metadata(input, key);
+	if (metadata != nullptr) {
+		std::lock_guard<std::mutex> lock(mutex);
+		insert_unsafe(key, metadata);
+	}
+	return metadata;
+}
+
+void parquet_metadata_cache::put(const std::string & key, std::shared_ptr<const parquet_file_metadata> metadata) {
+	std::string file_path;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (max_entries == 0) {
+			return;
+		}
+		insert_unsafe(key, metadata);
+		if (directory.empty()) {
+			return;
+		}
+		file_path = get_file_path(key);
+	}
+
+	// written under another name first, so a reader never sees a partial entry
+	// the directory may be shared by the processes of several workers
+	std::string temp_file_path = file_path + ".tmp" + std::to_string(getpid()) + "-"
+		+ std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	{
+		std::ofstream output(temp_file_path, std::ios::binary | std::ios::trunc);
+		write_metadata(output, key, *metadata);
+		if (!output) {
+			std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+			if (logger) {
+				logger->warn("|||{info}|||||", "info"_a="Could not persist the parquet metadata of {} to {}"_format(key, file_path));
+			}
+			output.close();
+			std::remove(temp_file_path.c_str());
+			return;
+		}
+	}
+	std::rename(temp_file_path.c_str(), file_path.c_str());
+}
+
+void parquet_metadata_cache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	lru_keys.clear();
+}
+
+std::size_t parquet_metadata_cache::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+void parquet_metadata_cache::insert_unsafe(const std::string & key, std::shared_ptr<const parquet_file_metadata> metadata) {
+	auto it = entries.find(key);
+	if (it != entries.end()) {
+		it->second.first = metadata;
+		lru_keys.splice(lru_keys.begin(), lru_keys, it->second.second);
+		return;
+	}
+	if (max_entries == 0) {
+		return;
+	}
+	while (entries.size() >= max_entries) {
+		entries.erase(lru_keys.back());
+		lru_keys.pop_back();
+	}
+	lru_keys.push_front(key);
+	entries.emplace(key, std::make_pair(metadata, lru_keys.begin()));
+}
+
+std::string parquet_metadata_cache::get_file_path(const std::string & key) {
+	std::ostringstream file_name;
+	file_name << std::hex << std::hash<std::string>{}(key);
+	return directory + "/.blazing-parquet-metadata-" + file_name.str() + ".meta";
+}
+
+} // namespace io
+} // namespace ral
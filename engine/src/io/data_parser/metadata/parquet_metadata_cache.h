@@ -0,0 +1,124 @@
+#ifndef BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_CACHE_H_
+#define BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cudf/types.hpp>
+
+#include <blazingdb/io/FileSystem/Uri.h>
+
+namespace ral {
+namespace io {
+
+/**
+ * What the planner needs from the footer of a parquet file: its schema and the min/max statistics of its row groups.
+ */
+struct parquet_file_metadata {
+	int64_t num_rows = 0;
+	int num_row_groups = 0;
+
+	std::vector<std::string> column_names;  /**< names of the leaf columns of the parquet schema */
+	std::vector<int> physical_types;  /**< parquet::Type::type of each column */
+	std::vector<int> converted_types;  /**< parquet::ConvertedType::type of each column */
+
+	/**
+	 * Indexed by column and then by row group, in the same layout set_min_max produces. They are empty for the columns
+	 * without statistics we can use, and the min and max of the string columns are in min_strings and max_strings.
+	 */
+	std::vector<std::vector<char>> stats_set;
+	std::vector<std::vector<int64_t>> min_values;
+	std::vector<std::vector<int64_t>> max_values;
+	std::vector<std::vector<std::string>> min_strings;
+	std::vector<std::vector<std::string>> max_strings;
+
+	/**
+	 * What DataSourceSequence splits the files into batches with: the total_byte_size and the number of rows of every
+	 * row group, and the uncompressed size of every column chunk, indexed by column and then by row group.
+	 */
+	std::vector<int64_t> row_group_byte_sizes;
+	std::vector<int64_t> row_group_num_rows;
+	std::vector<std::vector<int64_t>> column_chunk_sizes;
+
+	/**
+	 * Indexed by column and then by row group, the value filters (see skip_data/value_filter.hpp) of the column chunks
+	 * that only have dictionary encoded pages. Empty for the other chunks and columns.
+	 */
+	std::vector<std::vector<std::string>> value_filters;
+	std::size_t value_filter_max_bytes = 0;  /**< the setting the value filters were built with, 0 if they were not */
+
+	bool has_cudf_schema = false;  /**< whether the schema as cudf reads it was already added by parse_schema */
+	std::vector<std::string> cudf_column_names;
+	std::vector<cudf::type_id> cudf_column_types;
+};
+
+/**
+ * Keeps what was read from the footers of parquet files, so planning queries over the same files does not fetch and
+ * parse their footers again.
+ *
+ * An entry is keyed by the uri, the size and the modification time of its file, so a file that is rewritten gets a new
+ * entry and files whose modification time is unknown are not cached. Entries are evicted in LRU order. When a
+ * directory is set the entries are also written there, so they survive restarts of the engine.
+ */
+class parquet_metadata_cache {
+public:
+	static parquet_metadata_cache & getInstance() {
+		static parquet_metadata_cache instance;
+		return instance;
+	}
+
+	/**
+	 * @param max_entries How many files are kept in memory. 0 disables the cache.
+	 * @param directory Where the entries are persisted. Empty to keep them only in memory.
+	 * @param value_filter_max_bytes The most bytes of the value filter of a column chunk. 0 does not build them, as it
+	 * reads the dictionary pages of the files and not only their footers.
+	 */
+	void initialize(std::size_t max_entries, const std::string & directory, std::size_t value_filter_max_bytes = 0);
+
+	std::size_t get_value_filter_max_bytes();
+
+	/**
+	 * Returns the key of a file, or an empty string if the file can not be cached.
+	 */
+	std::string get_key(const Uri & uri);
+
+	/**
+	 * Returns the entry of a key from memory or from the cache directory, or nullptr if there is none.
+	 */
+	std::shared_ptr<const parquet_file_metadata> get(const std::string & key);
+
+	void put(const std::string & key, std::shared_ptr<const parquet_file_metadata> metadata);
+
+	void clear();
+
+	std::size_t size();
+
+	parquet_metadata_cache(const parquet_metadata_cache &) = delete;
+	parquet_metadata_cache & operator=(const parquet_metadata_cache &) = delete;
+
+private:
+	parquet_metadata_cache() = default;
+
+	/**
+	 * Adds an entry to memory, evicting the least recently used ones. The lock must be held.
+	 */
+	void insert_unsafe(const std::string & key, std::shared_ptr<const parquet_file_metadata> metadata);
+
+	std::string get_file_path(const std::string & key);
+
+	std::mutex mutex;
+	std::size_t max_entries = 10000;
+	std::string directory;
+	std::size_t value_filter_max_bytes = 0;
+	std::list<std::string> lru_keys;  /**< most recently used first */
+	std::unordered_map<std::string, std::pair<std::shared_ptr<const parquet_file_metadata>, std::list<std::string>::iterator>> entries;
+};
+
+} // namespace io
+} // namespace ral
+
+#endif	// BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_CACHE_H_
@@ -345,6 +345,13 @@ public:
         return *(this->root_);
     }
 
+    parse_tree clone() const {
+        assert(!!this->root_);
+        parse_tree tree;
+        tree.root_.reset(this->root_->clone());
+        return tree;
+    }
+
     bool build(const std::string& expression) {
         detail::expr_parser parser(expression);
         this->root_ = parser.parse();
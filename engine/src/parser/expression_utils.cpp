@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cctype>
 #include <map>
 #include <regex>
 #include <cassert>
@@ -365,6 +367,55 @@ std::vector<std::string> fix_column_aliases(const std::vector<std::string> & col
 	return col_names;
 }
 
+namespace {
+
+/**
+ * Calls fn with the position and length of every column reference of an expression, skipping the string literals.
+ */
+template <typename Fn>
+void for_each_column_reference(const std::string & expression, Fn fn) {
+	for(size_t pos = 0; pos < expression.size(); pos++) {
+		char ch = expression[pos];
+		if(ch == '\'' || ch == '"') {
+			for(pos++; pos < expression.size() && expression[pos] != ch; pos++) {
+				if(expression[pos] == '\\') {
+					pos++;
+				}
+			}
+		} else if(ch == '$' && pos + 1 < expression.size() && std::isdigit(expression[pos + 1])) {
+			size_t length = 1;
+			while(pos + length < expression.size() && std::isdigit(expression[pos + length])) {
+				length++;
+			}
+			fn(pos, length);
+			pos += length - 1;
+		}
+	}
+}
+
+} // namespace
+
+std::vector<int> get_column_references(const std::string & expression) {
+	std::vector<int> indices;
+	for_each_column_reference(expression, [&](size_t pos, size_t length) {
+		indices.push_back(std::stoi(expression.substr(pos + 1, length - 1)));
+	});
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	return indices;
+}
+
+std::string remap_column_references(const std::string & expression, const std::map<int, int> & new_indices) {
+	std::string remapped;
+	size_t copied = 0;
+	for_each_column_reference(expression, [&](size_t pos, size_t length) {
+		int index = std::stoi(expression.substr(pos + 1, length - 1));
+		remapped += expression.substr(copied, pos - copied) + "$" + std::to_string(new_indices.at(index));
+		copied = pos + length;
+	});
+	return remapped + expression.substr(copied);
+}
+
 std::string get_named_expression(const std::string & query_part, const std::string & expression_name) {
 	if(query_part.find(expression_name + "=[") == query_part.npos) {
 		return "";  // expression not found
@@ -158,3 +158,10 @@ std::string replace_calcite_regex(const std::string & expression);
 
 //Returns the column names according to the corresponding algebra expression
 std::vector<std::string> fix_column_aliases(const std::vector<std::string> & column_names, std::string expression);
+
+// Returns the indices of the columns ($n) an expression reads, sorted and without repetitions. The references inside
+// string literals are not columns
+std::vector<int> get_column_references(const std::string & expression);
+
+// Replaces every column reference $n of an expression by $new_indices[n], leaving the string literals as they are
+std::string remap_column_references(const std::string & expression, const std::map<int, int> & new_indices);
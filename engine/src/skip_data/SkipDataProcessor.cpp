@@ -6,11 +6,17 @@
 #include "SkipDataProcessor.h"
 
 #include <cudf/column/column_factories.hpp>
+#include <cudf/replace.hpp>
+#include <cudf/scalar/scalar.hpp>
+#include <cudf/strings/strings_column_view.hpp>
+#include <cudf/utilities/error.hpp>
 #include "CalciteExpressionParsing.h"
 #include "execution_graph/logic_controllers/LogicalFilter.h"
 #include "execution_graph/logic_controllers/LogicalProject.h"
 #include "error.hpp"
+#include "value_filter.hpp"
 
+#include <map>
 #include <numeric>
 
 using namespace fmt::literals;
@@ -45,6 +51,71 @@ private:
     std::string drop_value_;
 };
 
+// The value of a literal as value filters hash it (see hash_value). Returns false for the literals that are not strings
+// or integers
+bool get_value_filter_text(const literal_node & literal, std::string & text) {
+    cudf::type_id type = literal.type().id();
+    if (type == cudf::type_id::STRING && is_string(literal.value)) {
+        text = literal.value.substr(1, literal.value.size() - 2);
+        return true;
+    }
+    if (type == cudf::type_id::INT8 || type == cudf::type_id::INT16 || type == cudf::type_id::INT32 || type == cudf::type_id::INT64) {
+        try {
+            size_t parsed_length;
+            int64_t value = std::stoll(literal.value, &parsed_length);
+            if (parsed_length == literal.value.size()) {
+                text = std::to_string(value);
+                return true;
+            }
+        } catch (const std::exception &) {
+        }
+    }
+    return false;
+}
+
+struct skip_data_value_filter_transformer : public node_transformer {
+public:
+    explicit skip_data_value_filter_transformer(const std::function<int(int, const std::string &)> & get_mask_index)
+        : get_mask_index_{get_mask_index} {}
+
+    node * transform(operad_node& node) override { return &node; }
+
+    node * transform(operator_node& equal_node) override {
+        if (equal_node.value != "=" || equal_node.children.size() != 2) {
+            return &equal_node;
+        }
+
+        const node * variable = equal_node.children[0].get();
+        const node * literal = equal_node.children[1].get();
+        if (variable->type != node_type::VARIABLE) {
+            std::swap(variable, literal);
+        }
+        std::string text;
+        if (variable->type != node_type::VARIABLE || literal->type != node_type::LITERAL
+            || !get_value_filter_text(*static_cast<const literal_node *>(literal), text)) {
+            return &equal_node;
+        }
+
+        int mask_index = get_mask_index_(static_cast<const variable_node *>(variable)->index(), text);
+        if (mask_index < 0) {
+            return &equal_node;
+        }
+
+        // AND(=($n, literal), $mask), so the min and max of $n still apply
+        auto equal = std::unique_ptr<node>(new operator_node(equal_node.value));
+        equal->children = std::move(equal_node.children);
+
+        node * and_node = new operator_node("AND");
+        and_node->children.push_back(std::move(equal));
+        and_node->children.push_back(std::unique_ptr<node>(new variable_node("$" + std::to_string(mask_index))));
+
+        return and_node;
+    }
+
+private:
+    std::function<int(int, const std::string &)> get_mask_index_;
+};
+
 struct skip_data_transformer : public node_transformer {
 public:
     node * transform(operad_node& node) override { return &node; }
@@ -216,6 +287,26 @@ public:
     }
 };
 
+std::vector<std::string> strings_to_host(const cudf::column_view & column) {
+    if (column.size() == 0) {
+        return {};
+    }
+
+    cudf::strings_column_view strings(column);
+    std::vector<int32_t> offsets(column.size() + 1);
+    CUDA_TRY(cudaMemcpy(offsets.data(), strings.offsets().data<int32_t>() + column.offset(), offsets.size() * sizeof(int32_t), cudaMemcpyDeviceToHost));
+    std::vector<char> chars(offsets.back() - offsets.front());
+    if (!chars.empty()) {
+        CUDA_TRY(cudaMemcpy(chars.data(), strings.chars().data<char>() + offsets.front(), chars.size(), cudaMemcpyDeviceToHost));
+    }
+
+    std::vector<std::string> values(column.size());
+    for (cudf::size_type i = 0; i < column.size(); i++) {
+        values[i] = std::string(chars.data() + offsets[i] - offsets.front(), offsets[i + 1] - offsets[i]);
+    }
+    return values;
+}
+
 } // namespace
 
 void drop_value(ral::parser::parse_tree& tree, const std::string & value) {
@@ -223,6 +314,11 @@ void drop_value(ral::parser::parse_tree& tree, const std::string & value) {
     tree.transform(t);
 }
 
+void apply_value_filters(ral::parser::parse_tree& tree, const std::function<int(int, const std::string &)> & get_mask_index) {
+    skip_data_value_filter_transformer t(get_mask_index);
+    tree.transform(t);
+}
+
 bool apply_skip_data_rules(ral::parser::parse_tree& tree) {
     skip_data_reducer r;
     tree.transform(r);
@@ -304,9 +400,43 @@ std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_
         }
     }
 
+    // the value filters of the projected columns, read to host the first time an equality needs them
+    std::map<int, std::vector<std::string>> value_filters;
+    std::vector<std::unique_ptr<cudf::column>> value_filter_masks;
+    auto get_mask_index = [&](int column, const std::string & value) {
+        if (column < 0 || static_cast<size_t>(column) >= column_indeces.size()) {
+            return -1;
+        }
+        int col_index = column_indeces[column];
+        std::string metadata_filter_name = "filter_" + std::to_string(col_index) + '_' + names[col_index];
+        auto it = std::find(metadata_names.begin(), metadata_names.end(), metadata_filter_name);
+        if (it == metadata_names.end()) {
+            return -1;
+        }
+        if (value_filters.find(column) == value_filters.end()) {
+            std::vector<std::string> filters = strings_to_host(metadata_view.view().column(std::distance(metadata_names.begin(), it)));
+            for (auto & filter : filters) {
+                filter = from_hex(filter);
+            }
+            value_filters[column] = std::move(filters);
+        }
+
+        // whether every row group may have the value, so the mask goes after the min and max columns
+        uint64_t hash = hash_value(value);
+        const std::vector<std::string> & filters = value_filters[column];
+        std::vector<int8_t> may_contain(filters.size());
+        for (size_t i = 0; i < filters.size(); i++) {
+            may_contain[i] = value_filter_may_contain(filters[i], hash);
+        }
+        value_filter_masks.push_back(ral::utilities::vector_to_column(may_contain, cudf::data_type{cudf::type_id::BOOL8}));
+        return static_cast<int>(projected_metadata_cols.size() + value_filter_masks.size() - 1);
+    };
+
     // process filter_string to convert to skip data version
     ral::parser::parse_tree tree;
     if (tree.build(filter_string)){
+        apply_value_filters(tree, get_mask_index);
+
         // lets drop all columns that do not have skip data
         for (size_t i = 0; i < valid_metadata_columns.size(); i++){
             if (!valid_metadata_columns[i]) { // if this column has no metadata lets drop it from the expression tree
@@ -329,19 +459,30 @@ std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_
 
     // then we follow a similar pattern to process_filter
     std::vector<cudf::column_view> projected_metadata_col_views;
-    projected_metadata_col_views.reserve(projected_metadata_cols.size());
+    projected_metadata_col_views.reserve(projected_metadata_cols.size() + value_filter_masks.size());
     for (auto &&c : projected_metadata_cols) {
         projected_metadata_col_views.push_back(c->view());
     }
+    for (auto &&mask : value_filter_masks) {
+        projected_metadata_col_views.push_back(mask->view());
+    }
     std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table = ral::processor::evaluate_expressions(cudf::table_view{projected_metadata_col_views}, {filter_string});
 
     RAL_EXPECTS(evaluated_table.size() == 1 && evaluated_table[0]->view().type().id() == cudf::type_id::BOOL8, "Expression in skip_data processing did not evaluate to a boolean mask");
 
+    // a null comes from a row group without a min or max, which may have any value, so it is kept
+    cudf::column_view keep_mask = evaluated_table[0]->view();
+    std::unique_ptr<cudf::column> null_safe_keep_mask;
+    if (keep_mask.has_nulls()) {
+        null_safe_keep_mask = cudf::replace_nulls(keep_mask, cudf::numeric_scalar<bool>(true));
+        keep_mask = null_safe_keep_mask->view();
+    }
+
     CudfTableView metadata_ids = metadata_view.view().select({metadata_view.num_columns()-2,metadata_view.num_columns()-1});
     std::vector<std::string> metadata_id_names{metadata_view.names()[metadata_view.num_columns()-2], metadata_view.names()[metadata_view.num_columns()-1]};
     ral::frame::BlazingTableView metadata_ids_view(metadata_ids, metadata_id_names);
 
-    std::unique_ptr<ral::frame::BlazingTable> filtered_metadata_ids = ral::processor::applyBooleanFilter(metadata_ids_view, evaluated_table[0]->view());
+    std::unique_ptr<ral::frame::BlazingTable> filtered_metadata_ids = ral::processor::applyBooleanFilter(metadata_ids_view, keep_mask);
 
     return std::make_pair(std::move(filtered_metadata_ids), false);
 }
@@ -2,6 +2,7 @@
 #ifndef SKIPDATAPROCESSOR_H_
 #define SKIPDATAPROCESSOR_H_
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include "parser/expression_tree.hpp"
@@ -12,6 +13,9 @@ namespace skip_data {
 
 // For unit testing
 void drop_value(ral::parser::parse_tree& tree, const std::string & value);
+// Turns every =($n, literal) into AND(=($n, literal), $m), with the $m get_mask_index returns for the column n and the
+// literal as value filters hash it, or leaves it as it is if get_mask_index returns -1
+void apply_value_filters(ral::parser::parse_tree& tree, const std::function<int(int, const std::string &)> & get_mask_index);
 bool apply_skip_data_rules(ral::parser::parse_tree& tree);
 
 std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_table(
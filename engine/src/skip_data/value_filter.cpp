@@ -0,0 +1,109 @@
+#include "value_filter.hpp"
+#include <cstring>
+
+namespace ral {
+namespace skip_data {
+
+namespace {
+
+constexpr std::size_t BLOCK_BYTES = 32;
+
+// the salts of the parquet split block bloom filters
+constexpr uint32_t SALTS[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU,
+                               0xa2b7289dU, 0x705495c7U, 0x2df1424bU,
+                               0x9efc4947U, 0x5c6bfb31U};
+
+std::size_t block_offset(const std::string &filter, uint64_t hash) {
+  uint64_t num_blocks = filter.size() / BLOCK_BYTES;
+  return ((hash >> 32) * num_blocks >> 32) * BLOCK_BYTES;
+}
+
+uint32_t word_mask(uint64_t hash, int word) {
+  uint32_t key = static_cast<uint32_t>(hash);
+  return uint32_t{1} << ((key * SALTS[word]) >> 27);
+}
+
+} // namespace
+
+uint64_t hash_value(const std::string &value) {
+  // FNV-1a, with the final mix of MurmurHash3 so all the bits depend on all
+  // the bytes
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : value) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+std::string make_value_filter(const std::vector<uint64_t> &hashes,
+                              std::size_t max_bytes) {
+  if (hashes.empty() || max_bytes * 8 < hashes.size() * 4 ||
+      max_bytes < BLOCK_BYTES) {
+    return "";
+  }
+
+  std::size_t wanted_bytes = (hashes.size() * 10 + 7) / 8;
+  std::size_t num_bytes = BLOCK_BYTES;
+  while (num_bytes < wanted_bytes && num_bytes * 2 <= max_bytes) {
+    num_bytes *= 2;
+  }
+
+  std::string filter(num_bytes, '\0');
+  for (uint64_t hash : hashes) {
+    std::size_t offset = block_offset(filter, hash);
+    for (int word = 0; word < 8; word++) {
+      uint32_t bits;
+      std::memcpy(&bits, &filter[offset + word * 4], 4);
+      bits |= word_mask(hash, word);
+      std::memcpy(&filter[offset + word * 4], &bits, 4);
+    }
+  }
+  return filter;
+}
+
+bool value_filter_may_contain(const std::string &filter, uint64_t hash) {
+  if (filter.size() < BLOCK_BYTES) {
+    return true;
+  }
+
+  std::size_t offset = block_offset(filter, hash);
+  for (int word = 0; word < 8; word++) {
+    uint32_t bits;
+    std::memcpy(&bits, &filter[offset + word * 4], 4);
+    if ((bits & word_mask(hash, word)) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string to_hex(const std::string &bytes) {
+  const char digits[] = "0123456789abcdef";
+  std::string hex(bytes.size() * 2, '0');
+  for (std::size_t i = 0; i < bytes.size(); i++) {
+    unsigned char c = bytes[i];
+    hex[2 * i] = digits[c >> 4];
+    hex[2 * i + 1] = digits[c & 0xf];
+  }
+  return hex;
+}
+
+std::string from_hex(const std::string &hex) {
+  auto value = [](char c) {
+    return c <= '9' ? c - '0' : c - 'a' + 10;
+  };
+  std::string bytes(hex.size() / 2, '\0');
+  for (std::size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<char>(value(hex[2 * i]) << 4 | value(hex[2 * i + 1]));
+  }
+  return bytes;
+}
+
+} // namespace skip_data
+} // namespace ral
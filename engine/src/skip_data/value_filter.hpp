@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace skip_data {
+
+// Value filters tell which values a row group may have, so skip data can drop
+// the row groups that can not match an equality. They are split block bloom
+// filters like the parquet ones: blocks of eight 32 bit words, where a value
+// sets one bit of every word of one block. They can have false positives but
+// never false negatives.
+//
+// Values are hashed as text, strings as they are and integers in decimal, so
+// a literal of a query hashes the same whatever the type of its column.
+
+uint64_t hash_value(const std::string &value);
+
+// Builds the filter of a set of hashes with about ten bits per value and at
+// most max_bytes. The filter is empty if max_bytes leaves less than four bits
+// per value, as it would match almost anything.
+std::string make_value_filter(const std::vector<uint64_t> &hashes,
+                              std::size_t max_bytes);
+
+// Whether a row group with this filter may have the value of the hash. An
+// empty filter may have any value.
+bool value_filter_may_contain(const std::string &filter, uint64_t hash);
+
+std::string to_hex(const std::string &bytes);
+
+std::string from_hex(const std::string &hex);
+
+} // namespace skip_data
+} // namespace ral
@@ -0,0 +1,184 @@
+#include "utilities/Metrics.h"
+
+#include <algorithm>
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+std::size_t get_bucket(int64_t value) {
+	std::size_t bucket = 0;
+	while(value > 0 && bucket < Histogram::NUM_BUCKETS - 1) {
+		value >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+}  // namespace
+
+const std::size_t Histogram::NUM_BUCKETS;
+const std::size_t MetricsRegistry::MAX_QUERIES;
+
+void Histogram::record(int64_t value) {
+	if(value < 0) {
+		value = 0;
+	}
+	buckets[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+	num_values.fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(value, std::memory_order_relaxed);
+	int64_t current_max = max_value.load(std::memory_order_relaxed);
+	while(value > current_max && !max_value.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+	}
+}
+
+int64_t Histogram::percentile(double percent) const {
+	int64_t num_recorded = count();
+	if(num_recorded == 0) {
+		return 0;
+	}
+	int64_t rank = static_cast<int64_t>(percent / 100.0 * num_recorded);
+	if(rank >= num_recorded) {
+		rank = num_recorded - 1;
+	}
+	int64_t seen = 0;
+	for(std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+		seen += buckets[bucket].load(std::memory_order_relaxed);
+		if(seen > rank) {
+			int64_t upper_bound = bucket == 0 ? 0 : (int64_t{1} << bucket) - 1;
+			return std::min(upper_bound, max());
+		}
+	}
+	return max();
+}
+
+void Histogram::snapshot(const std::string & name, std::map<std::string, int64_t> & values) const {
+	values[name + "_count"] = count();
+	values[name + "_sum"] = sum();
+	values[name + "_max"] = max();
+	values[name + "_p50"] = percentile(50);
+	values[name + "_p99"] = percentile(99);
+}
+
+void KernelMetrics::snapshot(std::map<std::string, int64_t> & values) const {
+	values["batches_in"] = batches_in.get();
+	values["rows_in"] = rows_in.get();
+	values["bytes_in"] = bytes_in.get();
+	values["batches_out"] = batches_out.get();
+	values["rows_out"] = rows_out.get();
+	values["bytes_out"] = bytes_out.get();
+	values["network_bytes_in"] = network_bytes_in.get();
+	values["compute_time_us"] = compute_time_us.get();
+	input_wait_time_us.snapshot("input_wait_time_us", values);
+	output_time_us.snapshot("output_time_us", values);
+}
+
+void CacheMetrics::snapshot(std::map<std::string, int64_t> & values) const {
+	values["batches_added"] = batches_added.get();
+	values["rows_added"] = rows_added.get();
+	values["bytes_added"] = bytes_added.get();
+	values["batches_pulled"] = batches_pulled.get();
+	values["rows_pulled"] = rows_pulled.get();
+	values["bytes_pulled"] = bytes_pulled.get();
+	values["spill_bytes_host"] = spill_bytes_host.get();
+	values["spill_bytes_host_compressed"] = spill_bytes_host_compressed.get();
+	values["spill_bytes_disk"] = spill_bytes_disk.get();
+	pull_wait_time_us.snapshot("pull_wait_time_us", values);
+}
+
+void NetworkMetrics::snapshot(std::map<std::string, int64_t> & values) const {
+	values["messages_sent"] = messages_sent.get();
+	values["bytes_sent"] = bytes_sent.get();
+	values["messages_received"] = messages_received.get();
+	values["bytes_received"] = bytes_received.get();
+	send_time_us.snapshot("send_time_us", values);
+}
+
+MetricsRegistry & MetricsRegistry::getInstance() {
+	static MetricsRegistry registry;
+	return registry;
+}
+
+MetricsRegistry::QueryMetrics & MetricsRegistry::getQueryMetrics(int32_t query_id) {
+	auto it = queries.find(query_id);
+	if(it != queries.end()) {
+		return it->second;
+	}
+	if(query_order.size() >= MAX_QUERIES) {
+		// the kernels and caches of a forgotten query keep their metrics alive until they are destroyed
+		queries.erase(query_order.front());
+		query_order.pop_front();
+	}
+	query_order.push_back(query_id);
+	return queries[query_id];
+}
+
+std::shared_ptr<KernelMetrics> MetricsRegistry::registerKernel(int32_t query_id, int64_t kernel_id, const std::string & kernel_type) {
+	auto metrics = std::make_shared<KernelMetrics>();
+	std::lock_guard<std::mutex> lock(mutex);
+	getQueryMetrics(query_id).kernels.emplace_back(MetricsSample{"kernel", query_id, kernel_id, kernel_type, {}}, metrics);
+	return metrics;
+}
+
+std::shared_ptr<CacheMetrics> MetricsRegistry::registerCache(int32_t query_id, int64_t cache_id) {
+	auto metrics = std::make_shared<CacheMetrics>();
+	std::lock_guard<std::mutex> lock(mutex);
+	getQueryMetrics(query_id).caches.emplace_back(MetricsSample{"cache", query_id, cache_id, "cache", {}}, metrics);
+	return metrics;
+}
+
+std::shared_ptr<NetworkMetrics> MetricsRegistry::getNetworkMetrics(int32_t query_id, const std::string & message_token) {
+	std::size_t kernel_id_start = message_token.find('_');
+	std::string message_type = message_token.substr(0, kernel_id_start);
+	int64_t kernel_id = -1;
+	if(kernel_id_start != std::string::npos) {
+		std::size_t kernel_id_end = message_token.find('_', kernel_id_start + 1);
+		std::string kernel_id_str = message_token.substr(kernel_id_start + 1, kernel_id_end - kernel_id_start - 1);
+		if(!kernel_id_str.empty() && kernel_id_str.find_first_not_of("0123456789") == std::string::npos) {
+			kernel_id = std::stoll(kernel_id_str);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto & network = getQueryMetrics(query_id).network;
+	auto key = std::make_pair(message_type, kernel_id);
+	auto it = network.find(key);
+	if(it == network.end()) {
+		it = network.emplace(key, std::make_shared<NetworkMetrics>()).first;
+	}
+	return it->second;
+}
+
+std::vector<MetricsSample> MetricsRegistry::snapshot() {
+	std::vector<MetricsSample> samples;
+	std::lock_guard<std::mutex> lock(mutex);
+	for(int32_t query_id : query_order) {
+		const auto & query = queries[query_id];
+		for(const auto & kernel : query.kernels) {
+			MetricsSample sample = kernel.first;
+			kernel.second->snapshot(sample.values);
+			samples.push_back(std::move(sample));
+		}
+		for(const auto & cache : query.caches) {
+			MetricsSample sample = cache.first;
+			cache.second->snapshot(sample.values);
+			samples.push_back(std::move(sample));
+		}
+		for(const auto & network : query.network) {
+			MetricsSample sample{"network", query_id, network.first.second, network.first.first, {}};
+			network.second->snapshot(sample.values);
+			samples.push_back(std::move(sample));
+		}
+	}
+	return samples;
+}
+
+void MetricsRegistry::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	queries.clear();
+	query_order.clear();
+}
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace utilities {
+
+/**
+ * @brief A monotonic counter that can be incremented from any thread without locking.
+ */
+class Counter {
+public:
+	void add(int64_t value) { count.fetch_add(value, std::memory_order_relaxed); }
+
+	int64_t get() const { return count.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<int64_t> count{0};
+};
+
+/**
+ * @brief A histogram of non negative values with power of two buckets, that can be recorded into from any thread
+ * without locking. Bucket i counts the values in [2^(i-1), 2^i), so percentiles are estimated within a factor of two.
+ */
+class Histogram {
+public:
+	static const std::size_t NUM_BUCKETS = 48;
+
+	void record(int64_t value);
+
+	int64_t count() const { return num_values.load(std::memory_order_relaxed); }
+
+	int64_t sum() const { return total.load(std::memory_order_relaxed); }
+
+	int64_t max() const { return max_value.load(std::memory_order_relaxed); }
+
+	/**
+	 * Returns the upper bound of the bucket holding the given percentile (0 to 100), or 0 if nothing was recorded.
+	 */
+	int64_t percentile(double percent) const;
+
+	/**
+	 * Adds count, sum, max, p50 and p99 of the histogram to values, with the histogram name as prefix.
+	 */
+	void snapshot(const std::string & name, std::map<std::string, int64_t> & values) const;
+
+private:
+	std::array<std::atomic<int64_t>, NUM_BUCKETS> buckets{};
+	std::atomic<int64_t> num_values{0};
+	std::atomic<int64_t> total{0};
+	std::atomic<int64_t> max_value{0};
+};
+
+/**
+ * @brief Records the microseconds elapsed between its construction and its destruction into a histogram.
+ */
+class ScopedTimer {
+public:
+	explicit ScopedTimer(Histogram & histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+	~ScopedTimer() {
+		histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+private:
+	Histogram & histogram;
+	std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief What a kernel pulled from its inputs, added to its outputs and how long it took.
+ */
+struct KernelMetrics {
+	Counter batches_in;
+	Counter rows_in;
+	Counter bytes_in;
+	Counter batches_out;
+	Counter rows_out;
+	Counter bytes_out;
+	Counter network_bytes_in; /**< Bytes received from other nodes directly by the kernel. */
+	Counter compute_time_us; /**< Time spent running the kernel, including waiting for its inputs. */
+	Histogram input_wait_time_us; /**< Time waiting on an input cache for every batch pulled. */
+	Histogram output_time_us; /**< Time adding every batch to an output cache. */
+
+	void snapshot(std::map<std::string, int64_t> & values) const;
+};
+
+/**
+ * @brief What went through a CacheMachine and how much of it did not fit in GPU memory.
+ */
+struct CacheMetrics {
+	Counter batches_added;
+	Counter rows_added;
+	Counter bytes_added;
+	Counter batches_pulled;
+	Counter rows_pulled;
+	Counter bytes_pulled;
+	Counter spill_bytes_host; /**< Bytes added or downgraded to the host tier. */
+	Counter spill_bytes_host_compressed; /**< What the spill_bytes_host take in host memory, once compressed. */
+	Counter spill_bytes_disk; /**< Bytes added or downgraded to the disk tier. */
+	Histogram pull_wait_time_us; /**< Time waiting on the WaitingQueue for every batch pulled. */
+
+	void snapshot(std::map<std::string, int64_t> & values) const;
+};
+
+/**
+ * @brief The messages of one message type and kernel exchanged with the other nodes.
+ */
+struct NetworkMetrics {
+	Counter messages_sent;
+	Counter bytes_sent;
+	Counter messages_received;
+	Counter bytes_received;
+	Histogram send_time_us;
+
+	void snapshot(std::map<std::string, int64_t> & values) const;
+};
+
+/**
+ * @brief The values of one kernel, cache or message type at the time of the snapshot.
+ */
+struct MetricsSample {
+	std::string scope; /**< "kernel", "cache" or "network". */
+	int32_t query_id;
+	int64_t id; /**< The kernel or cache id. For network samples the id of the kernel that sent the messages, or -1. */
+	std::string name; /**< The kernel type, "cache" or the message type. */
+	std::map<std::string, int64_t> values;
+};
+
+/**
+ * @brief Process wide registry of the metrics of the most recent queries.
+ *
+ * Kernels and caches register themselves once and keep the returned pointer, so updating a metric never takes a lock.
+ * The registry only locks to register and to take snapshots. The metrics of a query are kept after it finishes,
+ * so they can be looked at afterwards, until MAX_QUERIES more recent queries have registered metrics.
+ */
+class MetricsRegistry {
+public:
+	static const std::size_t MAX_QUERIES = 16;
+
+	static MetricsRegistry & getInstance();
+
+	std::shared_ptr<KernelMetrics> registerKernel(int32_t query_id, int64_t kernel_id, const std::string & kernel_type);
+
+	std::shared_ptr<CacheMetrics> registerCache(int32_t query_id, int64_t cache_id);
+
+	/**
+	 * Returns the metrics of the messages with the given token, registering them the first time.
+	 * The message tokens look like <message type>_<kernel id>_<query substep>, and the metrics are kept by message
+	 * type and kernel id.
+	 */
+	std::shared_ptr<NetworkMetrics> getNetworkMetrics(int32_t query_id, const std::string & message_token);
+
+	std::vector<MetricsSample> snapshot();
+
+	void clear();
+
+private:
+	MetricsRegistry() = default;
+	MetricsRegistry(const MetricsRegistry &) = delete;
+	MetricsRegistry & operator=(const MetricsRegistry &) = delete;
+
+	struct QueryMetrics {
+		std::vector<std::pair<MetricsSample, std::shared_ptr<KernelMetrics>>> kernels;
+		std::vector<std::pair<MetricsSample, std::shared_ptr<CacheMetrics>>> caches;
+		std::map<std::pair<std::string, int64_t>, std::shared_ptr<NetworkMetrics>> network; /**< by message type and kernel id */
+	};
+
+	QueryMetrics & getQueryMetrics(int32_t query_id);
+
+	std::mutex mutex;
+	std::map<int32_t, QueryMetrics> queries;
+	std::deque<int32_t> query_order; /**< Oldest query first. */
+};
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,128 @@
+#include "utilities/QueryTracer.h"
+
+#include <fstream>
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+std::string escape_json(const std::string & value) {
+	std::string escaped;
+	escaped.reserve(value.size());
+	for(char c : value) {
+		if(c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		} else if(static_cast<unsigned char>(c) < 0x20) {
+			escaped += ' ';
+		} else {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+}  // namespace
+
+const int32_t QueryTracer::ANY_QUERY;
+const std::size_t QueryTracer::BUFFER_NUM_EVENTS;
+
+QueryTracer & QueryTracer::getInstance() {
+	static QueryTracer tracer;
+	return tracer;
+}
+
+void QueryTracer::startQuery(int32_t query_id) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(traced_queries.emplace(query_id, now_us()).second) {
+		num_traced_queries++;
+	}
+}
+
+QueryTracer::ThreadBuffer & QueryTracer::getThreadBuffer() {
+	thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+	if(!thread_buffer) {
+		thread_buffer = std::make_shared<ThreadBuffer>();
+		std::lock_guard<std::mutex> lock(mutex);
+		thread_buffer->thread_id = num_threads++;
+		buffers.push_back(thread_buffer);
+	}
+	return *thread_buffer;
+}
+
+void QueryTracer::record(int32_t query_id, const char * category, std::string name, int64_t begin_us, int64_t end_us,
+	const char * arg_name, int64_t arg_value) {
+	if(!is_enabled()) {
+		return;
+	}
+	ThreadBuffer & buffer = getThreadBuffer();
+	TraceEvent event{query_id, category, std::move(name), begin_us, end_us, arg_name, arg_value};
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if(buffer.events.size() < BUFFER_NUM_EVENTS) {
+		buffer.events.push_back(std::move(event));
+	} else {
+		buffer.events[buffer.next] = std::move(event);
+		buffer.next = (buffer.next + 1) % BUFFER_NUM_EVENTS;
+	}
+}
+
+bool QueryTracer::finishQuery(int32_t query_id, int32_t node_id, const std::string & file_path) {
+	std::vector<std::pair<int32_t, TraceEvent>> query_events;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = traced_queries.find(query_id);
+		if(it == traced_queries.end()) {
+			return false;
+		}
+		int64_t query_start_us = it->second;
+		traced_queries.erase(it);
+		num_traced_queries--;
+
+		for(auto & buffer : buffers) {
+			std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+			for(const auto & event : buffer->events) {
+				if(event.query_id == query_id || (event.query_id == ANY_QUERY && event.begin_us >= query_start_us)) {
+					query_events.emplace_back(buffer->thread_id, event);
+				}
+			}
+			if(traced_queries.empty()) {
+				buffer->events.clear();
+				buffer->events.shrink_to_fit();
+				buffer->next = 0;
+			}
+		}
+		if(traced_queries.empty()) {
+			// the buffers of the threads that already exited are not needed anymore
+			std::vector<std::shared_ptr<ThreadBuffer>> live_buffers;
+			for(auto & buffer : buffers) {
+				if(buffer.use_count() > 1) {
+					live_buffers.push_back(buffer);
+				}
+			}
+			buffers.swap(live_buffers);
+		}
+	}
+
+	std::ofstream file(file_path);
+	if(!file) {
+		return false;
+	}
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << node_id << ",\"args\":{\"name\":\"node " << node_id << "\"}}";
+	for(const auto & thread_event : query_events) {
+		const TraceEvent & event = thread_event.second;
+		file << ",\n{\"name\":\"" << escape_json(event.name) << "\",\"cat\":\"" << event.category
+			 << "\",\"ph\":\"X\",\"ts\":" << event.begin_us << ",\"dur\":" << (event.end_us - event.begin_us)
+			 << ",\"pid\":" << node_id << ",\"tid\":" << thread_event.first;
+		if(event.arg_name != nullptr) {
+			file << ",\"args\":{\"" << event.arg_name << "\":" << event.arg_value << "}";
+		}
+		file << "}";
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return static_cast<bool>(file);
+}
+
+}  // namespace utilities
+}  // namespace ral
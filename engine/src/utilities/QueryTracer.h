@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace utilities {
+
+/**
+ * @brief A span of time spent by a thread on something, like running a kernel or sending a message.
+ */
+struct TraceEvent {
+	int32_t query_id; /**< QueryTracer::ANY_QUERY when the event can not be tied to a query. */
+	const char * category; /**< Must be a string literal. */
+	std::string name;
+	int64_t begin_us;
+	int64_t end_us;
+	const char * arg_name; /**< Must be a string literal, or nullptr when the event has no argument. */
+	int64_t arg_value;
+};
+
+/**
+ * @brief Records what every thread is doing while traced queries run and writes it as a Chrome trace JSON file,
+ * which can be opened with chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Every thread records into its own ring buffer, so recording does not contend with other threads. Nothing is
+ * recorded while no query is being traced. The events of a query are taken out of the buffers when the query
+ * finishes; when a thread records more than BUFFER_NUM_EVENTS events its oldest events are overwritten.
+ */
+class QueryTracer {
+public:
+	static const int32_t ANY_QUERY = -1;
+	static const std::size_t BUFFER_NUM_EVENTS = 65536;
+
+	static QueryTracer & getInstance();
+
+	/**
+	 * Starts recording the events of a query.
+	 */
+	void startQuery(int32_t query_id);
+
+	/**
+	 * Stops recording the events of a query and writes them to file_path. The events that are not tied to any query
+	 * are written too if they happened while the query was running.
+	 * @param node_id The process id in the trace, so the traces of all the nodes can be looked at together.
+	 * @return false if the file could not be written.
+	 */
+	bool finishQuery(int32_t query_id, int32_t node_id, const std::string & file_path);
+
+	/**
+	 * Whether any query is being traced. Checking it is cheap, so the events can be skipped altogether otherwise.
+	 */
+	bool is_enabled() const { return num_traced_queries.load(std::memory_order_relaxed) > 0; }
+
+	void record(int32_t query_id, const char * category, std::string name, int64_t begin_us, int64_t end_us,
+		const char * arg_name = nullptr, int64_t arg_value = 0);
+
+	/**
+	 * The current time in microseconds, from the same clock as CodeTimer::start_time.
+	 */
+	static int64_t now_us() {
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	QueryTracer() = default;
+	QueryTracer(const QueryTracer &) = delete;
+	QueryTracer & operator=(const QueryTracer &) = delete;
+
+	struct ThreadBuffer {
+		std::mutex mutex; /**< Only taken by another thread when a query finishes. */
+		std::vector<TraceEvent> events;
+		std::size_t next = 0; /**< Where the next event goes once the buffer is full. */
+		int32_t thread_id;
+	};
+
+	ThreadBuffer & getThreadBuffer();
+
+	std::mutex mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::map<int32_t, int64_t> traced_queries; /**< The start time of every query being traced. */
+	std::atomic<int32_t> num_traced_queries{0};
+	int32_t num_threads = 0;
+};
+
+/**
+ * @brief Records a TraceEvent from its construction to its destruction, if tracing is enabled when it is constructed.
+ */
+class TraceSpan {
+public:
+	TraceSpan(int32_t query_id, const char * category, const std::string & name)
+		: enabled{QueryTracer::getInstance().is_enabled()}, query_id{query_id}, category{category} {
+		if(enabled) {
+			this->name = name;
+			begin_us = QueryTracer::now_us();
+		}
+	}
+
+	~TraceSpan() {
+		if(enabled) {
+			QueryTracer::getInstance().record(query_id, category, std::move(name), begin_us, QueryTracer::now_us(), arg_name, arg_value);
+		}
+	}
+
+	/**
+	 * Adds a number to the event, like the rows or bytes it processed.
+	 */
+	void set_arg(const char * arg_name, int64_t arg_value) {
+		this->arg_name = arg_name;
+		this->arg_value = arg_value;
+	}
+
+private:
+	bool enabled;
+	int32_t query_id;
+	const char * category;
+	std::string name;
+	int64_t begin_us = 0;
+	const char * arg_name = nullptr;
+	int64_t arg_value = 0;
+};
+
+}  // namespace utilities
+}  // namespace ral
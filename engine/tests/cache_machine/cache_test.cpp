@@ -1,3 +1,4 @@
+#include <fstream>
 #include <spdlog/spdlog.h>
 #include "tests/utilities/BlazingUnitTest.h"
 
@@ -7,6 +8,7 @@
 #include <src/utilities/DebuggingUtils.h>
 
 #include <cudf_test/column_wrapper.hpp>
+#include <cudf_test/table_utilities.hpp>
 
 using blazingdb::manager::Context;
 using blazingdb::transport::Address;
@@ -82,3 +84,24 @@ TEST_F(CacheMachineTest, CacheMachineTest) {
 	}
 	std::this_thread::sleep_for(std::chrono::seconds(1));
 }
+
+TEST_F(CacheMachineTest, LocalFileRoundTrip) {
+	for(bool use_direct_io : {false, true}) {
+		auto table = build_custom_table();
+		auto expected_table = build_custom_table();
+		size_t table_num_bytes = table->sizeInBytes();
+
+		ral::cache::CacheDataLocalFile cache_data(std::move(table), "/tmp", use_direct_io);
+		EXPECT_EQ(cache_data.sizeInBytes(), table_num_bytes);
+		EXPECT_EQ(cache_data.fileSizeInBytes() % 4096, 0);
+		EXPECT_GE(cache_data.fileSizeInBytes(), table_num_bytes);
+
+		auto decached_table = cache_data.decache();
+		cudf::test::expect_tables_equal(expected_table->view(), decached_table->view());
+		EXPECT_EQ(decached_table->names(), expected_table->names());
+
+		// the file is removed once the table is decached
+		std::ifstream spill_file(cache_data.filePath());
+		EXPECT_FALSE(spill_file.good());
+	}
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "bmr/EvictionPolicy.h"
+#include "bmr/EvictionSimulator.h"
+
+using ral::CostAwareEvictionPolicy;
+using ral::EvictionCandidate;
+using ral::EvictionSimulationResult;
+using ral::EvictionSimulator;
+using ral::EvictionTrace;
+using ral::EvictionTraceEvent;
+using ral::ReverseOrderEvictionPolicy;
+
+namespace {
+
+EvictionCandidate make_candidate(std::size_t tree_order, std::size_t queue_position, std::size_t size_bytes,
+	bool consumer_started, double consumer_bytes_per_second) {
+	EvictionCandidate candidate;
+	candidate.tree_order = tree_order;
+	candidate.queue_position = queue_position;
+	candidate.bytes_ahead = queue_position * size_bytes;
+	candidate.size_bytes = size_bytes;
+	candidate.consumer_started = consumer_started;
+	candidate.consumer_bytes_per_second = consumer_bytes_per_second;
+	return candidate;
+}
+
+// A pipeline whose output cache (tree order 0) is consumed as fast as it is produced, next to the build side of a join
+// (tree order 1) that is not consumed until the end of the query
+EvictionTrace make_join_trace() {
+	const std::size_t batch_bytes = 10000000;
+	EvictionTrace trace;
+	trace.tree_order[1] = 0;
+	trace.tree_order[2] = 1;
+	for (int64_t time_us = 0; time_us < 2000000; time_us += 10000) {
+		trace.events.push_back(EvictionTraceEvent{time_us, EvictionTraceEvent::Type::ADD, 1, batch_bytes});
+		if (time_us < 1000000) {
+			trace.events.push_back(EvictionTraceEvent{time_us, EvictionTraceEvent::Type::ADD, 2, batch_bytes});
+		}
+		if (time_us >= 30000) {
+			trace.events.push_back(EvictionTraceEvent{time_us, EvictionTraceEvent::Type::PULL, 1, 0});
+		}
+	}
+	for (int i = 0; i < 100; i++) {
+		trace.events.push_back(EvictionTraceEvent{3000000 + i * 10000, EvictionTraceEvent::Type::PULL, 2, 0});
+	}
+	return trace;
+}
+
+}  // namespace
+
+TEST(EvictionPolicyTest, ReverseOrderFollowsTheTreeThenNewestFirst) {
+	std::vector<EvictionCandidate> candidates = {
+		make_candidate(1, 0, 100, true, 0),
+		make_candidate(0, 0, 100, true, 0),
+		make_candidate(0, 1, 100, true, 0),
+		make_candidate(1, 1, 100, true, 0),
+	};
+	std::vector<std::size_t> expected = {2, 1, 3, 0};
+	EXPECT_EQ(ReverseOrderEvictionPolicy().rank(candidates), expected);
+}
+
+TEST(EvictionPolicyTest, CostAwarePrefersBatchesUsedLater) {
+	CostAwareEvictionPolicy policy;
+	std::vector<EvictionCandidate> candidates = {
+		make_candidate(0, 0, 100000000, true, 1e9), // pulled right away
+		make_candidate(0, 5, 100000000, true, 1e9), // pulled in half a second
+		make_candidate(1, 0, 100000000, false, 0), // its consumer has not started
+	};
+	std::vector<std::size_t> expected = {2, 1, 0};
+	EXPECT_EQ(policy.rank(candidates), expected);
+
+	EXPECT_LT(policy.time_to_consume_us(candidates[0]), policy.rematerialization_cost_us(candidates[0]));
+}
+
+TEST(EvictionPolicyTest, CostAwareAccountsForTheTargetTier) {
+	CostAwareEvictionPolicy policy;
+	EvictionCandidate to_host = make_candidate(0, 2, 100000000, true, 1e8);
+	EvictionCandidate to_disk = to_host;
+	to_disk.target_tier = 2;
+	EXPECT_LT(policy.rematerialization_cost_us(to_host), policy.rematerialization_cost_us(to_disk));
+
+	std::vector<std::size_t> expected = {0, 1};
+	EXPECT_EQ(policy.rank({to_host, to_disk}), expected);
+}
+
+TEST(EvictionPolicyTest, ParseTrace) {
+	std::istringstream input("# two caches\n"
+							 "cache 7 0\n"
+							 "cache 3 1\n"
+							 "0 add 7 1000\n"
+							 "50 pull 7\n");
+	EvictionTrace trace = ral::parse_eviction_trace(input);
+	EXPECT_EQ(trace.tree_order.at(7), 0);
+	EXPECT_EQ(trace.tree_order.at(3), 1);
+	ASSERT_EQ(trace.events.size(), 2);
+	EXPECT_EQ(trace.events[0].type, EvictionTraceEvent::Type::ADD);
+	EXPECT_EQ(trace.events[0].size_bytes, 1000);
+	EXPECT_EQ(trace.events[1].type, EvictionTraceEvent::Type::PULL);
+	EXPECT_EQ(trace.events[1].time_us, 50);
+	EXPECT_EQ(trace.events[1].cache_id, 7);
+
+	std::istringstream invalid("0 drop 7\n");
+	EXPECT_THROW(ral::parse_eviction_trace(invalid), std::runtime_error);
+}
+
+TEST(EvictionPolicyTest, SimulatorNeverDowngradesUnderTheLimit) {
+	EvictionSimulator::Settings settings;
+	settings.device_limit_bytes = 10000000000;
+	EvictionSimulationResult result = EvictionSimulator(settings).run(make_join_trace(), CostAwareEvictionPolicy());
+	EXPECT_EQ(result.bytes_downgraded, 0);
+	EXPECT_EQ(result.peak_device_bytes, 1040000000);
+}
+
+TEST(EvictionPolicyTest, CostAwareDowngradesLessThanReverseOrderOnAJoin) {
+	EvictionSimulator::Settings settings;
+	settings.device_limit_bytes = 500000000;
+	EvictionSimulator simulator(settings);
+	EvictionTrace trace = make_join_trace();
+
+	EvictionSimulationResult reverse_order = simulator.run(trace, ReverseOrderEvictionPolicy());
+	EvictionSimulationResult cost_aware = simulator.run(trace, CostAwareEvictionPolicy());
+
+	// the build side has to be downgraded either way
+	EXPECT_GE(cost_aware.bytes_downgraded, 500000000);
+	EXPECT_EQ(cost_aware.premature_reloads, 0);
+	EXPECT_GT(reverse_order.premature_reloads, 0);
+	EXPECT_LT(cost_aware.bytes_downgraded, reverse_order.bytes_downgraded);
+	EXPECT_LT(cost_aware.rematerialization_cost_us, reverse_order.rematerialization_cost_us);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "execution_graph/logic_controllers/FlowControl.h"
+
+using ral::cache::AdaptiveFlowControl;
+using ral::cache::ByteRate;
+
+TEST(FlowControlTest, ByteRateFollowsRecentRate) {
+	ByteRate rate(1000000);
+	EXPECT_FALSE(rate.has_rate());
+	EXPECT_EQ(rate.bytes_per_second(0), 0);
+
+	// 1 MB every 10 ms
+	int64_t now_us = 0;
+	for (int i = 0; i < 1000; i++) {
+		now_us += 10000;
+		rate.record(1000000, now_us);
+	}
+	EXPECT_TRUE(rate.has_rate());
+	EXPECT_NEAR(rate.bytes_per_second(now_us), 100000000.0, 5000000.0);
+
+	// nothing for three time constants
+	EXPECT_LT(rate.bytes_per_second(now_us + 3000000), 10000000.0);
+}
+
+TEST(FlowControlTest, ByteRateDoesNotBlowUpOnTheFirstRecord) {
+	ByteRate rate(1000000);
+	rate.record(1000000, 5000000);
+	EXPECT_LT(rate.bytes_per_second(5000000), 20000000.0);
+}
+
+TEST(FlowControlTest, BudgetIsTheMemoryShareUntilTheConsumerPulls) {
+	AdaptiveFlowControl flow_control(1000, 0);
+	int64_t now_us = 0;
+	for (int i = 0; i < 100; i++) {
+		now_us += 1000;
+		flow_control.record_added(1000000, now_us);
+	}
+	EXPECT_EQ(flow_control.get_budget(500000000, now_us), 500000000);
+}
+
+TEST(FlowControlTest, SlowConsumerHoldsBackProducer) {
+	AdaptiveFlowControl flow_control(1000, 0);
+	// the producer adds 100 MB/s and the consumer pulls 10 MB/s
+	int64_t now_us = 0;
+	for (int i = 0; i < 500; i++) {
+		now_us += 10000;
+		flow_control.record_added(1000000, now_us);
+		if (i % 10 == 0) {
+			flow_control.record_pulled(1000000, now_us);
+		}
+	}
+	std::size_t budget = flow_control.get_budget(500000000, now_us);
+	EXPECT_GT(budget, 5000000);
+	EXPECT_LT(budget, 20000000);
+
+	// less memory left than the consumer needs
+	EXPECT_EQ(flow_control.get_budget(3000000, now_us), 3000000);
+}
+
+TEST(FlowControlTest, FastConsumerOnlyLimitedByMemory) {
+	AdaptiveFlowControl flow_control(1000, 0);
+	int64_t now_us = 0;
+	for (int i = 0; i < 500; i++) {
+		now_us += 10000;
+		flow_control.record_added(1000000, now_us);
+		flow_control.record_pulled(1000000, now_us);
+	}
+	EXPECT_EQ(flow_control.get_budget(500000000, now_us), 500000000);
+}
+
+TEST(FlowControlTest, BudgetNeverBelowMinBytesNorBiggestBatch) {
+	AdaptiveFlowControl flow_control(1000, 4000000);
+	flow_control.record_added(1000000, 10000);
+	EXPECT_EQ(flow_control.get_budget(0, 10000), 4000000);
+
+	flow_control.record_added(8000000, 20000);
+	EXPECT_EQ(flow_control.get_budget(0, 20000), 8000000);
+}
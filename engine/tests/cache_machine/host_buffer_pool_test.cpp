@@ -0,0 +1,106 @@
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "bmr/BlazingHostBufferPool.h"
+
+struct HostBufferPoolTest : public ::testing::Test {
+	void SetUp() override {
+		blazing_host_buffer_pool::getInstance().set_max_cached_bytes(1073741824);
+		blazing_host_buffer_pool::getInstance().trim();
+	}
+
+	void TearDown() override {
+		blazing_host_buffer_pool::getInstance().trim();
+	}
+};
+
+TEST_F(HostBufferPoolTest, SizeClasses) {
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(1), 256);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(256), 256);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(257), 320);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(512), 512);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(513), 640);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(1000000), 1048576);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(1073741824), 1073741824);
+	EXPECT_EQ(blazing_host_buffer_pool::get_size_class(1073741825), 1073741825);
+}
+
+TEST_F(HostBufferPoolTest, ReusesReleasedBuffers) {
+	auto & pool = blazing_host_buffer_pool::getInstance();
+	const char * first_data = nullptr;
+	{
+		blazing_host_buffer buffer(1000);
+		std::memset(buffer.data(), 1, buffer.size());
+		first_data = buffer.data();
+		EXPECT_EQ(buffer.size(), 1000);
+		EXPECT_EQ(buffer.capacity(), 1024);
+		EXPECT_EQ(pool.get_used_bytes(), 1024);
+	}
+	EXPECT_EQ(pool.get_used_bytes(), 0);
+	EXPECT_EQ(pool.get_cached_bytes(), 1024);
+
+	// any request of the same size class gets the same memory back
+	blazing_host_buffer buffer(900);
+	EXPECT_EQ(buffer.data(), first_data);
+	EXPECT_EQ(pool.get_used_bytes(), 1024);
+	EXPECT_EQ(pool.get_cached_bytes(), 0);
+}
+
+TEST_F(HostBufferPoolTest, MovedBuffersAreReleasedOnce) {
+	auto & pool = blazing_host_buffer_pool::getInstance();
+	{
+		std::vector<blazing_host_buffer> buffers;
+		for (int i = 0; i < 10; i++) {
+			buffers.emplace_back(4096);
+		}
+		blazing_host_buffer moved = std::move(buffers[0]);
+		EXPECT_EQ(buffers[0].data(), nullptr);
+		EXPECT_EQ(buffers[0].size(), 0);
+		EXPECT_EQ(moved.size(), 4096);
+		EXPECT_EQ(pool.get_used_bytes(), 10 * 4096);
+	}
+	EXPECT_EQ(pool.get_used_bytes(), 0);
+	EXPECT_EQ(pool.get_cached_bytes(), 10 * 4096);
+}
+
+TEST_F(HostBufferPoolTest, MaxCachedBytes) {
+	auto & pool = blazing_host_buffer_pool::getInstance();
+	pool.set_max_cached_bytes(8192);
+	{
+		blazing_host_buffer first(4096);
+		blazing_host_buffer second(4096);
+		blazing_host_buffer third(4096);
+	}
+	EXPECT_EQ(pool.get_used_bytes(), 0);
+	EXPECT_EQ(pool.get_cached_bytes(), 8192);
+
+	pool.set_max_cached_bytes(0);
+	EXPECT_EQ(pool.get_cached_bytes(), 0);
+}
+
+TEST_F(HostBufferPoolTest, EmptyBuffer) {
+	blazing_host_buffer buffer(0);
+	EXPECT_EQ(buffer.data(), nullptr);
+	EXPECT_EQ(buffer.size(), 0);
+	EXPECT_EQ(blazing_host_buffer_pool::getInstance().get_used_bytes(), 0);
+}
+
+TEST_F(HostBufferPoolTest, AdoptedBuffers) {
+	auto & pool = blazing_host_buffer_pool::getInstance();
+	{
+		std::vector<blazing_host_buffer> buffers;
+		buffers.emplace_back(std::basic_string<char>(5000, 'a'));
+		buffers.emplace_back(std::basic_string<char>("short"));
+		EXPECT_EQ(pool.get_used_bytes(), 5005);
+
+		// growing the vector moves the buffers, the short one lives inside the string object
+		for (int i = 0; i < 10; i++) {
+			buffers.emplace_back(std::basic_string<char>(10, 'b'));
+		}
+		EXPECT_EQ(std::basic_string<char>(buffers[0].data(), buffers[0].size()), std::basic_string<char>(5000, 'a'));
+		EXPECT_EQ(std::basic_string<char>(buffers[1].data(), buffers[1].size()), "short");
+		EXPECT_EQ(pool.get_used_bytes(), 5105);
+	}
+	EXPECT_EQ(pool.get_used_bytes(), 0);
+	EXPECT_EQ(pool.get_cached_bytes(), 0);
+}
@@ -0,0 +1,89 @@
+#include <cstring>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "execution_graph/logic_controllers/HostCompression.h"
+
+using ral::cache::HostColumnCompressor;
+using ral::cache::HostCompressionCodec;
+
+namespace {
+
+blazing_host_buffer make_repetitive_buffer(std::size_t size) {
+	blazing_host_buffer buffer(size);
+	for (std::size_t i = 0; i < size; i++) {
+		buffer.data()[i] = static_cast<char>((i / 64) % 4);
+	}
+	return buffer;
+}
+
+blazing_host_buffer make_random_buffer(std::size_t size, unsigned seed) {
+	std::mt19937 generator(seed);
+	blazing_host_buffer buffer(size);
+	for (std::size_t i = 0; i < size; i++) {
+		buffer.data()[i] = static_cast<char>(generator());
+	}
+	return buffer;
+}
+
+}  // namespace
+
+TEST(HostCompressionTest, ParseCodec) {
+	EXPECT_EQ(ral::cache::parse_host_compression_codec("none"), HostCompressionCodec::NONE);
+	EXPECT_EQ(ral::cache::parse_host_compression_codec("lz4"), HostCompressionCodec::LZ4);
+	EXPECT_EQ(ral::cache::parse_host_compression_codec("zstd"), HostCompressionCodec::ZSTD);
+	EXPECT_THROW(ral::cache::parse_host_compression_codec("gzip"), std::runtime_error);
+}
+
+TEST(HostCompressionTest, RoundTrip) {
+	for (HostCompressionCodec codec : {HostCompressionCodec::LZ4, HostCompressionCodec::ZSTD}) {
+		blazing_host_buffer raw = make_repetitive_buffer(1000000);
+		blazing_host_buffer compressed = ral::cache::compress_host_buffer(codec, raw);
+		ASSERT_GT(compressed.size(), 0);
+		EXPECT_LT(compressed.size(), raw.size() / 4);
+
+		blazing_host_buffer decompressed = ral::cache::decompress_host_buffer(codec, compressed, raw.size());
+		ASSERT_EQ(decompressed.size(), raw.size());
+		EXPECT_EQ(std::memcmp(decompressed.data(), raw.data(), raw.size()), 0);
+
+		EXPECT_THROW(ral::cache::decompress_host_buffer(codec, raw, raw.size() * 2), std::runtime_error);
+	}
+}
+
+TEST(HostCompressionTest, IncompressibleBufferIsNotCompressed) {
+	blazing_host_buffer raw = make_random_buffer(100000, 1);
+	EXPECT_EQ(ral::cache::compress_host_buffer(HostCompressionCodec::LZ4, raw).size(), 0);
+}
+
+TEST(HostCompressionTest, CompressorChoosesPerColumn) {
+	HostColumnCompressor compressor(HostCompressionCodec::LZ4, 0.8, 4096, 4);
+	// column 0 compresses well, column 1 does not, and the last buffer of column 0 is too small to bother
+	std::vector<int> buffer_columns = {0, 1, 0};
+	for (unsigned batch = 0; batch < 4; batch++) {
+		std::vector<blazing_host_buffer> buffers;
+		buffers.push_back(make_repetitive_buffer(100000));
+		buffers.push_back(make_random_buffer(100000, batch));
+		buffers.push_back(make_repetitive_buffer(1000));
+
+		std::vector<HostCompressionCodec> codecs = compressor.compress(buffers, buffer_columns);
+		ASSERT_EQ(codecs.size(), 3);
+		EXPECT_EQ(codecs[0], HostCompressionCodec::LZ4);
+		EXPECT_LT(buffers[0].size(), 100000);
+		EXPECT_EQ(codecs[1], HostCompressionCodec::NONE);
+		EXPECT_EQ(buffers[1].size(), 100000);
+		EXPECT_EQ(codecs[2], HostCompressionCodec::NONE);
+		EXPECT_EQ(buffers[2].size(), 1000);
+	}
+	EXPECT_LT(compressor.get_column_ratio(0), 0.25);
+	EXPECT_EQ(compressor.get_column_ratio(1), 1.0);
+	EXPECT_EQ(compressor.get_column_ratio(2), 1.0);
+}
+
+TEST(HostCompressionTest, NoneLeavesBuffersAlone) {
+	HostColumnCompressor compressor(HostCompressionCodec::NONE, 0.8);
+	std::vector<blazing_host_buffer> buffers;
+	buffers.push_back(make_repetitive_buffer(100000));
+	std::vector<HostCompressionCodec> codecs = compressor.compress(buffers, {0});
+	EXPECT_EQ(codecs[0], HostCompressionCodec::NONE);
+	EXPECT_EQ(buffers[0].size(), 100000);
+}
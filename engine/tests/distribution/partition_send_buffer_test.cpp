@@ -0,0 +1,110 @@
+#include <cstring>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include <blazingdb/transport/ColumnTransport.h>
+
+#include "communication/messages/GPUComponentMessage.h"
+#include "distribution/PartitionSendBuffer.h"
+
+using ral::distribution::PartitionSendBuffer;
+using ral::frame::BlazingHostTable;
+using blazingdb::transport::Address;
+using blazingdb::transport::ColumnTransport;
+using blazingdb::transport::Node;
+
+namespace {
+
+// A table with a single INT32 column whose values are all fill
+std::unique_ptr<BlazingHostTable> make_host_table(int32_t num_rows, int32_t fill) {
+	ColumnTransport column;
+	column.metadata.dtype = (int32_t)cudf::type_id::INT32;
+	column.metadata.size = num_rows;
+	std::strcpy(column.metadata.col_name, "a");
+	column.data = 0;
+	column.valid = -1;
+	column.strings_data = -1;
+	column.strings_offsets = -1;
+	column.strings_nullmask = -1;
+	column.size_in_bytes = num_rows * sizeof(int32_t);
+
+	blazing_host_buffer buffer(column.size_in_bytes);
+	std::vector<int32_t> values(num_rows, fill);
+	std::memcpy(buffer.data(), values.data(), column.size_in_bytes);
+	std::vector<blazing_host_buffer> buffers;
+	buffers.push_back(std::move(buffer));
+	return std::make_unique<BlazingHostTable>(std::vector<ColumnTransport>{column}, std::move(buffers));
+}
+
+}  // namespace
+
+TEST(PartitionSendBufferTest, ShipsOncePartitionsAddUpToMaxBytes) {
+	PartitionSendBuffer send_buffer(1000, 60000);
+	Node node_a(Address::TCP("10.0.0.1", 9000, 9001));
+	Node node_b(Address::TCP("10.0.0.2", 9000, 9001));
+
+	EXPECT_TRUE(send_buffer.accepts(999));
+	EXPECT_FALSE(send_buffer.accepts(1000));
+
+	// 400 bytes each
+	EXPECT_TRUE(send_buffer.add(node_a, 0, make_host_table(100, 1)).empty());
+	EXPECT_TRUE(send_buffer.add(node_b, 0, make_host_table(100, 2)).empty());
+	EXPECT_TRUE(send_buffer.add(node_a, 1, make_host_table(100, 3)).empty());
+	auto ready = send_buffer.add(node_a, 0, make_host_table(200, 4));
+	ASSERT_EQ(ready.size(), 1);
+	EXPECT_TRUE(ready[0].destination == node_a);
+	EXPECT_EQ(ready[0].partition_id, 0);
+	EXPECT_EQ(ready[0].tables.size(), 2);
+
+	auto remaining = send_buffer.takeAll();
+	EXPECT_EQ(remaining.size(), 2);
+	EXPECT_TRUE(send_buffer.takeAll().empty());
+}
+
+TEST(PartitionSendBufferTest, ShipsPartitionsThatWaitedTooLong) {
+	PartitionSendBuffer send_buffer(1000, 10);
+	Node node_a(Address::TCP("10.0.0.1", 9000, 9001));
+	Node node_b(Address::TCP("10.0.0.2", 9000, 9001));
+
+	EXPECT_TRUE(send_buffer.add(node_a, 0, make_host_table(10, 1)).empty());
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	auto ready = send_buffer.add(node_b, 0, make_host_table(10, 2));
+	ASSERT_EQ(ready.size(), 1);
+	EXPECT_TRUE(ready[0].destination == node_a);
+}
+
+TEST(PartitionSendBufferTest, ReceiverSplitsFramedTables) {
+	Node node(Address::TCP("10.0.0.1", 9000, 9001));
+	std::vector<std::unique_ptr<BlazingHostTable>> tables;
+	tables.push_back(make_host_table(3, 7));
+	tables.push_back(make_host_table(5, 8));
+	ral::communication::messages::HostTablesMessage message("ColumnDataPartitionMessage_1_0", 1, node, std::move(tables), 2);
+	EXPECT_EQ(message.metadata().n_batches, 2);
+
+	std::vector<std::size_t> buffer_sizes;
+	std::vector<const char *> buffers;
+	std::vector<ColumnTransport> columns_offsets;
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
+	std::tie(buffer_sizes, buffers, columns_offsets, temp_scope_holder) = message.GetRawColumns();
+	ASSERT_EQ(buffers.size(), 2);
+	EXPECT_EQ(columns_offsets[1].data, 1);
+
+	// what the server hands to the deserializer
+	std::vector<std::basic_string<char>> raw_buffers;
+	for (std::size_t index = 0; index < buffers.size(); ++index) {
+		raw_buffers.emplace_back(buffers[index], buffer_sizes[index]);
+	}
+	auto received = ral::communication::messages::GPUComponentMessage::MakeFromHost(
+		message.metadata(), node.address().metadata(), columns_offsets, std::move(raw_buffers));
+	auto host_message = std::static_pointer_cast<ral::communication::messages::ReceivedHostMessage>(received);
+	EXPECT_EQ(host_message->getPartitionId(), 2);
+
+	auto received_tables = host_message->releaseBlazingHostTables();
+	ASSERT_EQ(received_tables.size(), 2);
+	EXPECT_EQ(received_tables[0]->num_rows(), 3);
+	EXPECT_EQ(received_tables[1]->num_rows(), 5);
+	EXPECT_EQ(received_tables[1]->get_columns_offsets()[0].data, 0);
+	int32_t value;
+	std::memcpy(&value, received_tables[1]->get_raw_buffers()[0].data(), sizeof(value));
+	EXPECT_EQ(value, 8);
+}
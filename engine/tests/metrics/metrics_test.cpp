@@ -0,0 +1,77 @@
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utilities/Metrics.h"
+
+using ral::utilities::Counter;
+using ral::utilities::Histogram;
+using ral::utilities::MetricsRegistry;
+
+TEST(MetricsTest, CountersAddFromManyThreads) {
+	Counter counter;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&counter]() {
+			for (int j = 0; j < 1000; ++j) {
+				counter.add(2);
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(counter.get(), 8000);
+}
+
+TEST(MetricsTest, HistogramPercentilesAreBucketUpperBounds) {
+	Histogram histogram;
+	EXPECT_EQ(histogram.percentile(50), 0);
+
+	for (int i = 0; i < 99; ++i) {
+		histogram.record(10);
+	}
+	histogram.record(1000);
+
+	EXPECT_EQ(histogram.count(), 100);
+	EXPECT_EQ(histogram.sum(), 99 * 10 + 1000);
+	EXPECT_EQ(histogram.max(), 1000);
+	EXPECT_EQ(histogram.percentile(50), 15);
+	EXPECT_EQ(histogram.percentile(100), 1000);
+}
+
+TEST(MetricsTest, SnapshotHasEveryRegisteredKernelCacheAndMessage) {
+	auto & registry = MetricsRegistry::getInstance();
+	registry.clear();
+
+	auto kernel_metrics = registry.registerKernel(1, 3, "ComputeAggregateKernel");
+	kernel_metrics->rows_in.add(100);
+	auto cache_metrics = registry.registerCache(1, 900000000);
+	cache_metrics->spill_bytes_host.add(4096);
+	registry.getNetworkMetrics(1, "ColumnDataPartitionMessage_3_0")->bytes_sent.add(512);
+	EXPECT_EQ(registry.getNetworkMetrics(1, "ColumnDataPartitionMessage_3_1")->bytes_sent.get(), 512);
+
+	auto samples = registry.snapshot();
+	ASSERT_EQ(samples.size(), 3);
+	EXPECT_EQ(samples[0].scope, "kernel");
+	EXPECT_EQ(samples[0].name, "ComputeAggregateKernel");
+	EXPECT_EQ(samples[0].values["rows_in"], 100);
+	EXPECT_EQ(samples[1].scope, "cache");
+	EXPECT_EQ(samples[1].values["spill_bytes_host"], 4096);
+	EXPECT_EQ(samples[2].scope, "network");
+	EXPECT_EQ(samples[2].name, "ColumnDataPartitionMessage");
+	EXPECT_EQ(samples[2].id, 3);
+	EXPECT_EQ(samples[2].values["bytes_sent"], 512);
+}
+
+TEST(MetricsTest, OnlyTheMostRecentQueriesAreKept) {
+	auto & registry = MetricsRegistry::getInstance();
+	registry.clear();
+
+	for (int32_t query_id = 0; query_id < (int32_t) MetricsRegistry::MAX_QUERIES + 2; ++query_id) {
+		registry.registerKernel(query_id, 0, "TableScan");
+	}
+	auto samples = registry.snapshot();
+	ASSERT_EQ(samples.size(), MetricsRegistry::MAX_QUERIES);
+	EXPECT_EQ(samples.front().query_id, 2);
+}
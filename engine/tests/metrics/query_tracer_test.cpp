@@ -0,0 +1,68 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "utilities/QueryTracer.h"
+
+using ral::utilities::QueryTracer;
+using ral::utilities::TraceSpan;
+
+namespace {
+
+std::string read_file(const std::string & path) {
+	std::ifstream file(path);
+	std::stringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+}  // namespace
+
+TEST(QueryTracerTest, NothingIsRecordedWhileNoQueryIsTraced) {
+	auto & tracer = QueryTracer::getInstance();
+	EXPECT_FALSE(tracer.is_enabled());
+	{
+		TraceSpan span(1, "kernel", "run TableScan 0");
+	}
+	tracer.startQuery(1);
+	EXPECT_TRUE(tracer.is_enabled());
+	const std::string path = "query_tracer_test_empty.json";
+	ASSERT_TRUE(tracer.finishQuery(1, 0, path));
+	EXPECT_FALSE(tracer.is_enabled());
+	EXPECT_EQ(read_file(path).find("TableScan"), std::string::npos);
+	std::remove(path.c_str());
+}
+
+TEST(QueryTracerTest, WritesTheEventsOfTheQueryFromEveryThread) {
+	auto & tracer = QueryTracer::getInstance();
+	tracer.startQuery(7);
+	tracer.startQuery(8);
+	{
+		TraceSpan span(7, "kernel", "run \"Projection\" 2");
+		span.set_arg("rows", 100);
+	}
+	std::thread other_thread([]() {
+		TraceSpan span(7, "network", "send ColumnDataMessage_2_0");
+		TraceSpan other_query_span(8, "kernel", "run Filter 5");
+	});
+	other_thread.join();
+	tracer.record(QueryTracer::ANY_QUERY, "network", "PinnedBufferProvider wait", QueryTracer::now_us(), QueryTracer::now_us());
+
+	const std::string path = "query_tracer_test.json";
+	ASSERT_TRUE(tracer.finishQuery(7, 3, path));
+	std::string trace = read_file(path);
+	EXPECT_NE(trace.find("\"name\":\"run \\\"Projection\\\" 2\""), std::string::npos);
+	EXPECT_NE(trace.find("\"args\":{\"rows\":100}"), std::string::npos);
+	EXPECT_NE(trace.find("send ColumnDataMessage_2_0"), std::string::npos);
+	EXPECT_NE(trace.find("PinnedBufferProvider wait"), std::string::npos);
+	EXPECT_NE(trace.find("\"pid\":3"), std::string::npos);
+	EXPECT_EQ(trace.find("run Filter 5"), std::string::npos);
+	std::remove(path.c_str());
+
+	ASSERT_TRUE(tracer.finishQuery(8, 3, path));
+	EXPECT_NE(read_file(path).find("run Filter 5"), std::string::npos);
+	std::remove(path.c_str());
+	EXPECT_FALSE(tracer.finishQuery(8, 3, path));
+}
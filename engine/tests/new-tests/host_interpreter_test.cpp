@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "Interpreter/interpreter_host.h"
+
+using namespace interops;
+
+namespace {
+
+/**
+ * Keeps the buffers of the host columns of a test alive.
+ */
+struct host_table_builder {
+	std::vector<std::shared_ptr<void>> buffers;
+
+	template <typename T>
+	host_column input(cudf::type_id type, const std::vector<T> & values, const std::vector<bool> & valids = {}) {
+		// not a vector, as vector<bool> has no data()
+		std::shared_ptr<T> data(new T[values.size()], std::default_delete<T[]>());
+		std::copy(values.begin(), values.end(), data.get());
+		buffers.push_back(data);
+		host_column column;
+		column.type = cudf::data_type{type};
+		column.size = values.size();
+		column.data = data.get();
+		column.null_mask = valids.empty() ? nullptr : make_null_mask(valids);
+		return column;
+	}
+
+	host_column strings(const std::vector<std::string> & values) {
+		auto chars = std::make_shared<std::string>();
+		auto offsets = std::make_shared<std::vector<int32_t>>(1, 0);
+		for (auto & value : values) {
+			*chars += value;
+			offsets->push_back(chars->size());
+		}
+		buffers.push_back(chars);
+		buffers.push_back(offsets);
+		host_column column;
+		column.type = cudf::data_type{cudf::type_id::STRING};
+		column.size = values.size();
+		column.data = chars->data();
+		column.offsets = offsets->data();
+		return column;
+	}
+
+	template <typename T>
+	mutable_host_column output(cudf::type_id type, cudf::size_type size) {
+		std::shared_ptr<T> data(new T[size](), std::default_delete<T[]>());
+		auto mask = std::make_shared<std::vector<cudf::bitmask_type>>((size + 31) / 32);
+		buffers.push_back(data);
+		buffers.push_back(mask);
+		mutable_host_column column;
+		column.type = cudf::data_type{type};
+		column.size = size;
+		column.data = data.get();
+		column.null_mask = mask->data();
+		return column;
+	}
+
+	cudf::bitmask_type * make_null_mask(const std::vector<bool> & valids) {
+		auto mask = std::make_shared<std::vector<cudf::bitmask_type>>((valids.size() + 31) / 32, 0);
+		buffers.push_back(mask);
+		for (size_t i = 0; i < valids.size(); i++) {
+			(*mask)[i / 32] |= static_cast<cudf::bitmask_type>(valids[i]) << (i % 32);
+		}
+		return mask->data();
+	}
+};
+
+template <typename T>
+T value_at(const mutable_host_column & column, cudf::size_type row) {
+	return static_cast<const T *>(column.data)[row];
+}
+
+bool is_valid(const mutable_host_column & column, cudf::size_type row) {
+	return (column.null_mask[row / 32] >> (row % 32)) & 1u;
+}
+
+host_scalar int_scalar(int64_t value) {
+	host_scalar scalar;
+	scalar.type = cudf::data_type{cudf::type_id::INT64};
+	scalar.valid = true;
+	scalar.int_value = value;
+	return scalar;
+}
+
+} // namespace
+
+TEST(HostInterpreterTest, ArithmeticOverManyChunksAndThreads) {
+	// ($0 + 5) * $1, over several chunks with a partial last one and nulls in $0
+	const cudf::size_type num_rows = 3 * HOST_INTERPRETER_CHUNK_SIZE + 17;
+	std::vector<int32_t> a(num_rows);
+	std::vector<double> b(num_rows);
+	std::vector<bool> a_valids(num_rows);
+	for (cudf::size_type i = 0; i < num_rows; i++) {
+		a[i] = i;
+		b[i] = 0.5 * (i % 7);
+		a_valids[i] = i % 5 != 0;
+	}
+
+	host_table_builder builder;
+	std::vector<host_column> table = {builder.input(cudf::type_id::INT32, a, a_valids), builder.input(cudf::type_id::FLOAT64, b)};
+
+	for (int num_threads : {1, 4}) {
+		std::vector<mutable_host_column> out_table = {builder.output<double>(cudf::type_id::FLOAT64, num_rows)};
+		perform_host_interpreter_operation(out_table, table,
+			{0, 2}, {SCALAR_INDEX, 1}, {2, 2}, {2},
+			{operator_type::BLZ_ADD, operator_type::BLZ_MUL},
+			{host_scalar{}, host_scalar{}}, {int_scalar(5), host_scalar{}}, {}, num_threads);
+
+		for (cudf::size_type i = 0; i < num_rows; i++) {
+			ASSERT_EQ(is_valid(out_table[0], i), i % 5 != 0) << "row " << i;
+			if (i % 5 != 0) {
+				ASSERT_DOUBLE_EQ(value_at<double>(out_table[0], i), (a[i] + 5) * b[i]) << "row " << i;
+			}
+		}
+	}
+}
+
+TEST(HostInterpreterTest, DivisionByZeroIsNull) {
+	host_table_builder builder;
+	std::vector<host_column> table = {builder.input<int64_t>(cudf::type_id::INT64, {7, -9, 4, 5}),
+		builder.input<int64_t>(cudf::type_id::INT64, {2, 0, -1, 5})};
+	std::vector<mutable_host_column> out_table = {builder.output<int64_t>(cudf::type_id::INT64, 4)};
+
+	perform_host_interpreter_operation(out_table, table,
+		{0}, {1}, {2}, {2}, {operator_type::BLZ_DIV}, {host_scalar{}}, {host_scalar{}});
+
+	EXPECT_EQ(value_at<int64_t>(out_table[0], 0), 3);
+	EXPECT_FALSE(is_valid(out_table[0], 1));
+	EXPECT_EQ(value_at<int64_t>(out_table[0], 2), -4);
+	EXPECT_EQ(value_at<int64_t>(out_table[0], 3), 1);
+}
+
+TEST(HostInterpreterTest, WritesOutputsAfterTheirOperationWhenRegistersAreReused) {
+	// output columns $0 + 1, $0 * 3 and $0 - 2, allocated so the first two share a register
+	std::vector<column_index_type> left_inputs = {0, 0, 0};
+	std::vector<column_index_type> right_inputs = {SCALAR_INDEX, SCALAR_INDEX, SCALAR_INDEX};
+	std::vector<column_index_type> outputs = {1, 2, 3};
+	std::vector<column_index_type> final_output_positions;
+	std::vector<column_index_type> final_output_ops;
+	allocate_registers(1, left_inputs, right_inputs, outputs, {1, 2, 3}, final_output_positions, final_output_ops);
+	ASSERT_EQ(final_output_positions[0], final_output_positions[1]);
+
+	host_table_builder builder;
+	std::vector<host_column> table = {builder.input<int16_t>(cudf::type_id::INT16, {1, 2, 3})};
+	std::vector<mutable_host_column> out_table = {builder.output<int64_t>(cudf::type_id::INT64, 3),
+		builder.output<int64_t>(cudf::type_id::INT64, 3), builder.output<int64_t>(cudf::type_id::INT64, 3)};
+
+	perform_host_interpreter_operation(out_table, table, left_inputs, right_inputs, outputs, final_output_positions,
+		{operator_type::BLZ_ADD, operator_type::BLZ_MUL, operator_type::BLZ_SUB}, std::vector<host_scalar>(3),
+		{int_scalar(1), int_scalar(3), int_scalar(2)}, final_output_ops);
+
+	for (cudf::size_type i = 0; i < 3; i++) {
+		EXPECT_EQ(value_at<int64_t>(out_table[0], i), i + 2);
+		EXPECT_EQ(value_at<int64_t>(out_table[1], i), 3 * (i + 1));
+		EXPECT_EQ(value_at<int64_t>(out_table[2], i), i - 1);
+	}
+}
+
+TEST(HostInterpreterTest, CaseWithMagicNumbers) {
+	// CASE WHEN $0 > 2 THEN $1 ELSE 0 END
+	host_table_builder builder;
+	std::vector<host_column> table = {builder.input<int32_t>(cudf::type_id::INT32, {1, 3, 5, 0}, {true, true, true, false}),
+		builder.input<int64_t>(cudf::type_id::INT64, {10, 20, 30, 40}, {true, true, false, true})};
+	std::vector<mutable_host_column> out_table = {builder.output<int64_t>(cudf::type_id::INT64, 4)};
+
+	perform_host_interpreter_operation(out_table, table,
+		{0, 2, 2}, {SCALAR_INDEX, 1, SCALAR_INDEX}, {2, 2, 2}, {2},
+		{operator_type::BLZ_GREATER, operator_type::BLZ_MAGIC_IF_NOT, operator_type::BLZ_FIRST_NON_MAGIC},
+		{host_scalar{}, host_scalar{}, host_scalar{}}, {int_scalar(2), host_scalar{}, int_scalar(0)});
+
+	EXPECT_EQ(value_at<int64_t>(out_table[0], 0), 0);
+	EXPECT_EQ(value_at<int64_t>(out_table[0], 1), 20);
+	EXPECT_FALSE(is_valid(out_table[0], 2));
+	EXPECT_TRUE(is_valid(out_table[0], 3));
+	EXPECT_EQ(value_at<int64_t>(out_table[0], 3), 0);
+}
+
+TEST(HostInterpreterTest, LogicalOrWithNulls) {
+	host_table_builder builder;
+	std::vector<host_column> table = {builder.input<bool>(cudf::type_id::BOOL8, {true, false, false, true}, {true, true, false, false}),
+		builder.input<bool>(cudf::type_id::BOOL8, {false, false, true, false}, {false, true, true, false})};
+	std::vector<mutable_host_column> out_table = {builder.output<bool>(cudf::type_id::BOOL8, 4)};
+
+	perform_host_interpreter_operation(out_table, table,
+		{0}, {1}, {2}, {2}, {operator_type::BLZ_LOGICAL_OR}, {host_scalar{}}, {host_scalar{}});
+
+	// true OR null is true, null OR null is null
+	EXPECT_TRUE(is_valid(out_table[0], 0));
+	EXPECT_TRUE(value_at<bool>(out_table[0], 0));
+	EXPECT_TRUE(is_valid(out_table[0], 1));
+	EXPECT_FALSE(value_at<bool>(out_table[0], 1));
+	EXPECT_TRUE(is_valid(out_table[0], 2));
+	EXPECT_TRUE(value_at<bool>(out_table[0], 2));
+	EXPECT_FALSE(is_valid(out_table[0], 3));
+}
+
+TEST(HostInterpreterTest, StringsAndDates) {
+	// $0 < 'bb', YEAR($1), MONTH($1), DAY($1)
+	host_table_builder builder;
+	std::vector<host_column> table = {builder.strings({"a", "bb", "bba", "c"}),
+		builder.input<int64_t>(cudf::type_id::TIMESTAMP_MILLISECONDS, {0, 951782400000ll, -86400000ll, 1609459199999ll})};
+	std::vector<mutable_host_column> out_table = {builder.output<bool>(cudf::type_id::BOOL8, 4),
+		builder.output<int16_t>(cudf::type_id::INT16, 4), builder.output<int16_t>(cudf::type_id::INT16, 4),
+		builder.output<int16_t>(cudf::type_id::INT16, 4)};
+
+	host_scalar bb;
+	bb.type = cudf::data_type{cudf::type_id::STRING};
+	bb.valid = true;
+	bb.str = "bb";
+	perform_host_interpreter_operation(out_table, table,
+		{0, 1, 1, 1}, {SCALAR_INDEX, UNARY_INDEX, UNARY_INDEX, UNARY_INDEX}, {2, 3, 4, 5}, {2, 3, 4, 5},
+		{operator_type::BLZ_LESS, operator_type::BLZ_YEAR, operator_type::BLZ_MONTH, operator_type::BLZ_DAY},
+		std::vector<host_scalar>(4), {bb, host_scalar{}, host_scalar{}, host_scalar{}});
+
+	std::vector<bool> less = {true, false, false, false};
+	std::vector<int16_t> years = {1970, 2000, 1969, 2020};
+	std::vector<int16_t> months = {1, 2, 12, 12};
+	std::vector<int16_t> days = {1, 29, 31, 31};
+	for (cudf::size_type i = 0; i < 4; i++) {
+		EXPECT_EQ(value_at<bool>(out_table[0], i), less[i]);
+		EXPECT_EQ(value_at<int16_t>(out_table[1], i), years[i]);
+		EXPECT_EQ(value_at<int16_t>(out_table[2], i), months[i]);
+		EXPECT_EQ(value_at<int16_t>(out_table[3], i), days[i]);
+	}
+}
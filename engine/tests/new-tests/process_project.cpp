@@ -5,6 +5,7 @@
 #include "cudf_test/type_lists.hpp"
 
 #include "execution_graph/logic_controllers/LogicalProject.h"
+#include "execution_graph/logic_controllers/ExpressionPlanCache.h"
 
 #include <execution_graph/logic_controllers/LogicPrimitives.h>
 #include "tests/utilities/BlazingUnitTest.h"
@@ -470,3 +471,98 @@ TYPED_TEST(ProjectRoundTest, test_round)
 
     cudf::test::expect_tables_equal(expect_cudf_table_view, out_table->view());
 }
+
+struct ProjectPlanCacheTest : public BlazingUnitTest {
+    void SetUp() override {
+        ral::processor::expression_plan_cache::getInstance().clear();
+    }
+};
+
+TEST_F(ProjectPlanCacheTest, test_compiled_plan_reused_across_batches)
+{
+    std::string query_part = "LogicalProject(A=[$0], EXPR$1=[+($0, $1)], EXPR$2=[10], EXPR$3=[*($1, 2)])";
+
+    for (int batch = 0; batch < 3; batch++) {
+        cudf::test::fixed_width_column_wrapper<int32_t> col1{{1 + batch, 2, 3}};
+        cudf::test::fixed_width_column_wrapper<int32_t> col2{{10, 20 + batch, 30}};
+
+        CudfTableView in_table_view {{col1, col2}};
+        std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+        std::vector<std::string> names({"A", "B"});
+        std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+        auto out_table = ral::processor::process_project(std::move(table), query_part, nullptr);
+
+        cudf::test::fixed_width_column_wrapper<int32_t> expect_col1{{1 + batch, 2, 3}};
+        cudf::test::fixed_width_column_wrapper<int32_t> expect_col2{{11 + batch, 22 + batch, 33}};
+        cudf::test::fixed_width_column_wrapper<int8_t> expect_col3{{10, 10, 10}};
+        cudf::test::fixed_width_column_wrapper<int32_t> expect_col4{{20, 40 + 2 * batch, 60}};
+
+        cudf::test::expect_columns_equivalent(expect_col1, out_table->view().column(0));
+        cudf::test::expect_columns_equivalent(expect_col2, out_table->view().column(1));
+        cudf::test::expect_columns_equivalent(expect_col3, out_table->view().column(2));
+        cudf::test::expect_columns_equivalent(expect_col4, out_table->view().column(3));
+        EXPECT_EQ(ral::processor::expression_plan_cache::getInstance().size(), 1);
+    }
+}
+
+TEST_F(ProjectPlanCacheTest, test_plan_depends_on_input_types)
+{
+    std::string query_part = "LogicalProject(EXPR$0=[+($0, 1)])";
+
+    cudf::test::fixed_width_column_wrapper<int32_t> int_col{{1, 2, 3}};
+    CudfTableView int_table_view {{int_col}};
+    auto int_out = ral::processor::process_project(
+        std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(int_table_view), std::vector<std::string>{"A"}), query_part, nullptr);
+
+    cudf::test::fixed_width_column_wrapper<double> double_col{{1.5, 2.5, 3.5}};
+    CudfTableView double_table_view {{double_col}};
+    auto double_out = ral::processor::process_project(
+        std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(double_table_view), std::vector<std::string>{"A"}), query_part, nullptr);
+
+    EXPECT_EQ(ral::processor::expression_plan_cache::getInstance().size(), 2);
+    cudf::test::fixed_width_column_wrapper<double> expect_double_col{{2.5, 3.5, 4.5}};
+    cudf::test::expect_columns_equivalent(expect_double_col, double_out->view().column(0));
+}
+
+TEST_F(ProjectPlanCacheTest, test_string_functions_evaluated_for_every_batch)
+{
+    std::string query_part = "LogicalProject(EXPR$0=[SUBSTRING($0, 1, 2)])";
+
+    std::vector<std::vector<std::string>> batches = {{"hello", "world"}, {"foo", "bar"}};
+    std::vector<std::vector<std::string>> expected = {{"he", "wo"}, {"fo", "ba"}};
+    for (size_t batch = 0; batch < batches.size(); batch++) {
+        cudf::test::strings_column_wrapper col1(batches[batch].begin(), batches[batch].end());
+        CudfTableView in_table_view {{col1}};
+        auto out_table = ral::processor::process_project(
+            std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(in_table_view), std::vector<std::string>{"A"}), query_part, nullptr);
+
+        cudf::test::strings_column_wrapper expect_col1(expected[batch].begin(), expected[batch].end());
+        cudf::test::expect_columns_equal(expect_col1, out_table->view().column(0));
+    }
+    EXPECT_EQ(ral::processor::expression_plan_cache::getInstance().size(), 1);
+}
+
+TEST_F(ProjectPlanCacheTest, test_wide_projection_with_common_subexpressions)
+{
+    // 120 derived columns that all share +($0, $1), too many for one register per column
+    const int num_expressions = 120;
+    std::string query_part = "LogicalProject(";
+    for (int i = 0; i < num_expressions; i++) {
+        query_part += (i > 0 ? ", " : "") + std::string("EXPR$") + std::to_string(i) + "=[*(+($0, $1), " + std::to_string(i) + ")]";
+    }
+    query_part += ")";
+
+    cudf::test::fixed_width_column_wrapper<int32_t> col1{{1, 2, 3}};
+    cudf::test::fixed_width_column_wrapper<int32_t> col2{{10, 20, 30}};
+    CudfTableView in_table_view {{col1, col2}};
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(in_table_view), std::vector<std::string>{"A", "B"});
+
+    auto out_table = ral::processor::process_project(std::move(table), query_part, nullptr);
+
+    ASSERT_EQ(out_table->num_columns(), num_expressions);
+    for (int i = 0; i < num_expressions; i++) {
+        cudf::test::fixed_width_column_wrapper<int32_t> expect_col{{11 * i, 22 * i, 33 * i}};
+        cudf::test::expect_columns_equivalent(expect_col, out_table->view().column(i));
+    }
+}
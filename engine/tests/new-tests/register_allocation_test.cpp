@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Interpreter/register_allocation.h"
+
+using namespace interops;
+
+namespace {
+
+const column_index_type SCALAR = -2;
+const column_index_type UNARY = -1;
+
+/**
+ * Runs an allocated plan where every operation adds its inputs (scalars are 1) and returns the value of every output
+ * column, read right after the operation it is written after.
+ */
+std::vector<int64_t> run_plan(const std::vector<int64_t> & input_values,
+	column_index_type num_registers,
+	const std::vector<column_index_type> & left_inputs,
+	const std::vector<column_index_type> & right_inputs,
+	const std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_output_positions,
+	const std::vector<column_index_type> & final_output_ops) {
+	std::vector<int64_t> registers(num_registers, -1);
+	std::copy(input_values.begin(), input_values.end(), registers.begin());
+
+	std::vector<int64_t> results(final_output_positions.size(), -1);
+	for (size_t op = 0; op < outputs.size(); op++) {
+		int64_t left = left_inputs[op] >= 0 ? registers.at(left_inputs[op]) : 1;
+		int64_t right = right_inputs[op] >= 0 ? registers.at(right_inputs[op]) : (right_inputs[op] == UNARY ? 0 : 1);
+		registers.at(outputs[op]) = left + right;
+		for (size_t i = 0; i < final_output_positions.size(); i++) {
+			if (final_output_ops[i] == static_cast<column_index_type>(op)) {
+				results[i] = registers.at(final_output_positions[i]);
+			}
+		}
+	}
+	return results;
+}
+
+} // namespace
+
+TEST(RegisterAllocationTest, ReusesRegistersOfDeadValues) {
+	// 2 inputs, then a chain: v2 = $0 + $1, v3 = v2 + 1, v4 = v3 + 1, v5 = v4 + $0
+	std::vector<column_index_type> left_inputs = {0, 2, 3, 4};
+	std::vector<column_index_type> right_inputs = {1, SCALAR, SCALAR, 0};
+	std::vector<column_index_type> outputs = {2, 3, 4, 5};
+	std::vector<column_index_type> final_output_positions;
+	std::vector<column_index_type> final_output_ops;
+
+	column_index_type num_registers = allocate_registers(2, left_inputs, right_inputs, outputs, {5}, final_output_positions, final_output_ops);
+
+	// $1 is dead after the first operation, so the chain never needs a third register
+	EXPECT_EQ(num_registers, 2);
+	EXPECT_EQ(final_output_ops, std::vector<column_index_type>({3}));
+
+	auto results = run_plan({10, 20}, num_registers, left_inputs, right_inputs, outputs, final_output_positions, final_output_ops);
+	EXPECT_EQ(results, std::vector<int64_t>({10 + 20 + 1 + 1 + 10}));
+}
+
+TEST(RegisterAllocationTest, WideProjectionFitsInFewRegisters) {
+	// 200 output columns, each one ($0 + $1) + 1 computed separately, which used to need one register per column
+	const int num_columns = 200;
+	std::vector<column_index_type> left_inputs;
+	std::vector<column_index_type> right_inputs;
+	std::vector<column_index_type> outputs;
+	std::vector<column_index_type> final_outputs;
+	column_index_type next_value = 2;
+	for (int i = 0; i < num_columns; i++) {
+		left_inputs.push_back(0);
+		right_inputs.push_back(1);
+		outputs.push_back(next_value++);
+		left_inputs.push_back(next_value - 1);
+		right_inputs.push_back(SCALAR);
+		outputs.push_back(next_value++);
+		final_outputs.push_back(next_value - 1);
+	}
+	std::vector<column_index_type> final_output_positions;
+	std::vector<column_index_type> final_output_ops;
+
+	column_index_type num_registers = allocate_registers(2, left_inputs, right_inputs, outputs, final_outputs, final_output_positions, final_output_ops);
+
+	EXPECT_LE(num_registers, 4);
+	auto results = run_plan({3, 4}, num_registers, left_inputs, right_inputs, outputs, final_output_positions, final_output_ops);
+	for (int i = 0; i < num_columns; i++) {
+		EXPECT_EQ(results[i], 3 + 4 + 1);
+		EXPECT_EQ(final_output_ops[i], 2 * i + 1);
+	}
+}
+
+TEST(RegisterAllocationTest, KeepsValuesUsedByLaterOperations) {
+	// v2 = $0 + 1 is an output column and is used by the last operation, v3 = $0 + $0, v4 = v3 + v2
+	std::vector<column_index_type> left_inputs = {0, 0, 3};
+	std::vector<column_index_type> right_inputs = {SCALAR, 0, 2};
+	std::vector<column_index_type> outputs = {2, 3, 4};
+	std::vector<column_index_type> final_output_positions;
+	std::vector<column_index_type> final_output_ops;
+
+	column_index_type num_registers = allocate_registers(1, left_inputs, right_inputs, outputs, {2, 4, 2}, final_output_positions, final_output_ops);
+
+	EXPECT_EQ(final_output_ops, std::vector<column_index_type>({0, 2, 0}));
+	EXPECT_EQ(final_output_positions[0], final_output_positions[2]);
+	auto results = run_plan({5}, num_registers, left_inputs, right_inputs, outputs, final_output_positions, final_output_ops);
+	EXPECT_EQ(results, std::vector<int64_t>({6, 16, 6}));
+}
+
+TEST(RegisterAllocationTest, UnusedInputRegistersAreFree) {
+	// $0 and $1 are never read, v3 = $2 + 1
+	std::vector<column_index_type> left_inputs = {2};
+	std::vector<column_index_type> right_inputs = {SCALAR};
+	std::vector<column_index_type> outputs = {3};
+	std::vector<column_index_type> final_output_positions;
+	std::vector<column_index_type> final_output_ops;
+
+	column_index_type num_registers = allocate_registers(3, left_inputs, right_inputs, outputs, {3}, final_output_positions, final_output_ops);
+
+	EXPECT_EQ(num_registers, 3);
+	EXPECT_EQ(outputs[0], 0);
+	EXPECT_EQ(left_inputs[0], 2);
+}
+
+TEST(RegisterAllocationTest, RejectsRegistersWrittenTwice) {
+	std::vector<column_index_type> left_inputs = {0, 0};
+	std::vector<column_index_type> right_inputs = {SCALAR, SCALAR};
+	std::vector<column_index_type> outputs = {1, 1};
+	std::vector<column_index_type> final_output_positions;
+	std::vector<column_index_type> final_output_ops;
+
+	EXPECT_THROW(allocate_registers(1, left_inputs, right_inputs, outputs, {1}, final_output_positions, final_output_ops), std::runtime_error);
+}
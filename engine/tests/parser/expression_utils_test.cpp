@@ -1,4 +1,5 @@
 #include "parser/expression_tree.hpp"
+#include "parser/expression_utils.hpp"
 #include <gtest/gtest.h>
 #include <iostream>
 
@@ -19,3 +20,16 @@ TEST_F(ExpressionUtilsTest, count_star_case) {
 
 	EXPECT_EQ(result, expected);
 }
+
+TEST_F(ExpressionUtilsTest, get_column_references) {
+	EXPECT_EQ(get_column_references(">(+($3, $1), $3)"), std::vector<int>({1, 3}));
+	EXPECT_EQ(get_column_references("AND(=($12, 'a$0'), LIKE($2, \"$5%\"))"), std::vector<int>({2, 12}));
+	EXPECT_EQ(get_column_references(">(5, 3)"), std::vector<int>());
+}
+
+TEST_F(ExpressionUtilsTest, remap_column_references) {
+	std::map<int, int> new_indices = {{1, 0}, {3, 1}, {12, 2}};
+
+	EXPECT_EQ(remap_column_references("AND(>($3, 5), =($1, 'a$3'))", new_indices), "AND(>($1, 5), =($0, 'a$3'))");
+	EXPECT_EQ(remap_column_references("=($12, 'it\\'s $1')", new_indices), "=($2, 'it\\'s $1')");
+}
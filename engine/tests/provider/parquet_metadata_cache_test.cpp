@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <fstream>
+#include "tests/utilities/BlazingUnitTest.h"
+#include "io/data_parser/metadata/parquet_metadata_cache.h"
+#include "FileSystem/LocalFileSystem.h"
+#include "Util/StringUtil.h"
+
+using ral::io::parquet_file_metadata;
+using ral::io::parquet_metadata_cache;
+
+struct ParquetMetadataCacheTest : public BlazingUnitTest {
+	void SetUp() override {
+		BlazingUnitTest::SetUp();
+		parquet_metadata_cache::getInstance().initialize(10000, "");
+		parquet_metadata_cache::getInstance().clear();
+	}
+
+	void TearDown() override {
+		parquet_metadata_cache::getInstance().initialize(10000, "");
+		parquet_metadata_cache::getInstance().clear();
+		BlazingUnitTest::TearDown();
+	}
+};
+
+std::shared_ptr<parquet_file_metadata> make_file_metadata(int num_row_groups) {
+	auto metadata = std::make_shared<parquet_file_metadata>();
+	metadata->num_rows = num_row_groups * 100;
+	metadata->num_row_groups = num_row_groups;
+	metadata->column_names = {"a", "b"};
+	metadata->physical_types = {2, 6};
+	metadata->converted_types = {0, 0};
+	metadata->row_group_byte_sizes = std::vector<int64_t>(num_row_groups, 4096);
+	metadata->row_group_num_rows = std::vector<int64_t>(num_row_groups, 1000);
+	metadata->column_chunk_sizes = {std::vector<int64_t>(num_row_groups, 800), std::vector<int64_t>(num_row_groups, 3000)};
+	metadata->stats_set = {std::vector<char>(num_row_groups, 1), std::vector<char>(num_row_groups, 1)};
+	metadata->min_values = {std::vector<int64_t>(num_row_groups, -5), {}};
+	metadata->max_values = {std::vector<int64_t>(num_row_groups, 5), {}};
+	metadata->min_strings = {{}, std::vector<std::string>(num_row_groups, "aa")};
+	metadata->max_strings = {{}, std::vector<std::string>(num_row_groups, "zz")};
+	metadata->value_filters = {{}, std::vector<std::string>(num_row_groups, std::string("\x00\x01\xff", 3))};
+	metadata->value_filter_max_bytes = 1024;
+	return metadata;
+}
+
+TEST_F(ParquetMetadataCacheTest, get_and_put) {
+	auto & cache = parquet_metadata_cache::getInstance();
+	EXPECT_EQ(cache.get("/tmp/a.parquet|10|1"), nullptr);
+
+	cache.put("/tmp/a.parquet|10|1", make_file_metadata(3));
+	auto metadata = cache.get("/tmp/a.parquet|10|1");
+	ASSERT_NE(metadata, nullptr);
+	EXPECT_EQ(metadata->num_row_groups, 3);
+
+	// a rewritten file has another key
+	EXPECT_EQ(cache.get("/tmp/a.parquet|10|2"), nullptr);
+}
+
+TEST_F(ParquetMetadataCacheTest, evicts_least_recently_used) {
+	auto & cache = parquet_metadata_cache::getInstance();
+	cache.initialize(2, "");
+
+	cache.put("first", make_file_metadata(1));
+	cache.put("second", make_file_metadata(2));
+	EXPECT_NE(cache.get("first"), nullptr);
+	cache.put("third", make_file_metadata(3));
+
+	EXPECT_EQ(cache.size(), 2);
+	EXPECT_NE(cache.get("first"), nullptr);
+	EXPECT_EQ(cache.get("second"), nullptr);
+	EXPECT_NE(cache.get("third"), nullptr);
+}
+
+TEST_F(ParquetMetadataCacheTest, disabled) {
+	auto & cache = parquet_metadata_cache::getInstance();
+	cache.initialize(0, "");
+
+	cache.put("first", make_file_metadata(1));
+	EXPECT_EQ(cache.size(), 0);
+	EXPECT_EQ(cache.get("first"), nullptr);
+	EXPECT_EQ(cache.get_key(Uri{"/tmp"}), "");
+}
+
+TEST_F(ParquetMetadataCacheTest, persisted_entries) {
+	std::unique_ptr<LocalFileSystem> localFileSystem(new LocalFileSystem(Path("/")));
+	std::string directory = "/tmp/" + randomString(10);
+	ASSERT_TRUE(localFileSystem->makeDirectory(Uri{directory}));
+
+	auto & cache = parquet_metadata_cache::getInstance();
+	cache.initialize(10000, directory);
+
+	auto metadata = make_file_metadata(4);
+	metadata->has_cudf_schema = true;
+	metadata->cudf_column_names = {"a", "b"};
+	metadata->cudf_column_types = {cudf::type_id::INT64, cudf::type_id::FLOAT64};
+	cache.put("/data/a.parquet|1000|1600000000000", metadata);
+
+	// as if the engine was restarted
+	cache.clear();
+	auto persisted = cache.get("/data/a.parquet|1000|1600000000000");
+	ASSERT_NE(persisted, nullptr);
+	EXPECT_EQ(persisted->num_rows, 400);
+	EXPECT_EQ(persisted->num_row_groups, 4);
+	EXPECT_EQ(persisted->column_names, metadata->column_names);
+	EXPECT_EQ(persisted->physical_types, metadata->physical_types);
+	EXPECT_EQ(persisted->row_group_byte_sizes, metadata->row_group_byte_sizes);
+	EXPECT_EQ(persisted->row_group_num_rows, metadata->row_group_num_rows);
+	EXPECT_EQ(persisted->column_chunk_sizes, metadata->column_chunk_sizes);
+	EXPECT_EQ(persisted->stats_set, metadata->stats_set);
+	EXPECT_EQ(persisted->min_values, metadata->min_values);
+	EXPECT_EQ(persisted->max_values, metadata->max_values);
+	EXPECT_EQ(persisted->min_strings, metadata->min_strings);
+	EXPECT_EQ(persisted->max_strings, metadata->max_strings);
+	EXPECT_EQ(persisted->value_filters, metadata->value_filters);
+	EXPECT_EQ(persisted->value_filter_max_bytes, 1024u);
+	EXPECT_TRUE(persisted->has_cudf_schema);
+	EXPECT_EQ(persisted->cudf_column_names, metadata->cudf_column_names);
+	EXPECT_EQ(persisted->cudf_column_types, metadata->cudf_column_types);
+
+	EXPECT_EQ(cache.get("/data/a.parquet|1000|1600000000001"), nullptr);
+
+	cache.initialize(10000, "");
+	for (auto & file_uri : localFileSystem->list(Uri{directory})) {
+		localFileSystem->remove(file_uri);
+	}
+	localFileSystem->remove(Uri{directory});
+}
@@ -227,3 +227,28 @@ TEST_F(ExpressionTreeTest, drop_test3) {
     EXPECT_EQ(solution, expected);
 
 }
+
+TEST_F(ExpressionTreeTest, value_filter_test1) {
+  // $0 has value filters, so the mask of its row groups that may have 'abc' is added after the min and max columns
+  ral::parser::parse_tree tree;
+  tree.build("AND(=($0, 'abc'), =($1, 7))");
+  ral::skip_data::apply_value_filters(tree, [](int column, const std::string & value) {
+    EXPECT_EQ(value, column == 0 ? "abc" : "7");
+    return column == 0 ? 4 : -1;
+  });
+  ral::skip_data::apply_skip_data_rules(tree);
+  EXPECT_EQ(tree.prefix(), "AND AND AND <= $0 'abc' >= $1 'abc' $4 AND <= $2 7 >= $3 7");
+}
+
+TEST_F(ExpressionTreeTest, value_filter_test2) {
+  // an IN over a column with value filters but without min and max
+  ral::parser::parse_tree tree;
+  tree.build("OR(=($0, 'a'), =('b', $0))");
+  int next_mask = 2;
+  ral::skip_data::apply_value_filters(tree, [&next_mask](int, const std::string &) {
+    return next_mask++;
+  });
+  ral::skip_data::drop_value(tree, "$0");
+  ral::skip_data::apply_skip_data_rules(tree);
+  EXPECT_EQ(tree.prefix(), "OR $2 $3");
+}
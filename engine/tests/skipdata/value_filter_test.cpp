@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include "skip_data/value_filter.hpp"
+
+using namespace ral::skip_data;
+
+TEST(ValueFilterTest, has_no_false_negatives) {
+  std::vector<uint64_t> hashes;
+  for (int i = 0; i < 1000; i++) {
+    hashes.push_back(hash_value("customer#" + std::to_string(i)));
+  }
+  std::string filter = make_value_filter(hashes, 4096);
+  ASSERT_FALSE(filter.empty());
+  EXPECT_LE(filter.size(), 4096u);
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(value_filter_may_contain(filter, hash_value("customer#" + std::to_string(i))));
+  }
+
+  int false_positives = 0;
+  for (int i = 1000; i < 11000; i++) {
+    false_positives += value_filter_may_contain(filter, hash_value("customer#" + std::to_string(i)));
+  }
+  EXPECT_LT(false_positives, 500);
+}
+
+TEST(ValueFilterTest, too_many_values) {
+  std::vector<uint64_t> hashes;
+  for (int i = 0; i < 1000; i++) {
+    hashes.push_back(hash_value(std::to_string(i)));
+  }
+  // less than four bits per value
+  std::string filter = make_value_filter(hashes, 256);
+  EXPECT_TRUE(filter.empty());
+  EXPECT_TRUE(value_filter_may_contain(filter, hash_value("anything")));
+}
+
+TEST(ValueFilterTest, hex) {
+  std::string bytes("\x00\x01\x7f\x80\xff", 5);
+  EXPECT_EQ(to_hex(bytes), "00017f80ff");
+  EXPECT_EQ(from_hex(to_hex(bytes)), bytes);
+}
@@ -347,6 +347,58 @@ TEST_F(WaitingQueueTestFixture, putGetWaitForId) {
 }
 
 
+TEST_F(WaitingQueueTestFixture, getByIdThenPop) {
+   DESCR("ensures msgs taken with get_or_wait() are skipped by pop_or_wait() "
+         "and the remaining msgs keep their fifo order");
+
+   cache::WaitingQueue wq(WAITING_QUEUE_TIMEOUT);
+   int totalNumItems = 10;
+
+   for(int i=0; i<totalNumItems; ++i) {
+      wq.put(createCacheMsg("uniqueId" + std::to_string(i)));
+   }
+
+   // take the odd ids out of the middle of the queue
+   for(int i=1; i<totalNumItems; i+=2) {
+      auto msgOut = wq.get_or_wait("uniqueId" + std::to_string(i));
+      ASSERT_NE(msgOut, nullptr);
+      EXPECT_EQ(msgOut->get_message_id(), "uniqueId" + std::to_string(i));
+   }
+
+   wq.finish();
+   for(int i=0; i<totalNumItems; i+=2) {
+      auto msgOut = wq.pop_or_wait();
+      ASSERT_NE(msgOut, nullptr);
+      EXPECT_EQ(msgOut->get_message_id(), "uniqueId" + std::to_string(i));
+   }
+   EXPECT_EQ(wq.pop_or_wait(), nullptr);
+   EXPECT_FALSE(wq.has_next_now());
+   EXPECT_EQ(wq.get_num_bytes(), 0);
+   EXPECT_EQ(wq.get_num_rows(), 0);
+}
+
+
+TEST_F(WaitingQueueTestFixture, getByIdDuplicatedIds) {
+   DESCR("ensures get_or_wait() returns msgs with the same id in fifo order");
+
+   cache::WaitingQueue wq(WAITING_QUEUE_TIMEOUT);
+
+   wq.put(createCacheMsg("uniqueId0"));
+   wq.put(createCacheMsg("repeatedId"));
+   wq.put(createCacheMsg("uniqueId1"));
+   wq.put(createCacheMsg("repeatedId"));
+
+   auto msgOut = wq.get_or_wait("repeatedId");
+   ASSERT_NE(msgOut, nullptr);
+   msgOut = wq.get_or_wait("repeatedId");
+   ASSERT_NE(msgOut, nullptr);
+
+   EXPECT_EQ(wq.pop_or_wait()->get_message_id(), "uniqueId0");
+   EXPECT_EQ(wq.pop_or_wait()->get_message_id(), "uniqueId1");
+   EXPECT_FALSE(wq.has_next_now());
+}
+
+
 // FIXME: enable this test when
 // https://github.com/BlazingDB/blazingsql/issues/884 is closed
 TEST_F(WaitingQueueTestFixture, DISABLED_putGetWaitForNonexistantId) {
@@ -360,7 +360,8 @@ FileStatus S3FileSystem::Private::getFileStatus(const Uri & uri) const {
 			const FileStatus fileStatus(uri, FileType::DIRECTORY, contentLength);
 			return fileStatus;
 		} else {
-			const FileStatus fileStatus(uri, FileType::FILE, contentLength);
+			const unsigned long long modificationTime = result.GetLastModified().Millis();
+			const FileStatus fileStatus(uri, FileType::FILE, contentLength, modificationTime);
 			return fileStatus;
 		}
 	} else {
@@ -11,8 +11,12 @@
 #include "aws/s3/model/HeadObjectRequest.h"
 #include <aws/core/Aws.h>
 #include <aws/s3/model/GetObjectRequest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <istream>
 #include <streambuf>
+#include <thread>
 
 #include "arrow/buffer.h"
 #include <arrow/memory_pool.h>
@@ -22,12 +26,42 @@
 #include "Library/Logging/Logger.h"
 namespace Logging = Library::Logging;
 
-// TODO: handle the situation when not all data is read
+namespace {
 
-S3ReadableFile::~S3ReadableFile() {}
+// Small reads are served from blocks of this size, so the footer, the page headers and the small column chunks of a
+// Parquet file turn into a few requests instead of one round trip each
+const int64_t READ_BLOCK_SIZE = 1 << 20;
 
+// Reads of at least this size skip the block cache and go straight into the destination, fetched in parallel parts
+const int64_t DIRECT_READ_THRESHOLD = 8 << 20;
+const int64_t PARALLEL_PART_SIZE = 8 << 20;
+const int64_t MAX_PARALLEL_PARTS = 8;
 
-S3ReadableFile::S3ReadableFile(std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucketName, std::string key) {
+// Blocks fetched in the background after a sequential read
+const int64_t READ_AHEAD_BLOCKS = 4;
+
+// Upper bound of the read cache of a single file
+const size_t MAX_CACHED_BLOCKS = 32;
+
+const int MAX_RETRIES = 5;
+const int RETRY_BASE_DELAY_MS = 50;
+
+void waitBeforeRetry(int attempt) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_BASE_DELAY_MS << attempt));
+}
+
+}  // namespace
+
+S3ReadableFile::~S3ReadableFile() {
+	// the read-ahead jobs use this object, so they must finish first
+	for(auto & job : readAheadJobs) {
+		job.wait();
+	}
+}
+
+
+S3ReadableFile::S3ReadableFile(std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucketName, std::string key)
+	: objectSize{-1}, useCounter{0}, lastReadEnd{-1} {
 	this->key = key;
 	this->bucketName = bucketName;
 	this->s3Client = s3Client;
@@ -49,257 +83,282 @@ arrow::Status S3ReadableFile::Close() {
 }
 
 arrow::Result<int64_t> S3ReadableFile::GetSize() {
-    int64_t size = -1;
-	Aws::S3::Model::HeadObjectRequest request;
+	int64_t size = objectSize;
+	if(size >= 0) {
+		return size;
+	}
 
+	std::lock_guard<std::mutex> lock(sizeMutex);
+	if(objectSize >= 0) {
+		return objectSize.load();
+	}
+
+	Aws::S3::Model::HeadObjectRequest request;
 	request.SetBucket(bucketName.data());
 	request.SetKey(key.data());
 
-	Aws::S3::Model::HeadObjectOutcome results = this->s3Client->HeadObject(request);
-
-	if(results.IsSuccess()) {
-		size = results.GetResult().GetContentLength();
-
-	} else {
-		size = -1;
-		Logging::Logger().logWarn("S3ReadableFile::GetSize, HeadObject failed");
-		bool shouldRetry = results.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logError(
-				std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data() + "  SHOULD RETRY");
-		} else {
-			Logging::Logger().logError(
-				std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+	for(int attempt = 0;; attempt++) {
+		Aws::S3::Model::HeadObjectOutcome results = this->s3Client->HeadObject(request);
+		if(results.IsSuccess()) {
+			objectSize = results.GetResult().GetContentLength();
+			return objectSize.load();
 		}
 
-        // TODO william jp errors for new arrow-0.17 API
-		//return arrow::Status::IOError(results.GetError().GetExceptionName() + " : " + results.GetError().GetMessage());
+		Logging::Logger().logWarn("S3ReadableFile::GetSize, HeadObject failed for bucketName: " + bucketName + " key " + key);
+		std::string error = std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data();
+		if(results.GetError().ShouldRetry() && attempt < MAX_RETRIES) {
+			Logging::Logger().logTrace("retrying " + error);
+			waitBeforeRetry(attempt);
+			continue;
+		}
+		Logging::Logger().logError(error + "  SHOULD NOT RETRY");
+		return arrow::Status::IOError("S3ReadableFile::GetSize failed for " + bucketName + "/" + key + ". " + error);
 	}
-
-	return size;
 }
 
-//arrow::Status S3ReadableFile::Read(int64_t nbytes, int64_t * bytesRead, void * buffer) {
-arrow::Result<int64_t> S3ReadableFile::Read(int64_t nbytes, void* buffer) {
-    int64_t bytesRead = -1;
-	//	std::cout<<"S3ReadableFile::Read " + std::to_string(nbytes)<<std::endl;
-	Aws::S3::Model::GetObjectRequest object_request;
+arrow::Status S3ReadableFile::fetchRange(int64_t position, int64_t nbytes, char * out) {
+	if(nbytes <= 0) {
+		return arrow::Status::OK();
+	}
 
+	Aws::S3::Model::GetObjectRequest object_request;
 	object_request.SetBucket(bucketName.data());
 	object_request.SetKey(key.data());
-    auto a = "bytes=" + std::to_string(position) + "-" + std::to_string(position + nbytes);
-	object_request.SetRange(a.data());
-
-	auto results = this->s3Client->GetObject(object_request);
+	// the end of an http range is inclusive
+	auto range = "bytes=" + std::to_string(position) + "-" + std::to_string(position + nbytes - 1);
+	object_request.SetRange(range.data());
+
+	for(int attempt = 0;; attempt++) {
+		auto results = this->s3Client->GetObject(object_request);
+		if(results.IsSuccess()) {
+			auto & body = results.GetResult().GetBody();
+			body.read(out, nbytes);
+			if(body.gcount() != nbytes) {
+				return arrow::Status::IOError("S3ReadableFile: expected " + std::to_string(nbytes) + " bytes at " +
+											  std::to_string(position) + " of " + bucketName + "/" + key + " but got " +
+											  std::to_string(body.gcount()));
+			}
+			return arrow::Status::OK();
+		}
 
-	if(!results.IsSuccess()) {
-		// TODO: Make bad arrow status here
 		Logging::Logger().logWarn(
-			"S3ReadableFile::Read, GetObject failed for bucketName: " + bucketName + " key " + key);
-		bool shouldRetry = results.GetError().ShouldRetry();
-
-		if(shouldRetry) {
-			Logging::Logger().logTrace("retrying");
-			return this->Read(nbytes, buffer);
-		} else {
-			bytesRead = 0;
-			Logging::Logger().logError(
-				std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			"S3ReadableFile::fetchRange, GetObject failed for bucketName: " + bucketName + " key " + key + " range " + range);
+		std::string error = std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data();
+		if(results.GetError().ShouldRetry() && attempt < MAX_RETRIES) {
+			Logging::Logger().logTrace("retrying " + error);
+			waitBeforeRetry(attempt);
+			continue;
 		}
-
-        // TODO william jp errors for new arrow-0.17 API
-		//return arrow::Status::IOError(results.GetError().GetExceptionName() + " : " + results.GetError().GetMessage());
-        return bytesRead;
-	} else {
-		bytesRead = results.GetResult().GetContentLength();
-		bytesRead = nbytes < bytesRead ? nbytes : bytesRead;
-		results.GetResult().GetBody().read((char *) buffer, bytesRead);
-		position += bytesRead;
-		return bytesRead;
+		Logging::Logger().logError(error + "  SHOULD NOT RETRY");
+		return arrow::Status::IOError("S3ReadableFile: GetObject failed for " + bucketName + "/" + key + ". " + error);
 	}
-    
-    return bytesRead;
 }
 
-//arrow::Status S3ReadableFile::Read(int64_t nbytes, std::shared_ptr<arrow::Buffer> * out) {
-arrow::Result<std::shared_ptr<arrow::Buffer>> S3ReadableFile::Read(int64_t nbytes) {
-    std::shared_ptr<arrow::Buffer> out = nullptr;
-
-	//	std::cout<<"S3ReadableFile::Read " + std::to_string(nbytes)<<std::endl;
-	Aws::S3::Model::GetObjectRequest object_request;
+arrow::Status S3ReadableFile::fetchRangeParallel(int64_t position, int64_t nbytes, char * out) {
+	int64_t numParts = (nbytes + PARALLEL_PART_SIZE - 1) / PARALLEL_PART_SIZE;
+	if(numParts <= 1) {
+		return fetchRange(position, nbytes, out);
+	}
 
-	object_request.SetBucket(bucketName.data());
-	object_request.SetKey(key.data());
-    auto a = "bytes=" + std::to_string(position) + "-" + std::to_string(position + nbytes);
-	object_request.SetRange(a.data());
+	std::vector<arrow::Status> statuses(numParts);
+	std::atomic<int64_t> nextPart{0};
+	auto fetchParts = [&]() {
+		for(int64_t part = nextPart++; part < numParts; part = nextPart++) {
+			int64_t partOffset = part * PARALLEL_PART_SIZE;
+			int64_t partSize = std::min(PARALLEL_PART_SIZE, nbytes - partOffset);
+			statuses[part] = fetchRange(position + partOffset, partSize, out + partOffset);
+		}
+	};
 
-	auto results = this->s3Client->GetObject(object_request);
+	std::vector<std::thread> workers;
+	for(int64_t worker = 1; worker < std::min(numParts, MAX_PARALLEL_PARTS); worker++) {
+		workers.emplace_back(fetchParts);
+	}
+	fetchParts();
+	for(auto & worker : workers) {
+		worker.join();
+	}
 
-	if(!results.IsSuccess()) {
-		// TODO: Make bad arrow status here
+	for(auto & status : statuses) {
+		ARROW_RETURN_NOT_OK(status);
+	}
+	return arrow::Status::OK();
+}
 
-		Logging::Logger().logWarn(
-			"S3ReadableFile::Read, GetObject failed for bucketName: " + bucketName + " key " + key);
-		bool shouldRetry = results.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logTrace("retrying");
-			return this->Read(nbytes);
-		} else {
-			Logging::Logger().logError(
-				std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+std::vector<std::shared_ptr<S3ReadableFile::CachedBlock>> S3ReadableFile::acquireBlocks(
+	int64_t firstBlock, int64_t lastBlock, std::vector<BlockRun> & runs) {
+	std::vector<std::shared_ptr<CachedBlock>> acquired;
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	for(int64_t index = firstBlock; index <= lastBlock; index++) {
+		auto it = blocks.find(index);
+		if(it == blocks.end()) {
+			auto block = std::make_shared<CachedBlock>();
+			bool extendsLastRun = !runs.empty() && runs.back().firstBlock + (int64_t) runs.back().blocks.size() == index;
+			if(!extendsLastRun) {
+				BlockRun run;
+				run.firstBlock = index;
+				run.promise = std::make_shared<std::promise<arrow::Status>>();
+				runs.push_back(std::move(run));
+			}
+			// the future is set before the lock is released, so other readers can already wait on it
+			block->ready = runs.back().promise->get_future().share();
+			runs.back().blocks.push_back(block);
+			it = blocks.emplace(index, block).first;
 		}
+		it->second->lastUse = ++useCounter;
+		acquired.push_back(it->second);
+	}
+	return acquired;
+}
 
-        // TODO william jp errors for new arrow-0.17 API
-		//return arrow::Status::IOError(results.GetError().GetExceptionName() + " : " + results.GetError().GetMessage());
-        
-        return out;
+void S3ReadableFile::fetchRun(const BlockRun & run, int64_t size) {
+	int64_t runStart = run.firstBlock * READ_BLOCK_SIZE;
+	int64_t runEnd = std::min(runStart + (int64_t) run.blocks.size() * READ_BLOCK_SIZE, size);
+
+	auto data = std::make_shared<std::string>(runEnd - runStart, '\0');
+	arrow::Status status = fetchRangeParallel(runStart, runEnd - runStart, &(*data)[0]);
+	if(status.ok()) {
+		for(size_t index = 0; index < run.blocks.size(); index++) {
+			auto & block = run.blocks[index];
+			block->data = data;
+			block->offset = index * READ_BLOCK_SIZE;
+			block->length = std::min(READ_BLOCK_SIZE, runEnd - runStart - block->offset);
+		}
 	} else {
-		// old implementation
-		/*
-std::shared_ptr<arrow::ResizableBuffer> buffer;
-AllocateResizableBuffer(arrow::default_memory_pool(), nbytes, &buffer);
-
-int64_t bytesRead = results.GetResult().GetContentLength();
-
-memcpy(buffer->mutable_data(), results.GetResult().GetBody().rdbuf(), bytesRead);
-
-position += bytesRead;
-*out = buffer;
-return arrow::Status::OK();
-*/
-
-		int64_t bytesRead = results.GetResult().GetContentLength();
-		bytesRead = nbytes < bytesRead ? nbytes : bytesRead;
-		position += bytesRead;
-		if(bytesRead < nbytes) {
-			Logging::Logger().logError(
-				"Did not read all the bytes at S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, "
-				"std::shared_ptr<arrow::Buffer>* out)");
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		for(size_t index = 0; index < run.blocks.size(); index++) {
+			auto it = blocks.find(run.firstBlock + index);
+			if(it != blocks.end() && it->second == run.blocks[index]) {
+				blocks.erase(it);
+			}
 		}
-		//		results.GetResult().GetBody().read((char*)(out->get()->mutable_data()), bytesRead);
-
-		arrow::Result<std::unique_ptr<arrow::ResizableBuffer>> buffer = 
-				AllocateResizableBuffer(nbytes, arrow::default_memory_pool());
-
-		results.GetResult().GetBody().read((char *) (buffer.ValueOrDie()->mutable_data()), bytesRead);
-		out = std::move(buffer.ValueOrDie());
-
-		return out;
 	}
+	run.promise->set_value(status);
 }
 
-//arrow::Status S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, int64_t * bytesRead, void * buffer) {
-arrow::Result<int64_t> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, void* buffer) {
-    int64_t bytesRead = -1;
-        
-	//	std::cout<<"S3ReadableFile::ReadAt " + std::to_string(nbytes)<<std::endl;
-
-	Aws::S3::Model::GetObjectRequest object_request;
-
-	object_request.SetBucket(bucketName.data());
-	object_request.SetKey(key.data());
-    auto a = "bytes=" + std::to_string(position) + "-" + std::to_string(position + nbytes);
-	object_request.SetRange(a.data());
-
-	auto results = this->s3Client->GetObject(object_request);
-
-	if(!results.IsSuccess()) {
-		// TODO: Make bad arrow status here
-
-		Logging::Logger().logWarn(
-			"S3ReadableFile::ReadAt, GetObject failed for bucketName: " + bucketName + " key " + key);
-		bool shouldRetry = results.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logTrace("retrying");
-			return this->ReadAt(position, nbytes, buffer);
-		} else {
-			bytesRead = 0;
-			Logging::Logger().logError(
-				std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+void S3ReadableFile::evictBlocksUnsafe() {
+	int64_t footerBlock = (objectSize - 1) / READ_BLOCK_SIZE;
+	while(blocks.size() > MAX_CACHED_BLOCKS) {
+		auto victim = blocks.end();
+		for(auto it = blocks.begin(); it != blocks.end(); ++it) {
+			bool fetched = it->second->ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			if(it->first != footerBlock && fetched && (victim == blocks.end() || it->second->lastUse < victim->second->lastUse)) {
+				victim = it;
+			}
 		}
-
-        // TODO william jp errors for new arrow-0.17 API
-		//return arrow::Status::IOError(results.GetError().GetExceptionName() + " : " + results.GetError().GetMessage());
-        
-        return bytesRead;
-	} else {
-		bytesRead = results.GetResult().GetContentLength();
-		bytesRead = nbytes < bytesRead ? nbytes : bytesRead;
-		this->position = position + bytesRead;
-		results.GetResult().GetBody().read((char *) buffer, bytesRead);
-
-		return bytesRead;
+		if(victim == blocks.end()) {
+			// everything else is still being fetched
+			break;
+		}
+		blocks.erase(victim);
 	}
-    
-    return bytesRead;
 }
 
-//arrow::Status S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, std::shared_ptr<arrow::Buffer> * out) {
-arrow::Result<std::shared_ptr<arrow::Buffer>> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes) {
-    std::shared_ptr<arrow::Buffer> out = nullptr;
-        
-	//	std::cout<<"S3ReadableFile::ReadAt " + std::to_string(nbytes)<<std::endl;
+void S3ReadableFile::readAhead(int64_t lastBlock, int64_t size) {
+	int64_t numBlocks = (size + READ_BLOCK_SIZE - 1) / READ_BLOCK_SIZE;
+	int64_t firstBlock = lastBlock + 1;
+	int64_t lastReadAheadBlock = std::min(lastBlock + READ_AHEAD_BLOCKS, numBlocks - 1);
+	if(firstBlock > lastReadAheadBlock) {
+		return;
+	}
 
-	Aws::S3::Model::GetObjectRequest object_request;
+	std::vector<BlockRun> runs;
+	acquireBlocks(firstBlock, lastReadAheadBlock, runs);
+	if(runs.empty()) {
+		return;
+	}
 
-	object_request.SetBucket(bucketName.data());
-	object_request.SetKey(key.data());
-    auto a = "bytes=" + std::to_string(position) + "-" + std::to_string(position + nbytes);
-	object_request.SetRange(a.data());
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	readAheadJobs.erase(std::remove_if(readAheadJobs.begin(), readAheadJobs.end(), [](std::future<void> & job) {
+		return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}), readAheadJobs.end());
+	readAheadJobs.push_back(std::async(std::launch::async, [this, runs, size]() {
+		for(auto & run : runs) {
+			fetchRun(run, size);
+		}
+	}));
+}
 
-	auto results = this->s3Client->GetObject(object_request);
+arrow::Result<int64_t> S3ReadableFile::readRange(int64_t position, int64_t nbytes, char * out) {
+	ARROW_ASSIGN_OR_RAISE(int64_t size, GetSize());
+	if(nbytes <= 0 || position >= size) {
+		return 0;
+	}
+	nbytes = std::min(nbytes, size - position);
+	bool sequential = lastReadEnd.exchange(position + nbytes) == position;
 
-	if(!results.IsSuccess()) {
-		// TODO: Make bad arrow status here
+	if(nbytes >= DIRECT_READ_THRESHOLD) {
+		ARROW_RETURN_NOT_OK(fetchRangeParallel(position, nbytes, out));
+		return nbytes;
+	}
 
-		Logging::Logger().logWarn(
-			"S3ReadableFile::ReadAt, GetObject failed for bucketName: " + bucketName + " key " + key);
-		bool shouldRetry = results.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logTrace("retrying");
-			return this->ReadAt(position, nbytes);
-		} else {
-			Logging::Logger().logError(
-				std::string(results.GetError().GetExceptionName().data()) + " : " + results.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
-		}
+	int64_t firstBlock = position / READ_BLOCK_SIZE;
+	int64_t lastBlock = (position + nbytes - 1) / READ_BLOCK_SIZE;
+	std::vector<BlockRun> runs;
+	std::vector<std::shared_ptr<CachedBlock>> needed = acquireBlocks(firstBlock, lastBlock, runs);
 
-        // TODO william jp errors for new arrow-0.17 API
-		//return arrow::Status::IOError(results.GetError().GetExceptionName() + " : " + results.GetError().GetMessage());
-        
-        return out;
-	} else {
-		// old implementation
-		/*
-		//byutes read should always be full amount
-		//should almost always be nBytes
-		std::shared_ptr<arrow::ResizableBuffer> buffer;
-		AllocateResizableBuffer(arrow::default_memory_pool(), nbytes, &buffer);
+	// the runs are disjoint, so they are fetched at the same time
+	std::vector<std::future<void>> runJobs;
+	for(size_t index = 1; index < runs.size(); index++) {
+		runJobs.push_back(std::async(std::launch::async, [this, &runs, index, size]() { fetchRun(runs[index], size); }));
+	}
+	if(!runs.empty()) {
+		fetchRun(runs[0], size);
+	}
+	for(auto & job : runJobs) {
+		job.wait();
+	}
 
-		int64_t bytesRead = nbytes;
+	for(size_t index = 0; index < needed.size(); index++) {
+		const auto & block = needed[index];
+		arrow::Status status = block->ready.get();
+		ARROW_RETURN_NOT_OK(status);
 
-		memcpy(buffer->mutable_data(), results.GetResult().GetBody().rdbuf(), bytesRead);
+		int64_t blockStart = (firstBlock + index) * READ_BLOCK_SIZE;
+		int64_t copyStart = std::max(position, blockStart);
+		int64_t copyEnd = std::min(position + nbytes, blockStart + block->length);
+		std::memcpy(out + (copyStart - position), block->data->data() + block->offset + (copyStart - blockStart), copyEnd - copyStart);
+	}
 
-		*out = buffer;
-		return arrow::Status::OK();
-		*/
-
-		int64_t bytesRead = results.GetResult().GetContentLength();
-		bytesRead = nbytes < bytesRead ? nbytes : bytesRead;
-		this->position = position + nbytes;
-		if(bytesRead < nbytes) {
-			Logging::Logger().logError(
-				"Did not read all the bytes at S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, "
-				"std::shared_ptr<arrow::Buffer>* out)");
-		}
-		//		results.GetResult().GetBody().read((char*)(out->get()->mutable_data()), bytesRead);
+	if(sequential) {
+		readAhead(lastBlock, size);
+	}
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		evictBlocksUnsafe();
+	}
+	return nbytes;
+}
 
-		arrow::Result<std::unique_ptr<arrow::ResizableBuffer>> buffer = AllocateResizableBuffer(nbytes, arrow::default_memory_pool());
+arrow::Result<int64_t> S3ReadableFile::Read(int64_t nbytes, void* buffer) {
+	ARROW_ASSIGN_OR_RAISE(int64_t bytesRead, readRange(position, nbytes, (char *) buffer));
+	position += bytesRead;
+	return bytesRead;
+}
 
-		results.GetResult().GetBody().read((char *) (buffer.ValueOrDie()->mutable_data()), bytesRead);
-		out = std::move(buffer.ValueOrDie());
+arrow::Result<std::shared_ptr<arrow::Buffer>> S3ReadableFile::Read(int64_t nbytes) {
+	ARROW_ASSIGN_OR_RAISE(auto buffer, arrow::AllocateResizableBuffer(nbytes, arrow::default_memory_pool()));
+	ARROW_ASSIGN_OR_RAISE(int64_t bytesRead, Read(nbytes, buffer->mutable_data()));
+	if(bytesRead < nbytes) {
+		ARROW_RETURN_NOT_OK(buffer->Resize(bytesRead));
+	}
+	return std::shared_ptr<arrow::Buffer>(std::move(buffer));
+}
 
-		return out;
+arrow::Result<int64_t> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, void* buffer) {
+	ARROW_ASSIGN_OR_RAISE(int64_t bytesRead, readRange(position, nbytes, (char *) buffer));
+	this->position = position + bytesRead;
+	return bytesRead;
+}
+
+arrow::Result<std::shared_ptr<arrow::Buffer>> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes) {
+	ARROW_ASSIGN_OR_RAISE(auto buffer, arrow::AllocateResizableBuffer(nbytes, arrow::default_memory_pool()));
+	ARROW_ASSIGN_OR_RAISE(int64_t bytesRead, ReadAt(position, nbytes, buffer->mutable_data()));
+	if(bytesRead < nbytes) {
+		ARROW_RETURN_NOT_OK(buffer->Resize(bytesRead));
 	}
+	return std::shared_ptr<arrow::Buffer>(std::move(buffer));
 }
 
 bool S3ReadableFile::supports_zero_copy() const { return false; }
@@ -7,11 +7,26 @@
 #ifndef SRC_UTIL_BLAZINGS3_S3READABLEFILE_H_
 #define SRC_UTIL_BLAZINGS3_S3READABLEFILE_H_
 
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
+#include <vector>
+
 #include "arrow/io/interfaces.h"
 #include "arrow/status.h"
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <aws/s3/S3Client.h>
 
+/**
+ * A RandomAccessFile over an S3 object.
+ *
+ * Reads go through a cache of fixed size blocks, so the many small reads of a Parquet footer and its page headers
+ * become a few coalesced range requests. Consecutive missing blocks are fetched with a single GetObject, reads that
+ * are large enough bypass the cache and are fetched in parallel parts, and sequential reads trigger a read-ahead of
+ * the next blocks. The block that holds the end of the object (where the Parquet footer lives) is never evicted, and
+ * the object size is only requested once.
+ */
 class S3ReadableFile : public arrow::io::RandomAccessFile {
 public:
 	S3ReadableFile(std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucket, std::string key);
@@ -39,12 +54,79 @@ public:
 	bool closed() const override;
 
 private:
+	/**
+	 * A block of the object in the read cache. The blocks fetched by the same request share its data.
+	 */
+	struct CachedBlock {
+		std::shared_future<arrow::Status> ready;  // becomes ready once data holds the bytes of the block
+		std::shared_ptr<std::string> data;
+		int64_t offset;  // where the block starts inside data
+		int64_t length;
+		uint64_t lastUse;
+	};
+
+	/**
+	 * A run of consecutive blocks that were missing from the cache and are fetched together.
+	 */
+	struct BlockRun {
+		int64_t firstBlock;
+		std::vector<std::shared_ptr<CachedBlock>> blocks;
+		std::shared_ptr<std::promise<arrow::Status>> promise;
+	};
+
+	/**
+	 * Reads a range of the object, through the block cache for small reads or straight into out for big ones.
+	 * The range is clamped to the size of the object.
+	 */
+	arrow::Result<int64_t> readRange(int64_t position, int64_t nbytes, char * out);
+
+	/**
+	 * Returns the blocks in [firstBlock, lastBlock], creating the ones that are missing. Every run of consecutive
+	 * missing blocks is added to runs, and whoever gets the runs must fetch them with fetchRun.
+	 */
+	std::vector<std::shared_ptr<CachedBlock>> acquireBlocks(int64_t firstBlock, int64_t lastBlock, std::vector<BlockRun> & runs);
+
+	/**
+	 * Fetches a run of consecutive blocks with a single (or a parallel multi part) request and marks them as ready.
+	 * Blocks that could not be fetched are removed from the cache, so a later read tries again.
+	 */
+	void fetchRun(const BlockRun & run, int64_t size);
+
+	/**
+	 * Schedules a background fetch of the blocks that follow a sequential read.
+	 */
+	void readAhead(int64_t lastBlock, int64_t size);
+
+	/**
+	 * Removes the least recently used blocks above the cache limit. The lock must be held.
+	 */
+	void evictBlocksUnsafe();
+
+	/**
+	 * Fetches a range split in parts that are requested in parallel.
+	 */
+	arrow::Status fetchRangeParallel(int64_t position, int64_t nbytes, char * out);
+
+	/**
+	 * Fetches a range with a single GetObject, retrying with exponential backoff when S3 says so.
+	 */
+	arrow::Status fetchRange(int64_t position, int64_t nbytes, char * out);
+
 	std::shared_ptr<Aws::S3::S3Client> s3Client;
 	std::string bucketName;
 	std::string key;
 	size_t position;
 	bool valid;
 
+	std::mutex sizeMutex;
+	std::atomic<int64_t> objectSize;  // -1 until the first HeadObject succeeds
+
+	std::mutex cacheMutex;
+	std::map<int64_t, std::shared_ptr<CachedBlock>> blocks;  // the read cache, by block index
+	uint64_t useCounter;
+	std::atomic<int64_t> lastReadEnd;  // used to detect sequential reads
+	std::vector<std::future<void>> readAheadJobs;  // declared last so they are waited for before anything else is destroyed
+
 	ARROW_DISALLOW_COPY_AND_ASSIGN(S3ReadableFile);
 };
 
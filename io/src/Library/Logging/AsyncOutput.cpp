@@ -0,0 +1,172 @@
+#include "Library/Logging/AsyncOutput.h"
+
+namespace Library {
+namespace Logging {
+namespace {
+std::atomic<uint64_t> nextInstanceId{1};
+
+// The ring of the calling thread for the last AsyncOutput it logged to. Only one AsyncOutput is expected to be used at
+// a time, the ring is registered again if the thread logs to another one.
+struct ThreadRing {
+	uint64_t instanceId{0};
+	std::shared_ptr<void> ring;
+};
+
+thread_local ThreadRing threadRing;
+}  // namespace
+
+AsyncOutput::Ring::Ring(std::size_t size) {
+	std::size_t capacity = 2;
+	while(capacity < size) {
+		capacity *= 2;
+	}
+	slots.resize(capacity);
+	mask = capacity - 1;
+}
+
+bool AsyncOutput::Ring::push(std::string & log) {
+	std::size_t currentTail = tail.load(std::memory_order_relaxed);
+	if(currentTail - head.load(std::memory_order_acquire) == slots.size()) {
+		return false;
+	}
+	slots[currentTail & mask] = std::move(log);
+	tail.store(currentTail + 1, std::memory_order_release);
+	return true;
+}
+
+bool AsyncOutput::Ring::pop(std::string & log) {
+	std::size_t currentHead = head.load(std::memory_order_relaxed);
+	if(currentHead == tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	log = std::move(slots[currentHead & mask]);
+	slots[currentHead & mask].clear();
+	head.store(currentHead + 1, std::memory_order_release);
+	return true;
+}
+
+std::size_t AsyncOutput::Ring::size() const {
+	return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+AsyncOutput::AsyncOutput(GenericOutput * output,
+	std::size_t ringSize,
+	std::chrono::milliseconds flushInterval,
+	std::size_t maxBatchSize)
+	: output{output}, ringSize{ringSize}, flushInterval{flushInterval}, maxBatchSize{maxBatchSize},
+	  instanceId{nextInstanceId++}, isActive{true} {
+	thread = std::thread(&AsyncOutput::doOnConsumer, this);
+}
+
+AsyncOutput::~AsyncOutput() { stop(); }
+
+void AsyncOutput::stop() {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		isActive = false;
+		condition.notify_one();
+	}
+
+	if(thread.joinable()) {
+		thread.join();
+	}
+
+	writeLogData();
+}
+
+void AsyncOutput::flush(std::string && log) { doOnProducer(std::move(log)); }
+
+void AsyncOutput::flush(const std::string & log) { doOnProducer(std::string(log)); }
+
+void AsyncOutput::flush(
+	const int nodeInd, const std::string & datetime, const std::string & level, const std::string & log) {
+	doOnProducer(datetime + "|" + std::to_string(nodeInd) + "|" + level + "|" + log);
+}
+
+void AsyncOutput::sync() { writeLogData(); }
+
+GenericOutput * AsyncOutput::release() {
+	stop();
+	return output.release();
+}
+
+void AsyncOutput::doOnProducer(std::string && log) {
+	Ring & ring = getThreadRing();
+	while(!ring.push(log)) {
+		condition.notify_one();
+		std::this_thread::yield();
+	}
+
+	if(ring.size() == ring.capacity() / 2) {
+		condition.notify_one();
+	}
+}
+
+AsyncOutput::Ring & AsyncOutput::getThreadRing() {
+	if(threadRing.instanceId != instanceId) {
+		auto ring = std::make_shared<Ring>(ringSize);
+		{
+			std::unique_lock<std::mutex> lock(ringsMutex);
+			rings.push_back(ring);
+		}
+		threadRing.instanceId = instanceId;
+		threadRing.ring = ring;
+	}
+	return *static_cast<Ring *>(threadRing.ring.get());
+}
+
+void AsyncOutput::doOnConsumer() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(isActive) {
+		condition.wait_for(lock, flushInterval);
+
+		lock.unlock();
+		writeLogData();
+		lock.lock();
+	}
+}
+
+void AsyncOutput::writeLogData() {
+	std::unique_lock<std::mutex> consumerLock(consumerMutex);
+	if(!output) {
+		return;
+	}
+
+	std::vector<std::shared_ptr<Ring>> currentRings;
+	{
+		std::unique_lock<std::mutex> lock(ringsMutex);
+		currentRings = rings;
+	}
+
+	std::string batch;
+	std::string log;
+	for(auto & ring : currentRings) {
+		while(ring->pop(log)) {
+			if(!batch.empty() && batch.length() + log.length() + 1 > maxBatchSize) {
+				// the output ends every flush with a new line
+				output->flush(batch);
+				batch.clear();
+			}
+			if(!batch.empty()) {
+				batch += '\n';
+			}
+			batch += log;
+		}
+	}
+	if(!batch.empty()) {
+		output->flush(batch);
+	}
+	currentRings.clear();
+
+	// the rings of the threads that already exited are not needed once they are drained
+	std::unique_lock<std::mutex> lock(ringsMutex);
+	std::vector<std::shared_ptr<Ring>> liveRings;
+	for(auto & ring : rings) {
+		if(ring.use_count() > 1 || ring->size() > 0) {
+			liveRings.push_back(ring);
+		}
+	}
+	rings.swap(liveRings);
+}
+}  // namespace Logging
+}  // namespace Library
@@ -0,0 +1,115 @@
+#ifndef SRC_LIBRARY_LOGGING_ASYNCOUTPUT_H_
+#define SRC_LIBRARY_LOGGING_ASYNCOUTPUT_H_
+
+#include "Library/Logging/GenericOutput.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Library {
+namespace Logging {
+/**
+ * Writes the logs to another output from a background thread, so the threads that log never wait on the output lock.
+ *
+ * Every thread that logs gets its own lock free ring buffer. The background thread drains all the rings every
+ * flushInterval, or sooner when a ring fills up to the half, and hands the logs to the output joined in batches of up
+ * to maxBatchSize bytes. A thread waits only when its own ring is full. The logs of one thread keep their order, the
+ * logs of different threads are interleaved by batch.
+ */
+class AsyncOutput : public GenericOutput {
+public:
+	AsyncOutput(GenericOutput * output,
+		std::size_t ringSize = 4096,
+		std::chrono::milliseconds flushInterval = std::chrono::milliseconds(10),
+		std::size_t maxBatchSize = 64 * 1024);
+
+	~AsyncOutput();
+
+public:
+	AsyncOutput(AsyncOutput &&) = delete;
+
+	AsyncOutput(const AsyncOutput &) = delete;
+
+	AsyncOutput & operator=(AsyncOutput &&) = delete;
+
+	AsyncOutput & operator=(const AsyncOutput &) = delete;
+
+public:
+	void flush(std::string && log) override;
+
+	void flush(const std::string & log) override;
+
+	void flush(
+		const int nodeInd, const std::string & datetime, const std::string & level, const std::string & log) override;
+
+	/**
+	 * Writes to the output everything logged before the call, from any thread.
+	 */
+	void sync();
+
+	/**
+	 * Stops the background thread, writes what is left in the rings and gives back the wrapped output. Nothing may log
+	 * to this output after the call.
+	 */
+	GenericOutput * release();
+
+private:
+	/**
+	 * Single producer single consumer ring. Only its thread pushes, and only the thread holding consumerMutex pops.
+	 */
+	class Ring {
+	public:
+		explicit Ring(std::size_t size);
+
+		bool push(std::string & log);
+
+		bool pop(std::string & log);
+
+		std::size_t size() const;
+
+		std::size_t capacity() const { return slots.size(); }
+
+	private:
+		std::vector<std::string> slots;
+		std::size_t mask;
+		alignas(64) std::atomic<std::size_t> head{0};
+		alignas(64) std::atomic<std::size_t> tail{0};
+	};
+
+	void doOnProducer(std::string && log);
+
+	void doOnConsumer();
+
+	Ring & getThreadRing();
+
+	void stop();
+
+	void writeLogData();
+
+private:
+	std::unique_ptr<GenericOutput> output;
+	const std::size_t ringSize;
+	const std::chrono::milliseconds flushInterval;
+	const std::size_t maxBatchSize;
+	const uint64_t instanceId;
+
+private:
+	std::mutex ringsMutex;
+	std::vector<std::shared_ptr<Ring>> rings;
+	std::mutex consumerMutex;
+
+private:
+	bool isActive;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread thread;
+};
+}  // namespace Logging
+}  // namespace Library
+
+#endif
@@ -1,11 +1,29 @@
 #include "Library/Logging/BlazingLogger.h"
 #include "Library/Logging/ServiceLogging.h"
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <ctime>
 
 namespace Library {
 namespace Logging {
+namespace {
+// Formatting the time is only done once per second and thread, the logs within the same second reuse it
+const std::string & getDatetime() {
+	thread_local std::time_t cachedTime{-1};
+	thread_local std::string cachedDatetime;
+
+	auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	if(time != cachedTime) {
+		std::tm localTime;
+		localtime_r(&time, &localTime);
+		char buffer[32];
+		std::size_t length = std::strftime(buffer, sizeof(buffer), "%FT%TZ", &localTime);
+		cachedDatetime.assign(buffer, length);
+		cachedTime = time;
+	}
+	return cachedDatetime;
+}
+}  // namespace
+
 BlazingLogger::BlazingLogger() {}
 
 BlazingLogger::~BlazingLogger() {}
@@ -41,12 +59,12 @@ void BlazingLogger::logFatal(std::string && logdata) { buildLogData(LoggingLevel
 void BlazingLogger::logFatal(const std::string & logdata) { buildLogData(LoggingLevel::FATAL, logdata); }
 
 void BlazingLogger::buildLogData(LoggingLevel level, const std::string & logdata) {
-	auto now = std::chrono::system_clock::now();
-	auto time = std::chrono::system_clock::to_time_t(now);
+	auto & service = ServiceLogging::getInstance();
+	if(!service.isLevelEnabled(level)) {
+		return;
+	}
 
-	std::ostringstream ss;
-	ss << std::put_time(std::localtime(&time), "%FT%TZ");
-	ServiceLogging::getInstance().setLogData(ss.str(), getLevelName(level), logdata);
+	service.setLogData(getDatetime(), getLevelName(level), logdata);
 }
 
 void BlazingLogger::sendDataToService(const std::string & logdata) {
@@ -13,5 +13,17 @@ const char * getLevelName(LoggingLevel level) {
 	}
 	return "";
 }
+
+int getLevelSeverity(LoggingLevel level) {
+	switch(level) {
+	case LoggingLevel::TRACE: return 0;
+	case LoggingLevel::DEBUG: return 1;
+	case LoggingLevel::INFO: return 2;
+	case LoggingLevel::WARN: return 3;
+	case LoggingLevel::ERROR: return 4;
+	case LoggingLevel::FATAL: return 5;
+	}
+	return 0;
+}
 }  // namespace Logging
 }  // namespace Library
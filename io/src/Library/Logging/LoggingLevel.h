@@ -6,6 +6,9 @@ namespace Logging {
 enum class LoggingLevel { INFO, WARN, TRACE, DEBUG, ERROR, FATAL };
 
 const char * getLevelName(LoggingLevel level);
+
+// TRACE is the least severe and FATAL the most severe level
+int getLevelSeverity(LoggingLevel level);
 }  // namespace Logging
 }  // namespace Library
 
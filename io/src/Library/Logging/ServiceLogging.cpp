@@ -1,4 +1,5 @@
 #include "Library/Logging/ServiceLogging.h"
+#include "AsyncOutput.h"
 #include "CoutOutput.h"
 #include "Library/Logging/GenericOutput.h"
 #include <stdlib.h>
@@ -35,6 +36,20 @@ void ServiceLogging::setLogOutput(GenericOutput * value) {
 	output = value;
 }
 
+void ServiceLogging::setAsyncOutput(bool enabled) {
+	auto asyncOutput = dynamic_cast<AsyncOutput *>(output);
+	if(enabled && asyncOutput == nullptr) {
+		output = new AsyncOutput(output);
+	} else if(!enabled && asyncOutput != nullptr) {
+		output = asyncOutput->release();
+		delete asyncOutput;
+	}
+}
+
+void ServiceLogging::setLoggingLevel(LoggingLevel level) {
+	minimumSeverity.store(getLevelSeverity(level), std::memory_order_relaxed);
+}
+
 void ServiceLogging::setNodeIdentifier(const int nodeInd) {
 	std::string message = "Node index " + std::to_string(nodeInd) + " was using temporary node index identifier " +
 						  std::to_string(this->nodeInd);
@@ -1,6 +1,8 @@
 #ifndef SRC_LIBRARY_LOGGING_SERVICELOGGING_H_
 #define SRC_LIBRARY_LOGGING_SERVICELOGGING_H_
 
+#include "Library/Logging/LoggingLevel.h"
+#include <atomic>
 #include <string>
 
 namespace Library {
@@ -37,11 +39,23 @@ public:
 
 	void setLogOutput(GenericOutput * output);
 
+	// Wraps the current output in an AsyncOutput, or flushes it and unwraps it when enabled is false. Like setLogOutput,
+	// it must not be called while other threads log.
+	void setAsyncOutput(bool enabled);
+
 	void setNodeIdentifier(const int nodeInd);
 
+	// Logs less severe than level are dropped before they are formatted. Everything is logged by default.
+	void setLoggingLevel(LoggingLevel level);
+
+	bool isLevelEnabled(LoggingLevel level) const {
+		return getLevelSeverity(level) >= minimumSeverity.load(std::memory_order_relaxed);
+	}
+
 private:
 	GenericOutput * output{nullptr};
 	int nodeInd;
+	std::atomic<int> minimumSeverity{0};
 };
 }  // namespace Logging
 }  // namespace Library
@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <iostream>
 #include <limits.h>
 #include <time.h>
 
 #include "gtest/gtest.h"
 
+#include "arrow/buffer.h"
 #include "arrow/status.h"
 
 #include "FileSystem/S3FileSystem.h"
@@ -27,8 +29,9 @@ protected:
 		const std::string accessKeyId = getAccessKeyIdEnvValue();
 		const std::string secretKey = getSecretKeyEnvValue();
 		const std::string sessionToken = getSessionTokenEnvValue();
+		const std::string endpointOverride = getEndpointOverrideEnvValue();
 		const FileSystemConnection fileSystemConnection(
-			bucketName, encryptionType, kmsKeyAmazonResourceName, accessKeyId, secretKey, sessionToken);
+			bucketName, encryptionType, kmsKeyAmazonResourceName, accessKeyId, secretKey, sessionToken, endpointOverride);
 
 		Path root;
 
@@ -94,6 +97,13 @@ private:
 		return value;
 	}
 
+	// optional, set it to run the tests against an S3 compatible server like MinIO (e.g. http://127.0.0.1:9000)
+	const std::string getEndpointOverrideEnvValue() const {
+		const std::string propertyEnvName = connectionPropertyEnvName(ConnectionProperty::ENDPOINT_OVERRIDE);
+		const char * envValue = std::getenv(propertyEnvName.c_str());
+		return envValue == nullptr ? std::string() : std::string(envValue);
+	}
+
 protected:
 	std::unique_ptr<S3FileSystem> s3FileSystem;
 };
@@ -385,3 +395,62 @@ TEST_F(S3FileSystemTest, ExistDirectoryEncryptedBucket) {
 
 	EXPECT_TRUE(exists);
 }
+
+TEST_F(S3FileSystemTest, RangedReads) {
+	const Uri uri(FileSystemType::S3, AUTHORITY, Path("/fileForRangedReadsTest.bin"));
+
+	// a few MB, so the test covers reads through the block cache, the read-ahead and the parallel parts
+	const int64_t fileSize = 20 * 1024 * 1024 + 12345;
+	std::string fileContents(fileSize, '\0');
+	for(int64_t i = 0; i < fileSize; i++) {
+		fileContents[i] = (char) ((i * 31 + i / 7919) % 251);
+	}
+
+	{
+		std::shared_ptr<arrow::io::OutputStream> outputStream = s3FileSystem->openWriteable(uri);
+		EXPECT_TRUE(outputStream->Write(fileContents).ok());
+		EXPECT_TRUE(outputStream->Close().ok());
+	}
+
+	std::shared_ptr<arrow::io::RandomAccessFile> file = s3FileSystem->openReadable(uri);
+	auto size = file->GetSize();
+	EXPECT_TRUE(size.ok());
+	EXPECT_EQ(*size, fileSize);
+
+	auto expectRead = [&](int64_t position, int64_t nbytes) {
+		auto buffer = file->ReadAt(position, nbytes);
+		EXPECT_TRUE(buffer.ok());
+		const int64_t expectedBytes = std::max<int64_t>(0, std::min(nbytes, fileSize - position));
+		EXPECT_EQ((*buffer)->size(), expectedBytes);
+		EXPECT_TRUE(std::string((const char *) (*buffer)->data(), (*buffer)->size()) ==
+					fileContents.substr(std::min(position, fileSize), expectedBytes));
+	};
+
+	// footer style reads, the second one is served by the cached tail block
+	expectRead(fileSize - 8, 8);
+	expectRead(fileSize - 5000, 4992);
+
+	// small sequential reads that cross block boundaries and trigger the read-ahead
+	for(int64_t position = 0; position < 6 * 1024 * 1024; position += 300000) {
+		expectRead(position, 300000);
+	}
+
+	// big reads are fetched in parallel parts
+	expectRead(1234, 18 * 1024 * 1024);
+
+	// reads past the end of the file
+	expectRead(fileSize - 100, 1000);
+	expectRead(fileSize, 10);
+	expectRead(fileSize + 10, 10);
+
+	// Read follows the position
+	EXPECT_TRUE(file->Seek(1000).ok());
+	auto buffer = file->Read(2000);
+	EXPECT_TRUE(buffer.ok());
+	EXPECT_TRUE(std::string((const char *) (*buffer)->data(), (*buffer)->size()) == fileContents.substr(1000, 2000));
+	EXPECT_EQ(*file->Tell(), 3000);
+	EXPECT_TRUE(file->Close().ok());
+
+	const bool removed = s3FileSystem->remove(uri);
+	EXPECT_TRUE(removed);
+}
@@ -1,6 +1,7 @@
 #ifndef TEST_MOCK_LIBRARY_LOGGING_SERVICELOGGING_H_
 #define TEST_MOCK_LIBRARY_LOGGING_SERVICELOGGING_H_
 
+#include "Library/Logging/LoggingLevel.h"
 #include <gmock/gmock.h>
 
 namespace Library {
@@ -66,6 +67,8 @@ public:
 
 	void setLogOutput(GenericOutput * output);
 
+	bool isLevelEnabled(LoggingLevel) const { return true; }
+
 private:
 	BlazingTest::Library::Logging::ServiceLoggingMock * mock{nullptr};
 };
@@ -1,10 +1,13 @@
+#include "Library/Logging/AsyncOutput.h"
 #include "Library/Logging/CoutOutput.h"
+#include "Library/Logging/FileOutput.h"
 #include "Library/Logging/Logger.h"
 #include "Library/Logging/ServiceLogging.h"
 #include "Library/Logging/TcpOutput.h"
 #include "Library/Network/GenericSocket.h"
 #include <boost/asio.hpp>
 #include <chrono>
+#include <cstdio>
 #include <ctime>
 #include <functional>
 #include <future>
@@ -293,3 +296,54 @@ TEST_F(LibraryLoggingPerformanceTest, PerformanceCoutOutput) {
 			  << " MBps\n";
 	std::cerr << "Improvement Ratio: " << (double) standardMean / (double) loggingMean << "x\n\n";
 }
+
+
+TEST_F(LibraryLoggingPerformanceTest, PerformanceAsyncOutputThreads) {
+	const int messageTimes{20000};
+	const int messageSize{99};
+	const std::string messageData = generateMessage(messageSize);
+	const std::string filename{"LibraryLoggingPerformanceTest.log"};
+
+	auto & service = Library::Logging::ServiceLogging::getInstance();
+
+	auto measure = [&](int threadSize, bool async) {
+		Library::Logging::GenericOutput * output = new Library::Logging::FileOutput(filename, true);
+		if(async) {
+			output = new Library::Logging::AsyncOutput(output);
+		}
+		service.setLogOutput(output);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		executeFunction(threadSize,
+			messageTimes,
+			messageData,
+			[](const int /*id*/, const int messageTimes, const std::string & messageData) {
+				for(int k = 0; k < messageTimes; ++k) {
+					Library::Logging::Logger().logInfo(messageData);
+				}
+			});
+		auto finish = std::chrono::high_resolution_clock::now();
+
+		// the async output writes what is left when it is replaced
+		service.setLogOutput(new Library::Logging::CoutOutput());
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+		return (double) threadSize * messageTimes / ((double) elapsed / 1000000.0);
+	};
+
+	std::cerr.precision(0);
+	std::cerr << std::fixed;
+	std::cerr << "\n\nMessage per Thread: " << messageTimes << '\n';
+	std::cerr << "Message Length: " << messageSize << " bytes\n\n";
+	std::cerr << "Threads | FileOutput msg/s | AsyncOutput msg/s | Improvement Ratio\n";
+	for(int threadSize = 1; threadSize <= 64; threadSize *= 2) {
+		double syncThroughput = measure(threadSize, false);
+		double asyncThroughput = measure(threadSize, true);
+		std::cerr << threadSize << " | " << syncThroughput << " | " << asyncThroughput << " | ";
+		std::cerr.precision(2);
+		std::cerr << asyncThroughput / syncThroughput << "x\n";
+		std::cerr.precision(0);
+	}
+	std::cerr << "\n";
+
+	std::remove(filename.c_str());
+}
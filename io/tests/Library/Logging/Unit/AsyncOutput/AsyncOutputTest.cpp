@@ -0,0 +1,117 @@
+#include "Library/Logging/AsyncOutput.h"
+#include "Library/Logging/CoutOutput.h"
+#include "Library/Logging/Logger.h"
+#include "Library/Logging/ServiceLogging.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+struct AsyncOutputTest : public ::testing::Test {
+	AsyncOutputTest() {}
+
+	virtual ~AsyncOutputTest() {}
+
+	virtual void SetUp() {
+		cout_buffer = std::cout.rdbuf();
+		std::cout.rdbuf(buffer.rdbuf());
+	}
+
+	virtual void TearDown() { std::cout.rdbuf(cout_buffer); }
+
+	std::vector<std::string> readLines() {
+		std::vector<std::string> lines;
+		std::string line;
+		while(std::getline(buffer, line)) {
+			lines.push_back(line);
+		}
+		return lines;
+	}
+
+	std::stringstream buffer;
+	std::streambuf * cout_buffer;
+
+	const std::string logData{"sample data"};
+};
+
+
+TEST_F(AsyncOutputTest, EvaluateSingleThreadMultiPrint) {
+	const int times = 100;
+
+	{
+		Library::Logging::AsyncOutput output(new Library::Logging::CoutOutput(), 8);
+		for(int k = 0; k < times; ++k) {
+			output.flush(logData + std::to_string(k));
+		}
+	}
+
+	auto lines = readLines();
+	ASSERT_EQ(lines.size(), times);
+	for(int k = 0; k < times; ++k) {
+		EXPECT_EQ(lines[k], logData + std::to_string(k));
+	}
+}
+
+
+TEST_F(AsyncOutputTest, EvaluateMultiThreadMultiPrint) {
+	const int times = 1000;
+	const int threadSize = 10;
+
+	{
+		Library::Logging::AsyncOutput output(new Library::Logging::CoutOutput(), 16, std::chrono::milliseconds(1), 256);
+
+		std::vector<std::thread> threads;
+		for(int k = 0; k < threadSize; ++k) {
+			threads.push_back(std::thread([this, &output, k, times]() {
+				for(int i = 0; i < times; ++i) {
+					output.flush(std::to_string(k) + " " + std::to_string(i));
+				}
+			}));
+		}
+
+		for(int k = 0; k < threadSize; ++k) {
+			threads[k].join();
+		}
+	}
+
+	// the logs of every thread keep their order
+	std::map<int, int> nextLog;
+	auto lines = readLines();
+	ASSERT_EQ(lines.size(), times * threadSize);
+	for(const auto & line : lines) {
+		std::istringstream stream(line);
+		int thread;
+		int log;
+		stream >> thread >> log;
+		EXPECT_EQ(log, nextLog[thread]++);
+	}
+}
+
+
+TEST_F(AsyncOutputTest, EvaluateSync) {
+	Library::Logging::AsyncOutput output(new Library::Logging::CoutOutput(), 16, std::chrono::milliseconds(60000));
+	output.flush(1, "2020-01-01T00:00:00Z", "INFO", logData);
+	output.sync();
+
+	auto lines = readLines();
+	ASSERT_EQ(lines.size(), 1);
+	EXPECT_EQ(lines[0], "2020-01-01T00:00:00Z|1|INFO|" + logData);
+}
+
+
+TEST_F(AsyncOutputTest, EvaluateLoggingLevel) {
+	auto & service = Library::Logging::ServiceLogging::getInstance();
+	service.setLogOutput(new Library::Logging::CoutOutput());
+	service.setLoggingLevel(Library::Logging::LoggingLevel::WARN);
+
+	Library::Logging::Logger().logTrace(logData);
+	Library::Logging::Logger().logInfo(logData);
+	Library::Logging::Logger().logError(logData);
+	service.setLoggingLevel(Library::Logging::LoggingLevel::TRACE);
+
+	auto lines = readLines();
+	ASSERT_EQ(lines.size(), 1);
+	EXPECT_NE(lines[0].find("|ERROR|" + logData), std::string::npos);
+}
@@ -578,6 +578,7 @@ def mergeMetadata(curr_table, fileMetadata, hiveMetadata):
         col_name = columns[index]
         names.append("min_" + str(index) + "_" + col_name)
         names.append("max_" + str(index) + "_" + col_name)
+        names.append("filter_" + str(index) + "_" + col_name)
     names.append("file_handle_index")
     names.append("row_group_index")
 
@@ -1162,23 +1163,50 @@ def load_config_options_from_env(user_config_options: dict):
     default_values = {
         "JOIN_PARTITION_SIZE_THRESHOLD": 400000000,
         "MAX_JOIN_SCATTER_MEM_OVERHEAD": 500000000,
+        "MERGE_AGGREGATE_PARTIAL_BYTE_SIZE": 268435456,  # 256 MB
         "MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE": 8,
         "NUM_BYTES_PER_ORDER_BY_PARTITION": 400000000,
         "TABLE_SCAN_KERNEL_NUM_THREADS": 4,
         "MAX_DATA_LOAD_CONCAT_CACHE_BYTE_SIZE": 400000000,
+        "NUM_BYTES_PER_TABLE_SCAN_BATCH": 0,
+        "TABLE_SCAN_LATE_MATERIALIZATION": 1,
         "FLOW_CONTROL_BYTES_THRESHOLD": 18446744073709551615,  # see https://en.cppreference.com/w/cpp/types/numeric_limits/max
+        "FLOW_CONTROL_ADAPTIVE": 0,
+        "FLOW_CONTROL_TARGET_LATENCY_MS": 1000,
         "ORDER_BY_SAMPLES_RATIO": 0.1,
         "MAX_ORDER_BY_SAMPLES_PER_NODE": 10000,
         "BLAZING_DEVICE_MEM_CONSUMPTION_THRESHOLD": 0.95,
         "BLAZ_HOST_MEM_CONSUMPTION_THRESHOLD": 0.75,
+        "HOST_BUFFER_POOL_MAX_CACHED_BYTES": 1073741824,
         "BLAZING_LOGGING_DIRECTORY": "blazing_log",
         "BLAZING_CACHE_DIRECTORY": "/tmp/",
+        "BLAZING_CACHE_DIRECT_IO": 0,
+        "CACHE_HOST_COMPRESSION": "none",
+        "CACHE_HOST_COMPRESSION_MAX_RATIO": 0.8,
         "MEMORY_MONITOR_PERIOD": 50,
+        "MEMORY_MONITOR_SPILL_AHEAD_RATIO": 1.0,
+        "MEMORY_MONITOR_EVICTION_POLICY": "reverse_order",
+        "MEMORY_MONITOR_HOST_BANDWIDTH": 10000000000,
+        "MEMORY_MONITOR_DISK_BANDWIDTH": 1000000000,
+        "CACHE_IO_NUM_THREADS": 2,
+        "PARQUET_METADATA_CACHE_MAX_ENTRIES": 10000,
+        "PARQUET_METADATA_CACHE_DIRECTORY": "",
+        "PARQUET_VALUE_FILTER_MAX_BYTES": 0,
+        "EXPRESSION_PLAN_CACHE_MAX_ENTRIES": 1000,
         "MAX_KERNEL_RUN_THREADS": 16,
+        "TASK_EXECUTOR_NUM_THREADS": 0,
         "MAX_SEND_MESSAGE_THREADS": 20,
+        "PARTITION_SEND_BUFFER_BYTE_SIZE": 4194304,  # 4 MB
+        "PARTITION_SEND_BUFFER_MAX_DELAY_MS": 100,
+        "TRANSPORT_MAX_CONNECTIONS_PER_PEER": 8,
+        "TRANSPORT_CONNECTION_IDLE_TIMEOUT_MS": 60000,
+        "TRANSPORT_MAX_MESSAGES_IN_FLIGHT": 16,
+        "TRANSPORT_RECEIVE_WORKERS": 4,
+        "ENABLE_QUERY_TRACE": 0,
         "LOGGING_LEVEL": "trace",
         "LOGGING_FLUSH_LEVEL": "warn",
         "LOGGING_MAX_SIZE_PER_FILE": 1073741824,  # 1 GB
+        "LOGGING_ASYNC": 0,
         "TRANSPORT_BUFFER_BYTE_SIZE": 1048576,  # 10 MB in bytes
         "TRANSPORT_POOL_NUM_BUFFERS": 100,
     }
@@ -1271,6 +1299,13 @@ class BlazingContext(object):
                     the nodes, instead of doing a standard hash based
                     partitioning shuffle. Value is in bytes.
                     default: 500000000
+            MERGE_AGGREGATE_PARTIAL_BYTE_SIZE : The partial results of an
+                    aggregation are merged as they arrive, every time two or
+                    more of them add up to this many bytes, instead of merging
+                    all of them at the end. Partials waiting to be merged can
+                    be spilled to host memory or disk. Set it to 0 to merge
+                    everything at the end. Value is in bytes.
+                    default: 268435456 (256 MB)
             MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE : The maximum number of
                     partitions that will be made for an order by.
                     Increse this number if running into OOM issues when
@@ -1287,10 +1322,34 @@ class BlazingContext(object):
             MAX_DATA_LOAD_CONCAT_CACHE_BYTE_SIZE : The max size in bytes to
                     concatenate the batches read from the scan kernels
                     default: 400000000
+            NUM_BYTES_PER_TABLE_SCAN_BATCH : The target size in bytes of
+                    each batch read by the scan kernels. Big parquet files
+                    are split by row groups and small files are read
+                    together until this size is reached.
+                    A value of 0 reads exactly one file per batch.
+                    default: 0
+            TABLE_SCAN_LATE_MATERIALIZATION : Set to 1 so a scan with a
+                    filter reads the columns of the filter first, and the
+                    other columns only for the parquet row groups with rows
+                    that pass it.
+                    default: 1
             FLOW_CONTROL_BYTES_THRESHOLD: If an output cache surpasses this
                     value in bytes, the kernel will try to stop
                     execution until the output cache contains less.
                     default: max size_t (makes it not applicable)
+            FLOW_CONTROL_ADAPTIVE : Set to 1 so every output cache that
+                    applies FLOW_CONTROL_BYTES_THRESHOLD sizes its own limit
+                    from the device and host memory left, shared among those
+                    caches, and from how fast its data is consumed.
+                    FLOW_CONTROL_BYTES_THRESHOLD still applies as a maximum.
+                    The caches that feed a kernel with several inputs, like
+                    the two sides of a join, keep the fixed limit.
+                    default: 0 (disabled)
+            FLOW_CONTROL_TARGET_LATENCY_MS : With FLOW_CONTROL_ADAPTIVE, when
+                    a kernel produces data faster than the next kernel
+                    consumes it, the output cache holds at most what the next
+                    kernel consumes in this many milliseconds.
+                    default: 1000
             ORDER_BY_SAMPLES_RATIO : The ratio to multiply the estimated total
                     number of rows in the SortAndSampleKernel to calculate
                     the number of samples
@@ -1312,26 +1371,138 @@ class BlazingContext(object):
                     NOTE: This parameter only works when used in the
                     BlazingContext
                     default: 0.75
+            HOST_BUFFER_POOL_MAX_CACHED_BYTES : How many bytes of released
+                    host buffers (from tables in the host cache) are kept
+                    by the host buffer pool to be reused by later batches
+                    and queries instead of being freed.
+                    default: 1073741824 (1 GiB)
             BLAZING_LOGGING_DIRECTORY : A folder path to place all logging
                     files. The path can be relative or absolute.
                     NOTE: This parameter only works when used in the
                     BlazingContext
                     default: 'blazing_log'
-            BLAZING_CACHE_DIRECTORY : A folder path to place all orc files
+            BLAZING_CACHE_DIRECTORY : A folder path to place all spill files
                     when start caching on Disk. The path can be relative
                     or absolute.
                     NOTE: This parameter only works when used in the
                     BlazingContext
                     default: '/tmp/'
+            BLAZING_CACHE_DIRECT_IO : Set to 1 to write and read the spill
+                    files with O_DIRECT, bypassing the page cache. It falls
+                    back to buffered I/O when the filesystem of
+                    BLAZING_CACHE_DIRECTORY does not support it.
+                    default: 0
+            CACHE_HOST_COMPRESSION : The codec used to compress the data that
+                    the caches move to host memory: none, lz4 or zstd.
+                    Compressed data takes less host memory, so more of it
+                    stays there before the caches have to spill to disk.
+                    default: none
+            CACHE_HOST_COMPRESSION_MAX_RATIO : With CACHE_HOST_COMPRESSION,
+                    columns whose compressed size is more than this fraction
+                    of their size are kept uncompressed. They are tried again
+                    every 16 batches.
+                    default: 0.8
             MEMORY_MONITOR_PERIOD : How often the memory monitor checks memory
                     consumption. The value is in milliseconds.
                     default: 50  (milliseconds)
+            MEMORY_MONITOR_SPILL_AHEAD_RATIO : Fraction of the device memory
+                    limit at which the memory monitor starts spilling caches.
+                    Values below 1.0 spill ahead of memory pressure, so that
+                    kernels rarely have to spill data themselves.
+                    default: 1.0
+            MEMORY_MONITOR_EVICTION_POLICY : Which batches the memory monitor
+                    spills first. reverse_order spills the newest batches of
+                    the caches closest to the output first. cost_aware spills
+                    first the batches that will not be consumed for the
+                    longest time, given how fast every cache is consumed,
+                    relative to the cost of spilling and reading them back.
+                    default: reverse_order
+            MEMORY_MONITOR_HOST_BANDWIDTH : With the cost_aware eviction
+                    policy, the bytes per second at which batches are copied
+                    between device and host memory.
+                    default: 10000000000
+            MEMORY_MONITOR_DISK_BANDWIDTH : With the cost_aware eviction
+                    policy, the bytes per second at which batches are written
+                    to and read from disk.
+                    default: 1000000000
+            CACHE_IO_NUM_THREADS : The number of threads that write spill
+                    files and read them back ahead of time in the background.
+                    With 0 all the disk I/O of the caches is synchronous.
+                    default: 2
+            PARQUET_METADATA_CACHE_MAX_ENTRIES : How many parquet files keep
+                    their schema and row group statistics in memory, so
+                    planning queries over the same files does not read their
+                    footers again. Files are recognized by their path, size
+                    and modification time. Set to 0 to disable the cache.
+                    default: 10000
+            PARQUET_METADATA_CACHE_DIRECTORY : An existing folder where the
+                    parquet metadata cache is also persisted, so it survives
+                    restarts. Empty to keep it only in memory.
+                    default: ""
+            PARQUET_VALUE_FILTER_MAX_BYTES : The most bytes of the bloom
+                    filter built from the dictionary of a parquet column
+                    chunk, so filters like col = 'value' or col IN (...)
+                    skip the row groups that do not have the value. Only
+                    string and integer columns whose pages are all
+                    dictionary encoded get one. It reads the dictionary
+                    pages when the metadata of a table is read. Set to 0
+                    to not build them.
+                    default: 0
+            EXPRESSION_PLAN_CACHE_MAX_ENTRIES : How many parsed and compiled
+                    lists of projection and filter expressions are kept, so
+                    the kernels do not parse them again for every batch.
+                    0 disables the cache.
+                    default: 1000
             MAX_KERNEL_RUN_THREADS : The number of threads available to run
                     kernels simultaneously.
                     default: 16
+            TASK_EXECUTOR_NUM_THREADS : The number of threads of the work
+                    stealing executor. When greater than 0, Projection,
+                    Filter and ComputeAggregate kernels are run as one task
+                    per batch on this executor instead of occupying one of
+                    the MAX_KERNEL_RUN_THREADS threads each. A task based
+                    kernel whose output is over its flow control budget is
+                    not run again until its output is pulled.
+                    default: 0 (disabled)
             MAX_SEND_MESSAGE_THREADS : The number of threads available to send
                     outgoing messages.
                     default: 20
+            PARTITION_SEND_BUFFER_BYTE_SIZE : Partitions smaller than this,
+                    that are sent to the same node by a distributed
+                    aggregation, join or order by, are held back and sent
+                    together as one message once they add up to this many
+                    bytes. Set it to 0 to send every partition on its own.
+                    default: 4194304 (4 MB)
+            PARTITION_SEND_BUFFER_MAX_DELAY_MS : The longest a partition is
+                    held back before it is sent, checked every time a batch
+                    is distributed.
+                    default: 100
+            TRANSPORT_MAX_CONNECTIONS_PER_PEER : How many connections to each
+                    of the other nodes are kept open and reused to send
+                    messages. A connection is shared by the threads sending
+                    to the node, a new one is only opened when all of them
+                    are in use.
+                    default: 8
+            TRANSPORT_CONNECTION_IDLE_TIMEOUT_MS : A connection that was not
+                    used for this many milliseconds is closed instead of
+                    reused.
+                    default: 60000
+            TRANSPORT_MAX_MESSAGES_IN_FLIGHT : How many messages can be sent
+                    on a connection before the receiving node acknowledges
+                    them. It bounds the memory the receiving node needs for
+                    each connection.
+                    default: 16
+            TRANSPORT_RECEIVE_WORKERS : The number of threads that read the
+                    incoming messages at the same time.
+                    default: 4
+            ENABLE_QUERY_TRACE : Set to 1 to write a timeline of every query
+                    to BLAZING_LOGGING_DIRECTORY, as a Chrome trace file
+                    named query_trace_<node>_<query id>.json on every node.
+                    It shows the kernels running, the batches computed,
+                    the cache adds and pulls, spills and the messages sent
+                    and received by every thread, and can be opened with
+                    chrome://tracing or https://ui.perfetto.dev
+                    default: 0
             LOGGING_LEVEL : Set the level (as string) to register into the logs
                     for the current tool of logging. Log levels have order of priority:
                     {trace, debug, info, warn, err, critical, off}. Using 'trace' will
@@ -1349,6 +1520,10 @@ class BlazingContext(object):
                     NOTE: This parameter only works when used in the
                     BlazingContext
                     default: 1 GB
+            LOGGING_ASYNC : Set to 1 to write the logs of the io library
+                    (file systems) from a background thread, so the threads
+                    that log never wait on the output.
+                    default: 0
             TRANSPORT_BUFFER_BYTE_SIZE : The size in bytes about the pinned buffer memory
                     default: 10 MBs
             TRANSPORT_POOL_NUM_BUFFERS: The number of buffers in the punned buffer memory pool.
@@ -1799,6 +1974,53 @@ class BlazingContext(object):
             free_memory_dictionary[0] = cio.getFreeMemoryCaller()
             return free_memory_dictionary
 
+    def get_metrics(self):
+        """
+        This function returns a pandas DataFrame with the metrics of the
+        most recent queries, with a row for every kernel, cache and
+        message type of every gpuID (worker column). The rows and bytes
+        going in and out, compute time, wait time on the caches, spilled
+        bytes and network bytes are collected while the queries run.
+        Times are in microseconds.
+
+        Example
+        --------
+        >>> from blazingsql import BlazingContext
+        >>> bc = BlazingContext()
+        >>> bc.create_table('taxi', '/home/user/taxi.parquet')
+        >>> result = bc.sql('SELECT passenger_count, SUM(fare) FROM taxi GROUP BY passenger_count')
+        >>> metrics = bc.get_metrics()
+        >>> print(metrics[metrics.scope == 'kernel'][['name', 'rows_in', 'rows_out', 'compute_time_us']])
+        """
+        if self.dask_client:
+            dask_futures = []
+            workers_id = []
+            workers = tuple(self.dask_client.scheduler_info()["workers"])
+            for worker_id, worker in enumerate(workers):
+                metrics = self.dask_client.submit(
+                    cio.getMetricsSnapshotCaller, workers=[worker], pure=False
+                )
+                dask_futures.append(metrics)
+                workers_id.append(worker_id)
+            aslist = self.dask_client.gather(dask_futures)
+        else:
+            workers_id = [0]
+            aslist = [cio.getMetricsSnapshotCaller()]
+
+        rows = []
+        for worker_id, samples in zip(workers_id, aslist):
+            for sample in samples:
+                row = {
+                    "worker": worker_id,
+                    "scope": sample["scope"],
+                    "query_id": sample["query_id"],
+                    "id": sample["id"],
+                    "name": sample["name"],
+                }
+                row.update(sample["values"])
+                rows.append(row)
+        return pandas.DataFrame(rows)
+
     def create_table(self, table_name, input, **kwargs):
         """
         Create a BlazingSQL table.